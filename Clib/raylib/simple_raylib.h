@@ -37,10 +37,110 @@ void srl_update_texture(void* buf);
 void srl_draw_buffer(void* buf, int x, int y);
 void srl_draw_buffer_scaled(void* buf, int x, int y, int dest_width, int dest_height);
 
+/* Compiled scene layout (must match SDF_COMPILED_SCENE) */
+#define SRL_ENTRY_SIZE          32
+#define SRL_FIELD_KIND          0
+#define SRL_FIELD_OPERATION     1
+#define SRL_FIELD_BLEND         2
+#define SRL_FIELD_TRANSFORMED   3   /* 1: map through MATRIX, scale by SCALE */
+#define SRL_FIELD_PARAMETERS    4
+#define SRL_FIELD_MATRIX        16  /* world-to-shape rows, 3 x 4 */
+#define SRL_FIELD_SCALE         28
+#define SRL_ENTRY_PARAMETERS    12
+
+#define SRL_KIND_SPHERE         1
+#define SRL_KIND_BOX            2
+#define SRL_KIND_CAPSULE        3
+#define SRL_KIND_CYLINDER       4
+#define SRL_KIND_TORUS          5
+#define SRL_KIND_PLANE          6
+
+#define SRL_OP_UNION            1
+#define SRL_OP_SUBTRACTION      2
+#define SRL_OP_INTERSECTION     3
+
+/* Instruction tape layout (must match SDF_TAPE) */
+#define SRL_INSTR_SIZE          5
+#define SRL_INSTR_OPCODE        0
+#define SRL_INSTR_DST           1
+#define SRL_INSTR_SRC_A         2
+#define SRL_INSTR_SRC_B         3
+#define SRL_INSTR_CONST         4
+#define SRL_INSTR_COUNT         2   /* member count of group opcodes (shares SRC_A) */
+#define SRL_TAPE_MAX_REGISTERS  32
+
+/* Primitive opcodes equal the SRL_KIND_* values. Group opcodes take the
+ * min over SRL_INSTR_COUNT spheres or boxes, constants field by field (SoA) */
+#define SRL_OPC_SPHERE_GROUP        8
+#define SRL_OPC_BOX_GROUP           9
+
+#define SRL_OPC_UNION               16
+#define SRL_OPC_SMOOTH_UNION        17
+#define SRL_OPC_SUBTRACTION         18
+#define SRL_OPC_SMOOTH_SUBTRACTION  19
+#define SRL_OPC_INTERSECTION        20
+#define SRL_OPC_SMOOTH_INTERSECTION 21
+
+/* Added to a primitive opcode for a rotated or scaled shape: its constants
+ * start with the world-to-shape matrix rows (3 x 4) and the scale */
+#define SRL_OPC_TRANSFORMED         32
+#define SRL_TRANSFORM_CONSTANTS     13
+
 /* Fast SDF Ray Marching (entire render loop in C for performance) */
 void srl_render_sdf_scene(void* buf, int width, int height,
                           float cam_x, float cam_y, float cam_z,
                           float cam_yaw, float cam_pitch);
+void srl_render_sdf_compiled(void* buf, int width, int height,
+                             float cam_x, float cam_y, float cam_z,
+                             float cam_yaw, float cam_pitch,
+                             const float* scene, int entry_count);
+void srl_render_sdf_tape(void* buf, int width, int height,
+                         float cam_x, float cam_y, float cam_z,
+                         float cam_yaw, float cam_pitch,
+                         const int* code, int instruction_count,
+                         const float* constants, int register_count, int result_register);
+
+/* Narrow-band brick cache (must match SDF_BRICK_FIELD): a grid of cells of
+ * SRL_BRICK_CELLS voxels, each with a brick of SRL_BRICK_SIZE^3 uint8 samples
+ * (x fastest) or -1 and a distance bound; the tape is the exact fallback */
+#define SRL_BRICK_CELLS         7
+#define SRL_BRICK_SIZE          8
+#define SRL_GRID_ORIGIN         0   /* origin xyz */
+#define SRL_GRID_VOXEL          3
+#define SRL_GRID_BAND           4
+#define SRL_GRID_SIZE           5
+void srl_render_sdf_bricks(void* buf, int width, int height,
+                           float cam_x, float cam_y, float cam_z,
+                           float cam_yaw, float cam_pitch,
+                           const int* code, int instruction_count,
+                           const float* constants, int register_count, int result_register,
+                           const float* grid, int cells_x, int cells_y, int cells_z,
+                           const int* cells, const float* coarse, const unsigned char* samples);
+
+/* SIMD ray packets (8 lanes with AVX2, 16 with AVX-512; 1 = scalar) */
+void srl_set_ray_packets(int enabled);
+int srl_ray_packet_width(void);
+
+/* Per-tile tape pruning in the CPU renderer (on by default) */
+void srl_set_tape_pruning(int enabled);
+int srl_tape_pruning(void);
+
+/* Cone-marched depth pre-pass in the CPU renderer (on by default) */
+void srl_set_depth_prepass(int enabled);
+int srl_depth_prepass(void);
+
+/* Variable-rate shading in the CPU renderer (full rate by default) */
+#define SRL_RATE_FULL           0
+#define SRL_RATE_CHECKERBOARD   1
+#define SRL_RATE_QUARTER        2
+void srl_set_shading_rate(int rate);
+int srl_shading_rate(void);
+
+/* Enhanced sphere tracing relaxation factor in [1, SRL_RELAXATION_MAX] (1 = plain sphere tracing) */
+#define SRL_RELAXATION_DEFAULT  1.2f
+#define SRL_RELAXATION_MAX      1.9f
+void srl_set_relaxation(float omega);
+float srl_relaxation(void);
 
 /* Input - Keyboard */
 int srl_is_key_down(int key);
@@ -0,0 +1,268 @@
+note
+	description: "[
+		Benchmarks for simple_sdf evaluation paths.
+
+		Traces a fixed grid of camera rays through a village-sized scene
+		and reports wall time, garbage collector activity and the total
+		number of march steps per run.
+
+		Runs:
+		- legacy vectors: the pre-value-type march loop (an SDF_VEC3 per
+		  step, six per normal) kept here as the baseline
+		- scalar march:   SDF_RAY_MARCHER.march (allocation-free steps)
+		- batch march:    SDF_RAY_MARCHER.march_batch into a reused
+		  SDF_HIT_BUFFER (no allocation per ray, normals included)
+		- plain steps:    batch march with relaxation 1 (plain sphere
+		  tracing), the step count baseline for enhanced sphere tracing
+		- frozen tape:    batch march with the scene frozen to an SDF_TAPE
+		- mixed tape:     frozen tape marched in `Precision_mixed' (REAL_32
+		  steps on the tape, REAL_64 near surfaces)
+		- hierarchy:      batch march with BVH culling (enable_hierarchy)
+
+		Usage:
+			ec -batch -config simple_sdf.ecf -target simple_sdf_benchmark -c_compile
+			simple_sdf_benchmark > bench_output.txt
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_BENCHMARK
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make
+			-- Run all benchmarks.
+		local
+			l_relaxation: REAL_64
+		do
+			create memory
+			create marcher.make_default
+			build_scene
+
+			print ("SIMPLE_SDF benchmark: " + scene.count.out + " shapes, "
+				+ (Grid_size * Grid_size).out + " rays per run%N%N")
+
+			run ("legacy vectors", agent trace_legacy)
+			run ("scalar march", agent trace_scalar)
+			run ("batch march", agent trace_batch)
+			l_relaxation := marcher.relaxation
+			marcher.set_relaxation (1.0).do_nothing
+			run ("plain steps", agent trace_batch)
+			marcher.set_relaxation (l_relaxation).do_nothing
+			scene.freeze
+			run ("frozen tape", agent trace_batch)
+			marcher.set_precision (marcher.Precision_mixed).do_nothing
+			run ("mixed tape", agent trace_batch)
+			marcher.set_precision (marcher.Precision_double).do_nothing
+			scene.thaw
+			scene.enable_hierarchy
+			run ("hierarchy", agent trace_batch)
+			scene.disable_hierarchy
+		end
+
+feature {NONE} -- Scene
+
+	build_scene
+			-- Ground plane plus a grid of houses (box + sphere roof).
+		local
+			i, j: INTEGER
+			l_box: SDF_BOX
+			l_roof: SDF_SPHERE
+		do
+			create scene.make
+			scene.add (create {SDF_PLANE}.make_xz (0.0)).do_nothing
+			from i := 0 until i >= Houses_per_side loop
+				from j := 0 until j >= Houses_per_side loop
+					create l_box.make (1.0, 1.0, 1.0)
+					l_box.translate_xyz (i * 3.0 - 15.0, 0.5, j * -3.0 - 5.0).do_nothing
+					scene.add_union (l_box).do_nothing
+					create l_roof.make (0.6)
+					l_roof.translate_xyz (i * 3.0 - 15.0, 1.1, j * -3.0 - 5.0).do_nothing
+					scene.add_smooth_union (l_roof, 0.2).do_nothing
+					j := j + 1
+				end
+				i := i + 1
+			end
+		end
+
+feature {NONE} -- Runs
+
+	run (a_name: STRING; a_trace: FUNCTION [INTEGER])
+			-- Run `a_trace' and report time, GC cycles, hit and step counts.
+		local
+			l_start, l_seconds: REAL_64
+			l_cycles: INTEGER
+			l_hits: INTEGER
+		do
+			memory.full_collect
+			march_steps := 0
+			l_cycles := gc_cycles
+			l_start := c_seconds
+			l_hits := a_trace.item ([])
+			l_seconds := c_seconds - l_start
+			l_cycles := gc_cycles - l_cycles
+
+			print (a_name + ": " + l_seconds.truncated_to_real.out + " s, "
+				+ l_cycles.out + " GC cycles, " + l_hits.out + " hits, "
+				+ march_steps.out + " steps%N")
+		end
+
+	trace_scalar: INTEGER
+			-- Trace the ray grid with SDF_RAY_MARCHER; return hit count.
+		local
+			i, j: INTEGER
+			l_origin: SDF_VEC3
+			l_hit: SDF_RAY_HIT
+		do
+			create l_origin.make (0.0, 4.0, 6.0)
+			from i := 0 until i >= Grid_size loop
+				from j := 0 until j >= Grid_size loop
+					l_hit := marcher.march (scene, l_origin, ray_direction (i, j))
+					if l_hit.is_hit then
+						Result := Result + 1
+					end
+					march_steps := march_steps + l_hit.steps
+					j := j + 1
+				end
+				i := i + 1
+			end
+		end
+
+	trace_batch: INTEGER
+			-- Trace the ray grid with `march_batch', one row per batch.
+		local
+			i, j: INTEGER
+			l_rays: SDF_RAY_BATCH
+			l_hits: SDF_HIT_BUFFER
+			l_direction: SDF_VEC3
+		do
+			create l_rays.make (Grid_size)
+			create l_hits.make (Grid_size)
+			from i := 0 until i >= Grid_size loop
+				l_rays.wipe_out
+				from j := 0 until j >= Grid_size loop
+					l_direction := ray_direction (i, j)
+					l_rays.extend (0.0, 4.0, 6.0, l_direction.x, l_direction.y, l_direction.z)
+					j := j + 1
+				end
+				marcher.march_batch (scene, l_rays, l_hits, True)
+				Result := Result + l_hits.hit_count
+				from j := 1 until j > l_hits.count loop
+					march_steps := march_steps + l_hits.step_count (j)
+					j := j + 1
+				end
+				i := i + 1
+			end
+		end
+
+	trace_legacy: INTEGER
+			-- Trace the ray grid with the legacy vector loop; return hit count.
+		local
+			i, j: INTEGER
+			l_origin: SDF_VEC3
+		do
+			create l_origin.make (0.0, 4.0, 6.0)
+			from i := 0 until i >= Grid_size loop
+				from j := 0 until j >= Grid_size loop
+					if legacy_march (l_origin, ray_direction (i, j)) then
+						Result := Result + 1
+					end
+					j := j + 1
+				end
+				i := i + 1
+			end
+		end
+
+	legacy_march (a_origin, a_direction: SDF_VEC3): BOOLEAN
+			-- Baseline: march loop as written before value types.
+		local
+			l_depth, l_dist: REAL_64
+			l_step: INTEGER
+			l_point, l_normal: SDF_VEC3
+		do
+			from
+				l_step := 0
+			until
+				l_step >= marcher.max_steps or l_depth >= marcher.max_distance
+			loop
+				l_point := a_origin + (a_direction * l_depth)
+				l_dist := scene.distance (l_point)
+				march_steps := march_steps + 1
+				if l_dist.abs < marcher.surface_threshold then
+					l_normal := legacy_normal (l_point)
+					Result := l_normal /= Void
+					l_step := marcher.max_steps
+				else
+					l_depth := l_depth + l_dist
+					l_step := l_step + 1
+				end
+			end
+		end
+
+	legacy_normal (a_point: SDF_VEC3): SDF_VEC3
+			-- Baseline: central differences with vector offsets.
+		local
+			dx, dy, dz: SDF_VEC3
+			eps: REAL_64
+		do
+			eps := marcher.normal_epsilon
+			create dx.make (eps, 0.0, 0.0)
+			create dy.make (0.0, eps, 0.0)
+			create dz.make (0.0, 0.0, eps)
+			create Result.make (
+				scene.distance (a_point + dx) - scene.distance (a_point - dx),
+				scene.distance (a_point + dy) - scene.distance (a_point - dy),
+				scene.distance (a_point + dz) - scene.distance (a_point - dz))
+			Result := Result.normalized
+		end
+
+	ray_direction (i, j: INTEGER): SDF_VEC3
+			-- Unit direction for grid cell (i, j), looking down -Z.
+		do
+			create Result.make ((i / Grid_size) * 2.0 - 1.0, (j / Grid_size) - 0.8, -1.0)
+			Result := Result.normalized
+		end
+
+feature {NONE} -- Implementation
+
+	scene: SDF_SCENE
+			-- Benchmark scene
+
+	marcher: SDF_RAY_MARCHER
+			-- Marcher under test
+
+	memory: MEMORY
+			-- GC access
+
+	march_steps: INTEGER
+			-- March steps taken so far in the current run
+
+	gc_cycles: INTEGER
+			-- Total collection cycles so far
+		do
+			Result := memory.gc_statistics (memory.Full_collector).cycle_count
+				+ memory.gc_statistics (memory.Incremental_collector).cycle_count
+		end
+
+	c_seconds: REAL_64
+			-- Processor time in seconds.
+		external
+			"C inline use <time.h>"
+		alias
+			"return (EIF_REAL_64)clock() / (EIF_REAL_64)CLOCKS_PER_SEC;"
+		end
+
+feature {NONE} -- Constants
+
+	Grid_size: INTEGER = 200
+			-- Rays per side of the traced grid
+
+	Houses_per_side: INTEGER = 10
+			-- Houses per side of the village grid
+
+end
@@ -57,6 +57,9 @@ feature {NONE} -- Scene Setup
 			l_ground := sdf.ground_plane (-1.5)
 			scene.add (l_ground).do_nothing
 
+			-- Instruction tape for the native renderer
+			scene_tape := scene.tape
+
 			-- Ray marcher with quality settings
 			ray_marcher := sdf.ray_marcher_custom (64, 50.0, 0.001)
 
@@ -82,7 +85,7 @@ feature {NONE} -- Render Loop
 				handle_input
 
 				-- Render scene to buffer using fast C ray marcher
-				c_render_sdf_scene (l_buf.handle, Render_width, Render_height,
+				l_buf.render_tape (scene_tape,
 					camera_origin.x.truncated_to_real, camera_origin.y.truncated_to_real, camera_origin.z.truncated_to_real,
 					camera_yaw.truncated_to_real, camera_pitch.truncated_to_real)
 
@@ -294,6 +297,9 @@ feature {NONE} -- Implementation
 	scene: SDF_SCENE
 			-- Current SDF scene
 
+	scene_tape: SDF_TAPE
+			-- Tape form of `scene' consumed by the C renderer
+
 	ray_marcher: SDF_RAY_MARCHER
 			-- Ray marcher for rendering
 
@@ -320,15 +326,4 @@ feature {NONE} -- Constants
 	Render_height: INTEGER = 1080
 			-- Render buffer height
 
-feature {NONE} -- C Externals
-
-	c_render_sdf_scene (a_buf: POINTER; a_width, a_height: INTEGER;
-			a_cam_x, a_cam_y, a_cam_z, a_cam_yaw, a_cam_pitch: REAL_32)
-			-- Fast C-based SDF ray marching (entire render loop in C).
-		external
-			"C inline use %"simple_raylib.h%""
-		alias
-			"srl_render_sdf_scene((void*)$a_buf, (int)$a_width, (int)$a_height, (float)$a_cam_x, (float)$a_cam_y, (float)$a_cam_z, (float)$a_cam_yaw, (float)$a_cam_pitch);"
-		end
-
 end
@@ -0,0 +1,226 @@
+note
+	description: "[
+		Dual number over REAL_64: a value with its gradient in x, y, z.
+
+		Forward-mode differentiation: every operation returns the result
+		of the same operation on `value' together with the chain-rule
+		derivative, so a distance computed on duals carries its exact
+		gradient with it. One evaluation yields the surface normal that
+		central differences would need six evaluations for. Expanded:
+		duals are values and never touch the GC heap.
+
+		At a kink (min, max, abs) the derivative of the branch taken is
+		returned, which is the one-sided gradient of the active surface.
+
+		Design by Contract:
+		- Components are never NaN
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+expanded class
+	SDF_DUAL
+
+create
+	default_create,
+	make,
+	make_constant
+
+feature {NONE} -- Initialization
+
+	make (a_value, a_dx, a_dy, a_dz: REAL_64)
+			-- Create `a_value' with gradient (a_dx, a_dy, a_dz).
+		do
+			set (a_value, a_dx, a_dy, a_dz)
+		ensure
+			value_set: value = a_value
+			dx_set: dx = a_dx
+			dy_set: dy = a_dy
+			dz_set: dz = a_dz
+		end
+
+	make_constant (a_value: REAL_64)
+			-- Create `a_value' with zero gradient.
+		do
+			value := a_value
+		ensure
+			value_set: value = a_value
+			flat: gradient_length = 0.0
+		end
+
+feature -- Access
+
+	value: REAL_64
+			-- Function value
+
+	dx: REAL_64
+			-- Partial derivative along x
+
+	dy: REAL_64
+			-- Partial derivative along y
+
+	dz: REAL_64
+			-- Partial derivative along z
+
+	gradient_length: REAL_64
+			-- Length of (dx, dy, dz)
+		do
+			Result := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz)
+		ensure
+			non_negative: Result >= 0.0
+		end
+
+feature -- Arithmetic
+
+	plus alias "+" (other: SDF_DUAL): SDF_DUAL
+			-- Sum
+		do
+			Result.set (value + other.value, dx + other.dx, dy + other.dy, dz + other.dz)
+		end
+
+	minus alias "-" (other: SDF_DUAL): SDF_DUAL
+			-- Difference
+		do
+			Result.set (value - other.value, dx - other.dx, dy - other.dy, dz - other.dz)
+		end
+
+	product alias "*" (other: SDF_DUAL): SDF_DUAL
+			-- Product
+		do
+			Result.set (value * other.value,
+				dx * other.value + value * other.dx,
+				dy * other.value + value * other.dy,
+				dz * other.value + value * other.dz)
+		end
+
+	opposite alias "-": SDF_DUAL
+			-- Negation
+		do
+			Result.set (- value, - dx, - dy, - dz)
+		end
+
+	plus_value (a_value: REAL_64): SDF_DUAL
+			-- Shifted by `a_value'
+		do
+			Result.set (value + a_value, dx, dy, dz)
+		end
+
+	scaled (a_factor: REAL_64): SDF_DUAL
+			-- Multiplied by `a_factor'
+		do
+			Result.set (value * a_factor, dx * a_factor, dy * a_factor, dz * a_factor)
+		end
+
+	squared: SDF_DUAL
+			-- Square
+		do
+			Result.set (value * value, 2.0 * value * dx, 2.0 * value * dy, 2.0 * value * dz)
+		ensure
+			non_negative: Result.value >= 0.0
+		end
+
+	square_root: SDF_DUAL
+			-- Square root of the non-negative part (flat at zero)
+		local
+			r: REAL_64
+		do
+			if value > 0.0 then
+				r := {DOUBLE_MATH}.sqrt (value)
+				Result.set (r, dx * 0.5 / r, dy * 0.5 / r, dz * 0.5 / r)
+			end
+		ensure
+			non_negative: Result.value >= 0.0
+		end
+
+	absolute: SDF_DUAL
+			-- Absolute value
+		do
+			if value < 0.0 then
+				Result := opposite
+			else
+				Result := Current
+			end
+		ensure
+			non_negative: Result.value >= 0.0
+		end
+
+feature -- Comparison operations
+
+	min (other: SDF_DUAL): SDF_DUAL
+			-- Smaller of the two, with its gradient
+		do
+			if other.value < value then
+				Result := other
+			else
+				Result := Current
+			end
+		end
+
+	max (other: SDF_DUAL): SDF_DUAL
+			-- Larger of the two, with its gradient
+		do
+			if other.value > value then
+				Result := other
+			else
+				Result := Current
+			end
+		end
+
+	min_value (a_value: REAL_64): SDF_DUAL
+			-- min (Current, `a_value')
+		do
+			if a_value < value then
+				Result.set (a_value, 0.0, 0.0, 0.0)
+			else
+				Result := Current
+			end
+		end
+
+	max_value (a_value: REAL_64): SDF_DUAL
+			-- max (Current, `a_value')
+		do
+			if a_value > value then
+				Result.set (a_value, 0.0, 0.0, 0.0)
+			else
+				Result := Current
+			end
+		end
+
+	clamped (a_lo, a_hi: REAL_64): SDF_DUAL
+			-- clamp (Current, a_lo, a_hi)
+		require
+			ordered: a_lo <= a_hi
+		do
+			Result := max_value (a_lo).min_value (a_hi)
+		end
+
+feature -- Element change
+
+	set (a_value, a_dx, a_dy, a_dz: REAL_64)
+			-- Set value and gradient.
+		do
+			value := a_value
+			dx := a_dx
+			dy := a_dy
+			dz := a_dz
+		ensure
+			value_set: value = a_value
+			dx_set: dx = a_dx
+			dy_set: dy = a_dy
+			dz_set: dz = a_dz
+		end
+
+feature -- Output
+
+	out_dual: STRING
+			-- "value (dx, dy, dz)"
+		do
+			Result := value.out + " (" + dx.out + ", " + dy.out + ", " + dz.out + ")"
+		end
+
+invariant
+	value_is_valid: not value.is_nan
+	gradient_is_valid: not dx.is_nan and not dy.is_nan and not dz.is_nan
+
+end
@@ -8,7 +8,20 @@ note
 		- Boolean operations (union, subtraction, intersection)
 		- Smooth blending operations
 		- Ray marching code
+		- Cone-marched depth pre-pass in workgroup shared memory
+		- Temporal reprojection of the previous frame's depth
+		- Checkerboard and quarter-rate shading with edge-aware reconstruction
+		- Analytic normals from a forward-differentiated scene function
+		- Domain repetition functions (`add_repetition')
+		- Rotated and scaled shapes through precomputed inverse matrices
+		  (`transformed_sdf')
 		- Full shader generation from SDF_SCENE
+
+		Every sd* and op* function has a *Grad twin that returns
+		vec4(distance, gradient). With `is_analytic_normals' the scene body
+		is rewritten onto the twins as `sceneSDFGrad' and `calcNormal'
+		normalizes its gradient: one scene evaluation per normal instead
+		of six.
 	]"
 	author: "Larry Rix"
 	date: "$Date$"
@@ -32,8 +45,105 @@ feature {NONE} -- Initialization
 			-- Initialize SDF GLSL builder.
 		do
 			make_builder
+			is_depth_prepass := True
+			is_analytic_normals := True
+			create repetitions.make (0)
+		end
+
+feature -- Settings
+
+	is_depth_prepass: BOOLEAN
+			-- Does `emit_ray_march_main' start each ray at a cone-marched depth?
+
+	set_depth_prepass (a_enabled: BOOLEAN)
+			-- Enable or disable the cone-marched depth pre-pass.
+		do
+			is_depth_prepass := a_enabled
+		ensure
+			set: is_depth_prepass = a_enabled
+		end
+
+	is_temporal_reprojection: BOOLEAN
+			-- Does the shader start rays at the previous frame's reprojected depth?
+			-- Such shaders take two dispatches per frame (see SDF_QUICK).
+
+	set_temporal_reprojection (a_enabled: BOOLEAN)
+			-- Enable or disable temporal reprojection.
+		do
+			is_temporal_reprojection := a_enabled
+		ensure
+			set: is_temporal_reprojection = a_enabled
+		end
+
+	is_analytic_normals: BOOLEAN
+			-- Does `generate_basic_shader' take normals from `sceneSDFGrad'
+			-- instead of central differences? The scene body must then build
+			-- its distance from sd* and op* calls, repetition functions, float
+			-- locals and numeric constants only (see `gradient_body').
+
+	set_analytic_normals (a_enabled: BOOLEAN)
+			-- Enable or disable analytic normals.
+		do
+			is_analytic_normals := a_enabled
+		ensure
+			set: is_analytic_normals = a_enabled
+		end
+
+	shading_rate: INTEGER
+			-- Pixels marched per frame: `Shading_rate_full', `Shading_rate_checkerboard'
+			-- or `Shading_rate_quarter'. Reduced rates replace the depth pre-pass
+			-- and temporal reprojection, and need a dispatch of
+			-- `dispatch_tile_width' by `dispatch_tile_height' pixels per workgroup.
+
+	set_shading_rate (a_rate: INTEGER)
+			-- Set the shading rate.
+		require
+			valid_rate: a_rate = Shading_rate_full or a_rate = Shading_rate_checkerboard
+				or a_rate = Shading_rate_quarter
+		do
+			shading_rate := a_rate
+		ensure
+			set: shading_rate = a_rate
 		end
 
+	dispatch_tile_width: INTEGER
+			-- Screen pixels covered by one workgroup horizontally.
+		do
+			if shading_rate = Shading_rate_full then
+				Result := Work_group_size
+			else
+				Result := 2 * Work_group_size
+			end
+		end
+
+	dispatch_tile_height: INTEGER
+			-- Screen pixels covered by one workgroup vertically.
+		do
+			if shading_rate = Shading_rate_quarter then
+				Result := 2 * Work_group_size
+			else
+				Result := Work_group_size
+			end
+		end
+
+	Shading_rate_full: INTEGER = 0
+			-- March every pixel.
+
+	Shading_rate_checkerboard: INTEGER = 1
+			-- March half the pixels in a checkerboard that alternates per frame.
+
+	Shading_rate_quarter: INTEGER = 2
+			-- March one pixel per 2x2 block, cycling through the block per frame.
+
+	Work_group_size: INTEGER = 16
+			-- Width and height of the compute workgroup (one screen tile).
+
+	Cone_coarse: INTEGER = 8
+			-- Pixel block width of a first-level pre-pass cone.
+
+	Cone_fine: INTEGER = 2
+			-- Pixel block width of a second-level pre-pass cone.
+
 feature -- Primitive Functions
 
 	emit_sphere_sdf
@@ -165,6 +275,199 @@ feature -- Operation Functions
 			newline
 		end
 
+feature -- Transforms
+
+	emit_transform_ops
+			-- Emit opTransform, which maps a world point into shape space with
+			-- a precomputed inverse matrix, and opAffine, which restores the
+			-- world distance.
+		do
+			emit_raw_line ("vec3 opTransform(vec3 p, mat4x3 m) {")
+			emit_raw_line ("    return m * vec4(p, 1.0);")
+			emit_raw_line ("}")
+			newline
+			emit_raw_line ("float opAffine(float d, mat4x3 m, float s) {")
+			emit_raw_line ("    return d * s;")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_affine_grad
+			-- Emit opAffineGrad function: the shape-space gradient turned back
+			-- into world space (the linear part of `m' is R^T / s).
+		do
+			emit_raw_line ("vec4 opAffineGrad(vec4 d, mat4x3 m, float s) {")
+			emit_raw_line ("    return vec4(d.x * s, s * (d.yzw * mat3(m)));")
+			emit_raw_line ("}")
+			newline
+		end
+
+	transformed_sdf (a_function, a_arguments: STRING; a_shape: SDF_SHAPE): STRING
+			-- Call of `a_function' with `a_arguments' after p for `a_shape':
+			-- wrapped in opTransform/opAffine when `a_shape' is transformed.
+		require
+			function_not_empty: a_function /= Void and then not a_function.is_empty
+			arguments_attached: a_arguments /= Void
+			shape_attached: a_shape /= Void
+		local
+			l_matrix: STRING
+		do
+			if a_shape.is_transformed then
+				l_matrix := transform_matrix (a_shape)
+				Result := "opAffine(" + a_function + "(opTransform(p, " + l_matrix + "), " + a_arguments + "), "
+					+ l_matrix + ", " + format_float (a_shape.scale) + ")"
+			else
+				Result := a_function + "(p, " + a_arguments + ")"
+			end
+		ensure
+			result_attached: Result /= Void
+		end
+
+	transform_matrix (a_shape: SDF_SHAPE): STRING
+			-- mat4x3 literal of the world-to-shape matrix of `a_shape'
+			-- (GLSL matrices are column-major)
+		require
+			shape_attached: a_shape /= Void
+			transformed: a_shape.is_transformed
+		local
+			l_m: ARRAY [REAL_64]
+			l_col: INTEGER
+		do
+			l_m := a_shape.transform_parameters
+			Result := "mat4x3("
+			from l_col := 1 until l_col > 4 loop
+				if l_col > 1 then
+					Result.append (", ")
+				end
+				Result.append (format_float (l_m [l_col]) + ", " + format_float (l_m [l_col + 4])
+					+ ", " + format_float (l_m [l_col + 8]))
+				l_col := l_col + 1
+			end
+			Result.append (")")
+		ensure
+			result_attached: Result /= Void
+		end
+
+feature -- Domain Repetition
+
+	add_repetition (a_name, a_child: STRING; a_mode: INTEGER; a_crosses_border: BOOLEAN)
+			-- Have `generate_basic_shader' emit `a_name'(p, s) (and `a_name'(p, s, l)
+			-- for `Repeat_limited'): the distance to copies of `a_child', a
+			-- child distance expression in the cell-local point `q' with the
+			-- child centred on the origin, every `s' along each axis (0 = not
+			-- repeated), in cells -l .. l when limited and mirrored in odd cells
+			-- for `Repeat_mirrored'. The child is evaluated once per sample, or
+			-- in the 8 cells around it if `a_crosses_border' (its bounds cross
+			-- a cell border). The scene body may call `a_name' like an op*
+			-- function; it has a *Grad twin for analytic normals.
+		require
+			name_not_empty: a_name /= Void and then not a_name.is_empty
+			child_not_empty: a_child /= Void and then not a_child.is_empty
+			valid_mode: a_mode = Repeat_infinite or a_mode = Repeat_limited or a_mode = Repeat_mirrored
+		do
+			repetitions.extend ([a_name.twin, a_child.twin, a_mode, a_crosses_border])
+		ensure
+			added: repetitions.count = old repetitions.count + 1
+		end
+
+	wipe_out_repetitions
+			-- Forget every `add_repetition'.
+		do
+			repetitions.wipe_out
+		ensure
+			none: repetitions.is_empty
+		end
+
+	emit_repetition (a_name, a_child: STRING; a_mode: INTEGER; a_crosses_border, a_gradient: BOOLEAN)
+			-- Emit repetition function `a_name' (see `add_repetition'), or its
+			-- *Grad twin returning vec4(distance, gradient) if `a_gradient'.
+		require
+			name_not_empty: a_name /= Void and then not a_name.is_empty
+			child_not_empty: a_child /= Void and then not a_child.is_empty
+			valid_mode: a_mode = Repeat_infinite or a_mode = Repeat_limited or a_mode = Repeat_mirrored
+		local
+			l_signature: STRING
+		do
+			l_signature := "(vec3 p, vec3 s"
+			if a_mode = Repeat_limited then
+				l_signature.append (", vec3 l")
+			end
+			l_signature.append (") {")
+			if a_gradient then
+				emit_raw_line ("vec4 " + a_name + "Grad" + l_signature)
+			else
+				emit_raw_line ("float " + a_name + l_signature)
+			end
+			emit_raw_line ("    bvec3 fixedAxis = equal(s, vec3(0.0));")
+			if a_mode = Repeat_limited then
+				emit_raw_line ("    vec3 id = mix(clamp(round(p / s), -l, l), vec3(0.0), fixedAxis);")
+			else
+				emit_raw_line ("    vec3 id = mix(round(p / s), vec3(0.0), fixedAxis);")
+			end
+			if a_gradient then
+				emit_raw_line ("    vec4 d = vec4(1e20, 0.0, 0.0, 0.0);")
+			else
+				emit_raw_line ("    float d = 1e20;")
+			end
+			if a_crosses_border then
+				-- The nearer neighbour on each axis: the 8 cells around p
+				emit_raw_line ("    vec3 o = mix(sign(p - s * id), vec3(0.0), fixedAxis);")
+				emit_raw_line ("    for (int k = 0; k < 8; k++) {")
+				emit_raw_line ("        vec3 c = id + o * vec3(k & 1, (k >> 1) & 1, (k >> 2) & 1);")
+				if a_mode = Repeat_limited then
+					emit_raw_line ("        if (any(greaterThan(abs(c), l))) continue;")
+				end
+			else
+				emit_raw_line ("    for (int k = 0; k < 1; k++) {")
+				emit_raw_line ("        vec3 c = id;")
+			end
+			emit_raw_line ("        vec3 q = p - s * c;")
+			if a_mode = Repeat_mirrored then
+				emit_raw_line ("        vec3 m = 1.0 - 2.0 * mod(abs(c), 2.0);")
+				emit_raw_line ("        q *= m;")
+			end
+			if a_gradient then
+				emit_raw_line ("        vec4 e = " + gradient_calls (a_child) + ";")
+				if a_mode = Repeat_mirrored then
+					emit_raw_line ("        e.yzw *= m;")
+				end
+				emit_raw_line ("        if (e.x < d.x) d = e;")
+			else
+				emit_raw_line ("        d = min(d, " + a_child + ");")
+			end
+			emit_raw_line ("    }")
+			emit_raw_line ("    return d;")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_all_repetitions (a_gradient: BOOLEAN)
+			-- Emit every function added with `add_repetition' (or their *Grad twins).
+		do
+			if not repetitions.is_empty then
+				if a_gradient then
+					emit_block_comment ("Domain Repetition Gradients")
+				else
+					emit_block_comment ("Domain Repetition")
+				end
+				across repetitions as r loop
+					emit_repetition (r.item.name, r.item.child, r.item.mode, r.item.crosses_border, a_gradient)
+				end
+			end
+		end
+
+	repetitions: ARRAYED_LIST [TUPLE [name, child: STRING; mode: INTEGER; crosses_border: BOOLEAN]]
+			-- Repetition functions added with `add_repetition'
+
+	Repeat_infinite: INTEGER = 1
+			-- Copies without end.
+
+	Repeat_limited: INTEGER = 2
+			-- Copies in cells -l .. l, the cell index clamped.
+
+	Repeat_mirrored: INTEGER = 3
+			-- Copies without end, mirrored in odd cells.
+
 feature -- All Primitives and Operations
 
 	emit_all_primitives
@@ -190,6 +493,258 @@ feature -- All Primitives and Operations
 			emit_smooth_union_op
 			emit_smooth_subtraction_op
 			emit_smooth_intersection_op
+			emit_transform_ops
+		end
+
+feature -- Gradient Functions
+
+	emit_sphere_grad
+			-- Emit sdSphereGrad function.
+		do
+			emit_raw_line ("vec4 sdSphereGrad(vec3 p, vec3 c, float r) {")
+			emit_raw_line ("    vec3 q = p - c;")
+			emit_raw_line ("    float l = length(q);")
+			emit_raw_line ("    return vec4(l - r, l > 0.0 ? q / l : vec3(0.0));")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_box_grad
+			-- Emit sdBoxGrad function: outside, the direction from the nearest
+			-- box point; inside, the axis of the nearest face.
+		do
+			emit_raw_line ("vec4 sdBoxGrad(vec3 p, vec3 c, vec3 b) {")
+			emit_raw_line ("    vec3 s = mix(vec3(1.0), vec3(-1.0), lessThan(p - c, vec3(0.0)));")
+			emit_raw_line ("    vec3 q = abs(p - c) - b;")
+			emit_raw_line ("    float m = max(q.x, max(q.y, q.z));")
+			emit_raw_line ("    if (m > 0.0) {")
+			emit_raw_line ("        vec3 o = max(q, 0.0);")
+			emit_raw_line ("        float l = length(o);")
+			emit_raw_line ("        return vec4(l, s * o / l);")
+			emit_raw_line ("    }")
+			emit_raw_line ("    return vec4(m, s * (q.x >= m ? vec3(1, 0, 0) : (q.y >= m ? vec3(0, 1, 0) : vec3(0, 0, 1))));")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_cylinder_grad
+			-- Emit sdCylinderGrad function.
+		do
+			emit_raw_line ("vec4 sdCylinderGrad(vec3 p, vec3 c, float r, float h) {")
+			emit_raw_line ("    vec3 q = p - c;")
+			emit_raw_line ("    float l = length(q.xz);")
+			emit_raw_line ("    vec3 gr = l > 0.0 ? vec3(q.x, 0.0, q.z) / l : vec3(0.0);")
+			emit_raw_line ("    vec3 gh = vec3(0.0, q.y < 0.0 ? -1.0 : 1.0, 0.0);")
+			emit_raw_line ("    vec2 d = vec2(l - r, abs(q.y) - h);")
+			emit_raw_line ("    float m = max(d.x, d.y);")
+			emit_raw_line ("    if (m > 0.0) {")
+			emit_raw_line ("        vec2 o = max(d, 0.0);")
+			emit_raw_line ("        float lo = length(o);")
+			emit_raw_line ("        return vec4(lo, (gr * o.x + gh * o.y) / lo);")
+			emit_raw_line ("    }")
+			emit_raw_line ("    return vec4(m, d.x >= d.y ? gr : gh);")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_capsule_grad
+			-- Emit sdCapsuleGrad function.
+		do
+			emit_raw_line ("vec4 sdCapsuleGrad(vec3 p, vec3 a, vec3 b, float r) {")
+			emit_raw_line ("    vec3 pa = p - a, ba = b - a;")
+			emit_raw_line ("    float h = clamp(dot(pa, ba) / dot(ba, ba), 0.0, 1.0);")
+			emit_raw_line ("    vec3 v = pa - ba * h;")
+			emit_raw_line ("    float l = length(v);")
+			emit_raw_line ("    return vec4(l - r, l > 0.0 ? v / l : vec3(0.0));")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_torus_grad
+			-- Emit sdTorusGrad function.
+		do
+			emit_raw_line ("vec4 sdTorusGrad(vec3 p, vec3 c, float R, float r) {")
+			emit_raw_line ("    vec3 q = p - c;")
+			emit_raw_line ("    float l = length(q.xz);")
+			emit_raw_line ("    vec3 gr = l > 0.0 ? vec3(q.x, 0.0, q.z) / l : vec3(0.0);")
+			emit_raw_line ("    vec2 t = vec2(l - R, q.y);")
+			emit_raw_line ("    float lt = length(t);")
+			emit_raw_line ("    return vec4(lt - r, lt > 0.0 ? (gr * t.x + vec3(0.0, t.y, 0.0)) / lt : vec3(0.0));")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_plane_grad
+			-- Emit sdPlaneGrad function.
+		do
+			emit_raw_line ("vec4 sdPlaneGrad(vec3 p, vec3 n, float h) {")
+			emit_raw_line ("    vec3 u = normalize(n);")
+			emit_raw_line ("    return vec4(dot(p, u) + h, u);")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_cone_grad
+			-- Emit sdConeGrad function.
+		do
+			emit_raw_line ("vec4 sdConeGrad(vec3 p, vec3 c, float r, float h) {")
+			emit_raw_line ("    vec3 q = p - c;")
+			emit_raw_line ("    float l = length(q.xz);")
+			emit_raw_line ("    vec3 gr = l > 0.0 ? vec3(q.x, 0.0, q.z) / l : vec3(0.0);")
+			emit_raw_line ("    vec2 d = abs(vec2(l, q.y)) - vec2(r * (1.0 - q.y / h), h);")
+			emit_raw_line ("    vec3 gx = gr + vec3(0.0, r / h, 0.0);")
+			emit_raw_line ("    vec3 gy = vec3(0.0, q.y < 0.0 ? -1.0 : 1.0, 0.0);")
+			emit_raw_line ("    float m = max(d.x, d.y);")
+			emit_raw_line ("    if (m > 0.0) {")
+			emit_raw_line ("        vec2 o = max(d, 0.0);")
+			emit_raw_line ("        float lo = length(o);")
+			emit_raw_line ("        return vec4(lo, (gx * o.x + gy * o.y) / lo);")
+			emit_raw_line ("    }")
+			emit_raw_line ("    return vec4(m, d.x >= d.y ? gx : gy);")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_union_grad
+			-- Emit opUnionGrad function.
+		do
+			emit_raw_line ("vec4 opUnionGrad(vec4 d1, vec4 d2) {")
+			emit_raw_line ("    return d1.x < d2.x ? d1 : d2;")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_subtraction_grad
+			-- Emit opSubtractionGrad function.
+		do
+			emit_raw_line ("vec4 opSubtractionGrad(vec4 d1, vec4 d2) {")
+			emit_raw_line ("    return d1.x > -d2.x ? d1 : -d2;")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_intersection_grad
+			-- Emit opIntersectionGrad function.
+		do
+			emit_raw_line ("vec4 opIntersectionGrad(vec4 d1, vec4 d2) {")
+			emit_raw_line ("    return d1.x > d2.x ? d1 : d2;")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_smooth_union_grad
+			-- Emit opSmoothUnionGrad function.
+		do
+			emit_raw_line ("vec4 opSmoothUnionGrad(vec4 d1, vec4 d2, float k) {")
+			emit_raw_line ("    float h = max(k - abs(d1.x - d2.x), 0.0) / k;")
+			emit_raw_line ("    float s = d1.x < d2.x ? -1.0 : 1.0;")
+			emit_raw_line ("    vec4 m = d1.x < d2.x ? d1 : d2;")
+			emit_raw_line ("    return vec4(m.x - h * h * k * 0.25, m.yzw + 0.5 * h * s * (d1.yzw - d2.yzw));")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_smooth_subtraction_grad
+			-- Emit opSmoothSubtractionGrad function.
+		do
+			emit_raw_line ("vec4 opSmoothSubtractionGrad(vec4 d1, vec4 d2, float k) {")
+			emit_raw_line ("    float h = clamp(0.5 - 0.5 * (d2.x + d1.x) / k, 0.0, 1.0);")
+			emit_raw_line ("    vec3 dh = h > 0.0 && h < 1.0 ? -0.5 * (d2.yzw + d1.yzw) / k : vec3(0.0);")
+			emit_raw_line ("    return vec4(mix(d2.x, -d1.x, h) + k * h * (1.0 - h),")
+			emit_raw_line ("        mix(d2.yzw, -d1.yzw, h) + (k * (1.0 - 2.0 * h) - d1.x - d2.x) * dh);")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_smooth_intersection_grad
+			-- Emit opSmoothIntersectionGrad function.
+		do
+			emit_raw_line ("vec4 opSmoothIntersectionGrad(vec4 d1, vec4 d2, float k) {")
+			emit_raw_line ("    float h = clamp(0.5 - 0.5 * (d2.x - d1.x) / k, 0.0, 1.0);")
+			emit_raw_line ("    vec3 dh = h > 0.0 && h < 1.0 ? -0.5 * (d2.yzw - d1.yzw) / k : vec3(0.0);")
+			emit_raw_line ("    return vec4(mix(d2.x, d1.x, h) + k * h * (1.0 - h),")
+			emit_raw_line ("        mix(d2.yzw, d1.yzw, h) + (k * (1.0 - 2.0 * h) + d1.x - d2.x) * dh);")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_all_gradients
+			-- Emit the *Grad twin of every primitive and operation.
+		do
+			emit_block_comment ("SDF Gradients: vec4(distance, gradient)")
+			emit_sphere_grad
+			emit_box_grad
+			emit_cylinder_grad
+			emit_capsule_grad
+			emit_torus_grad
+			emit_plane_grad
+			emit_cone_grad
+			emit_union_grad
+			emit_subtraction_grad
+			emit_intersection_grad
+			emit_smooth_union_grad
+			emit_smooth_subtraction_grad
+			emit_smooth_intersection_grad
+			emit_affine_grad
+		end
+
+	gradient_body (a_scene_sdf: STRING): STRING
+			-- `a_scene_sdf' rewritten to compute vec4(distance, gradient):
+			-- sd* and op* calls become their *Grad twins, float locals become
+			-- vec4 and numeric initializers become constants with zero gradient.
+		require
+			scene_sdf_attached: a_scene_sdf /= Void
+		local
+			l_line, l_value: STRING
+			l_start, l_eq, l_semi: INTEGER
+		do
+			create Result.make (a_scene_sdf.count * 2)
+			across a_scene_sdf.split ('%N') as ic loop
+				l_line := gradient_calls (ic.item)
+				across repetitions as r loop
+					l_line.replace_substring_all (r.item.name + "(", r.item.name + "Grad(")
+				end
+				from l_start := 1 until l_start > l_line.count or else not l_line [l_start].is_space loop
+					l_start := l_start + 1
+				end
+				if l_start + 5 <= l_line.count and then l_line.substring (l_start, l_start + 5).same_string ("float ") then
+					l_line.replace_substring ("vec4 ", l_start, l_start + 5)
+					l_eq := l_line.index_of ('=', l_start)
+					if l_eq > 0 then
+						l_semi := l_line.index_of (';', l_eq)
+						if l_semi > l_eq then
+							l_value := l_line.substring (l_eq + 1, l_semi - 1)
+							l_value.adjust
+							if l_value.is_double then
+								l_line.replace_substring (" vec4(" + l_value + ", 0.0, 0.0, 0.0)", l_eq + 1, l_semi - 1)
+							end
+						end
+					end
+				end
+				if not Result.is_empty then
+					Result.append_character ('%N')
+				end
+				Result.append (l_line)
+			end
+		end
+
+	gradient_calls (a_code: STRING): STRING
+			-- `a_code' with every sd* and op* call turned into its *Grad twin
+		require
+			code_attached: a_code /= Void
+		do
+			Result := a_code.twin
+			across Gradient_functions as f loop
+				Result.replace_substring_all (f.item + "(", f.item + "Grad(")
+			end
+		end
+
+	Gradient_functions: ARRAY [STRING]
+			-- Functions with a *Grad twin
+		once
+			Result := <<"sdSphere", "sdBox", "sdCylinder", "sdCapsule", "sdTorus", "sdPlane", "sdCone",
+				"opUnion", "opSubtraction", "opIntersection",
+				"opSmoothUnion", "opSmoothSubtraction", "opSmoothIntersection", "opAffine">>
 		end
 
 feature -- Shader Header
@@ -210,35 +765,52 @@ feature -- Shader Header
 			emit_raw_line ("    float cam_yaw, cam_pitch;")
 			emit_raw_line ("    float time;")
 			emit_raw_line ("    uint width, height;")
+			if is_temporal_reprojection or shading_rate /= Shading_rate_full then
+				emit_raw_line ("    float prev_x, prev_y, prev_z;")
+				emit_raw_line ("    float prev_yaw, prev_pitch;")
+				emit_raw_line ("    uint pass_index, frame_index;")
+			end
 			emit_raw_line ("};")
+			if is_temporal_reprojection then
+				emit_raw_line ("layout(std430, binding = 2) buffer DepthBuffer { float depth[]; };")
+				emit_raw_line ("layout(std430, binding = 3) buffer ReprojectedBuffer { uint reprojected[]; };")
+			end
 			newline
 		end
 
 feature -- Ray Marching
 
-	emit_ray_march_main
-			-- Emit standard ray marching main function.
+	emit_ray_direction
+			-- Emit `cameraBasis' (forward, right, up columns), `cameraDir'
+			-- and `rayDir', the current camera ray through a pixel.
 		do
-			emit_raw_line ("void main() {")
-			emit_raw_line ("    uvec2 gid = gl_GlobalInvocationID.xy;")
-			emit_raw_line ("    if (gid.x >= width || gid.y >= height) return;")
+			emit_raw_line ("mat3 cameraBasis(float yaw, float pitch) {")
+			emit_raw_line ("    float cy = cos(yaw), sy = sin(yaw);")
+			emit_raw_line ("    float cp = cos(pitch), sp = sin(pitch);")
+			emit_raw_line ("    vec3 forward = vec3(sy * cp, sp, -cy * cp);")
+			emit_raw_line ("    vec3 right = vec3(cy, 0, sy);")
+			emit_raw_line ("    return mat3(forward, right, cross(forward, right));")
+			emit_raw_line ("}")
 			newline
+			emit_raw_line ("vec3 cameraDir(vec2 pixel, mat3 basis) {")
 			emit_raw_line ("    // Screen UV coordinates")
-			emit_raw_line ("    vec2 uv = (vec2(gid) + 0.5) / vec2(width, height) * 2.0 - 1.0;")
+			emit_raw_line ("    vec2 uv = (pixel + 0.5) / vec2(width, height) * 2.0 - 1.0;")
 			emit_raw_line ("    uv.x *= float(width) / float(height);")
+			emit_raw_line ("    return normalize(basis[0] + basis[1] * uv.x + basis[2] * uv.y);")
+			emit_raw_line ("}")
 			newline
-			emit_raw_line ("    // Camera setup")
-			emit_raw_line ("    float cy = cos(cam_yaw), sy = sin(cam_yaw);")
-			emit_raw_line ("    float cp = cos(cam_pitch), sp = sin(cam_pitch);")
-			emit_raw_line ("    vec3 forward = vec3(sy * cp, sp, -cy * cp);")
-			emit_raw_line ("    vec3 right = vec3(cy, 0, sy);")
-			emit_raw_line ("    vec3 up = cross(forward, right);")
-			newline
-			emit_raw_line ("    vec3 ro = vec3(cam_x, cam_y, cam_z);")
-			emit_raw_line ("    vec3 rd = normalize(forward + right * uv.x + up * uv.y);")
+			emit_raw_line ("vec3 rayDir(vec2 pixel) {")
+			emit_raw_line ("    return cameraDir(pixel, cameraBasis(cam_yaw, cam_pitch));")
+			emit_raw_line ("}")
 			newline
+		end
+
+	emit_trace_ray
+			-- Emit `traceRay', which marches from depth `t' and returns the shaded
+			-- colour, leaving `t' at the hit (>= 200 on a miss) and `n' at its normal.
+		do
+			emit_raw_line ("vec3 traceRay(vec3 ro, vec3 rd, inout float t, out vec3 n) {")
 			emit_raw_line ("    // Ray march")
-			emit_raw_line ("    float t = 0.0;")
 			emit_raw_line ("    for (int i = 0; i < 128; i++) {")
 			emit_raw_line ("        vec3 p = ro + rd * t;")
 			emit_raw_line ("        float d = sceneSDF(p);")
@@ -248,40 +820,316 @@ feature -- Ray Marching
 			emit_raw_line ("    }")
 			newline
 			emit_raw_line ("    // Shading")
-			emit_raw_line ("    vec3 col;")
+			emit_raw_line ("    n = vec3(0.0, 1.0, 0.0);")
 			emit_raw_line ("    if (t < 200.0) {")
 			emit_raw_line ("        vec3 p = ro + rd * t;")
-			emit_raw_line ("        vec3 n = calcNormal(p);")
+			emit_raw_line ("        n = calcNormal(p);")
 			emit_raw_line ("        vec3 lightDir = normalize(vec3(1.0, 2.0, -1.0));")
 			emit_raw_line ("        float diff = max(dot(n, lightDir), 0.0);")
 			emit_raw_line ("        float amb = 0.2;")
-			emit_raw_line ("        col = vec3(0.8, 0.7, 0.6) * (diff + amb);")
-			emit_raw_line ("    } else {")
-			emit_raw_line ("        col = vec3(0.4, 0.6, 0.9);  // Sky color")
+			emit_raw_line ("        return vec3(0.8, 0.7, 0.6) * (diff + amb);")
 			emit_raw_line ("    }")
+			emit_raw_line ("    return vec3(0.4, 0.6, 0.9);  // Sky color")
+			emit_raw_line ("}")
 			newline
+			emit_raw_line ("void writePixel(ivec2 q, vec3 col) {")
 			emit_raw_line ("    // Output pixel (BGRA format)")
-			emit_raw_line ("    uint r = uint(clamp(col.r, 0.0, 1.0) * 255.0);")
-			emit_raw_line ("    uint g = uint(clamp(col.g, 0.0, 1.0) * 255.0);")
-			emit_raw_line ("    uint b = uint(clamp(col.b, 0.0, 1.0) * 255.0);")
-			emit_raw_line ("    pixels[gid.y * width + gid.x] = 0xFF000000u | (b << 16) | (g << 8) | r;")
+			emit_raw_line ("    if (q.x < int(width) && q.y < int(height)) {")
+			emit_raw_line ("        uint r = uint(clamp(col.r, 0.0, 1.0) * 255.0);")
+			emit_raw_line ("        uint g = uint(clamp(col.g, 0.0, 1.0) * 255.0);")
+			emit_raw_line ("        uint b = uint(clamp(col.b, 0.0, 1.0) * 255.0);")
+			emit_raw_line ("        pixels[uint(q.y) * width + uint(q.x)] = 0xFF000000u | (b << 16) | (g << 8) | r;")
+			emit_raw_line ("    }")
 			emit_raw_line ("}")
+			newline
+		end
+
+	emit_ray_march_main
+			-- Emit standard ray marching main function.
+		do
+			emit_ray_direction
+			emit_trace_ray
+			if shading_rate /= Shading_rate_full then
+				emit_variable_rate_main
+			else
+				if is_depth_prepass then
+					emit_depth_prepass
+				end
+				if is_temporal_reprojection then
+					emit_reprojection
+				end
+				emit_raw_line ("void main() {")
+				emit_raw_line ("    uvec2 gid = gl_GlobalInvocationID.xy;")
+				if is_temporal_reprojection then
+					emit_raw_line ("    if (pass_index == 0u) {")
+					emit_raw_line ("        if (gid.x < width && gid.y < height) reprojectDepth(gid);")
+					emit_raw_line ("        return;")
+					emit_raw_line ("    }")
+				end
+				emit_raw_line ("    vec3 ro = vec3(cam_x, cam_y, cam_z);")
+				if is_depth_prepass then
+					emit_depth_prepass_call
+				else
+					emit_raw_line ("    if (gid.x >= width || gid.y >= height) return;")
+					emit_raw_line ("    float t = 0.0;")
+				end
+				emit_raw_line ("    vec3 rd = rayDir(vec2(gid));")
+				if is_temporal_reprojection then
+					emit_reprojected_start
+				end
+				emit_raw_line ("    vec3 n;")
+				emit_raw_line ("    vec3 col = traceRay(ro, rd, t, n);")
+				if is_temporal_reprojection then
+					emit_raw_line ("    depth[gid.y * width + gid.x] = t;")
+				end
+				emit_raw_line ("    writePixel(ivec2(gid), col);")
+				emit_raw_line ("}")
+			end
 		end
 
 	emit_calc_normal
-			-- Emit surface normal calculation function.
+			-- Emit surface normal calculation function: the normalized
+			-- gradient of `sceneSDFGrad' with `is_analytic_normals' (up
+			-- where it vanishes), else central differences of `sceneSDF'.
 		do
 			emit_raw_line ("vec3 calcNormal(vec3 p) {")
-			emit_raw_line ("    const float e = 0.001;")
-			emit_raw_line ("    return normalize(vec3(")
-			emit_raw_line ("        sceneSDF(p + vec3(e, 0, 0)) - sceneSDF(p - vec3(e, 0, 0)),")
-			emit_raw_line ("        sceneSDF(p + vec3(0, e, 0)) - sceneSDF(p - vec3(0, e, 0)),")
-			emit_raw_line ("        sceneSDF(p + vec3(0, 0, e)) - sceneSDF(p - vec3(0, 0, e))")
-			emit_raw_line ("    ));")
+			if is_analytic_normals then
+				emit_raw_line ("    vec3 g = sceneSDFGrad(p).yzw;")
+				emit_raw_line ("    return dot(g, g) > 0.0 ? normalize(g) : vec3(0.0, 1.0, 0.0);")
+			else
+				emit_raw_line ("    const float e = 0.001;")
+				emit_raw_line ("    return normalize(vec3(")
+				emit_raw_line ("        sceneSDF(p + vec3(e, 0, 0)) - sceneSDF(p - vec3(e, 0, 0)),")
+				emit_raw_line ("        sceneSDF(p + vec3(0, e, 0)) - sceneSDF(p - vec3(0, e, 0)),")
+				emit_raw_line ("        sceneSDF(p + vec3(0, 0, e)) - sceneSDF(p - vec3(0, 0, e))")
+				emit_raw_line ("    ));")
+			end
+			emit_raw_line ("}")
+			newline
+		end
+
+feature -- Depth Pre-Pass
+
+	emit_depth_prepass
+			-- Emit `coneMarch' and the shared depth arrays of one workgroup tile.
+			-- A cone around `axis' with width `spread' holds every ray of its pixel
+			-- block within t * spread of the axis point at depth t, so a step of
+			-- sceneSDF - t * spread is empty for all of them.
+		local
+			l_coarse_row, l_fine_row: INTEGER
+		do
+			l_coarse_row := Work_group_size // Cone_coarse
+			l_fine_row := Work_group_size // Cone_fine
+			emit_raw_line ("shared float coarseDepth[" + (l_coarse_row * l_coarse_row).out + "];")
+			emit_raw_line ("shared float fineDepth[" + (l_fine_row * l_fine_row).out + "];")
+			newline
+			emit_raw_line ("// Depth up to which every ray through pixels [lo, hi] is empty, from safe depth t")
+			emit_raw_line ("float coneMarch(vec3 ro, vec2 lo, vec2 hi, float t) {")
+			emit_raw_line ("    vec3 d0 = rayDir(lo), d1 = rayDir(vec2(hi.x, lo.y));")
+			emit_raw_line ("    vec3 d2 = rayDir(vec2(lo.x, hi.y)), d3 = rayDir(hi);")
+			emit_raw_line ("    vec3 axis = normalize(d0 + d1 + d2 + d3);")
+			emit_raw_line ("    float spread = max(max(length(d0 - axis), length(d1 - axis)),")
+			emit_raw_line ("                       max(length(d2 - axis), length(d3 - axis))) * 1.001 + 1e-5;")
+			emit_raw_line ("    for (int i = 0; i < 32 && t <= 200.0; i++) {")
+			emit_raw_line ("        float gap = sceneSDF(ro + axis * t) - t * spread;")
+			emit_raw_line ("        if (gap < 0.001) break;")
+			emit_raw_line ("        t += gap;")
+			emit_raw_line ("    }")
+			emit_raw_line ("    return t;")
+			emit_raw_line ("}")
+			newline
+		end
+
+	emit_depth_prepass_call
+			-- Emit the two pre-pass levels at the start of `main' and set `t'
+			-- to the fine cone depth of the invocation's pixel. Out-of-bounds
+			-- invocations return only after both barriers.
+		local
+			l_coarse_row, l_fine_row, l_ratio: STRING
+		do
+			l_coarse_row := (Work_group_size // Cone_coarse).out + "u"
+			l_fine_row := (Work_group_size // Cone_fine).out + "u"
+			l_ratio := (Cone_coarse // Cone_fine).out + "u"
+			emit_raw_line ("    uvec2 lid = gl_LocalInvocationID.xy;")
+			emit_raw_line ("    vec2 tileBase = vec2(gl_WorkGroupID.xy * " + Work_group_size.out + "u);")
+			newline
+			emit_raw_line ("    // Depth pre-pass: " + Cone_coarse.out + "x" + Cone_coarse.out + " block cones, then "
+				+ Cone_fine.out + "x" + Cone_fine.out + " block cones from their depth")
+			emit_raw_line ("    if (lid.x < " + l_coarse_row + " && lid.y < " + l_coarse_row + ") {")
+			emit_raw_line ("        vec2 lo = tileBase + vec2(lid * " + Cone_coarse.out + "u);")
+			emit_raw_line ("        coarseDepth[lid.y * " + l_coarse_row + " + lid.x] = coneMarch(ro, lo, lo + "
+				+ (Cone_coarse - 1).out + ".0, 0.0);")
+			emit_raw_line ("    }")
+			emit_raw_line ("    barrier();")
+			emit_raw_line ("    if (lid.x < " + l_fine_row + " && lid.y < " + l_fine_row + ") {")
+			emit_raw_line ("        vec2 lo = tileBase + vec2(lid * " + Cone_fine.out + "u);")
+			emit_raw_line ("        float coarse = coarseDepth[(lid.y / " + l_ratio + ") * " + l_coarse_row
+				+ " + lid.x / " + l_ratio + "];")
+			emit_raw_line ("        fineDepth[lid.y * " + l_fine_row + " + lid.x] = coarse <= 200.0 ? coneMarch(ro, lo, lo + "
+				+ (Cone_fine - 1).out + ".0, coarse) : coarse;")
+			emit_raw_line ("    }")
+			emit_raw_line ("    barrier();")
+			emit_raw_line ("    if (gid.x >= width || gid.y >= height) return;")
+			emit_raw_line ("    float t = fineDepth[(lid.y / " + Cone_fine.out + "u) * " + l_fine_row
+				+ " + lid.x / " + Cone_fine.out + "u];")
+		end
+
+feature -- Temporal Reprojection
+
+	Reprojection_empty: STRING = "0x7F800000u"
+			-- Bits of +infinity: a pixel no previous-frame surface reprojected to.
+
+	emit_reprojection
+			-- Emit `reprojectDepth', the first of the two dispatches of a frame.
+			-- It carries the previous frame's surface point of a pixel into the
+			-- current camera and splats its distance onto the 2x2 pixels around
+			-- the projected point, so surfaces that grow on screen leave no gaps
+			-- for the background to show through. Positive floats order like
+			-- their bits, so atomicMin on the bits keeps the nearest sample.
+		do
+			emit_raw_line ("void reprojectDepth(uvec2 gid) {")
+			emit_raw_line ("    float d = depth[gid.y * width + gid.x];")
+			emit_raw_line ("    if (d <= 0.0 || d >= 200.0) return;  // No depth yet, or sky")
+			emit_raw_line ("    vec3 p = vec3(prev_x, prev_y, prev_z) + cameraDir(vec2(gid), cameraBasis(prev_yaw, prev_pitch)) * d;")
+			emit_raw_line ("    mat3 basis = cameraBasis(cam_yaw, cam_pitch);")
+			emit_raw_line ("    vec3 v = p - vec3(cam_x, cam_y, cam_z);")
+			emit_raw_line ("    float z = dot(v, basis[0]);")
+			emit_raw_line ("    if (z <= 0.0) return;")
+			emit_raw_line ("    vec2 uv = vec2(dot(v, basis[1]), dot(v, basis[2])) / z;")
+			emit_raw_line ("    uv.x *= float(height) / float(width);")
+			emit_raw_line ("    ivec2 base = ivec2(floor((uv + 1.0) * 0.5 * vec2(width, height) - 0.5));")
+			emit_raw_line ("    uint bits = floatBitsToUint(length(v));")
+			emit_raw_line ("    for (int k = 0; k < 4; k++) {")
+			emit_raw_line ("        ivec2 q = base + ivec2(k & 1, k >> 1);")
+			emit_raw_line ("        if (q.x >= 0 && q.y >= 0 && q.x < int(width) && q.y < int(height))")
+			emit_raw_line ("            atomicMin(reprojected[uint(q.y) * width + uint(q.x)], bits);")
+			emit_raw_line ("    }")
 			emit_raw_line ("}")
 			newline
 		end
 
+	emit_reprojected_start
+			-- Emit the move of `t' to just short of the pixel's reprojected depth,
+			-- backed off by 1% plus 0.01 for the spacing between samples. A
+			-- pixel nothing reprojected to (disocclusion, screen edge) or whose
+			-- start point lies inside geometry marches from `t' as before. The
+			-- pixel's entry is cleared for the next frame.
+		do
+			emit_raw_line ("    uint seen = reprojected[gid.y * width + gid.x];")
+			emit_raw_line ("    reprojected[gid.y * width + gid.x] = " + Reprojection_empty + ";")
+			emit_raw_line ("    if (seen != " + Reprojection_empty + ") {")
+			emit_raw_line ("        float s = uintBitsToFloat(seen) * 0.99 - 0.01;")
+			emit_raw_line ("        if (s > t && sceneSDF(ro + rd * s) > 0.0) t = s;")
+			emit_raw_line ("    }")
+		end
+
+feature -- Variable-Rate Shading
+
+	emit_variable_rate_main
+			-- Emit the reduced-rate main function. Each invocation owns a 2x1
+			-- (checkerboard) or 2x2 (quarter) pixel block: it marches one pixel
+			-- into shared memory, then after the barrier rebuilds the others
+			-- from marched neighbours of the same workgroup, marching them only
+			-- where those do not lie on one smooth surface.
+		local
+			l_shift_y: STRING
+		do
+			if shading_rate = Shading_rate_quarter then
+				l_shift_y := "1"
+			else
+				l_shift_y := "0"
+			end
+			emit_raw_line ("shared float rateDepth[" + (Work_group_size * Work_group_size).out + "];")
+			emit_raw_line ("shared vec3 rateNormal[" + (Work_group_size * Work_group_size).out + "];")
+			emit_raw_line ("shared vec3 rateColor[" + (Work_group_size * Work_group_size).out + "];")
+			newline
+			emit_raw_line ("// Marched sample of pixel q, if this workgroup marched it")
+			emit_raw_line ("bool rateSample(ivec2 q, out float d, out vec3 n, out vec3 c) {")
+			emit_raw_line ("    ivec2 l = ivec2(q.x >> 1, q.y >> " + l_shift_y + ") - ivec2(gl_WorkGroupID.xy * "
+				+ Work_group_size.out + "u);")
+			emit_raw_line ("    if (q.x >= int(width) || q.y >= int(height) || any(lessThan(l, ivec2(0)))")
+			emit_raw_line ("        || any(greaterThanEqual(l, ivec2(" + Work_group_size.out + ")))) return false;")
+			emit_raw_line ("    int i = l.y * " + Work_group_size.out + " + l.x;")
+			emit_raw_line ("    d = rateDepth[i];")
+			emit_raw_line ("    n = rateNormal[i];")
+			emit_raw_line ("    c = rateColor[i];")
+			emit_raw_line ("    return true;")
+			emit_raw_line ("}")
+			newline
+			emit_raw_line ("// Colour of pixel q from marched neighbours q +- s1 (and q +- s2 unless zero):")
+			emit_raw_line ("// the sky if all miss, their average if all hit one smooth surface")
+			emit_raw_line ("bool reconstructPixel(vec3 ro, ivec2 q, ivec2 s1, ivec2 s2, out vec3 col) {")
+			emit_raw_line ("    ivec2 src[4] = ivec2[4](q + s1, q - s1, q + s2, q - s2);")
+			emit_raw_line ("    int count = s2 == ivec2(0) ? 2 : 4;")
+			emit_raw_line ("    int used = 0, hits = 0;")
+			emit_raw_line ("    vec3 p0 = vec3(0.0), n0 = vec3(0.0);")
+			emit_raw_line ("    bool onSurface = true;")
+			emit_raw_line ("    col = vec3(0.0);")
+			emit_raw_line ("    for (int k = 0; k < count; k++) {")
+			emit_raw_line ("        float d;")
+			emit_raw_line ("        vec3 n, c;")
+			emit_raw_line ("        if (!rateSample(src[k], d, n, c)) continue;")
+			emit_raw_line ("        if (d < 200.0) {")
+			emit_raw_line ("            vec3 p = ro + rayDir(vec2(src[k])) * d;")
+			emit_raw_line ("            if (hits == 0) { p0 = p; n0 = n; }")
+			emit_raw_line ("            onSurface = onSurface && dot(n, n0) >= 0.95 && abs(dot(p - p0, n0)) <= 0.01 * d;")
+			emit_raw_line ("            hits++;")
+			emit_raw_line ("        }")
+			emit_raw_line ("        col += c;")
+			emit_raw_line ("        used++;")
+			emit_raw_line ("    }")
+			emit_raw_line ("    col /= float(max(used, 1));")
+			emit_raw_line ("    return used >= 2 && (hits == 0 || (hits == used && onSurface));")
+			emit_raw_line ("}")
+			newline
+			emit_raw_line ("void main() {")
+			emit_raw_line ("    uvec2 gid = gl_GlobalInvocationID.xy;")
+			emit_raw_line ("    uvec2 lid = gl_LocalInvocationID.xy;")
+			emit_raw_line ("    vec3 ro = vec3(cam_x, cam_y, cam_z);")
+			if shading_rate = Shading_rate_quarter then
+				emit_raw_line ("    ivec2 block = ivec2(gid * 2u);")
+				emit_raw_line ("    ivec2 phase = ivec2(frame_index & 1u, (frame_index >> 1) & 1u);")
+			else
+				emit_raw_line ("    ivec2 block = ivec2(gid.x * 2u, gid.y);")
+				emit_raw_line ("    ivec2 phase = ivec2((gid.y + frame_index) & 1u, 0);")
+			end
+			newline
+			emit_raw_line ("    // March this invocation's pixel of the pattern")
+			emit_raw_line ("    ivec2 own = block + phase;")
+			emit_raw_line ("    float t = 0.0;")
+			emit_raw_line ("    vec3 n;")
+			emit_raw_line ("    vec3 col = traceRay(ro, rayDir(vec2(own)), t, n);")
+			emit_raw_line ("    uint li = lid.y * " + Work_group_size.out + "u + lid.x;")
+			emit_raw_line ("    rateDepth[li] = t;")
+			emit_raw_line ("    rateNormal[li] = n;")
+			emit_raw_line ("    rateColor[li] = col;")
+			emit_raw_line ("    barrier();")
+			emit_raw_line ("    writePixel(own, col);")
+			newline
+			emit_raw_line ("    // Rebuild the rest of the block, marching at edges")
+			if shading_rate = Shading_rate_quarter then
+				emit_raw_line ("    for (int k = 1; k < 4; k++) {")
+				emit_raw_line ("        ivec2 delta = ivec2(k & 1, k >> 1);")
+				emit_raw_line ("        ivec2 q = block + ((phase + delta) & 1);")
+				emit_raw_line ("        ivec2 s1 = delta.y == 0 ? ivec2(1, 0) : (delta.x == 0 ? ivec2(0, 1) : ivec2(1, 1));")
+				emit_raw_line ("        ivec2 s2 = delta == ivec2(1) ? ivec2(1, -1) : ivec2(0);")
+				emit_raw_line ("        if (!reconstructPixel(ro, q, s1, s2, col)) {")
+				emit_raw_line ("            t = 0.0;")
+				emit_raw_line ("            col = traceRay(ro, rayDir(vec2(q)), t, n);")
+				emit_raw_line ("        }")
+				emit_raw_line ("        writePixel(q, col);")
+				emit_raw_line ("    }")
+			else
+				emit_raw_line ("    ivec2 q = block + ivec2(1 - phase.x, 0);")
+				emit_raw_line ("    if (!reconstructPixel(ro, q, ivec2(1, 0), ivec2(0, 1), col)) {")
+				emit_raw_line ("        t = 0.0;")
+				emit_raw_line ("        col = traceRay(ro, rayDir(vec2(q)), t, n);")
+				emit_raw_line ("    }")
+				emit_raw_line ("    writePixel(q, col);")
+			end
+			emit_raw_line ("}")
+		end
+
 feature -- Full Shader Generation
 
 	generate_basic_shader (a_scene_sdf: STRING): STRING
@@ -292,9 +1140,10 @@ feature -- Full Shader Generation
 			output.wipe_out
 			indent_level := 0
 
-			emit_compute_header (16, 16)
+			emit_compute_header (Work_group_size, Work_group_size)
 			emit_all_primitives
 			emit_all_operations
+			emit_all_repetitions (False)
 
 			-- Scene SDF function
 			emit_raw_line ("float sceneSDF(vec3 p) {")
@@ -302,6 +1151,15 @@ feature -- Full Shader Generation
 			emit_raw_line ("}")
 			newline
 
+			if is_analytic_normals then
+				emit_all_gradients
+				emit_all_repetitions (True)
+				emit_raw_line ("vec4 sceneSDFGrad(vec3 p) {")
+				emit_raw_line (gradient_body (a_scene_sdf))
+				emit_raw_line ("}")
+				newline
+			end
+
 			emit_calc_normal
 			emit_ray_march_main
 
@@ -0,0 +1,244 @@
+note
+	description: "[
+		Closed interval [lo, hi] of REAL_64 with conservative arithmetic.
+
+		Every operation returns an interval that contains the result of
+		the same operation applied to any values taken from the operands,
+		so a distance computed on intervals bounds the true distance over
+		a whole region of space. Expanded: intervals are values and never
+		touch the GC heap.
+
+		Design by Contract:
+		- lo <= hi
+		- Bounds are never NaN
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+expanded class
+	SDF_INTERVAL
+
+create
+	default_create,
+	make,
+	make_point
+
+feature {NONE} -- Initialization
+
+	make (a_lo, a_hi: REAL_64)
+			-- Create [a_lo, a_hi].
+		require
+			ordered: a_lo <= a_hi
+		do
+			lo := a_lo
+			hi := a_hi
+		ensure
+			lo_set: lo = a_lo
+			hi_set: hi = a_hi
+		end
+
+	make_point (a_value: REAL_64)
+			-- Create degenerate interval [a_value, a_value].
+		do
+			lo := a_value
+			hi := a_value
+		ensure
+			lo_set: lo = a_value
+			hi_set: hi = a_value
+		end
+
+feature -- Access
+
+	lo: REAL_64
+			-- Lower bound
+
+	hi: REAL_64
+			-- Upper bound
+
+	width: REAL_64
+			-- hi - lo
+		do
+			Result := hi - lo
+		ensure
+			non_negative: Result >= 0.0
+		end
+
+	middle: REAL_64
+			-- Midpoint
+		do
+			Result := lo * 0.5 + hi * 0.5
+		end
+
+feature -- Status report
+
+	has (a_value: REAL_64): BOOLEAN
+			-- Does the interval contain `a_value'?
+		do
+			Result := a_value >= lo and a_value <= hi
+		end
+
+	is_positive: BOOLEAN
+			-- Is every value > 0?
+		do
+			Result := lo > 0.0
+		end
+
+	is_negative: BOOLEAN
+			-- Is every value < 0?
+		do
+			Result := hi < 0.0
+		end
+
+feature -- Arithmetic
+
+	plus alias "+" (other: SDF_INTERVAL): SDF_INTERVAL
+			-- Sum
+		do
+			Result.set (lo + other.lo, hi + other.hi)
+		end
+
+	minus alias "-" (other: SDF_INTERVAL): SDF_INTERVAL
+			-- Difference
+		do
+			Result.set (lo - other.hi, hi - other.lo)
+		end
+
+	product alias "*" (other: SDF_INTERVAL): SDF_INTERVAL
+			-- Product
+		local
+			a, b, c, d: REAL_64
+		do
+			a := lo * other.lo
+			b := lo * other.hi
+			c := hi * other.lo
+			d := hi * other.hi
+			Result.set (a.min (b).min (c).min (d), a.max (b).max (c).max (d))
+		end
+
+	opposite alias "-": SDF_INTERVAL
+			-- Negation
+		do
+			Result.set (- hi, - lo)
+		end
+
+	plus_value (a_value: REAL_64): SDF_INTERVAL
+			-- Shifted by `a_value'
+		do
+			Result.set (lo + a_value, hi + a_value)
+		end
+
+	scaled (a_factor: REAL_64): SDF_INTERVAL
+			-- Multiplied by `a_factor'
+		do
+			if a_factor >= 0.0 then
+				Result.set (lo * a_factor, hi * a_factor)
+			else
+				Result.set (hi * a_factor, lo * a_factor)
+			end
+		end
+
+	squared: SDF_INTERVAL
+			-- Square (tight when the interval straddles zero)
+		do
+			if lo >= 0.0 then
+				Result.set (lo * lo, hi * hi)
+			elseif hi <= 0.0 then
+				Result.set (hi * hi, lo * lo)
+			else
+				Result.set (0.0, (lo * lo).max (hi * hi))
+			end
+		ensure
+			non_negative: Result.lo >= 0.0
+		end
+
+	square_root: SDF_INTERVAL
+			-- Square root of the non-negative part
+		do
+			Result.set ({DOUBLE_MATH}.sqrt (lo.max (0.0)), {DOUBLE_MATH}.sqrt (hi.max (0.0)))
+		ensure
+			non_negative: Result.lo >= 0.0
+		end
+
+	absolute: SDF_INTERVAL
+			-- Absolute value
+		do
+			if lo >= 0.0 then
+				Result := Current
+			elseif hi <= 0.0 then
+				Result.set (- hi, - lo)
+			else
+				Result.set (0.0, (- lo).max (hi))
+			end
+		ensure
+			non_negative: Result.lo >= 0.0
+		end
+
+feature -- Comparison operations
+
+	min (other: SDF_INTERVAL): SDF_INTERVAL
+			-- Range of min (a, b)
+		do
+			Result.set (lo.min (other.lo), hi.min (other.hi))
+		end
+
+	max (other: SDF_INTERVAL): SDF_INTERVAL
+			-- Range of max (a, b)
+		do
+			Result.set (lo.max (other.lo), hi.max (other.hi))
+		end
+
+	min_value (a_value: REAL_64): SDF_INTERVAL
+			-- Range of min (a, `a_value')
+		do
+			Result.set (lo.min (a_value), hi.min (a_value))
+		end
+
+	max_value (a_value: REAL_64): SDF_INTERVAL
+			-- Range of max (a, `a_value')
+		do
+			Result.set (lo.max (a_value), hi.max (a_value))
+		end
+
+	clamped (a_lo, a_hi: REAL_64): SDF_INTERVAL
+			-- Range of clamp (a, a_lo, a_hi)
+		require
+			ordered: a_lo <= a_hi
+		do
+			Result := max_value (a_lo).min_value (a_hi)
+		end
+
+	hull (other: SDF_INTERVAL): SDF_INTERVAL
+			-- Smallest interval containing both
+		do
+			Result.set (lo.min (other.lo), hi.max (other.hi))
+		end
+
+feature -- Element change
+
+	set (a_lo, a_hi: REAL_64)
+			-- Set bounds.
+		require
+			ordered: a_lo <= a_hi
+		do
+			lo := a_lo
+			hi := a_hi
+		ensure
+			lo_set: lo = a_lo
+			hi_set: hi = a_hi
+		end
+
+feature -- Output
+
+	out_interval: STRING
+			-- "[lo, hi]"
+		do
+			Result := "[" + lo.out + ", " + hi.out + "]"
+		end
+
+invariant
+	ordered: lo <= hi
+	lo_is_valid: not lo.is_nan
+	hi_is_valid: not hi.is_nan
+
+end
@@ -15,6 +15,28 @@ note
 		The blend radius k controls smoothness:
 		- k = 0: exact (sharp) operation
 		- k > 0: smooth transition over distance k
+
+		Interval forms (interval_*) take distance ranges over a region
+		and return a range containing the operation's result for any
+		distances drawn from them. All operations here are monotone in
+		each argument, so the bounds come from combining endpoints.
+
+		Lipschitz forms (lipschitz_*) take the Lipschitz bounds of the
+		input fields and return one for the result. The smooth blends
+		return a bound rather than an exact distance, but their gradient
+		is a convex combination of the input gradients (weights 1 - h/2
+		and h/2 for the quadratic blend, 1 - h^2/2 and h^2/2 for the
+		cubic one), so they never change faster than the steeper input.
+
+		Dual forms (dual_*) apply the operation to SDF_DUAL distances,
+		carrying the gradient through the blend for single-pass normals.
+
+		Domain repetition (repeat_*, op_*repeat) maps a point into one
+		cell of an infinite, limited or mirrored grid of copies, so a
+		child is evaluated once per sample however many copies there
+		are. A spacing of 0 leaves that axis alone. SDF_REPETITION wraps
+		a shape with these maps and checks neighbouring cells where the
+		shape crosses a cell border.
 	]"
 	author: "Larry Rix"
 	date: "$Date$"
@@ -121,6 +143,237 @@ feature -- Cubic Smooth Operations (smoother transitions)
 			end
 		end
 
+feature -- Interval Operations
+
+	interval_union (d1, d2: SDF_INTERVAL): SDF_INTERVAL
+			-- Range of `op_union' over `d1' and `d2'.
+		do
+			Result := d1.min (d2)
+		end
+
+	interval_subtraction (d1, d2: SDF_INTERVAL): SDF_INTERVAL
+			-- Range of `op_subtraction' (d1 cuts from d2).
+		do
+			Result := (- d1).max (d2)
+		end
+
+	interval_intersection (d1, d2: SDF_INTERVAL): SDF_INTERVAL
+			-- Range of `op_intersection'.
+		do
+			Result := d1.max (d2)
+		end
+
+	interval_xor (d1, d2: SDF_INTERVAL): SDF_INTERVAL
+			-- Range of `op_xor'.
+		do
+			Result := d1.min (d2).max (- d1.max (d2))
+		end
+
+	interval_smooth_union (d1, d2: SDF_INTERVAL; k: REAL_64): SDF_INTERVAL
+			-- Range of `smooth_union' (non-decreasing in both distances).
+		require
+			non_negative_k: k >= 0.0
+		do
+			Result.set (smooth_union (d1.lo, d2.lo, k), smooth_union (d1.hi, d2.hi, k))
+		end
+
+	interval_smooth_subtraction (d1, d2: SDF_INTERVAL; k: REAL_64): SDF_INTERVAL
+			-- Range of `smooth_subtraction' (non-increasing in d1, non-decreasing in d2).
+		require
+			non_negative_k: k >= 0.0
+		do
+			Result.set (smooth_subtraction (d1.hi, d2.lo, k), smooth_subtraction (d1.lo, d2.hi, k))
+		end
+
+	interval_smooth_intersection (d1, d2: SDF_INTERVAL; k: REAL_64): SDF_INTERVAL
+			-- Range of `smooth_intersection' (non-decreasing in both distances).
+		require
+			non_negative_k: k >= 0.0
+		do
+			Result.set (smooth_intersection (d1.lo, d2.lo, k), smooth_intersection (d1.hi, d2.hi, k))
+		end
+
+	interval_smooth_union_cubic (d1, d2: SDF_INTERVAL; k: REAL_64): SDF_INTERVAL
+			-- Range of `smooth_union_cubic'.
+		require
+			non_negative_k: k >= 0.0
+		do
+			Result.set (smooth_union_cubic (d1.lo, d2.lo, k), smooth_union_cubic (d1.hi, d2.hi, k))
+		end
+
+	interval_round (d: SDF_INTERVAL; r: REAL_64): SDF_INTERVAL
+			-- Range of `round'.
+		do
+			Result := d.plus_value (- r)
+		end
+
+	interval_onion (d: SDF_INTERVAL; thickness: REAL_64): SDF_INTERVAL
+			-- Range of `onion'.
+		require
+			positive_thickness: thickness > 0.0
+		do
+			Result := d.absolute.plus_value (- thickness)
+		end
+
+feature -- Dual Operations
+
+	dual_union (d1, d2: SDF_DUAL): SDF_DUAL
+			-- `op_union' with gradient.
+		do
+			Result := d1.min (d2)
+		end
+
+	dual_subtraction (d1, d2: SDF_DUAL): SDF_DUAL
+			-- `op_subtraction' (d1 cuts from d2) with gradient.
+		do
+			Result := (- d1).max (d2)
+		end
+
+	dual_intersection (d1, d2: SDF_DUAL): SDF_DUAL
+			-- `op_intersection' with gradient.
+		do
+			Result := d1.max (d2)
+		end
+
+	dual_smooth_union (d1, d2: SDF_DUAL; k: REAL_64): SDF_DUAL
+			-- `smooth_union' with gradient.
+		require
+			non_negative_k: k >= 0.0
+		do
+			if k <= 0.0 then
+				Result := dual_union (d1, d2)
+			else
+				Result := d1.min (d2) - dual_blend (d1, d2, k)
+			end
+		end
+
+	dual_smooth_subtraction (d1, d2: SDF_DUAL; k: REAL_64): SDF_DUAL
+			-- `smooth_subtraction' with gradient.
+		require
+			non_negative_k: k >= 0.0
+		do
+			if k <= 0.0 then
+				Result := dual_subtraction (d1, d2)
+			else
+				Result := (- d1).max (d2) + dual_blend (- d1, d2, k)
+			end
+		end
+
+	dual_smooth_intersection (d1, d2: SDF_DUAL; k: REAL_64): SDF_DUAL
+			-- `smooth_intersection' with gradient.
+		require
+			non_negative_k: k >= 0.0
+		do
+			if k <= 0.0 then
+				Result := dual_intersection (d1, d2)
+			else
+				Result := d1.max (d2) + dual_blend (d1, d2, k)
+			end
+		end
+
+	dual_smooth_union_cubic (d1, d2: SDF_DUAL; k: REAL_64): SDF_DUAL
+			-- `smooth_union_cubic' with gradient.
+		require
+			non_negative_k: k >= 0.0
+		local
+			h: SDF_DUAL
+		do
+			if k <= 0.0 then
+				Result := dual_union (d1, d2)
+			else
+				h := (- (d1 - d2).absolute).plus_value (k).max_value (0.0).scaled (1.0 / k)
+				Result := d1.min (d2) - (h.squared * h).scaled (k * (1.0 / 6.0))
+			end
+		end
+
+	dual_round (d: SDF_DUAL; r: REAL_64): SDF_DUAL
+			-- `round' with gradient.
+		do
+			Result := d.plus_value (- r)
+		end
+
+	dual_onion (d: SDF_DUAL; thickness: REAL_64): SDF_DUAL
+			-- `onion' with gradient.
+		require
+			positive_thickness: thickness > 0.0
+		do
+			Result := d.absolute.plus_value (- thickness)
+		end
+
+feature -- Lipschitz Bounds
+
+	lipschitz_union (l1, l2: REAL_64): REAL_64
+			-- Lipschitz bound of `op_union' of fields bounded by `l1' and `l2'.
+		require
+			positive_l1: l1 > 0.0
+			positive_l2: l2 > 0.0
+		do
+			Result := l1.max (l2)
+		ensure
+			positive: Result > 0.0
+		end
+
+	lipschitz_subtraction (l1, l2: REAL_64): REAL_64
+			-- Lipschitz bound of `op_subtraction'.
+		require
+			positive_l1: l1 > 0.0
+			positive_l2: l2 > 0.0
+		do
+			Result := l1.max (l2)
+		ensure
+			positive: Result > 0.0
+		end
+
+	lipschitz_intersection (l1, l2: REAL_64): REAL_64
+			-- Lipschitz bound of `op_intersection'.
+		require
+			positive_l1: l1 > 0.0
+			positive_l2: l2 > 0.0
+		do
+			Result := l1.max (l2)
+		ensure
+			positive: Result > 0.0
+		end
+
+	lipschitz_smooth (l1, l2, k: REAL_64): REAL_64
+			-- Lipschitz bound of `smooth_union', `smooth_subtraction',
+			-- `smooth_intersection' and `smooth_union_cubic' with radius `k'.
+		require
+			positive_l1: l1 > 0.0
+			positive_l2: l2 > 0.0
+			non_negative_k: k >= 0.0
+		do
+			Result := l1.max (l2)
+		ensure
+			positive: Result > 0.0
+		end
+
+	lipschitz_round (l: REAL_64): REAL_64
+			-- Lipschitz bound of `round' (an offset does not change slopes).
+		require
+			positive: l > 0.0
+		do
+			Result := l
+		end
+
+	lipschitz_onion (l: REAL_64): REAL_64
+			-- Lipschitz bound of `onion' (|d| has the slopes of d).
+		require
+			positive: l > 0.0
+		do
+			Result := l
+		end
+
+	lipschitz_elongate (l: REAL_64): REAL_64
+			-- Lipschitz bound of a field evaluated at `elongate_x', `elongate_y'
+			-- or `elongate_z' of the point (the remap moves points no farther
+			-- apart).
+		require
+			positive: l > 0.0
+		do
+			Result := l
+		end
+
 feature -- Utility Functions
 
 	clamp (value, min_val, max_val: REAL_64): REAL_64
@@ -198,4 +451,100 @@ feature -- Distance Modifications
 			)
 		end
 
+feature -- Domain Repetition
+
+	repeat_cell (x, spacing: REAL_64): INTEGER
+			-- Index of the cell holding coordinate `x', cells centred on
+			-- multiples of `spacing' (0 if `spacing' is 0).
+		require
+			non_negative_spacing: spacing >= 0.0
+		do
+			if spacing > 0.0 then
+				Result := (x / spacing).rounded
+			end
+		end
+
+	limited_repeat_cell (x, spacing: REAL_64; a_limit: INTEGER): INTEGER
+			-- `repeat_cell' clamped to -`a_limit' .. `a_limit'.
+		require
+			non_negative_spacing: spacing >= 0.0
+			non_negative_limit: a_limit >= 0
+		do
+			Result := repeat_cell (x, spacing).max (- a_limit).min (a_limit)
+		ensure
+			in_range: Result.abs <= a_limit
+		end
+
+	repeat_local (x, spacing: REAL_64; a_cell: INTEGER): REAL_64
+			-- `x' relative to the centre of cell `a_cell'.
+		do
+			Result := x - spacing * a_cell
+		end
+
+	mirrored_repeat_local (x, spacing: REAL_64; a_cell: INTEGER): REAL_64
+			-- `repeat_local', flipped in odd cells so that neighbouring
+			-- copies mirror each other and meet seamlessly.
+		do
+			Result := x - spacing * a_cell
+			if a_cell \\ 2 /= 0 then
+				Result := - Result
+			end
+		end
+
+	op_repeat (p, spacing: SDF_VEC3): SDF_VEC3
+			-- `p' in the nearest cell of an infinite grid.
+		require
+			p_attached: p /= Void
+			spacing_attached: spacing /= Void
+			non_negative_spacing: spacing.x >= 0.0 and spacing.y >= 0.0 and spacing.z >= 0.0
+		do
+			create Result.make (
+				repeat_local (p.x, spacing.x, repeat_cell (p.x, spacing.x)),
+				repeat_local (p.y, spacing.y, repeat_cell (p.y, spacing.y)),
+				repeat_local (p.z, spacing.z, repeat_cell (p.z, spacing.z))
+			)
+		end
+
+	op_limited_repeat (p, spacing: SDF_VEC3; a_limit_x, a_limit_y, a_limit_z: INTEGER): SDF_VEC3
+			-- `p' in the nearest cell of a grid of (2 * limit + 1) cells per axis.
+		require
+			p_attached: p /= Void
+			spacing_attached: spacing /= Void
+			non_negative_spacing: spacing.x >= 0.0 and spacing.y >= 0.0 and spacing.z >= 0.0
+			non_negative_limits: a_limit_x >= 0 and a_limit_y >= 0 and a_limit_z >= 0
+		do
+			create Result.make (
+				repeat_local (p.x, spacing.x, limited_repeat_cell (p.x, spacing.x, a_limit_x)),
+				repeat_local (p.y, spacing.y, limited_repeat_cell (p.y, spacing.y, a_limit_y)),
+				repeat_local (p.z, spacing.z, limited_repeat_cell (p.z, spacing.z, a_limit_z))
+			)
+		end
+
+	op_mirrored_repeat (p, spacing: SDF_VEC3): SDF_VEC3
+			-- `p' in the nearest cell of an infinite grid of alternately mirrored copies.
+		require
+			p_attached: p /= Void
+			spacing_attached: spacing /= Void
+			non_negative_spacing: spacing.x >= 0.0 and spacing.y >= 0.0 and spacing.z >= 0.0
+		do
+			create Result.make (
+				mirrored_repeat_local (p.x, spacing.x, repeat_cell (p.x, spacing.x)),
+				mirrored_repeat_local (p.y, spacing.y, repeat_cell (p.y, spacing.y)),
+				mirrored_repeat_local (p.z, spacing.z, repeat_cell (p.z, spacing.z))
+			)
+		end
+
+feature {NONE} -- Implementation
+
+	dual_blend (d1, d2: SDF_DUAL; k: REAL_64): SDF_DUAL
+			-- Quadratic blend term h^2 k / 4 with h = max (k - |d1 - d2|, 0) / k.
+		require
+			positive_k: k > 0.0
+		local
+			h: SDF_DUAL
+		do
+			h := (- (d1 - d2).absolute).plus_value (k).max_value (0.0).scaled (1.0 / k)
+			Result := h.squared.scaled (k * 0.25)
+		end
+
 end
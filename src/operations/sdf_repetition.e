@@ -0,0 +1,444 @@
+note
+	description: "[
+		Domain repetition of a shape: copies of `child' every `spacing_x',
+		`spacing_y', `spacing_z' (0 = not repeated on that axis), in an
+		infinite grid, a limited grid of 2 * limit + 1 cells per axis, or
+		an infinite grid whose odd cells hold mirrored copies.
+
+		Cells are centred on the child's position. A sample maps into its
+		own cell (SDF_OPS.repeat_cell and friends) and evaluates the child
+		once, whatever the number of copies. Only where the child's bounds
+		cross a cell border are the `reach_x' .. `reach_z' neighbouring
+		cells evaluated as well.
+
+		Copies in cells not evaluated are at least as far as the gap to
+		their bounds along one axis; `distance_at' takes the smaller of
+		that gap and the copies it evaluated, so it never overestimates,
+		even for children placed off-centre, and is exact near the copies.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_REPETITION
+
+inherit
+	SDF_FIELD
+		redefine
+			bounds
+		end
+
+create
+	make_infinite,
+	make_limited,
+	make_mirrored
+
+feature {NONE} -- Initialization
+
+	make_infinite (a_child: SDF_SHAPE; a_spacing_x, a_spacing_y, a_spacing_z: REAL_64)
+			-- Repeat `a_child' without end on every axis with a positive spacing.
+		require
+			child_attached: a_child /= Void
+			non_negative_spacing: a_spacing_x >= 0.0 and a_spacing_y >= 0.0 and a_spacing_z >= 0.0
+			repeats: a_spacing_x > 0.0 or a_spacing_y > 0.0 or a_spacing_z > 0.0
+		do
+			child := a_child
+			spacing_x := a_spacing_x
+			spacing_y := a_spacing_y
+			spacing_z := a_spacing_z
+			create ops
+			compute_reach
+		ensure
+			child_set: child = a_child
+			not_limited: not is_limited
+			not_mirrored: not is_mirrored
+		end
+
+	make_limited (a_child: SDF_SHAPE; a_spacing_x, a_spacing_y, a_spacing_z: REAL_64; a_limit_x, a_limit_y, a_limit_z: INTEGER)
+			-- Repeat `a_child' in cells -limit .. limit on each axis.
+		require
+			child_attached: a_child /= Void
+			non_negative_spacing: a_spacing_x >= 0.0 and a_spacing_y >= 0.0 and a_spacing_z >= 0.0
+			repeats: a_spacing_x > 0.0 or a_spacing_y > 0.0 or a_spacing_z > 0.0
+			non_negative_limits: a_limit_x >= 0 and a_limit_y >= 0 and a_limit_z >= 0
+		do
+			make_infinite (a_child, a_spacing_x, a_spacing_y, a_spacing_z)
+			is_limited := True
+			limit_x := a_limit_x
+			limit_y := a_limit_y
+			limit_z := a_limit_z
+		ensure
+			child_set: child = a_child
+			limited: is_limited
+		end
+
+	make_mirrored (a_child: SDF_SHAPE; a_spacing_x, a_spacing_y, a_spacing_z: REAL_64)
+			-- Repeat `a_child' without end, mirroring the copies in odd cells.
+		require
+			child_attached: a_child /= Void
+			non_negative_spacing: a_spacing_x >= 0.0 and a_spacing_y >= 0.0 and a_spacing_z >= 0.0
+			repeats: a_spacing_x > 0.0 or a_spacing_y > 0.0 or a_spacing_z > 0.0
+		do
+			make_infinite (a_child, a_spacing_x, a_spacing_y, a_spacing_z)
+			is_mirrored := True
+		ensure
+			child_set: child = a_child
+			mirrored: is_mirrored
+		end
+
+feature -- Access
+
+	child: SDF_SHAPE
+			-- Repeated shape; the copy in cell (0, 0, 0) is the shape itself
+
+	spacing_x, spacing_y, spacing_z: REAL_64
+			-- Distance between copies per axis (0 = not repeated)
+
+	limit_x, limit_y, limit_z: INTEGER
+			-- Highest cell index per axis when `is_limited'
+
+	reach_x, reach_y, reach_z: INTEGER
+			-- Neighbouring cells evaluated on each side, per axis
+
+	last_evaluated_count: INTEGER
+			-- Copies evaluated by the last `distance_at'
+
+	bounds: SDF_AABB
+			-- Box enclosing every copy (unbounded along unlimited axes)
+		local
+			l_child: SDF_AABB
+			h: REAL_64
+		do
+			l_child := child.bounds
+			create Result.make_infinite
+			h := half_extent (l_child.min_x, l_child.max_x, child.position.x)
+			if spacing_x = 0.0 then
+				Result.set (l_child.min_x, Result.min_y, Result.min_z, l_child.max_x, Result.max_y, Result.max_z)
+			elseif is_limited then
+				Result.set (child.position.x - limit_x * spacing_x - h, Result.min_y, Result.min_z,
+					child.position.x + limit_x * spacing_x + h, Result.max_y, Result.max_z)
+			end
+			h := half_extent (l_child.min_y, l_child.max_y, child.position.y)
+			if spacing_y = 0.0 then
+				Result.set (Result.min_x, l_child.min_y, Result.min_z, Result.max_x, l_child.max_y, Result.max_z)
+			elseif is_limited then
+				Result.set (Result.min_x, child.position.y - limit_y * spacing_y - h, Result.min_z,
+					Result.max_x, child.position.y + limit_y * spacing_y + h, Result.max_z)
+			end
+			h := half_extent (l_child.min_z, l_child.max_z, child.position.z)
+			if spacing_z = 0.0 then
+				Result.set (Result.min_x, Result.min_y, l_child.min_z, Result.max_x, Result.max_y, l_child.max_z)
+			elseif is_limited then
+				Result.set (Result.min_x, Result.min_y, child.position.z - limit_z * spacing_z - h,
+					Result.max_x, Result.max_y, child.position.z + limit_z * spacing_z + h)
+			end
+		ensure then
+			result_attached: Result /= Void
+		end
+
+feature -- Status report
+
+	is_limited: BOOLEAN
+			-- Is the grid limited to `limit_x' .. `limit_z' cells each side?
+
+	is_mirrored: BOOLEAN
+			-- Are copies in odd cells mirrored?
+
+feature -- Distance evaluation
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Distance to the nearest copy evaluated, capped by the gap to
+			-- the copies that were not.
+		local
+			cx, cy, cz, lx, ly, lz: REAL_64
+			kx, ky, kz, i, j, k: INTEGER
+		do
+			refresh_reach
+			cx := child.position.x
+			cy := child.position.y
+			cz := child.position.z
+			kx := cell (a_x - cx, spacing_x, limit_x)
+			ky := cell (a_y - cy, spacing_y, limit_y)
+			kz := cell (a_z - cz, spacing_z, limit_z)
+			last_evaluated_count := 0
+			Result := gap (a_x - cx - spacing_x * kx, spacing_x, kx, reach_x, limit_x, half_x)
+				.min (gap (a_y - cy - spacing_y * ky, spacing_y, ky, reach_y, limit_y, half_y))
+				.min (gap (a_z - cz - spacing_z * kz, spacing_z, kz, reach_z, limit_z, half_z))
+			from i := kx - reach_x until i > kx + reach_x loop
+				if has_cell (i, limit_x) then
+					lx := local_coordinate (a_x, cx, spacing_x, i)
+					from j := ky - reach_y until j > ky + reach_y loop
+						if has_cell (j, limit_y) then
+							ly := local_coordinate (a_y, cy, spacing_y, j)
+							from k := kz - reach_z until k > kz + reach_z loop
+								if has_cell (k, limit_z) then
+									lz := local_coordinate (a_z, cz, spacing_z, k)
+									Result := Result.min (child.distance_at (lx, ly, lz))
+									last_evaluated_count := last_evaluated_count + 1
+								end
+								k := k + 1
+							end
+						end
+						j := j + 1
+					end
+				end
+				i := i + 1
+			end
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Range over the box: at most the child over the part of its own
+			-- cell the box maps to, at least the child over that part widened
+			-- by the neighbours evaluated (or the gap to the others).
+		local
+			l_own, l_near: SDF_INTERVAL
+			ox0, ox1, oy0, oy1, oz0, oz1, l_gap: REAL_64
+		do
+			refresh_reach
+			local_range (a_min_x, a_max_x, child.position.x, spacing_x, limit_x)
+			ox0 := last_lo
+			ox1 := last_hi
+			l_gap := last_gap (child.position.x, spacing_x, reach_x, half_x)
+			local_range (a_min_y, a_max_y, child.position.y, spacing_y, limit_y)
+			oy0 := last_lo
+			oy1 := last_hi
+			l_gap := l_gap.min (last_gap (child.position.y, spacing_y, reach_y, half_y))
+			local_range (a_min_z, a_max_z, child.position.z, spacing_z, limit_z)
+			oz0 := last_lo
+			oz1 := last_hi
+			l_gap := l_gap.min (last_gap (child.position.z, spacing_z, reach_z, half_z))
+			l_own := child.interval_at (ox0, oy0, oz0, ox1, oy1, oz1)
+			l_near := child.interval_at (
+				widened_lo (ox0, ox1, child.position.x, spacing_x, reach_x), widened_lo (oy0, oy1, child.position.y, spacing_y, reach_y),
+				widened_lo (oz0, oz1, child.position.z, spacing_z, reach_z), widened_hi (ox0, ox1, child.position.x, spacing_x, reach_x),
+				widened_hi (oy0, oy1, child.position.y, spacing_y, reach_y), widened_hi (oz0, oz1, child.position.z, spacing_z, reach_z))
+			create Result.make (l_near.lo.min (l_gap).min (l_own.hi), l_own.hi)
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- `distance_at' with its gradient; mirrored copies flip it back.
+		local
+			cx, cy, cz, ux, uy, uz: REAL_64
+			kx, ky, kz, i, j, k: INTEGER
+			l_dual: SDF_DUAL
+		do
+			refresh_reach
+			cx := child.position.x
+			cy := child.position.y
+			cz := child.position.z
+			kx := cell (a_x - cx, spacing_x, limit_x)
+			ky := cell (a_y - cy, spacing_y, limit_y)
+			kz := cell (a_z - cz, spacing_z, limit_z)
+			ux := a_x - cx - spacing_x * kx
+			uy := a_y - cy - spacing_y * ky
+			uz := a_z - cz - spacing_z * kz
+			Result := gap_dual (ux, spacing_x, kx, reach_x, limit_x, half_x, 1.0, 0.0, 0.0)
+			Result := Result.min (gap_dual (uy, spacing_y, ky, reach_y, limit_y, half_y, 0.0, 1.0, 0.0))
+			Result := Result.min (gap_dual (uz, spacing_z, kz, reach_z, limit_z, half_z, 0.0, 0.0, 1.0))
+			from i := kx - reach_x until i > kx + reach_x loop
+				from j := ky - reach_y until j > ky + reach_y loop
+					from k := kz - reach_z until k > kz + reach_z loop
+						if has_cell (i, limit_x) and has_cell (j, limit_y) and has_cell (k, limit_z) then
+							l_dual := child.dual_at (local_coordinate (a_x, cx, spacing_x, i),
+								local_coordinate (a_y, cy, spacing_y, j), local_coordinate (a_z, cz, spacing_z, k))
+							if is_mirrored then
+								create l_dual.make (l_dual.value, l_dual.dx * mirror_sign (i), l_dual.dy * mirror_sign (j), l_dual.dz * mirror_sign (k))
+							end
+							Result := Result.min (l_dual)
+						end
+						k := k + 1
+					end
+					j := j + 1
+				end
+				i := i + 1
+			end
+		end
+
+	lipschitz_bound: REAL_64
+			-- Lipschitz bound of `child': mirroring and taking minima keep it
+		do
+			Result := child.lipschitz_bound
+		end
+
+feature {NONE} -- Implementation
+
+	ops: SDF_OPS
+			-- Repetition maps
+
+	half_x, half_y, half_z: REAL_64
+			-- Extent of `child' around its position per axis
+
+	seen_version: NATURAL_64
+			-- `child.version' when `reach_x' .. `reach_z' were computed
+
+	last_lo, last_hi: REAL_64
+			-- Range computed by the last `local_range'
+
+	refresh_reach
+			-- Recompute the neighbour reach if the child changed.
+		do
+			if seen_version /= child.version then
+				compute_reach
+			end
+		end
+
+	compute_reach
+			-- Measure the child and the neighbouring cells it reaches.
+		local
+			l_bounds: SDF_AABB
+		do
+			l_bounds := child.bounds
+			half_x := half_extent (l_bounds.min_x, l_bounds.max_x, child.position.x)
+			half_y := half_extent (l_bounds.min_y, l_bounds.max_y, child.position.y)
+			half_z := half_extent (l_bounds.min_z, l_bounds.max_z, child.position.z)
+			reach_x := axis_reach (half_x, spacing_x)
+			reach_y := axis_reach (half_y, spacing_y)
+			reach_z := axis_reach (half_z, spacing_z)
+			seen_version := child.version
+		end
+
+	half_extent (a_min, a_max, a_centre: REAL_64): REAL_64
+			-- Largest distance from `a_centre' to the range `a_min' .. `a_max'
+		do
+			Result := (a_max - a_centre).max (a_centre - a_min).max (0.0)
+		end
+
+	axis_reach (a_half, a_spacing: REAL_64): INTEGER
+			-- Neighbouring cells each side a copy of half-width `a_half' can reach
+		do
+			if a_spacing > 0.0 and a_half < Unbounded_half then
+				Result := ((a_half - a_spacing / 2.0) / a_spacing).ceiling.max (0)
+			end
+		end
+
+	cell (a_offset, a_spacing: REAL_64; a_limit: INTEGER): INTEGER
+			-- Cell holding `a_offset' from the child's position
+		do
+			if is_limited then
+				Result := ops.limited_repeat_cell (a_offset, a_spacing, a_limit)
+			else
+				Result := ops.repeat_cell (a_offset, a_spacing)
+			end
+		end
+
+	has_cell (a_cell, a_limit: INTEGER): BOOLEAN
+			-- Does cell index `a_cell' hold a copy?
+		do
+			Result := not is_limited or else a_cell.abs <= a_limit
+		end
+
+	local_coordinate (a_coordinate, a_centre, a_spacing: REAL_64; a_cell: INTEGER): REAL_64
+			-- `a_coordinate' mapped into the child's frame from cell `a_cell'
+		do
+			if is_mirrored then
+				Result := a_centre + ops.mirrored_repeat_local (a_coordinate - a_centre, a_spacing, a_cell)
+			else
+				Result := ops.repeat_local (a_coordinate, a_spacing, a_cell)
+			end
+		end
+
+	mirror_sign (a_cell: INTEGER): REAL_64
+			-- -1 in odd cells, 1 in even ones
+		do
+			if a_cell \\ 2 /= 0 then
+				Result := -1.0
+			else
+				Result := 1.0
+			end
+		end
+
+	gap (a_offset, a_spacing: REAL_64; a_cell, a_reach, a_limit: INTEGER; a_half: REAL_64): REAL_64
+			-- Lower bound of the distance to copies on this axis beyond
+			-- `a_reach' cells of `a_cell', `a_offset' from its centre.
+		do
+			Result := {REAL_64}.max_value
+			if a_spacing > 0.0 then
+				if has_cell (a_cell + a_reach + 1, a_limit) then
+					Result := (a_reach + 1) * a_spacing - a_half - a_offset
+				end
+				if has_cell (a_cell - a_reach - 1, a_limit) then
+					Result := Result.min ((a_reach + 1) * a_spacing - a_half + a_offset)
+				end
+			end
+		end
+
+	gap_dual (a_offset, a_spacing: REAL_64; a_cell, a_reach, a_limit: INTEGER; a_half, a_ax, a_ay, a_az: REAL_64): SDF_DUAL
+			-- `gap' with its gradient along axis (a_ax, a_ay, a_az)
+		local
+			l_plus, l_minus: REAL_64
+		do
+			l_plus := {REAL_64}.max_value
+			l_minus := {REAL_64}.max_value
+			if a_spacing > 0.0 then
+				if has_cell (a_cell + a_reach + 1, a_limit) then
+					l_plus := (a_reach + 1) * a_spacing - a_half - a_offset
+				end
+				if has_cell (a_cell - a_reach - 1, a_limit) then
+					l_minus := (a_reach + 1) * a_spacing - a_half + a_offset
+				end
+			end
+			if l_plus <= l_minus then
+				create Result.make (l_plus, - a_ax, - a_ay, - a_az)
+			else
+				create Result.make (l_minus, a_ax, a_ay, a_az)
+			end
+		end
+
+	local_range (a_min, a_max, a_centre, a_spacing: REAL_64; a_limit: INTEGER)
+			-- Set `last_lo', `last_hi' to the child-frame range that
+			-- `a_min' .. `a_max' maps to in the evaluated own cells.
+		local
+			k0, k1: INTEGER
+			l_swap: REAL_64
+		do
+			k0 := cell (a_min - a_centre, a_spacing, a_limit)
+			k1 := cell (a_max - a_centre, a_spacing, a_limit)
+			if k0 = k1 then
+				last_lo := local_coordinate (a_min, a_centre, a_spacing, k0)
+				last_hi := local_coordinate (a_max, a_centre, a_spacing, k0)
+				if last_lo > last_hi then
+					l_swap := last_lo
+					last_lo := last_hi
+					last_hi := l_swap
+				end
+			else
+				-- Several cells: the whole cell, plus the overhang of clamped end cells
+				last_lo := (a_centre - a_spacing / 2.0).min (a_min - a_spacing * k0)
+				last_hi := (a_centre + a_spacing / 2.0).max (a_max - a_spacing * k1)
+			end
+		end
+
+	last_gap (a_centre, a_spacing: REAL_64; a_reach: INTEGER; a_half: REAL_64): REAL_64
+			-- Lower bound of `gap' over the last `local_range'
+		do
+			if a_spacing > 0.0 then
+				Result := ((a_reach + 1) * a_spacing - a_half - (last_hi - a_centre).abs.max ((last_lo - a_centre).abs)).max (0.0)
+			else
+				Result := {REAL_64}.max_value
+			end
+		end
+
+	widened_lo (a_lo, a_hi, a_centre, a_spacing: REAL_64; a_reach: INTEGER): REAL_64
+			-- Low end of `a_lo' .. `a_hi' made symmetric about `a_centre' and
+			-- widened by `a_reach' cells, covering every neighbour evaluated
+		do
+			Result := a_centre - (a_hi - a_centre).abs.max ((a_lo - a_centre).abs) - a_reach * a_spacing
+		end
+
+	widened_hi (a_lo, a_hi, a_centre, a_spacing: REAL_64; a_reach: INTEGER): REAL_64
+			-- High end matching `widened_lo'
+		do
+			Result := a_centre + (a_hi - a_centre).abs.max ((a_lo - a_centre).abs) + a_reach * a_spacing
+		end
+
+	Unbounded_half: REAL_64 = 1.0e30
+			-- Half-extent beyond which the child counts as unbounded
+
+invariant
+	child_attached: child /= Void
+	ops_attached: ops /= Void
+	non_negative_spacing: spacing_x >= 0.0 and spacing_y >= 0.0 and spacing_z >= 0.0
+	non_negative_reach: reach_x >= 0 and reach_y >= 0 and reach_z >= 0
+
+end
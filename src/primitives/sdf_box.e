@@ -74,25 +74,79 @@ feature -- Access
 			Result := dimensions.z * 2.0
 		end
 
-feature -- Distance
+feature -- Local distance
 
-	distance (p: SDF_VEC3): REAL_64
-			-- Signed distance from point `p' to box surface.
+	local_distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from point (x, y, z) to box surface.
 			-- Exact SDF formula from Inigo Quilez.
 		local
-			q: SDF_VEC3
-			l_zero: SDF_VEC3
+			qx, qy, qz: REAL_64
+			ox, oy, oz: REAL_64
 		do
 			-- Transform point to box-local coordinates
-			q := p.minus (position).abs.minus (dimensions)
-
-			-- Create zero vector for max operation
-			create l_zero.make_zero
+			qx := (a_x - position.x).abs - dimensions.x
+			qy := (a_y - position.y).abs - dimensions.y
+			qz := (a_z - position.z).abs - dimensions.z
 
 			-- Exact box distance:
 			-- Outside: distance to nearest corner/edge/face
 			-- Inside: negative distance to nearest face
-			Result := q.max (l_zero).length + q.max_component.min (0.0)
+			ox := qx.max (0.0)
+			oy := qy.max (0.0)
+			oz := qz.max (0.0)
+			Result := {DOUBLE_MATH}.sqrt (ox * ox + oy * oy + oz * oz) + qx.max (qy).max (qz).min (0.0)
+		end
+
+	local_dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance with gradient (dual form of `local_distance_at')
+		local
+			qx, qy, qz: SDF_DUAL
+		do
+			qx.set (a_x - position.x, 1.0, 0.0, 0.0)
+			qy.set (a_y - position.y, 0.0, 1.0, 0.0)
+			qz.set (a_z - position.z, 0.0, 0.0, 1.0)
+			qx := qx.absolute.plus_value (- dimensions.x)
+			qy := qy.absolute.plus_value (- dimensions.y)
+			qz := qz.absolute.plus_value (- dimensions.z)
+			Result := (qx.max_value (0.0).squared + qy.max_value (0.0).squared + qz.max_value (0.0).squared).square_root
+				+ qx.max (qy).max (qz).min_value (0.0)
+		end
+
+	local_interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Distance range over a box (interval form of `local_distance_at')
+		local
+			qx, qy, qz: SDF_INTERVAL
+		do
+			qx.set (a_min_x - position.x, a_max_x - position.x)
+			qy.set (a_min_y - position.y, a_max_y - position.y)
+			qz.set (a_min_z - position.z, a_max_z - position.z)
+			qx := qx.absolute.plus_value (- dimensions.x)
+			qy := qy.absolute.plus_value (- dimensions.y)
+			qz := qz.absolute.plus_value (- dimensions.z)
+			Result := (qx.max_value (0.0).squared + qy.max_value (0.0).squared + qz.max_value (0.0).squared).square_root
+				+ qx.max (qy).max (qz).min_value (0.0)
+		end
+
+feature -- Local bounds
+
+	local_bounds: SDF_AABB
+			-- Center +/- half-extents
+		do
+			create Result.make_around (position.x, position.y, position.z, dimensions.x, dimensions.y, dimensions.z)
+		end
+
+feature -- Compilation
+
+	kind: INTEGER
+			-- Box kind code
+		do
+			Result := Kind_box
+		end
+
+	parameters: ARRAY [REAL_64]
+			-- Center (x, y, z), half-extents (x, y, z)
+		do
+			Result := <<position.x, position.y, position.z, dimensions.x, dimensions.y, dimensions.z>>
 		end
 
 feature -- Element change (fluent API)
@@ -105,6 +159,7 @@ feature -- Element change (fluent API)
 			positive_depth: a_depth > 0.0
 		do
 			create dimensions.make (a_width / 2.0, a_height / 2.0, a_depth / 2.0)
+			mark_changed
 			Result := Current
 		ensure
 			result_is_current: Result = Current
@@ -119,6 +174,7 @@ feature -- Element change (fluent API)
 			positive_z: a_half_extents.z > 0.0
 		do
 			dimensions := a_half_extents
+			mark_changed
 			Result := Current
 		ensure
 			dimensions_set: dimensions = a_half_extents
@@ -23,7 +23,8 @@ inherit
 		rename
 			position as point_a
 		redefine
-			make_at_origin
+			make_at_origin,
+			transform_pivot
 		end
 
 create
@@ -90,27 +91,115 @@ feature -- Access
 			non_negative: Result >= 0.0
 		end
 
-feature -- Distance
+feature -- Local distance
 
-	distance (p: SDF_VEC3): REAL_64
-			-- Signed distance from point `p' to capsule surface.
+	local_distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from point (x, y, z) to capsule surface.
 		local
-			pa, ba: SDF_VEC3
+			pa_x, pa_y, pa_z: REAL_64
+			ba_x, ba_y, ba_z: REAL_64
 			h, ba_dot: REAL_64
 		do
-			pa := p - point_a
-			ba := point_b - point_a
+			pa_x := a_x - point_a.x
+			pa_y := a_y - point_a.y
+			pa_z := a_z - point_a.z
+			ba_x := point_b.x - point_a.x
+			ba_y := point_b.y - point_a.y
+			ba_z := point_b.z - point_a.z
 
 			-- Project p onto line segment, clamped to [0, 1]
-			ba_dot := ba.dot (ba)
+			ba_dot := ba_x * ba_x + ba_y * ba_y + ba_z * ba_z
 			if ba_dot > 0.0 then
-				h := (pa.dot (ba) / ba_dot).max (0.0).min (1.0)
+				h := ((pa_x * ba_x + pa_y * ba_y + pa_z * ba_z) / ba_dot).max (0.0).min (1.0)
 			else
 				h := 0.0
 			end
 
 			-- Distance to nearest point on segment, minus radius
-			Result := pa.minus (ba * h).length - radius
+			pa_x := pa_x - ba_x * h
+			pa_y := pa_y - ba_y * h
+			pa_z := pa_z - ba_z * h
+			Result := {DOUBLE_MATH}.sqrt (pa_x * pa_x + pa_y * pa_y + pa_z * pa_z) - radius
+		end
+
+	local_dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance with gradient (dual form of `local_distance_at')
+		local
+			pa_x, pa_y, pa_z, h: SDF_DUAL
+			ba_x, ba_y, ba_z, ba_dot: REAL_64
+		do
+			pa_x.set (a_x - point_a.x, 1.0, 0.0, 0.0)
+			pa_y.set (a_y - point_a.y, 0.0, 1.0, 0.0)
+			pa_z.set (a_z - point_a.z, 0.0, 0.0, 1.0)
+			ba_x := point_b.x - point_a.x
+			ba_y := point_b.y - point_a.y
+			ba_z := point_b.z - point_a.z
+
+			ba_dot := ba_x * ba_x + ba_y * ba_y + ba_z * ba_z
+			if ba_dot > 0.0 then
+				h := (pa_x.scaled (ba_x) + pa_y.scaled (ba_y) + pa_z.scaled (ba_z)).scaled (1.0 / ba_dot).clamped (0.0, 1.0)
+			end
+
+			pa_x := pa_x - h.scaled (ba_x)
+			pa_y := pa_y - h.scaled (ba_y)
+			pa_z := pa_z - h.scaled (ba_z)
+			Result := (pa_x.squared + pa_y.squared + pa_z.squared).square_root.plus_value (- radius)
+		end
+
+	local_interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Distance range over a box (interval form of `local_distance_at')
+		local
+			pa_x, pa_y, pa_z, h: SDF_INTERVAL
+			ba_x, ba_y, ba_z, ba_dot: REAL_64
+		do
+			pa_x.set (a_min_x - point_a.x, a_max_x - point_a.x)
+			pa_y.set (a_min_y - point_a.y, a_max_y - point_a.y)
+			pa_z.set (a_min_z - point_a.z, a_max_z - point_a.z)
+			ba_x := point_b.x - point_a.x
+			ba_y := point_b.y - point_a.y
+			ba_z := point_b.z - point_a.z
+
+			ba_dot := ba_x * ba_x + ba_y * ba_y + ba_z * ba_z
+			if ba_dot > 0.0 then
+				h := (pa_x.scaled (ba_x) + pa_y.scaled (ba_y) + pa_z.scaled (ba_z)).scaled (1.0 / ba_dot).clamped (0.0, 1.0)
+			end
+
+			pa_x := pa_x - h.scaled (ba_x)
+			pa_y := pa_y - h.scaled (ba_y)
+			pa_z := pa_z - h.scaled (ba_z)
+			Result := (pa_x.squared + pa_y.squared + pa_z.squared).square_root.plus_value (- radius)
+		end
+
+feature -- Local bounds
+
+	local_bounds: SDF_AABB
+			-- Segment extent grown by radius
+		do
+			create Result.make (point_a.x.min (point_b.x) - radius, point_a.y.min (point_b.y) - radius,
+				point_a.z.min (point_b.z) - radius, point_a.x.max (point_b.x) + radius,
+				point_a.y.max (point_b.y) + radius, point_a.z.max (point_b.z) + radius)
+		end
+
+feature -- Transform
+
+	transform_pivot: SDF_VEC3
+			-- Midpoint of the segment: rotation and scale keep it in place
+		do
+			create Result.make ((point_a.x + point_b.x) * 0.5, (point_a.y + point_b.y) * 0.5, (point_a.z + point_b.z) * 0.5)
+		end
+
+feature -- Compilation
+
+	kind: INTEGER
+			-- Capsule kind code
+		do
+			Result := Kind_capsule
+		end
+
+	parameters: ARRAY [REAL_64]
+			-- Endpoint a (x, y, z), endpoint b (x, y, z), radius
+		do
+			Result := <<point_a.x, point_a.y, point_a.z, point_b.x, point_b.y, point_b.z, radius>>
 		end
 
 feature -- Element change (fluent API)
@@ -122,6 +211,7 @@ feature -- Element change (fluent API)
 			points_different: not point_a.is_equal (a_point_b)
 		do
 			point_b := a_point_b
+			mark_changed
 			Result := Current
 		ensure
 			point_b_set: point_b = a_point_b
@@ -134,6 +224,7 @@ feature -- Element change (fluent API)
 			positive_radius: a_radius > 0.0
 		do
 			radius := a_radius
+			mark_changed
 			Result := Current
 		ensure
 			radius_set: radius = a_radius
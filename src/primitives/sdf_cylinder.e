@@ -53,32 +53,81 @@ feature -- Access
 			Result := half_height * 2.0
 		end
 
-feature -- Distance
+feature -- Local distance
 
-	distance (p: SDF_VEC3): REAL_64
-			-- Signed distance from point `p' to cylinder surface.
+	local_distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from point (x, y, z) to cylinder surface.
 		local
-			l_local: SDF_VEC3
+			lx, ly, lz: REAL_64
 			d_radial, d_caps: REAL_64
-			d_outer: SDF_VEC2
-			l_zero: SDF_VEC2
+			o_radial, o_caps: REAL_64
 		do
 			-- Transform to cylinder-local coordinates
-			l_local := p - position
+			lx := a_x - position.x
+			ly := a_y - position.y
+			lz := a_z - position.z
 
 			-- Radial distance (XZ plane)
-			d_radial := l_local.xz.length - radius
+			d_radial := {DOUBLE_MATH}.sqrt (lx * lx + lz * lz) - radius
 
 			-- Cap distance (Y axis)
-			d_caps := l_local.y.abs - half_height
-
-			-- For exact SDF, combine radial and cap distances
-			create l_zero.make_zero
-			create d_outer.make (d_radial, d_caps)
+			d_caps := ly.abs - half_height
 
 			-- Outside: distance to nearest surface element
 			-- Inside: negative of minimum penetration
-			Result := d_outer.max (l_zero).length + d_outer.max_component.min (0.0)
+			o_radial := d_radial.max (0.0)
+			o_caps := d_caps.max (0.0)
+			Result := {DOUBLE_MATH}.sqrt (o_radial * o_radial + o_caps * o_caps) + d_radial.max (d_caps).min (0.0)
+		end
+
+	local_dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance with gradient (dual form of `local_distance_at')
+		local
+			lx, ly, lz, d_radial, d_caps: SDF_DUAL
+		do
+			lx.set (a_x - position.x, 1.0, 0.0, 0.0)
+			ly.set (a_y - position.y, 0.0, 1.0, 0.0)
+			lz.set (a_z - position.z, 0.0, 0.0, 1.0)
+			d_radial := (lx.squared + lz.squared).square_root.plus_value (- radius)
+			d_caps := ly.absolute.plus_value (- half_height)
+			Result := (d_radial.max_value (0.0).squared + d_caps.max_value (0.0).squared).square_root
+				+ d_radial.max (d_caps).min_value (0.0)
+		end
+
+	local_interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Distance range over a box (interval form of `local_distance_at')
+		local
+			lx, ly, lz, d_radial, d_caps: SDF_INTERVAL
+		do
+			lx.set (a_min_x - position.x, a_max_x - position.x)
+			ly.set (a_min_y - position.y, a_max_y - position.y)
+			lz.set (a_min_z - position.z, a_max_z - position.z)
+			d_radial := (lx.squared + lz.squared).square_root.plus_value (- radius)
+			d_caps := ly.absolute.plus_value (- half_height)
+			Result := (d_radial.max_value (0.0).squared + d_caps.max_value (0.0).squared).square_root
+				+ d_radial.max (d_caps).min_value (0.0)
+		end
+
+feature -- Local bounds
+
+	local_bounds: SDF_AABB
+			-- Center +/- (radius, half height, radius)
+		do
+			create Result.make_around (position.x, position.y, position.z, radius, half_height, radius)
+		end
+
+feature -- Compilation
+
+	kind: INTEGER
+			-- Cylinder kind code
+		do
+			Result := Kind_cylinder
+		end
+
+	parameters: ARRAY [REAL_64]
+			-- Center (x, y, z), radius, half height
+		do
+			Result := <<position.x, position.y, position.z, radius, half_height>>
 		end
 
 feature -- Element change (fluent API)
@@ -89,6 +138,7 @@ feature -- Element change (fluent API)
 			positive_height: a_height > 0.0
 		do
 			half_height := a_height / 2.0
+			mark_changed
 			Result := Current
 		ensure
 			half_height_updated: half_height = a_height / 2.0
@@ -101,6 +151,7 @@ feature -- Element change (fluent API)
 			positive_radius: a_radius > 0.0
 		do
 			radius := a_radius
+			mark_changed
 			Result := Current
 		ensure
 			radius_set: radius = a_radius
@@ -87,13 +87,52 @@ feature -- Access
 			-- Positive = plane is offset in normal direction
 			-- Negative = plane is offset opposite to normal
 
-feature -- Distance
+feature -- Local distance
 
-	distance (p: SDF_VEC3): REAL_64
-			-- Signed distance from point `p' to plane.
+	local_distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from point (x, y, z) to plane.
 			-- Positive = on normal side, negative = opposite side.
 		do
-			Result := p.dot (normal) + height
+			Result := a_x * normal.x + a_y * normal.y + a_z * normal.z + height
+		end
+
+	local_dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance with gradient: the gradient is the normal everywhere
+		do
+			Result.set (local_distance_at (a_x, a_y, a_z), normal.x, normal.y, normal.z)
+		end
+
+	local_interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Distance range over a box: dot (p, normal) + height
+		local
+			ix, iy, iz: SDF_INTERVAL
+		do
+			ix.set (a_min_x, a_max_x)
+			iy.set (a_min_y, a_max_y)
+			iz.set (a_min_z, a_max_z)
+			Result := (ix.scaled (normal.x) + iy.scaled (normal.y) + iz.scaled (normal.z)).plus_value (height)
+		end
+
+feature -- Local bounds
+
+	local_bounds: SDF_AABB
+			-- Planes are unbounded
+		do
+			create Result.make_infinite
+		end
+
+feature -- Compilation
+
+	kind: INTEGER
+			-- Plane kind code
+		do
+			Result := Kind_plane
+		end
+
+	parameters: ARRAY [REAL_64]
+			-- Normal (x, y, z), height
+		do
+			Result := <<normal.x, normal.y, normal.z, height>>
 		end
 
 feature -- Element change (fluent API)
@@ -105,6 +144,7 @@ feature -- Element change (fluent API)
 			normal_is_unit: a_normal.is_unit_vector
 		do
 			normal := a_normal
+			mark_changed
 			Result := Current
 		ensure
 			normal_set: normal = a_normal
@@ -115,6 +155,7 @@ feature -- Element change (fluent API)
 			-- Set height and return self
 		do
 			height := a_height
+			mark_changed
 			Result := Current
 		ensure
 			height_set: height = a_height
@@ -5,6 +5,18 @@ note
 		Each shape must implement distance calculation. Shapes can be
 		positioned in 3D space and support basic transformations.
 
+		Shapes implement the scalar `local_distance_at' (and its interval
+		and dual forms), which must not allocate: it is the inner loop of
+		every ray march. `distance' is a vector convenience built on top
+		of `distance_at'.
+
+		Every shape also carries an optional rotation and uniform scale
+		about `transform_pivot' (see `set_rotation', `rotate', `set_scale').
+		The world-to-shape inverse is a 3x4 matrix recomputed on every
+		change, so `distance_at' maps each sample with one matrix-vector
+		product and multiplies the local distance by `scale'. Untransformed
+		shapes skip the mapping altogether.
+
 		The distance function returns:
 		- Positive values for points outside the shape
 		- Negative values for points inside the shape
@@ -21,6 +33,14 @@ note
 deferred class
 	SDF_SHAPE
 
+inherit
+	SDF_FIELD
+		redefine
+			bounds
+		end
+
+	SDF_SHARED_CHANGE_STAMP
+
 feature {NONE} -- Initialization
 
 	make_at_origin
@@ -46,25 +66,250 @@ feature -- Access
 	position: SDF_VEC3
 			-- Center/origin position of the shape
 
-feature -- Distance (deferred)
+feature -- Distance
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- `local_distance_at' the point mapped into shape space, times `scale'
+		do
+			if attached inverse_matrix as m then
+				Result := local_distance_at (m [0] * a_x + m [1] * a_y + m [2] * a_z + m [3],
+					m [4] * a_x + m [5] * a_y + m [6] * a_z + m [7],
+					m [8] * a_x + m [9] * a_y + m [10] * a_z + m [11]) * transform_scale
+			else
+				Result := local_distance_at (a_x, a_y, a_z)
+			end
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- `local_dual_at' the mapped point, its gradient turned back into world space
+		local
+			l_dual: SDF_DUAL
+		do
+			if attached inverse_matrix as m and attached rotation as r then
+				l_dual := local_dual_at (m [0] * a_x + m [1] * a_y + m [2] * a_z + m [3],
+					m [4] * a_x + m [5] * a_y + m [6] * a_z + m [7],
+					m [8] * a_x + m [9] * a_y + m [10] * a_z + m [11])
+				-- d/dp of s * f (A p + t) is s * A^T grad f = R grad f
+				Result.set (l_dual.value * transform_scale,
+					r [0] * l_dual.dx + r [1] * l_dual.dy + r [2] * l_dual.dz,
+					r [3] * l_dual.dx + r [4] * l_dual.dy + r [5] * l_dual.dz,
+					r [6] * l_dual.dx + r [7] * l_dual.dy + r [8] * l_dual.dz)
+			else
+				Result := local_dual_at (a_x, a_y, a_z)
+			end
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- `local_interval_at' over the box enclosing the mapped box, times `scale'
+		local
+			cx, cy, cz, hx, hy, hz, lx, ly, lz, ex, ey, ez: REAL_64
+		do
+			if attached inverse_matrix as m then
+				cx := a_min_x * 0.5 + a_max_x * 0.5
+				cy := a_min_y * 0.5 + a_max_y * 0.5
+				cz := a_min_z * 0.5 + a_max_z * 0.5
+				hx := (a_max_x - a_min_x) * 0.5
+				hy := (a_max_y - a_min_y) * 0.5
+				hz := (a_max_z - a_min_z) * 0.5
+				lx := m [0] * cx + m [1] * cy + m [2] * cz + m [3]
+				ly := m [4] * cx + m [5] * cy + m [6] * cz + m [7]
+				lz := m [8] * cx + m [9] * cy + m [10] * cz + m [11]
+				ex := m [0].abs * hx + m [1].abs * hy + m [2].abs * hz
+				ey := m [4].abs * hx + m [5].abs * hy + m [6].abs * hz
+				ez := m [8].abs * hx + m [9].abs * hy + m [10].abs * hz
+				Result := local_interval_at (lx - ex, ly - ey, lz - ez, lx + ex, ly + ey, lz + ez).scaled (transform_scale)
+			else
+				Result := local_interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+			end
+		end
 
 	distance (p: SDF_VEC3): REAL_64
 			-- Signed distance from point `p' to this shape surface.
 			-- Positive = outside, negative = inside, zero = on surface.
 		require
 			point_attached: p /= Void
+		do
+			Result := distance_at (p.x, p.y, p.z)
+		end
+
+	distance_value (p: SDF_VEC3_VALUE): REAL_64
+			-- Signed distance from value point `p' to this shape surface.
+		do
+			Result := distance_at (p.x, p.y, p.z)
+		end
+
+	lipschitz_bound: REAL_64
+			-- 1: primitive distances are exact, and rotation and uniform
+			-- scale keep them exact
+		do
+			Result := 1.0
+		end
+
+feature -- Local distance
+
+	local_distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from shape-space point (x, y, z) to the
+			-- untransformed surface. Must not allocate.
 		deferred
 		end
 
-	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
-			-- Convenience: distance from point (x, y, z)
+	local_dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- `local_distance_at' with its shape-space gradient
+		deferred
+		end
+
+	local_interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Range of `local_distance_at' over a shape-space box
+		require
+			ordered_x: a_min_x <= a_max_x
+			ordered_y: a_min_y <= a_max_y
+			ordered_z: a_min_z <= a_max_z
+		deferred
+		end
+
+feature -- Bounds
+
+	bounds: SDF_AABB
+			-- Axis-aligned box enclosing the shape
+			-- (infinite for unbounded shapes).
+		local
+			l_local: SDF_AABB
+			l_pivot: SDF_VEC3
+			hx, hy, hz, cx, cy, cz: REAL_64
+		do
+			l_local := local_bounds
+			if attached rotation as r and not l_local.is_infinite then
+				l_pivot := transform_pivot
+				hx := (l_local.max_x - l_local.min_x) * 0.5
+				hy := (l_local.max_y - l_local.min_y) * 0.5
+				hz := (l_local.max_z - l_local.min_z) * 0.5
+				cx := l_local.center_x - l_pivot.x
+				cy := l_local.center_y - l_pivot.y
+				cz := l_local.center_z - l_pivot.z
+				create Result.make_around (
+					l_pivot.x + transform_scale * (r [0] * cx + r [1] * cy + r [2] * cz),
+					l_pivot.y + transform_scale * (r [3] * cx + r [4] * cy + r [5] * cz),
+					l_pivot.z + transform_scale * (r [6] * cx + r [7] * cy + r [8] * cz),
+					transform_scale * (r [0].abs * hx + r [1].abs * hy + r [2].abs * hz),
+					transform_scale * (r [3].abs * hx + r [4].abs * hy + r [5].abs * hz),
+					transform_scale * (r [6].abs * hx + r [7].abs * hy + r [8].abs * hz))
+			else
+				Result := l_local
+			end
+		ensure then
+			result_attached: Result /= Void
+			not_empty: not Result.is_empty
+		end
+
+	local_bounds: SDF_AABB
+			-- Axis-aligned box enclosing the untransformed shape
+			-- (infinite for unbounded shapes).
+		deferred
+		ensure
+			result_attached: Result /= Void
+			not_empty: not Result.is_empty
+		end
+
+feature -- Transform
+
+	is_transformed: BOOLEAN
+			-- Has the shape a rotation or scale?
+		do
+			Result := rotation /= Void
+		end
+
+	scale: REAL_64
+			-- Uniform scale about `transform_pivot' (1 when untransformed)
+		do
+			if is_transformed then
+				Result := transform_scale
+			else
+				Result := 1.0
+			end
+		ensure
+			positive: Result > 0.0
+		end
+
+	rotation_item (a_row, a_column: INTEGER): REAL_64
+			-- Entry (row, column) of the rotation matrix (identity when untransformed)
+		require
+			valid_row: a_row >= 1 and a_row <= 3
+			valid_column: a_column >= 1 and a_column <= 3
+		do
+			if attached rotation as r then
+				Result := r [(a_row - 1) * 3 + a_column - 1]
+			elseif a_row = a_column then
+				Result := 1.0
+			end
+		end
+
+	transform_pivot: SDF_VEC3
+			-- Point the rotation and scale keep in place
+		do
+			Result := position
+		ensure
+			result_attached: Result /= Void
+		end
+
+	transform_parameters: ARRAY [REAL_64]
+			-- World-to-shape matrix rows (3 x 4, row-major), then `scale':
+			-- the transform prefix of compiled and tape layouts
+		require
+			transformed: is_transformed
 		local
-			l_point: SDF_VEC3
+			i: INTEGER
 		do
-			create l_point.make (a_x, a_y, a_z)
-			Result := distance (l_point)
+			create Result.make_filled (0.0, 1, Transform_parameter_count)
+			if attached inverse_matrix as m then
+				from i := 0 until i >= 12 loop
+					Result [i + 1] := m [i]
+					i := i + 1
+				end
+			end
+			Result [Transform_parameter_count] := transform_scale
+		ensure
+			result_attached: Result /= Void
+			sized: Result.count = Transform_parameter_count
 		end
 
+	Transform_parameter_count: INTEGER = 13
+			-- Values in `transform_parameters'
+
+feature -- Change tracking
+
+	version: NATURAL_64
+			-- Number of geometric changes made to this shape
+
+feature -- Compilation
+
+	kind: INTEGER
+			-- Primitive kind code used by compiled scene layouts
+		deferred
+		ensure
+			valid_kind: Result >= Kind_sphere and Result <= Kind_plane
+		end
+
+	parameters: ARRAY [REAL_64]
+			-- Primitive parameters in compiled layout order.
+			-- See SDF_COMPILED_SCENE for the per-kind layout.
+		deferred
+		ensure
+			result_attached: Result /= Void
+			fits_entry: Result.count <= Max_parameter_count
+		end
+
+feature -- Kind constants
+
+	Kind_sphere: INTEGER = 1
+	Kind_box: INTEGER = 2
+	Kind_capsule: INTEGER = 3
+	Kind_cylinder: INTEGER = 4
+	Kind_torus: INTEGER = 5
+	Kind_plane: INTEGER = 6
+
+	Max_parameter_count: INTEGER = 12
+			-- Parameter slots available per compiled entry
+
 feature -- Status report
 
 	is_inside (p: SDF_VEC3): BOOLEAN
@@ -99,9 +344,11 @@ feature -- Element change (fluent API)
 			position_attached: a_position /= Void
 		do
 			position := a_position
+			mark_changed
 			Result := Current
 		ensure
 			position_set: position = a_position
+			changed: version > old version
 			result_is_current: Result = Current
 		end
 
@@ -113,8 +360,10 @@ feature -- Transformation (fluent API)
 			offset_attached: offset /= Void
 		do
 			position := position + offset
+			mark_changed
 			Result := Current
 		ensure
+			changed: version > old version
 			result_is_current: Result = Current
 		end
 
@@ -129,6 +378,188 @@ feature -- Transformation (fluent API)
 			result_is_current: Result = Current
 		end
 
+	set_rotation (a_axis: SDF_VEC3; a_angle: REAL_64): like Current
+			-- Turn the shape `a_angle' radians about `a_axis' through
+			-- `transform_pivot', replacing any previous rotation; return self.
+		require
+			axis_attached: a_axis /= Void
+			axis_not_zero: not a_axis.is_zero_vector
+		do
+			if not is_transformed then
+				transform_scale := 1.0
+			end
+			rotation := axis_rotation (a_axis, a_angle)
+			mark_changed
+			Result := Current
+		ensure
+			transformed: is_transformed
+			scale_kept: scale = old scale
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+	rotate (a_axis: SDF_VEC3; a_angle: REAL_64): like Current
+			-- Turn the shape a further `a_angle' radians about `a_axis'
+			-- through `transform_pivot'; return self.
+		require
+			axis_attached: a_axis /= Void
+			axis_not_zero: not a_axis.is_zero_vector
+		local
+			l_turn, l_product: SPECIAL [REAL_64]
+			i, j: INTEGER
+		do
+			l_turn := axis_rotation (a_axis, a_angle)
+			if attached rotation as r then
+				-- New rotation applied after the current one: turn * r
+				create l_product.make_filled (0.0, 9)
+				from i := 0 until i >= 3 loop
+					from j := 0 until j >= 3 loop
+						l_product [i * 3 + j] := l_turn [i * 3] * r [j] + l_turn [i * 3 + 1] * r [3 + j] + l_turn [i * 3 + 2] * r [6 + j]
+						j := j + 1
+					end
+					i := i + 1
+				end
+				rotation := l_product
+			else
+				transform_scale := 1.0
+				rotation := l_turn
+			end
+			mark_changed
+			Result := Current
+		ensure
+			transformed: is_transformed
+			scale_kept: scale = old scale
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+	set_scale (a_scale: REAL_64): like Current
+			-- Scale the shape uniformly by `a_scale' about `transform_pivot'; return self.
+		require
+			positive_scale: a_scale > 0.0
+		do
+			if not is_transformed then
+				rotation := axis_rotation (create {SDF_VEC3}.make (0.0, 1.0, 0.0), 0.0)
+			end
+			transform_scale := a_scale
+			mark_changed
+			Result := Current
+		ensure
+			transformed: is_transformed
+			scale_set: scale = a_scale
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+	reset_transform: like Current
+			-- Drop rotation and scale; return self.
+		do
+			rotation := Void
+			inverse_matrix := Void
+			transform_scale := 1.0
+			mark_changed
+			Result := Current
+		ensure
+			untransformed: not is_transformed
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+feature {NONE} -- Implementation
+
+	rotation: detachable SPECIAL [REAL_64]
+			-- Shape-to-world rotation, 3 x 3 row-major (Void: identity, no scale)
+
+	transform_scale: REAL_64
+			-- Scale set by `set_scale' (meaningful only when `is_transformed')
+
+	inverse_matrix: detachable SPECIAL [REAL_64]
+			-- World-to-shape map, 3 x 4 row-major: [R^T / s | pivot - R^T pivot / s].
+			-- Recomputed by `mark_changed'; Void when untransformed.
+
+	axis_rotation (a_axis: SDF_VEC3; a_angle: REAL_64): SPECIAL [REAL_64]
+			-- Rotation by `a_angle' radians about `a_axis' (Rodrigues' formula)
+		require
+			axis_attached: a_axis /= Void
+			axis_not_zero: not a_axis.is_zero_vector
+		local
+			kx, ky, kz, l_length, c, s, t: REAL_64
+		do
+			l_length := a_axis.length
+			kx := a_axis.x / l_length
+			ky := a_axis.y / l_length
+			kz := a_axis.z / l_length
+			c := {DOUBLE_MATH}.cosine (a_angle)
+			s := {DOUBLE_MATH}.sine (a_angle)
+			t := 1.0 - c
+			create Result.make_filled (0.0, 9)
+			Result [0] := c + t * kx * kx
+			Result [1] := t * kx * ky - s * kz
+			Result [2] := t * kx * kz + s * ky
+			Result [3] := t * kx * ky + s * kz
+			Result [4] := c + t * ky * ky
+			Result [5] := t * ky * kz - s * kx
+			Result [6] := t * kx * kz - s * ky
+			Result [7] := t * ky * kz + s * kx
+			Result [8] := c + t * kz * kz
+		ensure
+			sized: Result.count = 9
+		end
+
+	update_inverse
+			-- Recompute `inverse_matrix' from `rotation', `transform_scale'
+			-- and `transform_pivot'.
+		local
+			l_pivot: SDF_VEC3
+			m: SPECIAL [REAL_64]
+			i: INTEGER
+		do
+			if attached rotation as r then
+				l_pivot := transform_pivot
+				create m.make_filled (0.0, 12)
+				from i := 0 until i >= 3 loop
+					-- Row i of R^T / s is column i of R
+					m [i * 4] := r [i] / transform_scale
+					m [i * 4 + 1] := r [3 + i] / transform_scale
+					m [i * 4 + 2] := r [6 + i] / transform_scale
+					m [i * 4 + 3] := pivot_component (l_pivot, i)
+						- (m [i * 4] * l_pivot.x + m [i * 4 + 1] * l_pivot.y + m [i * 4 + 2] * l_pivot.z)
+					i := i + 1
+				end
+				inverse_matrix := m
+			else
+				inverse_matrix := Void
+			end
+		ensure
+			cached: is_transformed = (inverse_matrix /= Void)
+		end
+
+	pivot_component (a_pivot: SDF_VEC3; a_index: INTEGER): REAL_64
+			-- Component `a_index' (0 = x, 1 = y, 2 = z) of `a_pivot'
+		do
+			inspect a_index
+			when 0 then
+				Result := a_pivot.x
+			when 1 then
+				Result := a_pivot.y
+			else
+				Result := a_pivot.z
+			end
+		end
+
+	mark_changed
+			-- Record a change of the shape's geometry and refresh the
+			-- cached inverse transform.
+		do
+			version := version + 1
+			change_counter.put (change_counter.item + 1)
+			if is_transformed then
+				update_inverse
+			end
+		ensure
+			version_incremented: version = old version + 1
+		end
+
 feature {NONE} -- Constants
 
 	Surface_epsilon: REAL_64 = 0.0001
@@ -136,5 +567,7 @@ feature {NONE} -- Constants
 
 invariant
 	position_attached: position /= Void
+	inverse_cached: is_transformed = (inverse_matrix /= Void)
+	positive_scale: is_transformed implies transform_scale > 0.0
 
 end
@@ -0,0 +1,32 @@
+note
+	description: "[
+		Shared counter of geometric changes to SDF shapes.
+
+		Every shape edit (SDF_SHAPE.mark_changed) bumps the counter, so
+		caches built from shapes can detect "nothing moved" with a single
+		comparison instead of checking every shape's `version'.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_SHARED_CHANGE_STAMP
+
+feature -- Access
+
+	change_stamp: NATURAL_64
+			-- Number of geometric changes made to any shape so far
+		do
+			Result := change_counter.item
+		end
+
+feature {NONE} -- Implementation
+
+	change_counter: CELL [NATURAL_64]
+			-- Shared counter behind `change_stamp'
+		once
+			create Result.put (0)
+		end
+
+end
@@ -39,13 +39,67 @@ feature -- Access
 	radius: REAL_64
 			-- Sphere radius
 
-feature -- Distance
+feature -- Local distance
 
-	distance (p: SDF_VEC3): REAL_64
-			-- Signed distance from point `p' to sphere surface.
+	local_distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from point (x, y, z) to sphere surface.
 			-- Formula: length(p - center) - radius
+		local
+			dx, dy, dz: REAL_64
 		do
-			Result := p.minus (position).length - radius
+			dx := a_x - position.x
+			dy := a_y - position.y
+			dz := a_z - position.z
+			Result := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz) - radius
+		end
+
+	local_dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance with gradient: (p - center) / |p - center|
+		local
+			dx, dy, dz, l: REAL_64
+		do
+			dx := a_x - position.x
+			dy := a_y - position.y
+			dz := a_z - position.z
+			l := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz)
+			if l > 0.0 then
+				Result.set (l - radius, dx / l, dy / l, dz / l)
+			else
+				Result.set (- radius, 0.0, 0.0, 0.0)
+			end
+		end
+
+	local_interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Distance range over a box: |p - center| - radius
+		local
+			ix, iy, iz: SDF_INTERVAL
+		do
+			ix.set (a_min_x - position.x, a_max_x - position.x)
+			iy.set (a_min_y - position.y, a_max_y - position.y)
+			iz.set (a_min_z - position.z, a_max_z - position.z)
+			Result := (ix.squared + iy.squared + iz.squared).square_root.plus_value (- radius)
+		end
+
+feature -- Local bounds
+
+	local_bounds: SDF_AABB
+			-- Center +/- radius
+		do
+			create Result.make_around (position.x, position.y, position.z, radius, radius, radius)
+		end
+
+feature -- Compilation
+
+	kind: INTEGER
+			-- Sphere kind code
+		do
+			Result := Kind_sphere
+		end
+
+	parameters: ARRAY [REAL_64]
+			-- Center (x, y, z), radius
+		do
+			Result := <<position.x, position.y, position.z, radius>>
 		end
 
 feature -- Element change (fluent API)
@@ -56,6 +110,7 @@ feature -- Element change (fluent API)
 			positive_radius: a_radius > 0.0
 		do
 			radius := a_radius
+			mark_changed
 			Result := Current
 		ensure
 			radius_set: radius = a_radius
@@ -48,24 +48,73 @@ feature -- Access
 	minor_radius: REAL_64
 			-- Tube radius
 
-feature -- Distance
+feature -- Local distance
 
-	distance (p: SDF_VEC3): REAL_64
-			-- Signed distance from point `p' to torus surface.
+	local_distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from point (x, y, z) to torus surface.
 		local
-			l_local: SDF_VEC3
-			q: SDF_VEC2
+			lx, ly, lz: REAL_64
+			qx: REAL_64
 		do
 			-- Transform to torus-local coordinates
-			l_local := p - position
+			lx := a_x - position.x
+			ly := a_y - position.y
+			lz := a_z - position.z
 
 			-- Project onto XZ plane, get distance to ring center
 			-- q.x = distance from ring center in XZ
 			-- q.y = height (Y coordinate)
-			create q.make (l_local.xz.length - major_radius, l_local.y)
+			qx := {DOUBLE_MATH}.sqrt (lx * lx + lz * lz) - major_radius
 
 			-- Distance to tube surface
-			Result := q.length - minor_radius
+			Result := {DOUBLE_MATH}.sqrt (qx * qx + ly * ly) - minor_radius
+		end
+
+	local_dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance with gradient (dual form of `local_distance_at')
+		local
+			lx, ly, lz, qx: SDF_DUAL
+		do
+			lx.set (a_x - position.x, 1.0, 0.0, 0.0)
+			ly.set (a_y - position.y, 0.0, 1.0, 0.0)
+			lz.set (a_z - position.z, 0.0, 0.0, 1.0)
+			qx := (lx.squared + lz.squared).square_root.plus_value (- major_radius)
+			Result := (qx.squared + ly.squared).square_root.plus_value (- minor_radius)
+		end
+
+	local_interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Distance range over a box (interval form of `local_distance_at')
+		local
+			lx, ly, lz, qx: SDF_INTERVAL
+		do
+			lx.set (a_min_x - position.x, a_max_x - position.x)
+			ly.set (a_min_y - position.y, a_max_y - position.y)
+			lz.set (a_min_z - position.z, a_max_z - position.z)
+			qx := (lx.squared + lz.squared).square_root.plus_value (- major_radius)
+			Result := (qx.squared + ly.squared).square_root.plus_value (- minor_radius)
+		end
+
+feature -- Local bounds
+
+	local_bounds: SDF_AABB
+			-- Center +/- (major + minor, minor, major + minor)
+		do
+			create Result.make_around (position.x, position.y, position.z,
+				major_radius + minor_radius, minor_radius, major_radius + minor_radius)
+		end
+
+feature -- Compilation
+
+	kind: INTEGER
+			-- Torus kind code
+		do
+			Result := Kind_torus
+		end
+
+	parameters: ARRAY [REAL_64]
+			-- Center (x, y, z), major radius, minor radius
+		do
+			Result := <<position.x, position.y, position.z, major_radius, minor_radius>>
 		end
 
 feature -- Element change (fluent API)
@@ -77,6 +126,7 @@ feature -- Element change (fluent API)
 			greater_than_minor: a_radius > minor_radius
 		do
 			major_radius := a_radius
+			mark_changed
 			Result := Current
 		ensure
 			radius_set: major_radius = a_radius
@@ -90,6 +140,7 @@ feature -- Element change (fluent API)
 			less_than_major: a_radius < major_radius
 		do
 			minor_radius := a_radius
+			mark_changed
 			Result := Current
 		ensure
 			radius_set: minor_radius = a_radius
@@ -36,6 +36,12 @@ note
 		CALLBACKS:
 			sdf.set_on_frame (agent my_update)        -- Per-frame logic
 
+		TEMPORAL REPROJECTION (shaders from SDF_GLSL_BUILDER with it enabled):
+			sdf.enable_temporal_reprojection          -- Start rays at last frame's depth
+
+		VARIABLE-RATE SHADING (shaders from SDF_GLSL_BUILDER at the same rate):
+			sdf.set_shading_rate ({SDF_GLSL_BUILDER}.Shading_rate_checkerboard)
+
 		CONTROLS (built-in):
 			WASD, Space/Ctrl    - Move
 			Arrows              - Look
@@ -159,6 +165,46 @@ feature -- Animation Control
 			time_scale := a_scale
 		end
 
+feature -- Temporal Reprojection
+
+	is_temporal_reprojection: BOOLEAN
+			-- Does each frame reproject the previous frame's depth before marching?
+
+	enable_temporal_reprojection
+			-- Keep a depth buffer across frames and dispatch the shader twice per
+			-- frame: pass 0 reprojects last frame's depth into the moved camera,
+			-- pass 1 marches from it. The shader must be generated with
+			-- {SDF_GLSL_BUILDER}.set_temporal_reprojection (True).
+			-- Ignored at reduced `shading_rate's, which replace it.
+			-- Takes effect at the next `run'.
+		do
+			is_temporal_reprojection := True
+		end
+
+	disable_temporal_reprojection
+			-- March every frame from the camera.
+		do
+			is_temporal_reprojection := False
+		end
+
+feature -- Shading Rate
+
+	shading_rate: INTEGER
+			-- Pixels the shader marches per frame (a {SDF_GLSL_BUILDER} shading rate).
+
+	set_shading_rate (a_rate: INTEGER)
+			-- Match the dispatch to a shader generated with
+			-- {SDF_GLSL_BUILDER}.set_shading_rate (`a_rate').
+		require
+			valid_rate: a_rate = {SDF_GLSL_BUILDER}.Shading_rate_full
+				or a_rate = {SDF_GLSL_BUILDER}.Shading_rate_checkerboard
+				or a_rate = {SDF_GLSL_BUILDER}.Shading_rate_quarter
+		do
+			shading_rate := a_rate
+		ensure
+			set: shading_rate = a_rate
+		end
+
 feature -- Screenshots
 
 	screenshot (a_path: STRING)
@@ -198,6 +244,10 @@ feature -- Constants
 	Default_shader: STRING = "sdf_buffer_output.spv"
 			-- Default shader used when no custom shader specified.
 
+	Params_size: INTEGER = 64
+			-- Bytes of the shader parameter block: camera, time and size (0..31),
+			-- previous camera (32..51), dispatch pass (52) and frame index (56).
+
 feature {NONE} -- Implementation
 
 	running, screenshot_pending: BOOLEAN
@@ -208,6 +258,7 @@ feature {NONE} -- Implementation
 	shader: detachable VULKAN_SHADER
 	pipeline: detachable VULKAN_PIPELINE
 	output_buffer, params_buffer: detachable VULKAN_BUFFER
+	depth_buffer, reprojected_buffer: detachable VULKAN_BUFFER
 	mfb: detachable SIMPLE_MINIFB
 	window: detachable MINIFB_WINDOW
 	display_buffer: detachable MINIFB_BUFFER
@@ -230,7 +281,7 @@ feature {NONE} -- Implementation
 					l_pipe := l_vk.create_pipeline (l_ctx, l_sh); pipeline := l_pipe
 					if l_pipe.is_valid then
 						l_out := l_vk.create_buffer (l_ctx, (a_w * a_h * 4).to_integer_64, l_vk.Buffer_storage | l_vk.Buffer_transfer)
-						l_par := l_vk.create_buffer (l_ctx, 32, l_vk.Buffer_storage)
+						l_par := l_vk.create_buffer (l_ctx, Params_size, l_vk.Buffer_storage)
 						output_buffer := l_out; params_buffer := l_par
 						if l_out.is_valid and l_par.is_valid then
 							l_pipe.bind_buffer (0, l_out).do_nothing
@@ -259,10 +310,39 @@ feature {NONE} -- Implementation
 			end
 		end
 
+	prepare_temporal_buffers: BOOLEAN
+			-- Create and bind the depth buffers of temporal reprojection:
+			-- no depth yet (0) and nothing reprojected (+infinity bits).
+		local
+			l_depth, l_seen: VULKAN_BUFFER
+			l_init: MANAGED_POINTER
+			i: INTEGER
+		do
+			if attached vk as l_vk and attached ctx as c and attached pipeline as p then
+				l_depth := l_vk.create_buffer (c, (width * height * 4).to_integer_64, l_vk.Buffer_storage)
+				l_seen := l_vk.create_buffer (c, (width * height * 4).to_integer_64, l_vk.Buffer_storage)
+				depth_buffer := l_depth; reprojected_buffer := l_seen
+				if l_depth.is_valid and l_seen.is_valid then
+					create l_init.make (width * height * 4)
+					l_depth.upload (l_init.item, (width * height * 4).to_integer_64, 0).do_nothing
+					from i := 0 until i >= width * height loop
+						l_init.put_natural_32 (0x7F800000, i * 4); i := i + 1
+					end
+					l_seen.upload (l_init.item, (width * height * 4).to_integer_64, 0).do_nothing
+					p.bind_buffer (2, l_depth).do_nothing
+					p.bind_buffer (3, l_seen).do_nothing
+					Result := True
+				end
+			end
+		end
+
 	render_loop
 		local
 			params, pixels: MANAGED_POINTER
 			fps_count: INTEGER; fps_time, dt: REAL
+			prev_x, prev_y, prev_z, prev_yaw, prev_pitch: REAL
+			temporal: BOOLEAN
+			tile_w, tile_h: INTEGER
 			lw: MINIFB_WINDOW; lb: MINIFB_BUFFER; lc: VULKAN_CONTEXT
 			lp: VULKAN_PIPELINE; lo, lpa: VULKAN_BUFFER
 			m: DOUBLE_MATH
@@ -270,8 +350,20 @@ feature {NONE} -- Implementation
 			if attached window as w and attached display_buffer as b and attached ctx as c and
 			   attached pipeline as p and attached output_buffer as ob and attached params_buffer as pb then
 				lw := w; lb := b; lc := c; lp := p; lo := ob; lpa := pb
-				create params.make (32); create pixels.make (width * height * 4); create m
+				create params.make (Params_size); create pixels.make (width * height * 4); create m
 				running := True; time := 0; real_time := 0; fps_time := 0; dt := 0.016
+				-- Reduced rates replace reprojection: their shaders have no pass 0
+				temporal := is_temporal_reprojection and then shading_rate = {SDF_GLSL_BUILDER}.Shading_rate_full
+					and then prepare_temporal_buffers
+				if is_temporal_reprojection and shading_rate = {SDF_GLSL_BUILDER}.Shading_rate_full and not temporal then
+					print ("Temporal reprojection unavailable, marching every frame from the camera%N")
+				end
+				prev_x := camera_x; prev_y := camera_y; prev_z := camera_z
+				prev_yaw := camera_yaw; prev_pitch := camera_pitch
+				-- Reduced-rate shaders cover 2x1 or 2x2 pixels per invocation
+				tile_w := 16; tile_h := 16
+				if shading_rate /= {SDF_GLSL_BUILDER}.Shading_rate_full then tile_w := 32 end
+				if shading_rate = {SDF_GLSL_BUILDER}.Shading_rate_quarter then tile_h := 32 end
 
 				from until not running or lw.should_close loop
 					handle_input (lw)
@@ -293,9 +385,23 @@ feature {NONE} -- Implementation
 					params.put_real_32 (camera_pitch, 16); params.put_real_32 (time, 20)
 					params.put_natural_32 (width.to_natural_32, 24); params.put_natural_32 (height.to_natural_32, 28)
 
-					lpa.upload (params.item, 32, 0).do_nothing
-					lp.dispatch (lc, (width + 15) // 16, (height + 15) // 16, 1).do_nothing
+					params.put_real_32 (prev_x, 32); params.put_real_32 (prev_y, 36)
+					params.put_real_32 (prev_z, 40); params.put_real_32 (prev_yaw, 44)
+					params.put_real_32 (prev_pitch, 48); params.put_natural_32 (frame_count.to_natural_32, 56)
+
+					if temporal then
+						-- Pass 0: reproject last frame's depth into this camera
+						params.put_natural_32 (0, 52)
+						lpa.upload (params.item, Params_size, 0).do_nothing
+						lp.dispatch (lc, (width + 15) // 16, (height + 15) // 16, 1).do_nothing
+						lp.wait_idle (lc)
+					end
+					params.put_natural_32 (1, 52)
+					lpa.upload (params.item, Params_size, 0).do_nothing
+					lp.dispatch (lc, (width + tile_w - 1) // tile_w, (height + tile_h - 1) // tile_h, 1).do_nothing
 					lp.wait_idle (lc)
+					prev_x := camera_x; prev_y := camera_y; prev_z := camera_z
+					prev_yaw := camera_yaw; prev_pitch := camera_pitch
 					lo.download (pixels.item, (width * height * 4).to_integer_64, 0).do_nothing
 
 					if screenshot_pending then
@@ -390,6 +496,8 @@ feature {NONE} -- Implementation
 		do
 			if attached output_buffer as b then b.dispose end
 			if attached params_buffer as b then b.dispose end
+			if attached depth_buffer as b then b.dispose end
+			if attached reprojected_buffer as b then b.dispose end
 			if attached pipeline as p then p.dispose end
 			if attached shader as s then s.dispose end
 			if attached ctx as c then c.dispose end
@@ -0,0 +1,210 @@
+note
+	description: "[
+		Caller-owned hit results of SDF_RAY_MARCHER.march_batch.
+
+		Structure-of-arrays counterpart of SDF_RAY_HIT: one slot per ray
+		holding hit flag, depth, position, normal and step count. The
+		buffer is allocated once and overwritten by every batch, so tracing
+		does not create objects. Slot indices are 1-based; the SPECIAL
+		arrays are 0-based (slot `i' at index `i - 1').
+
+		Normals are optional: when a batch is marched without them,
+		`has_normals' is False until SDF_RAY_MARCHER.compute_batch_normals
+		fills them for the hit slots.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_HIT_BUFFER
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_capacity: INTEGER)
+			-- Create buffer with room for `a_capacity' results.
+		require
+			positive_capacity: a_capacity > 0
+		do
+			capacity := a_capacity
+			create hits.make_filled (False, a_capacity)
+			create depths.make_filled (0.0, a_capacity)
+			create position_x.make_filled (0.0, a_capacity)
+			create position_y.make_filled (0.0, a_capacity)
+			create position_z.make_filled (0.0, a_capacity)
+			create normal_x.make_filled (0.0, a_capacity)
+			create normal_y.make_filled (0.0, a_capacity)
+			create normal_z.make_filled (0.0, a_capacity)
+			create steps.make_filled (0, a_capacity)
+		ensure
+			capacity_set: capacity = a_capacity
+			empty: count = 0
+		end
+
+feature -- Access
+
+	capacity: INTEGER
+			-- Maximum number of results
+
+	count: INTEGER
+			-- Number of results written by the last batch
+
+	hit_count: INTEGER
+			-- Number of hits among the last `count' results
+
+	hits: SPECIAL [BOOLEAN]
+			-- Hit flags
+
+	depths: SPECIAL [REAL_64]
+			-- Distance traveled along each ray (zero if miss)
+
+	position_x, position_y, position_z: SPECIAL [REAL_64]
+			-- Hit positions (zero if miss)
+
+	normal_x, normal_y, normal_z: SPECIAL [REAL_64]
+			-- Surface normals (zero if miss or not computed)
+
+	steps: SPECIAL [INTEGER]
+			-- March steps taken per ray
+
+	is_hit (a_index: INTEGER): BOOLEAN
+			-- Did ray `a_index' hit a surface?
+		require
+			valid_index: a_index >= 1 and a_index <= count
+		do
+			Result := hits [a_index - 1]
+		end
+
+	depth (a_index: INTEGER): REAL_64
+			-- Distance traveled by ray `a_index'
+		require
+			valid_index: a_index >= 1 and a_index <= count
+		do
+			Result := depths [a_index - 1]
+		end
+
+	step_count (a_index: INTEGER): INTEGER
+			-- March steps taken by ray `a_index'
+		require
+			valid_index: a_index >= 1 and a_index <= count
+		do
+			Result := steps [a_index - 1]
+		end
+
+	to_hit (a_index: INTEGER): SDF_RAY_HIT
+			-- Result `a_index' as a (newly created) SDF_RAY_HIT
+		require
+			valid_index: a_index >= 1 and a_index <= count
+			normals_available: is_hit (a_index) implies has_normals
+		local
+			i: INTEGER
+		do
+			i := a_index - 1
+			if hits [i] then
+				create Result.make_hit (
+					create {SDF_VEC3}.make (position_x [i], position_y [i], position_z [i]),
+					depths [i],
+					create {SDF_VEC3}.make (normal_x [i], normal_y [i], normal_z [i]),
+					steps [i])
+			else
+				create Result.make_miss (steps [i])
+			end
+		ensure
+			result_attached: Result /= Void
+			same_hit: Result.hit = is_hit (a_index)
+		end
+
+feature -- Status report
+
+	has_normals: BOOLEAN
+			-- Are normals filled in for the hit slots?
+
+feature {SDF_RAY_MARCHER} -- Element change
+
+	reset (a_count: INTEGER)
+			-- Prepare for a batch of `a_count' results.
+		require
+			valid_count: a_count >= 0 and a_count <= capacity
+		do
+			count := a_count
+			hit_count := 0
+			has_normals := False
+		ensure
+			count_set: count = a_count
+			no_hits: hit_count = 0
+			no_normals: not has_normals
+		end
+
+	put_hit (a_index: INTEGER; a_depth, a_x, a_y, a_z: REAL_64; a_steps: INTEGER)
+			-- Record hit of ray `a_index' at (x, y, z) after `a_depth'.
+		require
+			valid_index: a_index >= 1 and a_index <= count
+		local
+			i: INTEGER
+		do
+			i := a_index - 1
+			hits [i] := True
+			depths [i] := a_depth
+			position_x [i] := a_x
+			position_y [i] := a_y
+			position_z [i] := a_z
+			normal_x [i] := 0.0
+			normal_y [i] := 0.0
+			normal_z [i] := 0.0
+			steps [i] := a_steps
+			hit_count := hit_count + 1
+		ensure
+			is_hit: is_hit (a_index)
+		end
+
+	put_miss (a_index: INTEGER; a_steps: INTEGER)
+			-- Record miss of ray `a_index'.
+		require
+			valid_index: a_index >= 1 and a_index <= count
+		local
+			i: INTEGER
+		do
+			i := a_index - 1
+			hits [i] := False
+			depths [i] := 0.0
+			position_x [i] := 0.0
+			position_y [i] := 0.0
+			position_z [i] := 0.0
+			normal_x [i] := 0.0
+			normal_y [i] := 0.0
+			normal_z [i] := 0.0
+			steps [i] := a_steps
+		ensure
+			is_miss: not is_hit (a_index)
+		end
+
+	put_normal (a_index: INTEGER; a_nx, a_ny, a_nz: REAL_64)
+			-- Set normal of hit `a_index'.
+		require
+			valid_index: a_index >= 1 and a_index <= count
+			is_hit: is_hit (a_index)
+		do
+			normal_x [a_index - 1] := a_nx
+			normal_y [a_index - 1] := a_ny
+			normal_z [a_index - 1] := a_nz
+		end
+
+	set_has_normals
+			-- Mark normals as filled in.
+		do
+			has_normals := True
+		ensure
+			has_normals: has_normals
+		end
+
+invariant
+	valid_count: count >= 0 and count <= capacity
+	valid_hit_count: hit_count >= 0 and hit_count <= count
+	arrays_sized: hits.count = capacity and depths.count = capacity and steps.count = capacity
+	positions_sized: position_x.count = capacity and position_y.count = capacity and position_z.count = capacity
+	normals_sized: normal_x.count = capacity and normal_y.count = capacity and normal_z.count = capacity
+
+end
@@ -0,0 +1,115 @@
+note
+	description: "[
+		Batch of rays in structure-of-arrays layout for SDF_RAY_MARCHER.march_batch.
+
+		Origins and directions are stored as six parallel REAL_64 arrays so a
+		batch of picking or visibility rays can be refilled every frame
+		without creating SDF_VEC3 objects. Ray indices are 1-based; the
+		underlying SPECIAL arrays are 0-based (ray `i' at index `i - 1').
+
+		Directions must be unit length; `set_ray' checks this, bulk writers
+		into the arrays are responsible for it themselves.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_RAY_BATCH
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_capacity: INTEGER)
+			-- Create empty batch able to hold `a_capacity' rays.
+		require
+			positive_capacity: a_capacity > 0
+		do
+			capacity := a_capacity
+			create origin_x.make_filled (0.0, a_capacity)
+			create origin_y.make_filled (0.0, a_capacity)
+			create origin_z.make_filled (0.0, a_capacity)
+			create direction_x.make_filled (0.0, a_capacity)
+			create direction_y.make_filled (0.0, a_capacity)
+			create direction_z.make_filled (0.0, a_capacity)
+		ensure
+			capacity_set: capacity = a_capacity
+			empty: count = 0
+		end
+
+feature -- Access
+
+	capacity: INTEGER
+			-- Maximum number of rays
+
+	count: INTEGER
+			-- Number of rays in the batch
+
+	origin_x, origin_y, origin_z: SPECIAL [REAL_64]
+			-- Ray origins (0-based storage)
+
+	direction_x, direction_y, direction_z: SPECIAL [REAL_64]
+			-- Unit ray directions (0-based storage)
+
+feature -- Element change
+
+	set_ray (a_index: INTEGER; a_ox, a_oy, a_oz, a_dx, a_dy, a_dz: REAL_64)
+			-- Set ray `a_index' to origin (ox, oy, oz) and direction (dx, dy, dz).
+		require
+			valid_index: a_index >= 1 and a_index <= count
+			direction_is_unit: ((a_dx * a_dx + a_dy * a_dy + a_dz * a_dz) - 1.0).abs < Direction_tolerance
+		do
+			origin_x [a_index - 1] := a_ox
+			origin_y [a_index - 1] := a_oy
+			origin_z [a_index - 1] := a_oz
+			direction_x [a_index - 1] := a_dx
+			direction_y [a_index - 1] := a_dy
+			direction_z [a_index - 1] := a_dz
+		ensure
+			origin_set: origin_x [a_index - 1] = a_ox and origin_y [a_index - 1] = a_oy and origin_z [a_index - 1] = a_oz
+			direction_set: direction_x [a_index - 1] = a_dx and direction_y [a_index - 1] = a_dy and direction_z [a_index - 1] = a_dz
+		end
+
+	set_count (a_count: INTEGER)
+			-- Set number of rays in use to `a_count'.
+		require
+			valid_count: a_count >= 0 and a_count <= capacity
+		do
+			count := a_count
+		ensure
+			count_set: count = a_count
+		end
+
+	extend (a_ox, a_oy, a_oz, a_dx, a_dy, a_dz: REAL_64)
+			-- Append ray with origin (ox, oy, oz) and direction (dx, dy, dz).
+		require
+			not_full: count < capacity
+			direction_is_unit: ((a_dx * a_dx + a_dy * a_dy + a_dz * a_dz) - 1.0).abs < Direction_tolerance
+		do
+			count := count + 1
+			set_ray (count, a_ox, a_oy, a_oz, a_dx, a_dy, a_dz)
+		ensure
+			one_more: count = old count + 1
+		end
+
+	wipe_out
+			-- Remove all rays (storage is kept).
+		do
+			count := 0
+		ensure
+			empty: count = 0
+		end
+
+feature {NONE} -- Constants
+
+	Direction_tolerance: REAL_64 = 1.0e-6
+			-- Allowed deviation of squared direction length from 1
+
+invariant
+	valid_count: count >= 0 and count <= capacity
+	origins_sized: origin_x.count = capacity and origin_y.count = capacity and origin_z.count = capacity
+	directions_sized: direction_x.count = capacity and direction_y.count = capacity and direction_z.count = capacity
+
+end
@@ -3,13 +3,52 @@ note
 		Ray marcher for SDF rendering.
 
 		Ray marching algorithm:
-		1. Start at ray origin
+		1. Start where the ray enters the field's bounds
 		2. Evaluate SDF distance at current position
 		3. If distance < threshold, we hit the surface
-		4. Otherwise, march forward by the distance value
-		5. Repeat until hit, max distance, or max steps
-
-		Surface normals are computed via numerical gradient.
+		4. Otherwise, march forward by `relaxation' times the distance value
+		5. Repeat until hit, the ray leaves the bounds, or max steps
+
+		With `relaxation' above 1 (enhanced sphere tracing) a step can leave
+		the unbounding sphere of the previous point. When the spheres of two
+		consecutive points stop overlapping the ray steps back to the plain
+		step and marches with a factor of 1 from there.
+
+		Distances are divided by the field's `lipschitz_bound' before they
+		are used as steps or compared with `surface_threshold', so fields
+		that change faster than true distances are marched safely without
+		shrinking the threshold for every field.
+
+		Surface normals are the normalized gradient from the field's
+		`dual_at' (forward-mode differentiation, one evaluation per
+		normal). Where that gradient vanishes they fall back to central
+		differences over `normal_epsilon' (six evaluations), which
+		`difference_normal_at' also exposes directly.
+
+		`precision' selects the arithmetic of the march. `Precision_double'
+		runs every step on `distance_at' in REAL_64. `Precision_mixed'
+		runs the bulk of the march in REAL_32 on the field's
+		`distance_at_32' and finishes each approach to a surface in
+		REAL_64, so hit points and normals keep double accuracy.
+
+		Every ray is first clipped to the field's `bounds', widened by the
+		hit tolerance: the march starts where the ray enters the box and
+		stops where it leaves it, and a ray that misses the box returns a
+		miss after zero steps.
+
+		With an `occupancy' grid (SDF_OCCUPANCY_GRID, built from the
+		field being marched) a ray that reaches a cell proven empty
+		crosses the run of empty cells in one DDA walk, without
+		evaluating the field, and resumes sphere tracing in the first
+		cell that may hold surface.
+
+		Any SDF_FIELD can be marched, including a baked SDF_BRICK_FIELD
+		or a camera-centred SDF_CLIPMAP_FIELD, whose samples cost a few
+		fetches instead of a scene walk.
+
+		`march_batch' traces an SDF_RAY_BATCH into a caller-owned
+		SDF_HIT_BUFFER without allocating; normals can be deferred to
+		`compute_batch_normals'.
 	]"
 	author: "Larry Rix"
 	date: "$Date$"
@@ -35,6 +74,9 @@ feature {NONE} -- Initialization
 			max_distance := a_max_distance
 			surface_threshold := a_surface_threshold
 			normal_epsilon := 0.0001
+			relaxation := Default_relaxation
+			precision := Precision_double
+			create clip_box.make_infinite
 		ensure
 			max_steps_set: max_steps = a_max_steps
 			max_distance_set: max_distance = a_max_distance
@@ -48,10 +90,15 @@ feature {NONE} -- Initialization
 			max_distance := Default_max_distance
 			surface_threshold := Default_surface_threshold
 			normal_epsilon := 0.0001
+			relaxation := Default_relaxation
+			precision := Precision_double
+			create clip_box.make_infinite
 		ensure
 			default_steps: max_steps = Default_max_steps
 			default_distance: max_distance = Default_max_distance
 			default_threshold: surface_threshold = Default_surface_threshold
+			default_relaxation: relaxation = Default_relaxation
+			double_precision: precision = Precision_double
 		end
 
 feature -- Access
@@ -66,7 +113,24 @@ feature -- Access
 			-- Distance considered "on surface"
 
 	normal_epsilon: REAL_64
-			-- Epsilon for normal computation
+			-- Epsilon for central-difference normals
+
+	relaxation: REAL_64
+			-- Step factor of enhanced sphere tracing (1 = plain sphere tracing)
+
+	precision: INTEGER
+			-- Arithmetic of the march: `Precision_double' or `Precision_mixed'
+
+	occupancy: detachable SDF_OCCUPANCY_GRID
+			-- Empty-space grid of the field being marched (Void: none)
+
+feature -- Status report
+
+	is_valid_precision (a_precision: INTEGER): BOOLEAN
+			-- Is `a_precision' a precision mode?
+		do
+			Result := a_precision = Precision_double or a_precision = Precision_mixed
+		end
 
 feature -- Element change
 
@@ -118,6 +182,42 @@ feature -- Element change
 			result_is_current: Result = Current
 		end
 
+	set_relaxation (a_value: REAL_64): like Current
+			-- Set enhanced sphere tracing step factor and return self.
+		require
+			at_least_one: a_value >= 1.0
+			below_two: a_value < 2.0
+		do
+			relaxation := a_value
+			Result := Current
+		ensure
+			relaxation_set: relaxation = a_value
+			result_is_current: Result = Current
+		end
+
+	set_precision (a_precision: INTEGER): like Current
+			-- Set march arithmetic and return self.
+		require
+			valid_precision: is_valid_precision (a_precision)
+		do
+			precision := a_precision
+			Result := Current
+		ensure
+			precision_set: precision = a_precision
+			result_is_current: Result = Current
+		end
+
+	set_occupancy (a_grid: detachable SDF_OCCUPANCY_GRID): like Current
+			-- Skip empty space with `a_grid' (Void: march every step) and return self.
+			-- `a_grid' must be built from the field the rays are marched through.
+		do
+			occupancy := a_grid
+			Result := Current
+		ensure
+			occupancy_set: occupancy = a_grid
+			result_is_current: Result = Current
+		end
+
 feature -- Ray marching
 
 	march (a_scene: SDF_SCENE; a_origin, a_direction: SDF_VEC3): SDF_RAY_HIT
@@ -127,37 +227,8 @@ feature -- Ray marching
 			origin_attached: a_origin /= Void
 			direction_attached: a_direction /= Void
 			direction_is_unit: a_direction.is_unit_vector
-		local
-			l_depth: REAL_64
-			l_step: INTEGER
-			l_point: SDF_VEC3
-			l_dist: REAL_64
-			l_normal: SDF_VEC3
 		do
-			from
-				l_depth := 0.0
-				l_step := 0
-			until
-				l_step >= max_steps or l_depth >= max_distance
-			loop
-				l_point := a_origin + (a_direction * l_depth)
-				l_dist := a_scene.distance (l_point)
-
-				if l_dist.abs < surface_threshold then
-					-- Hit surface
-					l_normal := compute_normal (a_scene, l_point)
-					create Result.make_hit (l_point, l_depth, l_normal, l_step + 1)
-					l_step := max_steps  -- Exit loop
-				else
-					l_depth := l_depth + l_dist
-					l_step := l_step + 1
-				end
-			end
-
-			if Result = Void then
-				-- Ray missed
-				create Result.make_miss (l_step)
-			end
+			Result := march_field (a_scene, a_origin, a_direction)
 		ensure
 			result_attached: Result /= Void
 		end
@@ -169,39 +240,67 @@ feature -- Ray marching
 			origin_attached: a_origin /= Void
 			direction_attached: a_direction /= Void
 			direction_is_unit: a_direction.is_unit_vector
-		local
-			l_depth: REAL_64
-			l_step: INTEGER
-			l_point: SDF_VEC3
-			l_dist: REAL_64
-			l_normal: SDF_VEC3
 		do
-			from
-				l_depth := 0.0
-				l_step := 0
-			until
-				l_step >= max_steps or l_depth >= max_distance
-			loop
-				l_point := a_origin + (a_direction * l_depth)
-				l_dist := a_shape.distance (l_point)
+			Result := march_field (a_shape, a_origin, a_direction)
+		ensure
+			result_attached: Result /= Void
+		end
 
-				if l_dist.abs < surface_threshold then
-					-- Hit surface
-					l_normal := compute_normal_shape (a_shape, l_point)
-					create Result.make_hit (l_point, l_depth, l_normal, l_step + 1)
-					l_step := max_steps  -- Exit loop
+	march_field (a_field: SDF_FIELD; a_origin, a_direction: SDF_VEC3): SDF_RAY_HIT
+			-- March ray through any distance field, return hit info.
+			-- The step loop is allocation-free; only the result is created.
+		require
+			field_attached: a_field /= Void
+			origin_attached: a_origin /= Void
+			direction_attached: a_direction /= Void
+			direction_is_unit: a_direction.is_unit_vector
+		do
+			step_scale := 1.0 / a_field.lipschitz_bound
+			prepare_clip (a_field)
+			trace (a_field, a_origin.x, a_origin.y, a_origin.z, a_direction.x, a_direction.y, a_direction.z)
+			if last_hit then
+				create Result.make_hit (create {SDF_VEC3}.make (last_x, last_y, last_z), last_depth,
+					normal_at (a_field, last_x, last_y, last_z), last_steps)
+			else
+				-- Ray missed
+				create Result.make_miss (last_steps)
+			end
+		ensure
+			result_attached: Result /= Void
+		end
+
+	march_batch (a_field: SDF_FIELD; a_rays: SDF_RAY_BATCH; a_hits: SDF_HIT_BUFFER; a_with_normals: BOOLEAN)
+			-- March every ray of `a_rays' through `a_field' into `a_hits'.
+			-- Nothing is allocated; with `a_with_normals' False normals are
+			-- left for `compute_batch_normals'.
+		require
+			field_attached: a_field /= Void
+			rays_attached: a_rays /= Void
+			hits_attached: a_hits /= Void
+			buffer_large_enough: a_hits.capacity >= a_rays.count
+		local
+			i: INTEGER
+		do
+			a_hits.reset (a_rays.count)
+			step_scale := 1.0 / a_field.lipschitz_bound
+			prepare_clip (a_field)
+			from i := 1 until i > a_rays.count loop
+				trace (a_field,
+					a_rays.origin_x [i - 1], a_rays.origin_y [i - 1], a_rays.origin_z [i - 1],
+					a_rays.direction_x [i - 1], a_rays.direction_y [i - 1], a_rays.direction_z [i - 1])
+				if last_hit then
+					a_hits.put_hit (i, last_depth, last_x, last_y, last_z, last_steps)
 				else
-					l_depth := l_depth + l_dist
-					l_step := l_step + 1
+					a_hits.put_miss (i, last_steps)
 				end
+				i := i + 1
 			end
-
-			if Result = Void then
-				-- Ray missed
-				create Result.make_miss (l_step)
+			if a_with_normals then
+				compute_batch_normals (a_field, a_hits)
 			end
 		ensure
-			result_attached: Result /= Void
+			count_set: a_hits.count = a_rays.count
+			normals_if_requested: a_with_normals implies a_hits.has_normals
 		end
 
 feature -- Normal computation
@@ -211,25 +310,8 @@ feature -- Normal computation
 		require
 			scene_attached: a_scene /= Void
 			point_attached: a_point /= Void
-		local
-			eps: REAL_64
-			dx, dy, dz: SDF_VEC3
-			nx, ny, nz: REAL_64
 		do
-			eps := normal_epsilon
-
-			-- Sample SDF at offset points
-			create dx.make (eps, 0.0, 0.0)
-			create dy.make (0.0, eps, 0.0)
-			create dz.make (0.0, 0.0, eps)
-
-			-- Central difference gradient
-			nx := a_scene.distance (a_point + dx) - a_scene.distance (a_point - dx)
-			ny := a_scene.distance (a_point + dy) - a_scene.distance (a_point - dy)
-			nz := a_scene.distance (a_point + dz) - a_scene.distance (a_point - dz)
-
-			create Result.make (nx, ny, nz)
-			Result := Result.normalized
+			Result := normal_at (a_scene, a_point.x, a_point.y, a_point.z)
 		ensure
 			result_attached: Result /= Void
 			is_normalized: Result.is_unit_vector
@@ -240,28 +322,321 @@ feature -- Normal computation
 		require
 			shape_attached: a_shape /= Void
 			point_attached: a_point /= Void
-		local
-			eps: REAL_64
-			dx, dy, dz: SDF_VEC3
-			nx, ny, nz: REAL_64
 		do
-			eps := normal_epsilon
-
-			create dx.make (eps, 0.0, 0.0)
-			create dy.make (0.0, eps, 0.0)
-			create dz.make (0.0, 0.0, eps)
+			Result := normal_at (a_shape, a_point.x, a_point.y, a_point.z)
+		ensure
+			result_attached: Result /= Void
+			is_normalized: Result.is_unit_vector
+		end
 
-			nx := a_shape.distance (a_point + dx) - a_shape.distance (a_point - dx)
-			ny := a_shape.distance (a_point + dy) - a_shape.distance (a_point - dy)
-			nz := a_shape.distance (a_point + dz) - a_shape.distance (a_point - dz)
+	normal_at (a_field: SDF_FIELD; a_x, a_y, a_z: REAL_64): SDF_VEC3
+			-- Surface normal of `a_field' at (x, y, z) from its dual gradient.
+			-- Only the returned vector is allocated.
+		require
+			field_attached: a_field /= Void
+		do
+			compute_gradient (a_field, a_x, a_y, a_z)
+			create Result.make (last_nx, last_ny, last_nz)
+		ensure
+			result_attached: Result /= Void
+			is_normalized: Result.is_unit_vector
+		end
 
-			create Result.make (nx, ny, nz)
-			Result := Result.normalized
+	difference_normal_at (a_field: SDF_FIELD; a_x, a_y, a_z: REAL_64): SDF_VEC3
+			-- Surface normal of `a_field' at (x, y, z) by central differences
+			-- over `normal_epsilon'.
+		require
+			field_attached: a_field /= Void
+		do
+			compute_difference_gradient (a_field, a_x, a_y, a_z)
+			create Result.make (last_nx, last_ny, last_nz)
 		ensure
 			result_attached: Result /= Void
 			is_normalized: Result.is_unit_vector
 		end
 
+	compute_batch_normals (a_field: SDF_FIELD; a_hits: SDF_HIT_BUFFER)
+			-- Fill normals of all hits in `a_hits' (deferred normal pass).
+		require
+			field_attached: a_field /= Void
+			hits_attached: a_hits /= Void
+		local
+			i: INTEGER
+		do
+			from i := 1 until i > a_hits.count loop
+				if a_hits.is_hit (i) then
+					compute_gradient (a_field, a_hits.position_x [i - 1], a_hits.position_y [i - 1], a_hits.position_z [i - 1])
+					a_hits.put_normal (i, last_nx, last_ny, last_nz)
+				end
+				i := i + 1
+			end
+			a_hits.set_has_normals
+		ensure
+			has_normals: a_hits.has_normals
+		end
+
+feature {NONE} -- Implementation
+
+	prepare_clip (a_field: SDF_FIELD)
+			-- Set `clip_box' to the bounds of `a_field' widened by the
+			-- distance at which `trace' reports a hit.
+		require
+			field_attached: a_field /= Void
+		do
+			clip_box := a_field.bounds
+			if not clip_box.is_empty then
+				clip_box.expand (surface_threshold / step_scale)
+			end
+		end
+
+	trace (a_field: SDF_FIELD; a_ox, a_oy, a_oz, a_dx, a_dy, a_dz: REAL_64)
+			-- Clip one ray to `clip_box', then sphere-trace the part inside
+			-- in the arithmetic of `precision'.
+		do
+			if clip_box.is_empty then
+				clip_near := max_distance
+				clip_far := 0.0
+			else
+				clip_near := clip_box.ray_entry (a_ox, a_oy, a_oz, a_dx, a_dy, a_dz).max (0.0)
+				clip_far := clip_box.ray_exit (a_ox, a_oy, a_oz, a_dx, a_dy, a_dz).min (max_distance)
+			end
+			if clip_near > clip_far then
+				-- No surface along the ray: miss without a step
+				last_hit := False
+				last_depth := max_distance
+				last_steps := 0
+				last_x := a_ox + a_dx * max_distance
+				last_y := a_oy + a_dy * max_distance
+				last_z := a_oz + a_dz * max_distance
+			elseif precision = Precision_mixed then
+				trace_mixed (a_field, a_ox, a_oy, a_oz, a_dx, a_dy, a_dz)
+			else
+				trace_double (a_field, a_ox, a_oy, a_oz, a_dx, a_dy, a_dz)
+			end
+		end
+
+	trace_double (a_field: SDF_FIELD; a_ox, a_oy, a_oz, a_dx, a_dy, a_dz: REAL_64)
+			-- Sphere-trace one ray from `clip_near' to `clip_far' with
+			-- distances scaled by `step_scale'; set `last_hit', `last_depth', `last_steps'
+			-- and the hit point `last_x', `last_y', `last_z'.
+		local
+			l_depth, l_dist, l_omega, l_prev, l_stride, px, py, pz: REAL_64
+			l_step: INTEGER
+			l_hit: BOOLEAN
+		do
+			from
+				l_depth := clip_near
+				l_omega := relaxation
+				l_step := 0
+			until
+				l_hit or l_step >= max_steps or l_depth >= clip_far
+			loop
+				if attached occupancy as l_grid
+					and then l_grid.is_empty_at (a_ox + a_dx * l_depth, a_oy + a_dy * l_depth, a_oz + a_dz * l_depth)
+				then
+					-- Cross the empty cells without evaluating the field
+					l_depth := l_grid.skip_empty (a_ox, a_oy, a_oz, a_dx, a_dy, a_dz, l_depth, clip_far)
+					l_prev := 0.0
+					l_stride := 0.0
+				end
+				px := a_ox + a_dx * l_depth
+				py := a_oy + a_dy * l_depth
+				pz := a_oz + a_dz * l_depth
+				l_dist := a_field.distance_at (px, py, pz) * step_scale
+
+				if l_omega > 1.0 and l_dist + l_prev < l_stride then
+					-- Overstep: back to the plain step, no relaxation from here
+					l_depth := l_depth - l_stride + l_prev
+					l_stride := l_prev
+					l_omega := 1.0
+				elseif l_dist.abs < surface_threshold then
+					-- Hit surface
+					l_hit := True
+				else
+					l_prev := l_dist
+					l_stride := l_omega * l_dist
+					l_depth := l_depth + l_stride
+				end
+				l_step := l_step + 1
+			end
+			last_hit := l_hit
+			last_depth := l_depth
+			last_steps := l_step
+			last_x := px
+			last_y := py
+			last_z := pz
+		end
+
+	trace_mixed (a_field: SDF_FIELD; a_ox, a_oy, a_oz, a_dx, a_dy, a_dz: REAL_64)
+			-- `trace_double' with REAL_32 steps on `distance_at_32', handing
+			-- every approach to within `Refinement_band' thresholds of a
+			-- surface to `refine'.
+		local
+			ox, oy, oz, dx, dy, dz: REAL_32
+			l_depth, l_dist, l_omega, l_prev, l_stride, l_scale, l_band, l_max: REAL_32
+			l_step: INTEGER
+			l_hit: BOOLEAN
+		do
+			ox := a_ox.truncated_to_real
+			oy := a_oy.truncated_to_real
+			oz := a_oz.truncated_to_real
+			dx := a_dx.truncated_to_real
+			dy := a_dy.truncated_to_real
+			dz := a_dz.truncated_to_real
+			l_scale := step_scale.truncated_to_real
+			l_band := (surface_threshold * Refinement_band).truncated_to_real
+			l_max := clip_far.truncated_to_real
+			from
+				l_depth := clip_near.truncated_to_real
+				l_omega := relaxation.truncated_to_real
+			until
+				l_hit or l_step >= max_steps or l_depth >= l_max
+			loop
+				if attached occupancy as l_grid
+					and then l_grid.is_empty_at (a_ox + a_dx * l_depth, a_oy + a_dy * l_depth, a_oz + a_dz * l_depth)
+				then
+					-- Cross the empty cells without evaluating the field
+					l_depth := l_grid.skip_empty (a_ox, a_oy, a_oz, a_dx, a_dy, a_dz, l_depth, clip_far.max (l_depth)).truncated_to_real
+					l_prev := {REAL_32} 0.0
+					l_stride := {REAL_32} 0.0
+				end
+				l_dist := a_field.distance_at_32 (ox + dx * l_depth, oy + dy * l_depth, oz + dz * l_depth) * l_scale
+				l_step := l_step + 1
+				if l_omega > {REAL_32} 1.0 and l_dist + l_prev < l_stride then
+					-- Overstep: back to the plain step, no relaxation from here
+					l_depth := l_depth - l_stride + l_prev
+					l_stride := l_prev
+					l_omega := {REAL_32} 1.0
+				elseif l_dist < l_band then
+					-- Near a surface: continue in REAL_64 until hit or clear of it
+					refine (a_field, a_ox, a_oy, a_oz, a_dx, a_dy, a_dz, l_depth, l_step)
+					l_hit := last_hit
+					l_depth := last_depth.truncated_to_real
+					l_step := last_steps
+					l_prev := {REAL_32} 0.0
+					l_stride := {REAL_32} 0.0
+				else
+					l_prev := l_dist
+					l_stride := l_omega * l_dist
+					l_depth := l_depth + l_stride
+				end
+			end
+			if not l_hit then
+				last_hit := False
+				last_depth := l_depth
+				last_steps := l_step
+				last_x := a_ox + a_dx * last_depth
+				last_y := a_oy + a_dy * last_depth
+				last_z := a_oz + a_dz * last_depth
+			end
+		end
+
+	refine (a_field: SDF_FIELD; a_ox, a_oy, a_oz, a_dx, a_dy, a_dz, a_depth: REAL_64; a_steps: INTEGER)
+			-- Plain sphere tracing in REAL_64 from `a_depth', after `a_steps'
+			-- steps, until a hit or a step that leaves the refinement band.
+			-- Set `last_hit', `last_depth', `last_steps' and the last point.
+		local
+			l_depth, l_dist, px, py, pz: REAL_64
+			l_step: INTEGER
+			l_hit, l_clear: BOOLEAN
+		do
+			from
+				l_depth := a_depth
+				l_step := a_steps
+				px := a_ox + a_dx * l_depth
+				py := a_oy + a_dy * l_depth
+				pz := a_oz + a_dz * l_depth
+			until
+				l_hit or l_clear or l_step >= max_steps or l_depth >= clip_far
+			loop
+				px := a_ox + a_dx * l_depth
+				py := a_oy + a_dy * l_depth
+				pz := a_oz + a_dz * l_depth
+				l_dist := a_field.distance_at (px, py, pz) * step_scale
+				if l_dist.abs < surface_threshold then
+					l_hit := True
+				else
+					l_depth := l_depth + l_dist
+					l_clear := l_dist >= surface_threshold * Refinement_band
+				end
+				l_step := l_step + 1
+			end
+			last_hit := l_hit
+			last_depth := l_depth
+			last_steps := l_step
+			last_x := px
+			last_y := py
+			last_z := pz
+		end
+
+	compute_gradient (a_field: SDF_FIELD; a_x, a_y, a_z: REAL_64)
+			-- Normalized dual gradient into `last_nx', `last_ny', `last_nz';
+			-- central differences where it vanishes.
+		local
+			d: SDF_DUAL
+			len: REAL_64
+		do
+			d := a_field.dual_at (a_x, a_y, a_z)
+			len := d.gradient_length
+			if len > 0.0 then
+				last_nx := d.dx / len
+				last_ny := d.dy / len
+				last_nz := d.dz / len
+			else
+				compute_difference_gradient (a_field, a_x, a_y, a_z)
+			end
+		end
+
+	compute_difference_gradient (a_field: SDF_FIELD; a_x, a_y, a_z: REAL_64)
+			-- Normalized central-difference gradient into `last_nx', `last_ny', `last_nz'.
+		local
+			eps, nx, ny, nz, len: REAL_64
+		do
+			eps := normal_epsilon
+
+			-- Central difference gradient
+			nx := a_field.distance_at (a_x + eps, a_y, a_z) - a_field.distance_at (a_x - eps, a_y, a_z)
+			ny := a_field.distance_at (a_x, a_y + eps, a_z) - a_field.distance_at (a_x, a_y - eps, a_z)
+			nz := a_field.distance_at (a_x, a_y, a_z + eps) - a_field.distance_at (a_x, a_y, a_z - eps)
+
+			len := {DOUBLE_MATH}.sqrt (nx * nx + ny * ny + nz * nz)
+			last_nx := nx / len
+			last_ny := ny / len
+			last_nz := nz / len
+		end
+
+	step_scale: REAL_64
+			-- 1 / Lipschitz bound of the field being traced
+
+	clip_box: SDF_AABB
+			-- Bounds of the field being traced, widened by the hit distance
+
+	clip_near, clip_far: REAL_64
+			-- Part of the current ray inside `clip_box'
+
+	last_hit: BOOLEAN
+			-- Did the last `trace' hit?
+
+	last_depth: REAL_64
+			-- Depth reached by the last `trace'
+
+	last_steps: INTEGER
+			-- Steps taken by the last `trace'
+
+	last_x, last_y, last_z: REAL_64
+			-- Final point of the last `trace'
+
+	last_nx, last_ny, last_nz: REAL_64
+			-- Normal from the last `compute_gradient'
+
+feature -- Constants
+
+	Precision_double: INTEGER = 1
+			-- Every step in REAL_64
+
+	Precision_mixed: INTEGER = 2
+			-- REAL_32 steps, REAL_64 near surfaces
+
 feature {NONE} -- Constants
 
 	Default_max_steps: INTEGER = 128
@@ -273,10 +648,20 @@ feature {NONE} -- Constants
 	Default_surface_threshold: REAL_64 = 0.001
 			-- Default surface threshold
 
+	Default_relaxation: REAL_64 = 1.2
+			-- Default enhanced sphere tracing step factor
+
+	Refinement_band: REAL_64 = 16.0
+			-- Surface thresholds from a surface within which `Precision_mixed'
+			-- marches in REAL_64 (well above REAL_32 rounding at `max_distance')
+
 invariant
 	positive_max_steps: max_steps > 0
 	positive_max_distance: max_distance > 0.0
 	positive_threshold: surface_threshold > 0.0
 	positive_epsilon: normal_epsilon > 0.0
+	valid_relaxation: relaxation >= 1.0 and relaxation < 2.0
+	valid_precision: is_valid_precision (precision)
+	clip_box_attached: clip_box /= Void
 
 end
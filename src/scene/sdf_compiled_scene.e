@@ -0,0 +1,208 @@
+note
+	description: "[
+		Compiled scene: flat REAL_32 representation of an SDF_SCENE.
+
+		Each scene entry is packed into a fixed-size record that native
+		renderers (see Clib/raylib/simple_raylib_impl.c) can walk without
+		touching Eiffel objects:
+
+			[0]       kind        (sphere=1, box=2, capsule=3, cylinder=4, torus=5, plane=6)
+			[1]       operation   (union=1, subtraction=2, intersection=3)
+			[2]       blend       (0 = sharp)
+			[3]       transformed (1 if the shape is rotated or scaled, else 0)
+			[4..15]   parameters  (see SDF_SHAPE.parameters)
+			[16..27]  world-to-shape matrix rows (3 x 4), identity if untransformed
+			[28]      scale       (1 if untransformed)
+			[29..31]  reserved
+
+		Parameter layout per kind:
+		- sphere:   center xyz, radius
+		- box:      center xyz, half-extents xyz
+		- capsule:  point a xyz, point b xyz, radius
+		- cylinder: center xyz, radius, half height
+		- torus:    center xyz, major radius, minor radius
+		- plane:    normal xyz, height
+
+		Parameters are in shape space; a transformed record maps each
+		sample with its matrix first and multiplies the distance by its
+		scale (see SDF_SHAPE.transform_parameters).
+
+		`lipschitz_bound' is the scene's bound at compile time. Every
+		record kind and operation is 1-Lipschitz, so native renderers
+		march it with plain steps.
+
+		The compiled scene is a snapshot: recompile after editing the scene.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_COMPILED_SCENE
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_scene: SDF_SCENE)
+			-- Compile `a_scene' into flat entry records.
+		require
+			scene_attached: a_scene /= Void
+		local
+			i, j: INTEGER
+			l_entry: SDF_SCENE_ENTRY
+			l_params, l_transform: ARRAY [REAL_64]
+		do
+			count := a_scene.count
+			lipschitz_bound := a_scene.lipschitz_bound
+			create data.make (count.max (1) * Entry_size * Real_32_bytes)
+			from i := 1 until i > count loop
+				l_entry := a_scene.shapes [i]
+				put (i, Field_kind, l_entry.shape.kind.to_double)
+				put (i, Field_operation, l_entry.operation.to_double)
+				put (i, Field_blend, l_entry.blend)
+				l_params := l_entry.shape.parameters
+				from j := 0 until j >= {SDF_SHAPE}.Max_parameter_count loop
+					if j < l_params.count then
+						put (i, Field_parameters + j, l_params [l_params.lower + j])
+					else
+						put (i, Field_parameters + j, 0.0)
+					end
+					j := j + 1
+				end
+				if l_entry.shape.is_transformed then
+					put (i, Field_transformed, 1.0)
+					l_transform := l_entry.shape.transform_parameters
+				else
+					put (i, Field_transformed, 0.0)
+					l_transform := Identity_transform
+				end
+				from j := 0 until j >= {SDF_SHAPE}.Transform_parameter_count loop
+					put (i, Field_matrix + j, l_transform [l_transform.lower + j])
+					j := j + 1
+				end
+				from j := Field_scale + 1 until j >= Entry_size loop
+					put (i, j, 0.0)
+					j := j + 1
+				end
+				i := i + 1
+			end
+		ensure
+			count_set: count = a_scene.count
+			lipschitz_bound_set: lipschitz_bound = a_scene.lipschitz_bound
+		end
+
+feature -- Access
+
+	count: INTEGER
+			-- Number of compiled entries
+
+	lipschitz_bound: REAL_64
+			-- Lipschitz bound of the compiled scene
+
+	data: MANAGED_POINTER
+			-- Packed entry records (`count' * `Entry_size' REAL_32 values)
+
+	item (a_entry, a_field: INTEGER): REAL_32
+			-- Field `a_field' (0-based) of entry `a_entry' (1-based)
+		require
+			valid_entry: a_entry >= 1 and a_entry <= count
+			valid_field: a_field >= 0 and a_field < Entry_size
+		do
+			Result := data.read_real_32 (offset (a_entry, a_field))
+		end
+
+	kind (a_entry: INTEGER): INTEGER
+			-- Primitive kind of entry `a_entry'
+		require
+			valid_entry: a_entry >= 1 and a_entry <= count
+		do
+			Result := item (a_entry, Field_kind).truncated_to_integer
+		end
+
+	operation (a_entry: INTEGER): INTEGER
+			-- Combine operation of entry `a_entry'
+		require
+			valid_entry: a_entry >= 1 and a_entry <= count
+		do
+			Result := item (a_entry, Field_operation).truncated_to_integer
+		end
+
+	blend (a_entry: INTEGER): REAL_32
+			-- Blend radius of entry `a_entry'
+		require
+			valid_entry: a_entry >= 1 and a_entry <= count
+		do
+			Result := item (a_entry, Field_blend)
+		end
+
+	parameter (a_entry, a_index: INTEGER): REAL_32
+			-- Parameter `a_index' (0-based) of entry `a_entry'
+		require
+			valid_entry: a_entry >= 1 and a_entry <= count
+			valid_index: a_index >= 0 and a_index < {SDF_SHAPE}.Max_parameter_count
+		do
+			Result := item (a_entry, Field_parameters + a_index)
+		end
+
+	is_transformed (a_entry: INTEGER): BOOLEAN
+			-- Is entry `a_entry' rotated or scaled?
+		require
+			valid_entry: a_entry >= 1 and a_entry <= count
+		do
+			Result := item (a_entry, Field_transformed) /= {REAL_32} 0.0
+		end
+
+feature -- Status report
+
+	is_empty: BOOLEAN
+			-- Are there no compiled entries?
+		do
+			Result := count = 0
+		end
+
+feature -- Layout constants
+
+	Entry_size: INTEGER = 32
+			-- REAL_32 values per entry record
+
+	Field_kind: INTEGER = 0
+	Field_operation: INTEGER = 1
+	Field_blend: INTEGER = 2
+	Field_transformed: INTEGER = 3
+	Field_parameters: INTEGER = 4
+	Field_matrix: INTEGER = 16
+	Field_scale: INTEGER = 28
+
+feature {NONE} -- Implementation
+
+	put (a_entry, a_field: INTEGER; a_value: REAL_64)
+			-- Store `a_value' in field `a_field' of entry `a_entry'.
+		do
+			data.put_real_32 (a_value.truncated_to_real, offset (a_entry, a_field))
+		end
+
+	offset (a_entry, a_field: INTEGER): INTEGER
+			-- Byte offset of field `a_field' of entry `a_entry'
+		do
+			Result := ((a_entry - 1) * Entry_size + a_field) * Real_32_bytes
+		end
+
+	Real_32_bytes: INTEGER = 4
+			-- Size of REAL_32 in bytes
+
+	Identity_transform: ARRAY [REAL_64]
+			-- Transform fields of an untransformed record
+		once
+			Result := <<1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 1.0>>
+		end
+
+invariant
+	data_attached: data /= Void
+	non_negative_count: count >= 0
+	parameters_fit: Field_parameters + {SDF_SHAPE}.Max_parameter_count = Field_matrix
+	transform_fits: Field_matrix + {SDF_SHAPE}.Transform_parameter_count = Field_scale + 1
+	record_fits: Field_scale < Entry_size
+
+end
@@ -0,0 +1,93 @@
+note
+	description: "[
+		Deferred base for anything that can be ray marched: a scalar
+		signed distance function over 3D space.
+
+		Implemented by SDF_SHAPE and SDF_SCENE. `distance_at' takes plain
+		coordinates so the march loop runs without heap allocation.
+
+		`interval_at' is the region form: a guaranteed range of the
+		distance over an axis-aligned box, used to skip empty space and
+		to cull work per region.
+
+		`lipschitz_bound' is a bound L on how fast the field changes:
+		|f(p) - f(q)| <= L * |p - q|. A value d then guarantees no surface
+		within d / L, which is the step a marcher may safely take.
+
+		`dual_at' is the differentiated form: the distance together with
+		its gradient from one forward-mode evaluation, which gives the
+		surface normal without sampling the field around the point.
+
+		`distance_at_32' is the single-precision form for the bulk of a
+		march. By default it rounds `distance_at'; fields with a REAL_32
+		evaluator (SDF_TAPE, frozen SDF_SCENE) redefine it.
+
+		`bounds' is a box enclosing the surface and the inside: the
+		distance is positive everywhere outside it. It is infinite unless
+		the field knows better; SDF_RAY_MARCHER clips every ray to it.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+deferred class
+	SDF_FIELD
+
+feature -- Distance
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from point (x, y, z) to the field surface.
+			-- Positive = outside, negative = inside, zero = on surface.
+			-- Must not allocate: this is the inner loop of every march.
+		deferred
+		end
+
+	distance_at_32 (a_x, a_y, a_z: REAL_32): REAL_32
+			-- `distance_at' evaluated in single precision where the field
+			-- supports it. Must not allocate.
+		do
+			Result := distance_at (a_x, a_y, a_z).truncated_to_real
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Range containing `distance_at' for every point of the box
+			-- (min_x, min_y, min_z) .. (max_x, max_y, max_z).
+		require
+			ordered_x: a_min_x <= a_max_x
+			ordered_y: a_min_y <= a_max_y
+			ordered_z: a_min_z <= a_max_z
+		deferred
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- `distance_at' (a_x, a_y, a_z) with its gradient.
+		deferred
+		end
+
+	lipschitz_bound: REAL_64
+			-- Bound on the rate of change of `distance_at' (1 for exact distances)
+		deferred
+		ensure
+			positive: Result > 0.0
+		end
+
+	distance_interval (a_box: SDF_AABB): SDF_INTERVAL
+			-- Range of the distance over `a_box'
+		require
+			box_attached: a_box /= Void
+			not_empty: not a_box.is_empty
+		do
+			Result := interval_at (a_box.min_x, a_box.min_y, a_box.min_z, a_box.max_x, a_box.max_y, a_box.max_z)
+		end
+
+feature -- Bounds
+
+	bounds: SDF_AABB
+			-- Box outside which the distance is positive (infinite by default)
+		do
+			create Result.make_infinite
+		ensure
+			result_attached: Result /= Void
+		end
+
+end
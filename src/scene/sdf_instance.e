@@ -0,0 +1,360 @@
+note
+	description: "[
+		Placed copy of a shared prototype: an SDF_SHAPE or a sub-scene
+		(SDF_SCENE_GROUP) seen through a per-instance transform.
+
+		The prototype is referenced, never copied, so thousands of
+		instances of one rock cost a few dozen scalars each. The
+		transform maps prototype space to world space as: scale
+		uniformly by `scale', turn by a 3 x 3 rotation (`set_yaw',
+		`set_rotation', `rotate'), then move by `offset_x', `offset_y',
+		`offset_z'. The world-to-prototype 3 x 4 matrix is recomputed
+		once per change, as in SDF_SHAPE, so a sample costs one
+		matrix-vector product. Rotation and uniform scale keep distances
+		exact: the instance distance is `scale' times the prototype
+		distance at the mapped point.
+
+		Instances are usually gathered in an SDF_INSTANCE_GRID, which
+		evaluates only the instances near each sample.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_INSTANCE
+
+inherit
+	SDF_FIELD
+		redefine
+			bounds
+		end
+
+	SDF_SHARED_CHANGE_STAMP
+
+create
+	make_shape,
+	make_group
+
+feature {NONE} -- Initialization
+
+	make_shape (a_prototype: SDF_SHAPE)
+			-- Create instance of `a_prototype' with the identity transform.
+		require
+			prototype_attached: a_prototype /= Void
+		do
+			prototype := a_prototype
+			scale := 1.0
+			create rotation.make_filled (0.0, 9)
+			create inverse_matrix.make_filled (0.0, 12)
+			rotation := axis_rotation (0.0, 1.0, 0.0, 0.0)
+			update_inverse
+		ensure
+			prototype_set: prototype = a_prototype
+			identity: offset_x = 0.0 and offset_y = 0.0 and offset_z = 0.0 and yaw = 0.0 and scale = 1.0
+		end
+
+	make_group (a_prototype: SDF_SCENE_GROUP)
+			-- Create instance of the sub-scene `a_prototype' with the identity transform.
+		require
+			prototype_attached: a_prototype /= Void
+		do
+			prototype := a_prototype
+			scale := 1.0
+			create rotation.make_filled (0.0, 9)
+			create inverse_matrix.make_filled (0.0, 12)
+			rotation := axis_rotation (0.0, 1.0, 0.0, 0.0)
+			update_inverse
+		ensure
+			prototype_set: prototype = a_prototype
+			identity: offset_x = 0.0 and offset_y = 0.0 and offset_z = 0.0 and yaw = 0.0 and scale = 1.0
+		end
+
+feature -- Access
+
+	prototype: SDF_FIELD
+			-- Shared geometry (an SDF_SHAPE or an SDF_SCENE_GROUP)
+
+	offset_x, offset_y, offset_z: REAL_64
+			-- Translation applied last
+
+	yaw: REAL_64
+			-- Angle in radians of the last `set_yaw' (0 once `set_rotation'
+			-- or `rotate' turned the instance otherwise)
+
+	scale: REAL_64
+			-- Uniform scale applied first
+
+	version: NATURAL_64
+			-- Number of changes made to the transform
+
+	rotation_item (a_row, a_column: INTEGER): REAL_64
+			-- Entry (row, column) of the prototype-to-world rotation
+		require
+			valid_row: a_row >= 1 and a_row <= 3
+			valid_column: a_column >= 1 and a_column <= 3
+		do
+			Result := rotation [(a_row - 1) * 3 + a_column - 1]
+		end
+
+	prototype_bounds: SDF_AABB
+			-- Bounds of `prototype' in its own space
+		do
+			Result := prototype.bounds
+		ensure
+			result_attached: Result /= Void
+		end
+
+	bounds: SDF_AABB
+			-- World box enclosing the instance (infinite if the prototype
+			-- is unbounded, empty if it is an empty group)
+		local
+			l_local: SDF_AABB
+			r: like rotation
+			hx, hy, hz, cx, cy, cz: REAL_64
+		do
+			l_local := prototype_bounds
+			if l_local.is_empty or l_local.is_infinite then
+				Result := l_local
+			else
+				r := rotation
+				hx := (l_local.max_x - l_local.min_x) * 0.5
+				hy := (l_local.max_y - l_local.min_y) * 0.5
+				hz := (l_local.max_z - l_local.min_z) * 0.5
+				cx := l_local.center_x
+				cy := l_local.center_y
+				cz := l_local.center_z
+				create Result.make_around (
+					offset_x + scale * (r [0] * cx + r [1] * cy + r [2] * cz),
+					offset_y + scale * (r [3] * cx + r [4] * cy + r [5] * cz),
+					offset_z + scale * (r [6] * cx + r [7] * cy + r [8] * cz),
+					scale * (r [0].abs * hx + r [1].abs * hy + r [2].abs * hz),
+					scale * (r [3].abs * hx + r [4].abs * hy + r [5].abs * hz),
+					scale * (r [6].abs * hx + r [7].abs * hy + r [8].abs * hz))
+			end
+		ensure then
+			result_attached: Result /= Void
+		end
+
+feature -- Distance
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- `scale' times the prototype distance at the mapped point
+		local
+			m: like inverse_matrix
+		do
+			m := inverse_matrix
+			Result := prototype.distance_at (
+				m [0] * a_x + m [1] * a_y + m [2] * a_z + m [3],
+				m [4] * a_x + m [5] * a_y + m [6] * a_z + m [7],
+				m [8] * a_x + m [9] * a_y + m [10] * a_z + m [11]) * scale
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Prototype range over the box enclosing the mapped box, scaled
+		local
+			m: like inverse_matrix
+			hx, hy, hz, cx, cy, cz, lx, ly, lz, ex, ey, ez: REAL_64
+		do
+			m := inverse_matrix
+			hx := (a_max_x - a_min_x) * 0.5
+			hy := (a_max_y - a_min_y) * 0.5
+			hz := (a_max_z - a_min_z) * 0.5
+			cx := a_min_x * 0.5 + a_max_x * 0.5
+			cy := a_min_y * 0.5 + a_max_y * 0.5
+			cz := a_min_z * 0.5 + a_max_z * 0.5
+			lx := m [0] * cx + m [1] * cy + m [2] * cz + m [3]
+			ly := m [4] * cx + m [5] * cy + m [6] * cz + m [7]
+			lz := m [8] * cx + m [9] * cy + m [10] * cz + m [11]
+			ex := m [0].abs * hx + m [1].abs * hy + m [2].abs * hz
+			ey := m [4].abs * hx + m [5].abs * hy + m [6].abs * hz
+			ez := m [8].abs * hx + m [9].abs * hy + m [10].abs * hz
+			Result := prototype.interval_at (lx - ex, ly - ey, lz - ez, lx + ex, ly + ey, lz + ez).scaled (scale)
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- `distance_at' with the prototype gradient turned back into world space
+		local
+			m, r: like rotation
+			l_dual: SDF_DUAL
+		do
+			m := inverse_matrix
+			r := rotation
+			l_dual := prototype.dual_at (
+				m [0] * a_x + m [1] * a_y + m [2] * a_z + m [3],
+				m [4] * a_x + m [5] * a_y + m [6] * a_z + m [7],
+				m [8] * a_x + m [9] * a_y + m [10] * a_z + m [11])
+			create Result.make (l_dual.value * scale,
+				r [0] * l_dual.dx + r [1] * l_dual.dy + r [2] * l_dual.dz,
+				r [3] * l_dual.dx + r [4] * l_dual.dy + r [5] * l_dual.dz,
+				r [6] * l_dual.dx + r [7] * l_dual.dy + r [8] * l_dual.dz)
+		end
+
+	lipschitz_bound: REAL_64
+			-- Lipschitz bound of `prototype': rotation and uniform scale keep it
+		do
+			Result := prototype.lipschitz_bound
+		end
+
+feature -- Element change (fluent API)
+
+	set_offset (a_x, a_y, a_z: REAL_64): like Current
+			-- Move the instance to (x, y, z) and return self.
+		do
+			offset_x := a_x
+			offset_y := a_y
+			offset_z := a_z
+			update_inverse
+			mark_changed
+			Result := Current
+		ensure
+			offset_set: offset_x = a_x and offset_y = a_y and offset_z = a_z
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+	set_yaw (a_angle: REAL_64): like Current
+			-- Turn the instance to `a_angle' radians about +Y and return self.
+		do
+			rotation := axis_rotation (0.0, 1.0, 0.0, a_angle)
+			yaw := a_angle
+			update_inverse
+			mark_changed
+			Result := Current
+		ensure
+			yaw_set: yaw = a_angle
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+	set_rotation (a_axis: SDF_VEC3; a_angle: REAL_64): like Current
+			-- Turn the instance to `a_angle' radians about `a_axis' and return self.
+		require
+			axis_attached: a_axis /= Void
+			axis_not_zero: not a_axis.is_zero_vector
+		do
+			rotation := axis_rotation (a_axis.x, a_axis.y, a_axis.z, a_angle)
+			yaw := 0.0
+			update_inverse
+			mark_changed
+			Result := Current
+		ensure
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+	rotate (a_axis: SDF_VEC3; a_angle: REAL_64): like Current
+			-- Turn the instance a further `a_angle' radians about `a_axis'; return self.
+		require
+			axis_attached: a_axis /= Void
+			axis_not_zero: not a_axis.is_zero_vector
+		local
+			l_turn, l_product: like rotation
+			i, j: INTEGER
+		do
+			l_turn := axis_rotation (a_axis.x, a_axis.y, a_axis.z, a_angle)
+			-- New rotation applied after the current one: turn * rotation
+			create l_product.make_filled (0.0, 9)
+			from i := 0 until i >= 3 loop
+				from j := 0 until j >= 3 loop
+					l_product [i * 3 + j] := l_turn [i * 3] * rotation [j] + l_turn [i * 3 + 1] * rotation [3 + j]
+						+ l_turn [i * 3 + 2] * rotation [6 + j]
+					j := j + 1
+				end
+				i := i + 1
+			end
+			rotation := l_product
+			yaw := 0.0
+			update_inverse
+			mark_changed
+			Result := Current
+		ensure
+			scale_kept: scale = old scale
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+	set_scale (a_scale: REAL_64): like Current
+			-- Scale the prototype uniformly by `a_scale' and return self.
+		require
+			positive_scale: a_scale > 0.0
+		do
+			scale := a_scale
+			update_inverse
+			mark_changed
+			Result := Current
+		ensure
+			scale_set: scale = a_scale
+			changed: version > old version
+			result_is_current: Result = Current
+		end
+
+feature {NONE} -- Implementation
+
+	rotation: SPECIAL [REAL_64]
+			-- Prototype-to-world rotation, 3 x 3 row-major
+
+	inverse_matrix: SPECIAL [REAL_64]
+			-- World-to-prototype matrix, 3 x 4 row-major: R^T / `scale'
+			-- with the offset folded into the last column
+
+	axis_rotation (a_x, a_y, a_z, a_angle: REAL_64): like rotation
+			-- Rotation by `a_angle' radians about axis (x, y, z) (Rodrigues' formula)
+		local
+			kx, ky, kz, l_length, c, s, t: REAL_64
+		do
+			l_length := {DOUBLE_MATH}.sqrt (a_x * a_x + a_y * a_y + a_z * a_z)
+			kx := a_x / l_length
+			ky := a_y / l_length
+			kz := a_z / l_length
+			c := {DOUBLE_MATH}.cosine (a_angle)
+			s := {DOUBLE_MATH}.sine (a_angle)
+			t := 1.0 - c
+			create Result.make_filled (0.0, 9)
+			Result [0] := c + t * kx * kx
+			Result [1] := t * kx * ky - s * kz
+			Result [2] := t * kx * kz + s * ky
+			Result [3] := t * kx * ky + s * kz
+			Result [4] := c + t * ky * ky
+			Result [5] := t * ky * kz - s * kx
+			Result [6] := t * kx * kz - s * ky
+			Result [7] := t * ky * kz + s * kx
+			Result [8] := c + t * kz * kz
+		ensure
+			sized: Result.count = 9
+		end
+
+	update_inverse
+			-- Recompute `inverse_matrix' from `rotation', `scale' and the offset.
+		local
+			m: like inverse_matrix
+			i: INTEGER
+		do
+			create m.make_filled (0.0, 12)
+			from i := 0 until i >= 3 loop
+				-- Row i of R^T / s is column i of R
+				m [i * 4] := rotation [i] / scale
+				m [i * 4 + 1] := rotation [3 + i] / scale
+				m [i * 4 + 2] := rotation [6 + i] / scale
+				m [i * 4 + 3] := - (m [i * 4] * offset_x + m [i * 4 + 1] * offset_y + m [i * 4 + 2] * offset_z)
+				i := i + 1
+			end
+			inverse_matrix := m
+		end
+
+	mark_changed
+			-- Record a change of the transform.
+		do
+			version := version + 1
+			change_counter.put (change_counter.item + 1)
+		ensure
+			version_incremented: version = old version + 1
+		end
+
+invariant
+	prototype_attached: prototype /= Void
+	positive_scale: scale > 0.0
+	rotation_sized: rotation /= Void and then rotation.count = 9
+	inverse_sized: inverse_matrix /= Void and then inverse_matrix.count = 12
+
+end
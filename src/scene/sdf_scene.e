@@ -9,7 +9,41 @@ note
 
 		Operations can be exact (sharp) or smooth (blended).
 		The first shape added is the base; subsequent shapes are combined
-		using the specified operation.
+		using the specified operation. To scope operations to part of a
+		scene (a cut through one object only), build a tree of
+		SDF_SCENE_GROUP nodes instead.
+
+		`freeze' lowers the scene to an SDF_TAPE that `distance_at' then
+		runs instead of walking the entries. Adding shapes thaws the
+		scene; moving, resizing or transforming one of its shapes lowers
+		the tape again on the next evaluation. The shared change stamp
+		makes the check cheap, and edits to shapes of other scenes leave
+		the tape alone.
+
+		`enable_hierarchy' makes `distance_at' cull shapes through a
+		bounding volume hierarchy (SDF_SCENE_HIERARCHY), which follows
+		shape moves by itself. It takes precedence over a frozen tape.
+
+		A frozen scene also evaluates in single precision
+		(`distance_at_32'), which SDF_RAY_MARCHER uses in mixed precision.
+
+		`bounds' folds the shape bounds through the operations: a union
+		grows the box, a sharp intersection shrinks it to the overlap and
+		a smooth operation widens it by its blend radius. It is cached
+		until a shape changes or an entry is added, and SDF_RAY_MARCHER
+		clips rays to it.
+
+		Every change records a dirty region: the world-space box outside
+		which the surface did not move. An added shape dirties its bounds,
+		a moved or resized one its old and new bounds, each widened by the
+		entry's blend radius; an added intersection or `clear' dirties the
+		whole scene. Shape edits are picked up through the shared change
+		stamp by `sync_dirty_regions', which a cache calls before it
+		reads the log. Caches built from the scene keep the
+		`dirty_serial' they were built at and rebuild only what
+		`dirty_regions_since' touches (SDF_BRICK_FIELD.update,
+		SDF_CLIPMAP_FIELD.update). A cached distance d at a point is
+		stale only if a region lies within |d| of it.
 	]"
 	author: "Larry Rix"
 	date: "$Date$"
@@ -18,6 +52,15 @@ note
 class
 	SDF_SCENE
 
+inherit
+	SDF_FIELD
+		redefine
+			distance_at_32,
+			bounds
+		end
+
+	SDF_SHARED_CHANGE_STAMP
+
 create
 	make
 
@@ -28,6 +71,9 @@ feature {NONE} -- Initialization
 		do
 			create shapes.make (10)
 			create ops
+			create dirty_regions.make (Dirty_log_capacity)
+			create cached_bounds.make_empty
+			seen_stamp := change_stamp
 		ensure
 			empty_scene: shapes.is_empty
 		end
@@ -59,21 +105,39 @@ feature -- Distance evaluation
 	distance (p: SDF_VEC3): REAL_64
 			-- Combined signed distance from point to scene.
 			-- Returns max value if scene is empty.
+		require
+			point_attached: p /= Void
+		do
+			Result := distance_at (p.x, p.y, p.z)
+		end
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Combined signed distance from point (x, y, z) to scene.
+			-- Returns max value if scene is empty.
 		local
 			entry: SDF_SCENE_ENTRY
 			d: REAL_64
 			i: INTEGER
 		do
-			if shapes.is_empty then
+			if use_hierarchy then
+				if not attached hierarchy then
+					create hierarchy.make (Current)
+				end
+				if attached hierarchy as l_hierarchy then
+					Result := l_hierarchy.distance_at (a_x, a_y, a_z)
+				end
+			elseif attached live_tape as l_tape then
+				Result := l_tape.distance_at (a_x, a_y, a_z)
+			elseif shapes.is_empty then
 				Result := {REAL_64}.max_value
 			else
 				-- Start with first shape's distance
-				Result := shapes.first.shape.distance (p)
+				Result := shapes.first.shape.distance_at (a_x, a_y, a_z)
 
 				-- Combine with remaining shapes
 				from i := 2 until i > shapes.count loop
 					entry := shapes [i]
-					d := entry.shape.distance (p)
+					d := entry.shape.distance_at (a_x, a_y, a_z)
 
 					inspect entry.operation
 					when Op_union then
@@ -104,6 +168,233 @@ feature -- Distance evaluation
 			end
 		end
 
+	distance_at_32 (a_x, a_y, a_z: REAL_32): REAL_32
+			-- Single-precision distance: the frozen tape's REAL_32 run,
+			-- else `distance_at' rounded.
+		do
+			if not use_hierarchy and attached live_tape as l_tape then
+				Result := l_tape.distance_at_32 (a_x, a_y, a_z)
+			else
+				Result := Precursor (a_x, a_y, a_z)
+			end
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Range of the combined distance over the box, folded over the
+			-- entries like `distance_at'. [max, max] if the scene is empty.
+		local
+			entry: SDF_SCENE_ENTRY
+			d: SDF_INTERVAL
+			i: INTEGER
+		do
+			if shapes.is_empty then
+				Result.set ({REAL_64}.max_value, {REAL_64}.max_value)
+			else
+				Result := shapes.first.shape.interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+				from i := 2 until i > shapes.count loop
+					entry := shapes [i]
+					d := entry.shape.interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+					inspect entry.operation
+					when Op_subtraction then
+						if entry.blend > 0.0 then
+							Result := ops.interval_smooth_subtraction (d, Result, entry.blend)
+						else
+							Result := ops.interval_subtraction (d, Result)
+						end
+					when Op_intersection then
+						if entry.blend > 0.0 then
+							Result := ops.interval_smooth_intersection (Result, d, entry.blend)
+						else
+							Result := ops.interval_intersection (Result, d)
+						end
+					else
+						if entry.blend > 0.0 then
+							Result := ops.interval_smooth_union (Result, d, entry.blend)
+						else
+							Result := ops.interval_union (Result, d)
+						end
+					end
+					i := i + 1
+				end
+			end
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance and gradient at (x, y, z), from the frozen tape if
+			-- any and the hierarchy is off, else folded over the entries
+			-- like `distance_at'. Max value with zero gradient if the
+			-- scene is empty.
+		local
+			entry: SDF_SCENE_ENTRY
+			d: SDF_DUAL
+			i: INTEGER
+		do
+			if not use_hierarchy and attached live_tape as l_tape then
+				Result := l_tape.dual_at (a_x, a_y, a_z)
+			elseif shapes.is_empty then
+				Result.set ({REAL_64}.max_value, 0.0, 0.0, 0.0)
+			else
+				Result := shapes.first.shape.dual_at (a_x, a_y, a_z)
+				from i := 2 until i > shapes.count loop
+					entry := shapes [i]
+					d := entry.shape.dual_at (a_x, a_y, a_z)
+					inspect entry.operation
+					when Op_subtraction then
+						if entry.blend > 0.0 then
+							Result := ops.dual_smooth_subtraction (d, Result, entry.blend)
+						else
+							Result := ops.dual_subtraction (d, Result)
+						end
+					when Op_intersection then
+						if entry.blend > 0.0 then
+							Result := ops.dual_smooth_intersection (Result, d, entry.blend)
+						else
+							Result := ops.dual_intersection (Result, d)
+						end
+					else
+						if entry.blend > 0.0 then
+							Result := ops.dual_smooth_union (Result, d, entry.blend)
+						else
+							Result := ops.dual_union (Result, d)
+						end
+					end
+					i := i + 1
+				end
+			end
+		end
+
+	lipschitz_bound: REAL_64
+			-- Largest gradient length of the scene: the entries' Lipschitz
+			-- bounds combined through the operations like `distance_at'
+			-- (1 for an empty scene). Kept until an entry is added or a
+			-- shape changes, so the marcher may ask for it on every ray.
+		local
+			entry: SDF_SCENE_ENTRY
+			i: INTEGER
+		do
+			if not is_lipschitz_current or lipschitz_stamp /= change_stamp then
+				if shapes.is_empty then
+					cached_lipschitz := 1.0
+				else
+					cached_lipschitz := shapes.first.shape.lipschitz_bound
+					from i := 2 until i > shapes.count loop
+						entry := shapes [i]
+						if entry.blend > 0.0 then
+							cached_lipschitz := ops.lipschitz_smooth (cached_lipschitz, entry.shape.lipschitz_bound, entry.blend)
+						else
+							inspect entry.operation
+							when Op_subtraction then
+								cached_lipschitz := ops.lipschitz_subtraction (entry.shape.lipschitz_bound, cached_lipschitz)
+							when Op_intersection then
+								cached_lipschitz := ops.lipschitz_intersection (cached_lipschitz, entry.shape.lipschitz_bound)
+							else
+								cached_lipschitz := ops.lipschitz_union (cached_lipschitz, entry.shape.lipschitz_bound)
+							end
+						end
+						i := i + 1
+					end
+				end
+				lipschitz_stamp := change_stamp
+				is_lipschitz_current := True
+			end
+			Result := cached_lipschitz
+		end
+
+feature -- Bounds
+
+	bounds: SDF_AABB
+			-- Box enclosing the surface: entry boxes merged by unions,
+			-- clipped by intersections and widened by smooth blends
+			-- (empty for an empty scene)
+		local
+			entry: SDF_SCENE_ENTRY
+			i: INTEGER
+		do
+			if not is_bounds_current or bounds_stamp /= change_stamp then
+				cached_bounds.set_empty
+				from i := 1 until i > shapes.count loop
+					entry := shapes [i]
+					if i = 1 then
+						cached_bounds.merge (entry.shape.bounds)
+					elseif entry.operation = Op_intersection then
+						if entry.blend > 0.0 and not cached_bounds.is_empty then
+							cached_bounds.expand (entry.blend)
+						end
+						-- Only the overlap, widened by a smooth blend, keeps surface
+						cached_bounds.intersect (entry.affected_region)
+					elseif entry.operation = Op_subtraction then
+						-- Cutting never adds surface outside the box,
+						-- but a smooth cut bulges out by up to the blend
+						if entry.blend > 0.0 and not cached_bounds.is_empty then
+							cached_bounds.expand (entry.blend)
+						end
+					else
+						cached_bounds.merge (entry.shape.bounds)
+						if entry.blend > 0.0 then
+							-- A smooth union dips below the min near the seam
+							cached_bounds.expand (entry.blend)
+						end
+					end
+					i := i + 1
+				end
+				bounds_stamp := change_stamp
+				is_bounds_current := True
+			end
+			Result := cached_bounds.twin
+		ensure then
+			empty_scene_empty: shapes.is_empty implies Result.is_empty
+		end
+
+feature -- Compilation
+
+	tape: SDF_TAPE
+			-- Scene lowered to a register-allocated instruction tape
+		local
+			l_builder: SDF_TAPE_BUILDER
+		do
+			create l_builder.make
+			Result := l_builder.to_tape (l_builder.add_scene (Current))
+		ensure
+			result_attached: Result /= Void
+			at_most_one_instruction_per_shape_and_combine: Result.instruction_count <= (2 * count - 1).max (0)
+		end
+
+	frozen_tape: detachable SDF_TAPE
+			-- Tape used by `distance_at' while frozen
+
+	is_frozen: BOOLEAN
+			-- Is `distance_at' running `frozen_tape'?
+		do
+			Result := frozen_tape /= Void
+		end
+
+	freeze
+			-- Compile to `frozen_tape' and evaluate through it from now on.
+		do
+			frozen_tape := tape
+			frozen_stamp := change_stamp
+			frozen_versions := shape_version_sum
+		ensure
+			frozen: is_frozen
+		end
+
+	thaw
+			-- Evaluate by walking the entries again.
+		do
+			frozen_tape := Void
+		ensure
+			not_frozen: not is_frozen
+		end
+
+	compiled: SDF_COMPILED_SCENE
+			-- Flat snapshot of this scene for native renderers
+		do
+			create Result.make (Current)
+		ensure
+			result_attached: Result /= Void
+			same_count: Result.count = count
+		end
+
 feature -- Element change
 
 	add (a_shape: SDF_SHAPE): like Current
@@ -112,9 +403,12 @@ feature -- Element change
 			shape_attached: a_shape /= Void
 		do
 			shapes.extend (create {SDF_SCENE_ENTRY}.make (a_shape, Op_union, 0.0))
+			record_added (shapes.last)
+			invalidate
 			Result := Current
 		ensure
 			shape_added: shapes.count = old shapes.count + 1
+			thawed: not is_frozen
 			result_is_current: Result = Current
 		end
 
@@ -124,9 +418,12 @@ feature -- Element change
 			shape_attached: a_shape /= Void
 		do
 			shapes.extend (create {SDF_SCENE_ENTRY}.make (a_shape, Op_union, 0.0))
+			record_added (shapes.last)
+			invalidate
 			Result := Current
 		ensure
 			shape_added: shapes.count = old shapes.count + 1
+			thawed: not is_frozen
 			result_is_current: Result = Current
 		end
 
@@ -136,9 +433,12 @@ feature -- Element change
 			shape_attached: a_shape /= Void
 		do
 			shapes.extend (create {SDF_SCENE_ENTRY}.make (a_shape, Op_subtraction, 0.0))
+			record_added (shapes.last)
+			invalidate
 			Result := Current
 		ensure
 			shape_added: shapes.count = old shapes.count + 1
+			thawed: not is_frozen
 			result_is_current: Result = Current
 		end
 
@@ -148,9 +448,12 @@ feature -- Element change
 			shape_attached: a_shape /= Void
 		do
 			shapes.extend (create {SDF_SCENE_ENTRY}.make (a_shape, Op_intersection, 0.0))
+			record_added (shapes.last)
+			invalidate
 			Result := Current
 		ensure
 			shape_added: shapes.count = old shapes.count + 1
+			thawed: not is_frozen
 			result_is_current: Result = Current
 		end
 
@@ -161,9 +464,12 @@ feature -- Element change
 			positive_blend: a_blend > 0.0
 		do
 			shapes.extend (create {SDF_SCENE_ENTRY}.make (a_shape, Op_union, a_blend))
+			record_added (shapes.last)
+			invalidate
 			Result := Current
 		ensure
 			shape_added: shapes.count = old shapes.count + 1
+			thawed: not is_frozen
 			result_is_current: Result = Current
 		end
 
@@ -174,9 +480,12 @@ feature -- Element change
 			positive_blend: a_blend > 0.0
 		do
 			shapes.extend (create {SDF_SCENE_ENTRY}.make (a_shape, Op_subtraction, a_blend))
+			record_added (shapes.last)
+			invalidate
 			Result := Current
 		ensure
 			shape_added: shapes.count = old shapes.count + 1
+			thawed: not is_frozen
 			result_is_current: Result = Current
 		end
 
@@ -187,21 +496,231 @@ feature -- Element change
 			positive_blend: a_blend > 0.0
 		do
 			shapes.extend (create {SDF_SCENE_ENTRY}.make (a_shape, Op_intersection, a_blend))
+			record_added (shapes.last)
+			invalidate
 			Result := Current
 		ensure
 			shape_added: shapes.count = old shapes.count + 1
+			thawed: not is_frozen
 			result_is_current: Result = Current
 		end
 
 	clear
 			-- Remove all shapes from scene.
 		do
+			sync_dirty_regions
+			record_dirty (extent)
 			shapes.wipe_out
+			invalidate
 		ensure
 			empty: shapes.is_empty
+			thawed: not is_frozen
+		end
+
+feature -- Change tracking
+
+	dirty_serial: INTEGER
+			-- Number of dirty regions recorded up to the last
+			-- `sync_dirty_regions'
+		do
+			Result := dropped_region_count + dirty_regions.count
+		end
+
+	has_dirty_regions_since (a_serial: INTEGER): BOOLEAN
+			-- Does the log still hold every region recorded after
+			-- `a_serial'? If not, a cache must rebuild in full.
+		do
+			Result := a_serial >= dropped_region_count and a_serial <= dropped_region_count + dirty_regions.count
+		end
+
+	dirty_regions_since (a_serial: INTEGER): ARRAYED_LIST [SDF_AABB]
+			-- Regions recorded after `a_serial', oldest first
+		require
+			logged: has_dirty_regions_since (a_serial)
+		local
+			i: INTEGER
+		do
+			create Result.make (dropped_region_count + dirty_regions.count - a_serial)
+			from i := a_serial - dropped_region_count + 1 until i > dirty_regions.count loop
+				Result.extend (dirty_regions [i])
+				i := i + 1
+			end
+		ensure
+			result_attached: Result /= Void
+		end
+
+	Dirty_log_capacity: INTEGER = 256
+			-- Regions kept before the oldest are dropped
+
+	sync_dirty_regions
+			-- Record old and new region of every entry whose shape changed
+			-- since the last sync; call before reading the log.
+		local
+			l_region: SDF_AABB
+			i: INTEGER
+		do
+			if seen_stamp /= change_stamp then
+				from i := 1 until i > shapes.count loop
+					if shapes [i].is_edited then
+						create l_region.make_empty
+						l_region.merge (shapes [i].seen_region)
+						l_region.merge (shapes [i].affected_region)
+						shapes [i].note_seen
+						record_dirty (l_region)
+					end
+					i := i + 1
+				end
+				seen_stamp := change_stamp
+			end
+		ensure
+			serial_grown: dirty_serial >= old dirty_serial
+		end
+
+feature -- Acceleration
+
+	use_hierarchy: BOOLEAN
+			-- Does `distance_at' go through `hierarchy'?
+
+	hierarchy: detachable SDF_SCENE_HIERARCHY
+			-- BVH evaluator, built on first use after `enable_hierarchy'
+
+	enable_hierarchy
+			-- Cull distant shapes with a bounding volume hierarchy.
+		do
+			use_hierarchy := True
+		ensure
+			enabled: use_hierarchy
+		end
+
+	disable_hierarchy
+			-- Evaluate every shape again.
+		do
+			use_hierarchy := False
+			hierarchy := Void
+		ensure
+			disabled: not use_hierarchy
+		end
+
+feature {NONE} -- Implementation
+
+	invalidate
+			-- Drop caches that depend on the entry list.
+		do
+			frozen_tape := Void
+			hierarchy := Void
+			is_bounds_current := False
+			is_lipschitz_current := False
+		ensure
+			thawed: not is_frozen
+			no_hierarchy: hierarchy = Void
+			bounds_stale: not is_bounds_current
+			lipschitz_stale: not is_lipschitz_current
+		end
+
+	frozen_stamp: NATURAL_64
+			-- `change_stamp' when `frozen_tape' was last checked
+
+	frozen_versions: NATURAL_64
+			-- `shape_version_sum' when `frozen_tape' was lowered
+
+	live_tape: detachable SDF_TAPE
+			-- `frozen_tape', lowered again first if one of the entries'
+			-- shapes changed since (Void when not frozen)
+		do
+			if attached frozen_tape and frozen_stamp /= change_stamp then
+				-- Something changed somewhere: only our own shapes matter
+				if shape_version_sum /= frozen_versions then
+					freeze
+				else
+					frozen_stamp := change_stamp
+				end
+			end
+			Result := frozen_tape
+		end
+
+	shape_version_sum: NATURAL_64
+			-- Sum of the entries' shape versions: versions only grow and
+			-- adding an entry thaws, so it changes exactly when a shape does
+		local
+			i: INTEGER
+		do
+			from i := 1 until i > shapes.count loop
+				Result := Result + shapes [i].shape.version
+				i := i + 1
+			end
+		end
+
+	cached_bounds: SDF_AABB
+			-- `bounds' as last folded
+
+	is_bounds_current: BOOLEAN
+			-- Was `cached_bounds' folded from the current entry list?
+
+	bounds_stamp: NATURAL_64
+			-- `change_stamp' when `cached_bounds' was folded
+
+	cached_lipschitz: REAL_64
+			-- `lipschitz_bound' as last folded
+
+	is_lipschitz_current: BOOLEAN
+			-- Was `cached_lipschitz' folded from the current entry list?
+
+	lipschitz_stamp: NATURAL_64
+			-- `change_stamp' when `cached_lipschitz' was folded
+
+	dirty_regions: ARRAYED_LIST [SDF_AABB]
+			-- Most recent dirty regions, oldest first
+
+	dropped_region_count: INTEGER
+			-- Regions dropped from the front of `dirty_regions'
+
+	seen_stamp: NATURAL_64
+			-- `change_stamp' when the entries were last checked for edits
+
+	record_dirty (a_region: SDF_AABB)
+			-- Append `a_region' to the log, dropping the oldest when full.
+		require
+			region_attached: a_region /= Void
+		do
+			if not a_region.is_empty then
+				if dirty_regions.count >= Dirty_log_capacity then
+					dirty_regions.start
+					dirty_regions.remove
+					dropped_region_count := dropped_region_count + 1
+				end
+				dirty_regions.extend (a_region)
+			end
+		end
+
+	record_added (a_entry: SDF_SCENE_ENTRY)
+			-- Record the region changed by appending `a_entry'.
+		require
+			entry_attached: a_entry /= Void
+		do
+			sync_dirty_regions
+			if a_entry.operation = Op_intersection then
+				-- Clips everything outside the shape
+				record_dirty (extent)
+			else
+				record_dirty (a_entry.affected_region)
+			end
+		end
+
+	extent: SDF_AABB
+			-- Union of every entry's region as last seen
+		local
+			i: INTEGER
+		do
+			create Result.make_empty
+			from i := 1 until i > shapes.count loop
+				Result.merge (shapes [i].seen_region)
+				i := i + 1
+			end
+		ensure
+			result_attached: Result /= Void
 		end
 
-feature {NONE} -- Operation constants
+feature -- Operation constants
 
 	Op_union: INTEGER = 1
 	Op_subtraction: INTEGER = 2
@@ -210,5 +729,8 @@ feature {NONE} -- Operation constants
 invariant
 	shapes_attached: shapes /= Void
 	ops_attached: ops /= Void
+	dirty_regions_attached: dirty_regions /= Void
+	cached_bounds_attached: cached_bounds /= Void
+	bounded_log: dirty_regions.count <= Dirty_log_capacity
 
 end
@@ -1,6 +1,10 @@
 note
 	description: "[
 		Entry in an SDF scene: shape with operation and blend radius.
+
+		The entry remembers the shape's `version' and region as the scene
+		last saw them, so the scene can tell which entries an edit moved
+		and where they used to be.
 	]"
 	author: "Larry Rix"
 	date: "$Date$"
@@ -24,6 +28,7 @@ feature {NONE} -- Initialization
 			shape := a_shape
 			operation := a_operation
 			blend := a_blend
+			note_seen
 		ensure
 			shape_set: shape = a_shape
 			operation_set: operation = a_operation
@@ -41,9 +46,47 @@ feature -- Access
 	blend: REAL_64
 			-- Blend radius for smooth operations (0 = sharp)
 
+	affected_region: SDF_AABB
+			-- Region whose surface the entry can change: the shape's
+			-- bounds widened by `blend'
+		do
+			Result := shape.bounds
+			if blend > 0.0 then
+				Result.expand (blend)
+			end
+		ensure
+			result_attached: Result /= Void
+		end
+
+feature -- Change tracking
+
+	seen_version: NATURAL_64
+			-- `shape.version' when the scene last looked
+
+	seen_region: SDF_AABB
+			-- `affected_region' when the scene last looked
+
+	is_edited: BOOLEAN
+			-- Has the shape changed since the scene last looked?
+		do
+			Result := shape.version /= seen_version
+		end
+
+feature {SDF_SCENE} -- Change tracking
+
+	note_seen
+			-- Remember the shape as it is now.
+		do
+			seen_version := shape.version
+			seen_region := affected_region
+		ensure
+			not_edited: not is_edited
+		end
+
 invariant
 	shape_attached: shape /= Void
 	valid_operation: operation >= 1 and operation <= 3
 	non_negative_blend: blend >= 0.0
+	seen_region_attached: seen_region /= Void
 
 end
@@ -0,0 +1,537 @@
+note
+	description: "[
+		Node of a hierarchical CSG scene: an ordered list of children,
+		shapes or nested groups, each joined to the fold of the children
+		before it by its own operation and blend radius.
+
+		SDF_SCENE folds every entry into one running result, so a
+		subtraction cuts everything added before it. A group scopes its
+		operations: a subtraction inside a group cuts only that group's
+		children, and the group enters its parent as a single operand
+		with the operation and blend it was added with.
+
+		Each group caches a box its distance never undercuts: the bounds
+		of its first child and its union children, widened by smooth
+		blends (subtraction and intersection only raise the distance).
+		`distance_at' skips a child whose box is too far away to change
+		the running result, and evaluates each run of sharp unions
+		(where order does not matter) starting with its nearest child.
+		In a well-partitioned tree a sample then only descends into the
+		few groups around it.
+
+		Culling relies on primitives returning at least the distance to
+		their bounds (true for all exact SDF primitives). Moving shapes
+		and adding children are picked up on the next evaluation through
+		the shared change stamp.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_SCENE_GROUP
+
+inherit
+	SDF_FIELD
+		redefine
+			bounds
+		end
+
+	SDF_SHARED_CHANGE_STAMP
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make
+			-- Create empty group.
+		do
+			create ops
+			create children.make (4)
+			create operations.make (4)
+			create blends.make (4)
+			create child_bounds.make (4)
+			create cached_bounds.make_empty
+			seen_stamp := change_stamp
+		ensure
+			empty: is_empty
+		end
+
+feature -- Access
+
+	count: INTEGER
+			-- Number of children
+		do
+			Result := children.count
+		end
+
+	child (i: INTEGER): SDF_FIELD
+			-- Child `i' (an SDF_SHAPE or an SDF_SCENE_GROUP)
+		require
+			valid_index: i >= 1 and i <= count
+		do
+			Result := children [i]
+		end
+
+	operation (i: INTEGER): INTEGER
+			-- Operation joining child `i' to the fold of the children
+			-- before it (see SDF_SCENE operation constants; ignored for
+			-- the first child)
+		require
+			valid_index: i >= 1 and i <= count
+		do
+			Result := operations [i]
+		end
+
+	blend (i: INTEGER): REAL_64
+			-- Blend radius of `operation' (i) (0 = sharp)
+		require
+			valid_index: i >= 1 and i <= count
+		do
+			Result := blends [i]
+		end
+
+	shape_count: INTEGER
+			-- Number of shapes in the whole subtree
+		local
+			i: INTEGER
+		do
+			from i := 1 until i > children.count loop
+				if attached {SDF_SCENE_GROUP} children [i] as l_group then
+					Result := Result + l_group.shape_count
+				else
+					Result := Result + 1
+				end
+				i := i + 1
+			end
+		ensure
+			non_negative: Result >= 0
+		end
+
+	bounds: SDF_AABB
+			-- Box outside which the distance is at least the distance to
+			-- the box (empty for an empty group)
+		do
+			refresh
+			Result := cached_bounds.twin
+		ensure then
+			result_attached: Result /= Void
+		end
+
+	last_evaluated_count: INTEGER
+			-- Number of shapes evaluated by the last `distance_at'
+
+feature -- Status report
+
+	is_empty: BOOLEAN
+			-- Has the group no children?
+		do
+			Result := children.is_empty
+		end
+
+	has_group (a_group: SDF_SCENE_GROUP): BOOLEAN
+			-- Is `a_group' this group or nested anywhere below it?
+		require
+			group_attached: a_group /= Void
+		local
+			i: INTEGER
+		do
+			Result := a_group = Current
+			from i := 1 until Result or i > children.count loop
+				if attached {SDF_SCENE_GROUP} children [i] as l_group then
+					Result := l_group.has_group (a_group)
+				end
+				i := i + 1
+			end
+		end
+
+feature -- Distance evaluation
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Signed distance from (x, y, z): the children folded in order,
+			-- skipping those that cannot change the result.
+			-- Returns max value if the group is empty.
+		local
+			i, j: INTEGER
+		do
+			refresh
+			last_evaluated_count := 0
+			Result := {REAL_64}.max_value
+			from i := 1 until i > children.count loop
+				if i = 1 or is_sharp_union (i) then
+					from j := i until j = children.count or else not is_sharp_union (j + 1) loop
+						j := j + 1
+					end
+					Result := union_run (i, j, Result, a_x, a_y, a_z)
+					i := j + 1
+				else
+					if not is_culled (i, Result, a_x, a_y, a_z) then
+						Result := combined (i, Result, child_distance (i, a_x, a_y, a_z))
+					end
+					i := i + 1
+				end
+			end
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Range of the distance over the box, folded over the children.
+			-- [max, max] if the group is empty.
+		local
+			d: SDF_INTERVAL
+			i: INTEGER
+		do
+			if children.is_empty then
+				Result.set ({REAL_64}.max_value, {REAL_64}.max_value)
+			else
+				Result := children.first.interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+				from i := 2 until i > children.count loop
+					d := children [i].interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+					if operations [i] = {SDF_SCENE}.Op_subtraction then
+						if blends [i] > 0.0 then
+							Result := ops.interval_smooth_subtraction (d, Result, blends [i])
+						else
+							Result := ops.interval_subtraction (d, Result)
+						end
+					elseif operations [i] = {SDF_SCENE}.Op_intersection then
+						if blends [i] > 0.0 then
+							Result := ops.interval_smooth_intersection (Result, d, blends [i])
+						else
+							Result := ops.interval_intersection (Result, d)
+						end
+					else
+						if blends [i] > 0.0 then
+							Result := ops.interval_smooth_union (Result, d, blends [i])
+						else
+							Result := ops.interval_union (Result, d)
+						end
+					end
+					i := i + 1
+				end
+			end
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance and gradient at (x, y, z), folded over the children
+			-- (one evaluation per hit does not need culling).
+			-- Max value with zero gradient if the group is empty.
+		local
+			d: SDF_DUAL
+			i: INTEGER
+		do
+			if children.is_empty then
+				Result.set ({REAL_64}.max_value, 0.0, 0.0, 0.0)
+			else
+				Result := children.first.dual_at (a_x, a_y, a_z)
+				from i := 2 until i > children.count loop
+					d := children [i].dual_at (a_x, a_y, a_z)
+					if operations [i] = {SDF_SCENE}.Op_subtraction then
+						if blends [i] > 0.0 then
+							Result := ops.dual_smooth_subtraction (d, Result, blends [i])
+						else
+							Result := ops.dual_subtraction (d, Result)
+						end
+					elseif operations [i] = {SDF_SCENE}.Op_intersection then
+						if blends [i] > 0.0 then
+							Result := ops.dual_smooth_intersection (Result, d, blends [i])
+						else
+							Result := ops.dual_intersection (Result, d)
+						end
+					else
+						if blends [i] > 0.0 then
+							Result := ops.dual_smooth_union (Result, d, blends [i])
+						else
+							Result := ops.dual_union (Result, d)
+						end
+					end
+					i := i + 1
+				end
+			end
+		end
+
+	lipschitz_bound: REAL_64
+			-- Child bounds folded through the operations (1 for an empty group)
+		local
+			i: INTEGER
+		do
+			if children.is_empty then
+				Result := 1.0
+			else
+				Result := children.first.lipschitz_bound
+				from i := 2 until i > children.count loop
+					if blends [i] > 0.0 then
+						Result := ops.lipschitz_smooth (Result, children [i].lipschitz_bound, blends [i])
+					elseif operations [i] = {SDF_SCENE}.Op_subtraction then
+						Result := ops.lipschitz_subtraction (children [i].lipschitz_bound, Result)
+					elseif operations [i] = {SDF_SCENE}.Op_intersection then
+						Result := ops.lipschitz_intersection (Result, children [i].lipschitz_bound)
+					else
+						Result := ops.lipschitz_union (Result, children [i].lipschitz_bound)
+					end
+					i := i + 1
+				end
+			end
+		end
+
+feature -- Compilation
+
+	tape: SDF_TAPE
+			-- Group tree lowered to a register-allocated instruction tape
+			-- (no culling: every shape is evaluated)
+		local
+			l_builder: SDF_TAPE_BUILDER
+		do
+			create l_builder.make
+			Result := l_builder.to_tape (l_builder.add_scene_group (Current))
+		ensure
+			result_attached: Result /= Void
+		end
+
+feature -- Element change
+
+	add (a_shape: SDF_SHAPE): like Current
+			-- Add shape with union operation (base case).
+		require
+			shape_attached: a_shape /= Void
+		do
+			Result := add_shape (a_shape, {SDF_SCENE}.Op_union, 0.0)
+		ensure
+			shape_added: count = old count + 1
+			result_is_current: Result = Current
+		end
+
+	add_union (a_shape: SDF_SHAPE): like Current
+			-- Add shape combined with union (OR).
+		require
+			shape_attached: a_shape /= Void
+		do
+			Result := add_shape (a_shape, {SDF_SCENE}.Op_union, 0.0)
+		ensure
+			shape_added: count = old count + 1
+			result_is_current: Result = Current
+		end
+
+	add_subtraction (a_shape: SDF_SHAPE): like Current
+			-- Add shape cut from the group's children added so far.
+		require
+			shape_attached: a_shape /= Void
+		do
+			Result := add_shape (a_shape, {SDF_SCENE}.Op_subtraction, 0.0)
+		ensure
+			shape_added: count = old count + 1
+			result_is_current: Result = Current
+		end
+
+	add_intersection (a_shape: SDF_SHAPE): like Current
+			-- Add shape combined with intersection (AND).
+		require
+			shape_attached: a_shape /= Void
+		do
+			Result := add_shape (a_shape, {SDF_SCENE}.Op_intersection, 0.0)
+		ensure
+			shape_added: count = old count + 1
+			result_is_current: Result = Current
+		end
+
+	add_shape (a_shape: SDF_SHAPE; a_operation: INTEGER; a_blend: REAL_64): like Current
+			-- Add shape combined by `a_operation' with blend radius `a_blend'.
+		require
+			shape_attached: a_shape /= Void
+			valid_operation: a_operation >= {SDF_SCENE}.Op_union and a_operation <= {SDF_SCENE}.Op_intersection
+			non_negative_blend: a_blend >= 0.0
+		do
+			extend_child (a_shape, a_operation, a_blend)
+			Result := Current
+		ensure
+			shape_added: count = old count + 1
+			result_is_current: Result = Current
+		end
+
+	add_group (a_group: SDF_SCENE_GROUP; a_operation: INTEGER; a_blend: REAL_64): like Current
+			-- Add `a_group' as one operand combined by `a_operation' with
+			-- blend radius `a_blend'.
+		require
+			group_attached: a_group /= Void
+			no_cycle: not a_group.has_group (Current)
+			valid_operation: a_operation >= {SDF_SCENE}.Op_union and a_operation <= {SDF_SCENE}.Op_intersection
+			non_negative_blend: a_blend >= 0.0
+		do
+			extend_child (a_group, a_operation, a_blend)
+			Result := Current
+		ensure
+			group_added: count = old count + 1
+			result_is_current: Result = Current
+		end
+
+feature -- Update
+
+	refresh
+			-- Recompute the cached bounds if any shape or group changed
+			-- since the last check.
+		local
+			i: INTEGER
+		do
+			if seen_stamp /= change_stamp then
+				cached_bounds.set_empty
+				from i := 1 until i > children.count loop
+					child_bounds [i] := children [i].bounds
+					-- Subtraction and intersection never lower the distance
+					if (i = 1 or operations [i] = {SDF_SCENE}.Op_union) and not child_bounds [i].is_empty then
+						cached_bounds.merge (child_bounds [i])
+						if i > 1 and blends [i] > 0.0 then
+							-- A smooth union dips below the min near the seam
+							cached_bounds.expand (blends [i])
+						end
+					end
+					i := i + 1
+				end
+				seen_stamp := change_stamp
+			end
+		end
+
+feature {NONE} -- Implementation
+
+	ops: SDF_OPS
+			-- Boolean operations
+
+	children: ARRAYED_LIST [SDF_FIELD]
+			-- Shapes and nested groups, in fold order
+
+	operations: ARRAYED_LIST [INTEGER]
+			-- Operation per child
+
+	blends: ARRAYED_LIST [REAL_64]
+			-- Blend radius per child
+
+	child_bounds: ARRAYED_LIST [SDF_AABB]
+			-- Bounds per child as of the last `refresh'
+
+	cached_bounds: SDF_AABB
+			-- Bounds of the group as of the last `refresh'
+
+	seen_stamp: NATURAL_64
+			-- `change_stamp' at the last `refresh'
+
+	extend_child (a_child: SDF_FIELD; a_operation: INTEGER; a_blend: REAL_64)
+			-- Append `a_child' and mark the group changed.
+		do
+			children.extend (a_child)
+			operations.extend (a_operation)
+			blends.extend (a_blend)
+			child_bounds.extend (create {SDF_AABB}.make_empty)
+			-- Enclosing groups hold bounds that depend on this one
+			change_counter.put (change_counter.item + 1)
+		end
+
+	is_sharp_union (i: INTEGER): BOOLEAN
+			-- Is child `i' joined by a sharp union?
+		do
+			Result := operations [i] = {SDF_SCENE}.Op_union and blends [i] = 0.0
+		end
+
+	box_distance (i: INTEGER; a_x, a_y, a_z: REAL_64): REAL_64
+			-- Distance from (x, y, z) to the bounds of child `i'
+			-- (max value for an empty child group)
+		do
+			if child_bounds [i].is_empty then
+				Result := {REAL_64}.max_value
+			else
+				Result := child_bounds [i].distance_at (a_x, a_y, a_z)
+			end
+		end
+
+	is_culled (i: INTEGER; a_current, a_x, a_y, a_z: REAL_64): BOOLEAN
+			-- Does combining child `i' leave `a_current' unchanged at (x, y, z)?
+			-- Judged only outside the child's box, where the box distance is
+			-- a lower bound of the child's distance.
+		local
+			l_box: REAL_64
+		do
+			if a_current < {REAL_64}.max_value then
+				l_box := box_distance (i, a_x, a_y, a_z)
+				if l_box > 0.0 then
+					if i = 1 or is_sharp_union (i) then
+						Result := l_box >= a_current
+					elseif operations [i] = {SDF_SCENE}.Op_union then
+						-- Smooth union is the min once the operands are a blend apart
+						Result := l_box >= a_current + blends [i]
+					elseif operations [i] = {SDF_SCENE}.Op_subtraction then
+						-- max (-d, current) is current once -d is a blend below it
+						Result := l_box >= blends [i] - a_current
+					end
+				end
+			end
+		end
+
+	union_run (a_first, a_last: INTEGER; a_best, a_x, a_y, a_z: REAL_64): REAL_64
+			-- `a_best' united with children `a_first'..`a_last' (sharp unions,
+			-- or the base), visiting the child with the nearest box first.
+		local
+			i, l_nearest: INTEGER
+			l_box, l_nearest_box: REAL_64
+		do
+			Result := a_best
+			l_nearest := a_first
+			if a_last > a_first then
+				l_nearest_box := {REAL_64}.max_value
+				from i := a_first until i > a_last loop
+					l_box := box_distance (i, a_x, a_y, a_z)
+					if l_box < l_nearest_box then
+						l_nearest := i
+						l_nearest_box := l_box
+					end
+					i := i + 1
+				end
+			end
+			if not is_culled (l_nearest, Result, a_x, a_y, a_z) then
+				Result := Result.min (child_distance (l_nearest, a_x, a_y, a_z))
+			end
+			from i := a_first until i > a_last loop
+				if i /= l_nearest and then not is_culled (i, Result, a_x, a_y, a_z) then
+					Result := Result.min (child_distance (i, a_x, a_y, a_z))
+				end
+				i := i + 1
+			end
+		end
+
+	child_distance (i: INTEGER; a_x, a_y, a_z: REAL_64): REAL_64
+			-- Distance to child `i', counted in `last_evaluated_count'
+		do
+			Result := children [i].distance_at (a_x, a_y, a_z)
+			if attached {SDF_SCENE_GROUP} children [i] as l_group then
+				last_evaluated_count := last_evaluated_count + l_group.last_evaluated_count
+			else
+				last_evaluated_count := last_evaluated_count + 1
+			end
+		end
+
+	combined (i: INTEGER; a_current, a_distance: REAL_64): REAL_64
+			-- `a_current' combined with `a_distance' by the operation of child `i'
+		do
+			if operations [i] = {SDF_SCENE}.Op_subtraction then
+				if blends [i] > 0.0 then
+					Result := ops.smooth_subtraction (a_distance, a_current, blends [i])
+				else
+					Result := ops.op_subtraction (a_distance, a_current)
+				end
+			elseif operations [i] = {SDF_SCENE}.Op_intersection then
+				if blends [i] > 0.0 then
+					Result := ops.smooth_intersection (a_current, a_distance, blends [i])
+				else
+					Result := ops.op_intersection (a_current, a_distance)
+				end
+			else
+				if blends [i] > 0.0 then
+					Result := ops.smooth_union (a_current, a_distance, blends [i])
+				else
+					Result := ops.op_union (a_current, a_distance)
+				end
+			end
+		end
+
+invariant
+	ops_attached: ops /= Void
+	parallel_children: operations.count = children.count and blends.count = children.count
+		and child_bounds.count = children.count
+
+end
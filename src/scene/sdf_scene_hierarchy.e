@@ -0,0 +1,298 @@
+note
+	description: "[
+		BVH-accelerated evaluation of an SDF_SCENE.
+
+		The entry list is split into segments: maximal runs of union
+		entries (sharp or smooth, the first entry counts as a union) and
+		single subtraction/intersection entries. Segments are folded in
+		order exactly like SDF_SCENE.distance_at. Each union run of at
+		least `Min_run_length' entries gets an SDF_BVH over its entry
+		bounds, each widened by the entry's blend radius, and is walked
+		near-first: a subtree whose box is farther away than the current
+		best distance cannot change the result and is skipped.
+
+		Culling relies on primitives returning at least the distance to
+		their bounds (true for all exact SDF primitives). Inside a run,
+		smooth blends are applied in traversal order; this matches the
+		fold exactly for sharp unions and for blends that do not overlap
+		more than two shapes.
+
+		Moving or resizing shapes is picked up on the next evaluation:
+		a shared change stamp (SDF_SHAPE.change_stamp) makes the check
+		O(1) per sample, and changed entries refit their BVH.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_SCENE_HIERARCHY
+
+inherit
+	SDF_FIELD
+
+	SDF_SHARED_CHANGE_STAMP
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_scene: SDF_SCENE)
+			-- Build segments and hierarchies for `a_scene'.
+		require
+			scene_attached: a_scene /= Void
+		local
+			i, l_first: INTEGER
+		do
+			scene := a_scene
+			create ops
+			create segment_first.make (4)
+			create segment_last.make (4)
+			create segment_bvh.make (4)
+			create versions.make_filled (0, a_scene.count.max (1))
+			create stack.make_filled (0, 64)
+			from i := 1 until i > a_scene.count loop
+				versions [i - 1] := a_scene.shapes [i].shape.version
+				i := i + 1
+			end
+			from i := 1 until i > a_scene.count loop
+				if i = 1 or a_scene.shapes [i].operation = {SDF_SCENE}.Op_union then
+					-- Extend the current union run
+					from l_first := i until i > a_scene.count or else (i > l_first and a_scene.shapes [i].operation /= {SDF_SCENE}.Op_union) loop
+						i := i + 1
+					end
+					add_segment (l_first, i - 1)
+				else
+					add_segment (i, i)
+					i := i + 1
+				end
+			end
+			seen_stamp := change_stamp
+		ensure
+			scene_set: scene = a_scene
+		end
+
+feature -- Access
+
+	scene: SDF_SCENE
+			-- Scene being accelerated
+
+	segment_count: INTEGER
+			-- Number of fold segments
+		do
+			Result := segment_first.count
+		end
+
+	hierarchy_count: INTEGER
+			-- Number of union runs with a BVH
+		local
+			i: INTEGER
+		do
+			from i := 1 until i > segment_bvh.count loop
+				if segment_bvh [i] /= Void then
+					Result := Result + 1
+				end
+				i := i + 1
+			end
+		end
+
+	last_evaluated_count: INTEGER
+			-- Number of shapes evaluated by the last `distance_at'
+
+feature -- Distance evaluation
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Combined signed distance from (x, y, z) to `scene'.
+			-- Returns max value if the scene is empty.
+		local
+			s, i: INTEGER
+			l_entry: SDF_SCENE_ENTRY
+		do
+			refresh
+			last_evaluated_count := 0
+			Result := {REAL_64}.max_value
+			from s := 1 until s > segment_first.count loop
+				if attached segment_bvh [s] as l_bvh then
+					Result := union_run (l_bvh, segment_first [s], Result, a_x, a_y, a_z)
+				else
+					from i := segment_first [s] until i > segment_last [s] loop
+						l_entry := scene.shapes [i]
+						Result := combine (l_entry, Result, l_entry.shape.distance_at (a_x, a_y, a_z), i = 1)
+						last_evaluated_count := last_evaluated_count + 1
+						i := i + 1
+					end
+				end
+				s := s + 1
+			end
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Range of the distance over the box (the scene's entry fold).
+		do
+			Result := scene.interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Distance and gradient at (x, y, z) (the scene's entry fold:
+			-- one evaluation per hit does not need culling).
+		do
+			Result := scene.dual_at (a_x, a_y, a_z)
+		end
+
+	lipschitz_bound: REAL_64
+			-- Lipschitz bound of `scene' (culling does not change the field)
+		do
+			Result := scene.lipschitz_bound
+		end
+
+feature -- Update
+
+	refresh
+			-- Refit hierarchies whose shapes changed since the last check.
+		local
+			s, i: INTEGER
+			l_changed: BOOLEAN
+			l_shape: SDF_SHAPE
+		do
+			if seen_stamp /= change_stamp then
+				from s := 1 until s > segment_first.count loop
+					if attached segment_bvh [s] as l_bvh then
+						l_changed := False
+						from i := segment_first [s] until i > segment_last [s] loop
+							l_shape := scene.shapes [i].shape
+							if versions [i - 1] /= l_shape.version then
+								versions [i - 1] := l_shape.version
+								l_bvh.set_item_bounds (i - segment_first [s] + 1, entry_bounds (scene.shapes [i]))
+								l_changed := True
+							end
+							i := i + 1
+						end
+						if l_changed then
+							l_bvh.refit
+						end
+					end
+					s := s + 1
+				end
+				seen_stamp := change_stamp
+			end
+		end
+
+feature {NONE} -- Implementation
+
+	ops: SDF_OPS
+			-- Boolean operations
+
+	segment_first, segment_last: ARRAYED_LIST [INTEGER]
+			-- Entry range of each segment
+
+	segment_bvh: ARRAYED_LIST [detachable SDF_BVH]
+			-- Hierarchy of each union run (Void for short runs and single entries)
+
+	versions: SPECIAL [NATURAL_64]
+			-- Shape versions the bounds were taken from
+
+	seen_stamp: NATURAL_64
+			-- `change_stamp' at the last `refresh'
+
+	stack: SPECIAL [INTEGER]
+			-- Traversal stack reused by `union_run'
+
+	add_segment (a_first, a_last: INTEGER)
+			-- Append segment for entries `a_first'..`a_last'.
+		local
+			l_boxes: ARRAY [SDF_AABB]
+			i: INTEGER
+		do
+			segment_first.extend (a_first)
+			segment_last.extend (a_last)
+			if a_last - a_first + 1 >= Min_run_length then
+				create l_boxes.make_filled (create {SDF_AABB}.make_empty, 1, a_last - a_first + 1)
+				from i := a_first until i > a_last loop
+					l_boxes [i - a_first + 1] := entry_bounds (scene.shapes [i])
+					i := i + 1
+				end
+				segment_bvh.extend (create {SDF_BVH}.make (l_boxes))
+			else
+				segment_bvh.extend (Void)
+			end
+		end
+
+	entry_bounds (a_entry: SDF_SCENE_ENTRY): SDF_AABB
+			-- Shape bounds of `a_entry' widened by its blend radius
+		do
+			Result := a_entry.affected_region
+		end
+
+	union_run (a_bvh: SDF_BVH; a_first: INTEGER; a_best, a_x, a_y, a_z: REAL_64): REAL_64
+			-- `a_best' united with the run starting at entry `a_first', near-first.
+		local
+			l_top, l_node, l_near, l_far: INTEGER
+			l_box: REAL_64
+			l_entry: SDF_SCENE_ENTRY
+		do
+			Result := a_best
+			stack [0] := 1
+			l_top := 1
+			from until l_top = 0 loop
+				l_top := l_top - 1
+				l_node := stack [l_top]
+				l_box := a_bvh.node_distance (l_node, a_x, a_y, a_z)
+				-- Outside the box every enclosed shape is at least `l_box' away
+				if l_box <= 0.0 or l_box < Result then
+					if a_bvh.is_leaf (l_node) then
+						l_entry := scene.shapes [a_first + a_bvh.leaf_item (l_node) - 1]
+						Result := combine (l_entry, Result, l_entry.shape.distance_at (a_x, a_y, a_z), True)
+						last_evaluated_count := last_evaluated_count + 1
+					else
+						-- Push the farther child first so the nearer one is visited next
+						l_near := a_bvh.left (l_node)
+						l_far := a_bvh.right (l_node)
+						if a_bvh.node_distance (l_far, a_x, a_y, a_z) < a_bvh.node_distance (l_near, a_x, a_y, a_z) then
+							l_near := l_far
+							l_far := a_bvh.left (l_node)
+						end
+						if l_top + 2 > stack.count then
+							stack := stack.aliased_resized_area_with_default (0, stack.count * 2)
+						end
+						stack [l_top] := l_far
+						stack [l_top + 1] := l_near
+						l_top := l_top + 2
+					end
+				end
+			end
+		end
+
+	combine (a_entry: SDF_SCENE_ENTRY; a_current, a_distance: REAL_64; a_as_union: BOOLEAN): REAL_64
+			-- `a_current' combined with `a_distance' by the entry's operation
+			-- (always union when `a_as_union').
+		do
+			if a_as_union or a_entry.operation = {SDF_SCENE}.Op_union then
+				if a_entry.blend > 0.0 then
+					Result := ops.smooth_union (a_current, a_distance, a_entry.blend)
+				else
+					Result := ops.op_union (a_current, a_distance)
+				end
+			elseif a_entry.operation = {SDF_SCENE}.Op_subtraction then
+				if a_entry.blend > 0.0 then
+					Result := ops.smooth_subtraction (a_distance, a_current, a_entry.blend)
+				else
+					Result := ops.op_subtraction (a_distance, a_current)
+				end
+			elseif a_entry.blend > 0.0 then
+				Result := ops.smooth_intersection (a_current, a_distance, a_entry.blend)
+			else
+				Result := ops.op_intersection (a_current, a_distance)
+			end
+		end
+
+feature -- Constants
+
+	Min_run_length: INTEGER = 8
+			-- Shortest union run worth a hierarchy
+
+invariant
+	scene_attached: scene /= Void
+	parallel_segments: segment_last.count = segment_first.count and segment_bvh.count = segment_first.count
+
+end
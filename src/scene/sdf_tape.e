@@ -0,0 +1,1070 @@
+note
+	description: "[
+		Instruction tape: an SDF_SCENE lowered to straight-line register code.
+
+		Each instruction is `Instruction_size' integers:
+
+			[0] opcode    (see Opcode constants)
+			[1] dst       destination register
+			[2] src_a     first operand register (combine opcodes),
+			              member count (group opcodes)
+			[3] src_b     second operand register (combine opcodes)
+			[4] constant  offset of the instruction's constants
+
+		Primitive opcodes read the point and their constants and write
+		`dst'; combine opcodes read two registers. A group opcode is the
+		sharp union of `member_count' primitives of one kind, stored
+		structure-of-arrays: every constant of the kind's layout is an
+		array over the members, so a vector kernel loads each field of
+		several members at once and reduces with min. Sharp and smooth
+		variants are separate opcodes, and derived constants (capsule
+		axis, inverse blend radius) are precomputed, so evaluation has no
+		per-sample dispatch on shapes, operations or blend radii.
+
+		Constant layout per opcode:
+		- sphere:   center xyz, radius
+		- box:      center xyz, half-extents xyz
+		- capsule:  point a xyz, axis (b - a) xyz, 1 / |b - a|^2 (0 if degenerate), radius
+		- cylinder: center xyz, radius, half height
+		- torus:    center xyz, major radius, minor radius
+		- plane:    normal xyz, height
+		- smooth:   k, 1 / k, k / 4
+		- group:    n centers x, n centers y, ... (member layout, field by field)
+
+		A rotated or scaled shape (see SDF_SHAPE.set_rotation) has opcode
+		kind + `Opcode_transformed', and its constants start with the
+		world-to-shape matrix rows (3 x 4) and the scale, followed by the
+		primitive's layout: the point is mapped once, the distance scaled
+		once. Such shapes are never grouped.
+
+		`pruned' specializes the tape to a region using `interval_at'
+		(the C renderer does the same per screen tile). `dual_at' runs
+		the program on SDF_DUAL values for distance and gradient at once;
+		`distance_at_32' runs it in REAL_32 on `constants_32'.
+
+		Built by SDF_TAPE_BUILDER (see SDF_SCENE.tape). The tape is a
+		snapshot; `native_code' and `native_constants' hold the same
+		program for the C interpreter in Clib/raylib/simple_raylib_impl.c.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_TAPE
+
+inherit
+	SDF_FIELD
+		redefine
+			distance_at_32
+		end
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_code: SPECIAL [INTEGER]; a_constants: SPECIAL [REAL_64]; a_register_count, a_result_register: INTEGER)
+			-- Create tape from register-allocated `a_code' and `a_constants'.
+		require
+			code_attached: a_code /= Void
+			constants_attached: a_constants /= Void
+			whole_instructions: a_code.count \\ Instruction_size = 0
+			valid_registers: a_register_count >= 0
+			valid_result: a_code.count > 0 implies (a_result_register >= 0 and a_result_register < a_register_count)
+		local
+			i: INTEGER
+		do
+			code := a_code
+			constants := a_constants
+			instruction_count := a_code.count // Instruction_size
+			register_count := a_register_count
+			result_register := a_result_register
+			create registers.make_filled (0.0, a_register_count.max (1))
+			create interval_registers.make_filled (create {SDF_INTERVAL}, a_register_count.max (1))
+			create dual_registers.make_filled (create {SDF_DUAL}, a_register_count.max (1))
+			create registers_32.make_filled ({REAL_32} 0.0, a_register_count.max (1))
+			create constants_32.make_filled ({REAL_32} 0.0, a_constants.count)
+			from i := 0 until i >= a_constants.count loop
+				constants_32 [i] := a_constants [i].truncated_to_real
+				i := i + 1
+			end
+
+			create native_code.make (a_code.count.max (1) * Integer_32_bytes)
+			from i := 0 until i >= a_code.count loop
+				native_code.put_integer_32 (a_code [i], i * Integer_32_bytes)
+				i := i + 1
+			end
+			create native_constants.make (a_constants.count.max (1) * Real_32_bytes)
+			from i := 0 until i >= a_constants.count loop
+				native_constants.put_real_32 (a_constants [i].truncated_to_real, i * Real_32_bytes)
+				i := i + 1
+			end
+		ensure
+			code_set: code = a_code
+			constants_set: constants = a_constants
+			registers_set: register_count = a_register_count
+		end
+
+feature -- Access
+
+	code: SPECIAL [INTEGER]
+			-- Instruction words (`instruction_count' * `Instruction_size')
+
+	constants: SPECIAL [REAL_64]
+			-- Constant pool
+
+	instruction_count: INTEGER
+			-- Number of instructions
+
+	register_count: INTEGER
+			-- Number of registers the program needs
+
+	result_register: INTEGER
+			-- Register holding the final distance
+
+	opcode (a_instruction: INTEGER): INTEGER
+			-- Opcode of instruction `a_instruction' (1-based)
+		require
+			valid_instruction: a_instruction >= 1 and a_instruction <= instruction_count
+		do
+			Result := code [(a_instruction - 1) * Instruction_size]
+		end
+
+	constant_offset (a_instruction: INTEGER): INTEGER
+			-- Offset in `constants' of the constants of `a_instruction' (1-based)
+		require
+			valid_instruction: a_instruction >= 1 and a_instruction <= instruction_count
+		do
+			Result := code [(a_instruction - 1) * Instruction_size + Field_constant]
+		end
+
+	member_count (a_instruction: INTEGER): INTEGER
+			-- Number of shapes of group instruction `a_instruction' (1-based),
+			-- 0 for other opcodes
+		require
+			valid_instruction: a_instruction >= 1 and a_instruction <= instruction_count
+		do
+			if is_group_opcode (opcode (a_instruction)) then
+				Result := code [(a_instruction - 1) * Instruction_size + Field_member_count]
+			end
+		ensure
+			non_negative: Result >= 0
+		end
+
+	instruction_constant_count (a_instruction: INTEGER): INTEGER
+			-- Number of constants read by `a_instruction' (1-based)
+		require
+			valid_instruction: a_instruction >= 1 and a_instruction <= instruction_count
+		do
+			if is_group_opcode (opcode (a_instruction)) then
+				Result := member_count (a_instruction) * constant_count (member_opcode (opcode (a_instruction)))
+			else
+				Result := constant_count (opcode (a_instruction))
+			end
+		end
+
+	constants_32: SPECIAL [REAL_32]
+			-- `constants' rounded to single precision for `distance_at_32'
+
+	native_code: MANAGED_POINTER
+			-- `code' as int32 words for the C interpreter
+
+	native_constants: MANAGED_POINTER
+			-- `constants' as REAL_32 values for the C interpreter
+
+feature -- Status report
+
+	is_empty: BOOLEAN
+			-- Does the tape have no instructions?
+		do
+			Result := instruction_count = 0
+		end
+
+feature -- Distance evaluation
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Run the tape at point (x, y, z).
+			-- Returns max value for an empty tape.
+		local
+			i, j, n, pc, c, op: INTEGER
+			dx, dy, dz, ox, oy, oz, t, h, px, py, pz: REAL_64
+			l_code: like code
+			l_k: like constants
+			r: like registers
+		do
+			if instruction_count = 0 then
+				Result := {REAL_64}.max_value
+			else
+				l_code := code
+				l_k := constants
+				r := registers
+				from i := 0 until i >= instruction_count loop
+					pc := i * Instruction_size
+					c := l_code [pc + 4]
+					op := l_code [pc]
+					if op > Opcode_transformed then
+						-- Map the point into shape space (the matrix rows lead the constants)
+						px := l_k [c] * a_x + l_k [c + 1] * a_y + l_k [c + 2] * a_z + l_k [c + 3]
+						py := l_k [c + 4] * a_x + l_k [c + 5] * a_y + l_k [c + 6] * a_z + l_k [c + 7]
+						pz := l_k [c + 8] * a_x + l_k [c + 9] * a_y + l_k [c + 10] * a_z + l_k [c + 11]
+						c := c + Transform_constant_count
+						op := op - Opcode_transformed
+					else
+						px := a_x
+						py := a_y
+						pz := a_z
+					end
+					inspect op
+					when Opcode_sphere then
+						dx := px - l_k [c]
+						dy := py - l_k [c + 1]
+						dz := pz - l_k [c + 2]
+						r [l_code [pc + 1]] := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz) - l_k [c + 3]
+					when Opcode_box then
+						dx := (px - l_k [c]).abs - l_k [c + 3]
+						dy := (py - l_k [c + 1]).abs - l_k [c + 4]
+						dz := (pz - l_k [c + 2]).abs - l_k [c + 5]
+						ox := dx.max (0.0)
+						oy := dy.max (0.0)
+						oz := dz.max (0.0)
+						r [l_code [pc + 1]] := {DOUBLE_MATH}.sqrt (ox * ox + oy * oy + oz * oz) + dx.max (dy).max (dz).min (0.0)
+					when Opcode_capsule then
+						dx := px - l_k [c]
+						dy := py - l_k [c + 1]
+						dz := pz - l_k [c + 2]
+						h := ((dx * l_k [c + 3] + dy * l_k [c + 4] + dz * l_k [c + 5]) * l_k [c + 6]).max (0.0).min (1.0)
+						dx := dx - l_k [c + 3] * h
+						dy := dy - l_k [c + 4] * h
+						dz := dz - l_k [c + 5] * h
+						r [l_code [pc + 1]] := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz) - l_k [c + 7]
+					when Opcode_cylinder then
+						dx := px - l_k [c]
+						dz := pz - l_k [c + 2]
+						ox := {DOUBLE_MATH}.sqrt (dx * dx + dz * dz) - l_k [c + 3]
+						oy := (py - l_k [c + 1]).abs - l_k [c + 4]
+						dx := ox.max (0.0)
+						dy := oy.max (0.0)
+						r [l_code [pc + 1]] := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy) + ox.max (oy).min (0.0)
+					when Opcode_torus then
+						dx := px - l_k [c]
+						dy := py - l_k [c + 1]
+						dz := pz - l_k [c + 2]
+						t := {DOUBLE_MATH}.sqrt (dx * dx + dz * dz) - l_k [c + 3]
+						r [l_code [pc + 1]] := {DOUBLE_MATH}.sqrt (t * t + dy * dy) - l_k [c + 4]
+					when Opcode_plane then
+						r [l_code [pc + 1]] := px * l_k [c] + py * l_k [c + 1] + pz * l_k [c + 2] + l_k [c + 3]
+					when Opcode_sphere_group then
+						n := l_code [pc + 2]
+						t := {REAL_64}.max_value
+						from j := c until j >= c + n loop
+							dx := px - l_k [j]
+							dy := py - l_k [j + n]
+							dz := pz - l_k [j + 2 * n]
+							t := t.min ({DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz) - l_k [j + 3 * n])
+							j := j + 1
+						end
+						r [l_code [pc + 1]] := t
+					when Opcode_box_group then
+						n := l_code [pc + 2]
+						t := {REAL_64}.max_value
+						from j := c until j >= c + n loop
+							dx := (px - l_k [j]).abs - l_k [j + 3 * n]
+							dy := (py - l_k [j + n]).abs - l_k [j + 4 * n]
+							dz := (pz - l_k [j + 2 * n]).abs - l_k [j + 5 * n]
+							ox := dx.max (0.0)
+							oy := dy.max (0.0)
+							oz := dz.max (0.0)
+							t := t.min ({DOUBLE_MATH}.sqrt (ox * ox + oy * oy + oz * oz) + dx.max (dy).max (dz).min (0.0))
+							j := j + 1
+						end
+						r [l_code [pc + 1]] := t
+					when Opcode_union then
+						r [l_code [pc + 1]] := r [l_code [pc + 2]].min (r [l_code [pc + 3]])
+					when Opcode_smooth_union then
+						dx := r [l_code [pc + 2]]
+						dy := r [l_code [pc + 3]]
+						h := (l_k [c] - (dx - dy).abs).max (0.0) * l_k [c + 1]
+						r [l_code [pc + 1]] := dx.min (dy) - h * h * l_k [c + 2]
+					when Opcode_subtraction then
+						r [l_code [pc + 1]] := (- r [l_code [pc + 3]]).max (r [l_code [pc + 2]])
+					when Opcode_smooth_subtraction then
+						dx := r [l_code [pc + 2]]
+						dy := - r [l_code [pc + 3]]
+						h := (l_k [c] - (dy - dx).abs).max (0.0) * l_k [c + 1]
+						r [l_code [pc + 1]] := dy.max (dx) + h * h * l_k [c + 2]
+					when Opcode_intersection then
+						r [l_code [pc + 1]] := r [l_code [pc + 2]].max (r [l_code [pc + 3]])
+					when Opcode_smooth_intersection then
+						dx := r [l_code [pc + 2]]
+						dy := r [l_code [pc + 3]]
+						h := (l_k [c] - (dx - dy).abs).max (0.0) * l_k [c + 1]
+						r [l_code [pc + 1]] := dx.max (dy) + h * h * l_k [c + 2]
+					else
+						-- Unknown opcode: leave register unchanged
+					end
+					if l_code [pc] > Opcode_transformed then
+						-- The scale sits just before the primitive's constants
+						r [l_code [pc + 1]] := r [l_code [pc + 1]] * l_k [c - 1]
+					end
+					i := i + 1
+				end
+				Result := r [result_register]
+			end
+		end
+
+	distance_at_32 (a_x, a_y, a_z: REAL_32): REAL_32
+			-- Run the tape at point (x, y, z) in single precision, on
+			-- `constants_32' (the C interpreter's arithmetic).
+			-- Returns max value for an empty tape.
+		local
+			i, j, n, pc, c, op: INTEGER
+			dx, dy, dz, ox, oy, oz, t, h, px, py, pz: REAL_32
+			l_code: like code
+			l_k: like constants_32
+			r: like registers_32
+		do
+			if instruction_count = 0 then
+				Result := {REAL_32}.max_value
+			else
+				l_code := code
+				l_k := constants_32
+				r := registers_32
+				from i := 0 until i >= instruction_count loop
+					pc := i * Instruction_size
+					c := l_code [pc + 4]
+					op := l_code [pc]
+					if op > Opcode_transformed then
+						-- Map the point into shape space (the matrix rows lead the constants)
+						px := l_k [c] * a_x + l_k [c + 1] * a_y + l_k [c + 2] * a_z + l_k [c + 3]
+						py := l_k [c + 4] * a_x + l_k [c + 5] * a_y + l_k [c + 6] * a_z + l_k [c + 7]
+						pz := l_k [c + 8] * a_x + l_k [c + 9] * a_y + l_k [c + 10] * a_z + l_k [c + 11]
+						c := c + Transform_constant_count
+						op := op - Opcode_transformed
+					else
+						px := a_x
+						py := a_y
+						pz := a_z
+					end
+					inspect op
+					when Opcode_sphere then
+						dx := px - l_k [c]
+						dy := py - l_k [c + 1]
+						dz := pz - l_k [c + 2]
+						r [l_code [pc + 1]] := square_root_32 (dx * dx + dy * dy + dz * dz) - l_k [c + 3]
+					when Opcode_box then
+						dx := (px - l_k [c]).abs - l_k [c + 3]
+						dy := (py - l_k [c + 1]).abs - l_k [c + 4]
+						dz := (pz - l_k [c + 2]).abs - l_k [c + 5]
+						ox := dx.max ({REAL_32} 0.0)
+						oy := dy.max ({REAL_32} 0.0)
+						oz := dz.max ({REAL_32} 0.0)
+						r [l_code [pc + 1]] := square_root_32 (ox * ox + oy * oy + oz * oz) + dx.max (dy).max (dz).min ({REAL_32} 0.0)
+					when Opcode_capsule then
+						dx := px - l_k [c]
+						dy := py - l_k [c + 1]
+						dz := pz - l_k [c + 2]
+						h := ((dx * l_k [c + 3] + dy * l_k [c + 4] + dz * l_k [c + 5]) * l_k [c + 6]).max ({REAL_32} 0.0).min ({REAL_32} 1.0)
+						dx := dx - l_k [c + 3] * h
+						dy := dy - l_k [c + 4] * h
+						dz := dz - l_k [c + 5] * h
+						r [l_code [pc + 1]] := square_root_32 (dx * dx + dy * dy + dz * dz) - l_k [c + 7]
+					when Opcode_cylinder then
+						dx := px - l_k [c]
+						dz := pz - l_k [c + 2]
+						ox := square_root_32 (dx * dx + dz * dz) - l_k [c + 3]
+						oy := (py - l_k [c + 1]).abs - l_k [c + 4]
+						dx := ox.max ({REAL_32} 0.0)
+						dy := oy.max ({REAL_32} 0.0)
+						r [l_code [pc + 1]] := square_root_32 (dx * dx + dy * dy) + ox.max (oy).min ({REAL_32} 0.0)
+					when Opcode_torus then
+						dx := px - l_k [c]
+						dy := py - l_k [c + 1]
+						dz := pz - l_k [c + 2]
+						t := square_root_32 (dx * dx + dz * dz) - l_k [c + 3]
+						r [l_code [pc + 1]] := square_root_32 (t * t + dy * dy) - l_k [c + 4]
+					when Opcode_plane then
+						r [l_code [pc + 1]] := px * l_k [c] + py * l_k [c + 1] + pz * l_k [c + 2] + l_k [c + 3]
+					when Opcode_sphere_group then
+						n := l_code [pc + 2]
+						t := {REAL_32}.max_value
+						from j := c until j >= c + n loop
+							dx := px - l_k [j]
+							dy := py - l_k [j + n]
+							dz := pz - l_k [j + 2 * n]
+							t := t.min (square_root_32 (dx * dx + dy * dy + dz * dz) - l_k [j + 3 * n])
+							j := j + 1
+						end
+						r [l_code [pc + 1]] := t
+					when Opcode_box_group then
+						n := l_code [pc + 2]
+						t := {REAL_32}.max_value
+						from j := c until j >= c + n loop
+							dx := (px - l_k [j]).abs - l_k [j + 3 * n]
+							dy := (py - l_k [j + n]).abs - l_k [j + 4 * n]
+							dz := (pz - l_k [j + 2 * n]).abs - l_k [j + 5 * n]
+							ox := dx.max ({REAL_32} 0.0)
+							oy := dy.max ({REAL_32} 0.0)
+							oz := dz.max ({REAL_32} 0.0)
+							t := t.min (square_root_32 (ox * ox + oy * oy + oz * oz) + dx.max (dy).max (dz).min ({REAL_32} 0.0))
+							j := j + 1
+						end
+						r [l_code [pc + 1]] := t
+					when Opcode_union then
+						r [l_code [pc + 1]] := r [l_code [pc + 2]].min (r [l_code [pc + 3]])
+					when Opcode_smooth_union then
+						dx := r [l_code [pc + 2]]
+						dy := r [l_code [pc + 3]]
+						h := (l_k [c] - (dx - dy).abs).max ({REAL_32} 0.0) * l_k [c + 1]
+						r [l_code [pc + 1]] := dx.min (dy) - h * h * l_k [c + 2]
+					when Opcode_subtraction then
+						r [l_code [pc + 1]] := (- r [l_code [pc + 3]]).max (r [l_code [pc + 2]])
+					when Opcode_smooth_subtraction then
+						dx := r [l_code [pc + 2]]
+						dy := - r [l_code [pc + 3]]
+						h := (l_k [c] - (dy - dx).abs).max ({REAL_32} 0.0) * l_k [c + 1]
+						r [l_code [pc + 1]] := dy.max (dx) + h * h * l_k [c + 2]
+					when Opcode_intersection then
+						r [l_code [pc + 1]] := r [l_code [pc + 2]].max (r [l_code [pc + 3]])
+					when Opcode_smooth_intersection then
+						dx := r [l_code [pc + 2]]
+						dy := r [l_code [pc + 3]]
+						h := (l_k [c] - (dx - dy).abs).max ({REAL_32} 0.0) * l_k [c + 1]
+						r [l_code [pc + 1]] := dx.max (dy) + h * h * l_k [c + 2]
+					else
+						-- Unknown opcode: leave register unchanged
+					end
+					if l_code [pc] > Opcode_transformed then
+						-- The scale sits just before the primitive's constants
+						r [l_code [pc + 1]] := r [l_code [pc + 1]] * l_k [c - 1]
+					end
+					i := i + 1
+				end
+				Result := r [result_register]
+			end
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Run the tape on intervals: range of the distance over the box.
+			-- [max, max] for an empty tape.
+		local
+			i, pc: INTEGER
+			ix, iy, iz: SDF_INTERVAL
+			r: like interval_registers
+		do
+			if instruction_count = 0 then
+				Result.set ({REAL_64}.max_value, {REAL_64}.max_value)
+			else
+				r := interval_registers
+				ix.set (a_min_x, a_max_x)
+				iy.set (a_min_y, a_max_y)
+				iz.set (a_min_z, a_max_z)
+				from i := 0 until i >= instruction_count loop
+					pc := i * Instruction_size
+					r [code [pc + 1]] := instruction_interval (pc, ix, iy, iz, r [code [pc + 2]], r [code [pc + 3]])
+					i := i + 1
+				end
+				Result := r [result_register]
+			end
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Run the tape on dual numbers: distance and gradient at (x, y, z).
+			-- Max value with zero gradient for an empty tape.
+		local
+			i, pc: INTEGER
+			lx, ly, lz: SDF_DUAL
+			r: like dual_registers
+		do
+			if instruction_count = 0 then
+				Result.set ({REAL_64}.max_value, 0.0, 0.0, 0.0)
+			else
+				r := dual_registers
+				lx.set (a_x, 1.0, 0.0, 0.0)
+				ly.set (a_y, 0.0, 1.0, 0.0)
+				lz.set (a_z, 0.0, 0.0, 1.0)
+				from i := 0 until i >= instruction_count loop
+					pc := i * Instruction_size
+					r [code [pc + 1]] := instruction_dual (pc, lx, ly, lz, r [code [pc + 2]], r [code [pc + 3]])
+					i := i + 1
+				end
+				Result := r [result_register]
+			end
+		end
+
+	lipschitz_bound: REAL_64
+			-- 1: every primitive opcode is an exact distance and every
+			-- combine opcode keeps the larger bound of its operands
+			-- (see SDF_OPS.lipschitz_smooth)
+		do
+			Result := 1.0
+		end
+
+feature -- Specialization
+
+	pruned (a_region: SDF_AABB): SDF_TAPE
+			-- Tape computing the same distance as Current at every point of
+			-- `a_region', without the branches that cannot decide it there.
+			-- A combine whose outcome is fixed over the region (one operand
+			-- always the minimum of a union, or the maximum of an intersection)
+			-- collapses to that operand. Along chains of sharp unions an
+			-- operand also goes when it starts above every sibling's upper
+			-- bound, and so does a group member. Instructions the result no
+			-- longer reads are dropped and the rest is register-allocated again.
+		require
+			region_attached: a_region /= Void
+			not_empty: not a_region.is_empty
+		local
+			l_builder: SDF_TAPE_BUILDER
+			l_value, l_source_a, l_source_b, l_new, l_register_value: SPECIAL [INTEGER]
+			l_range: SPECIAL [SDF_INTERVAL]
+			l_live: SPECIAL [BOOLEAN]
+			l_cut: SPECIAL [REAL_64]
+			ix, iy, iz: SDF_INTERVAL
+			i, pc, a, b, l_result: INTEGER
+			l_cut_a, l_cut_b: REAL_64
+		do
+			if instruction_count = 0 then
+				Result := Current
+			else
+				create l_value.make_filled (0, instruction_count)
+				create l_source_a.make_filled (-1, instruction_count)
+				create l_source_b.make_filled (-1, instruction_count)
+				create l_new.make_filled (0, instruction_count)
+				create l_register_value.make_filled (0, register_count.max (1))
+				create l_range.make_filled (create {SDF_INTERVAL}, instruction_count)
+				create l_live.make_filled (False, instruction_count)
+				create l_cut.make_filled (0.0, instruction_count)
+				ix.set (a_region.min_x, a_region.max_x)
+				iy.set (a_region.min_y, a_region.max_y)
+				iz.set (a_region.min_z, a_region.max_z)
+
+				-- Forward: ranges per instruction, decided combines become their operand
+				from i := 0 until i >= instruction_count loop
+					pc := i * Instruction_size
+					l_value [i] := i
+					if is_primitive_opcode (code [pc]) or is_group_opcode (code [pc]) then
+						l_range [i] := instruction_interval (pc, ix, iy, iz, l_range [0], l_range [0])
+					else
+						a := l_register_value [code [pc + 2]]
+						b := l_register_value [code [pc + 3]]
+						inspect decided_operand (pc, l_range [a], l_range [b])
+						when Operand_a then
+							l_value [i] := a
+						when Operand_b then
+							l_value [i] := b
+						else
+							l_source_a [i] := a
+							l_source_b [i] := b
+						end
+						l_range [i] := instruction_interval (pc, ix, iy, iz, l_range [a], l_range [b])
+					end
+					l_register_value [code [pc + 1]] := l_value [i]
+					i := i + 1
+				end
+
+				-- Backward: keep what the result still reads. `l_cut' [v] is the
+				-- loosest bound above which v cannot reach the result: below a
+				-- sharp union, the smallest upper bound of its siblings.
+				l_result := l_register_value [result_register]
+				keep (l_result, {REAL_64}.max_value, l_live, l_cut)
+				from i := instruction_count - 1 until i < 0 loop
+					a := l_source_a [i]
+					b := l_source_b [i]
+					if l_live [i] and a >= 0 then
+						if code [i * Instruction_size] = Opcode_union then
+							l_cut_a := l_cut [i].min (l_range [b].hi)
+							l_cut_b := l_cut [i].min (l_range [a].hi)
+							if l_range [a].lo > l_cut_a or l_range [b].lo > l_cut_b then
+								-- Collapse to the operand that can still be the minimum
+								if l_range [a].lo > l_cut_a then
+									l_value [i] := b
+								else
+									l_value [i] := a
+								end
+								l_source_a [i] := -1
+								l_live [i] := False
+								keep (l_value [i], l_cut [i], l_live, l_cut)
+							else
+								keep (a, l_cut_a, l_live, l_cut)
+								keep (b, l_cut_b, l_live, l_cut)
+							end
+						else
+							keep (a, {REAL_64}.max_value, l_live, l_cut)
+							keep (b, {REAL_64}.max_value, l_live, l_cut)
+						end
+					end
+					i := i - 1
+				end
+				l_result := resolved (l_result, l_value)
+
+				create l_builder.make
+				from i := 0 until i >= instruction_count loop
+					if l_live [i] then
+						if l_source_a [i] >= 0 then
+							l_new [i] := l_builder.add_instruction (Current, i + 1,
+								l_new [resolved (l_source_a [i], l_value)], l_new [resolved (l_source_b [i], l_value)])
+						elseif is_group_opcode (code [i * Instruction_size]) then
+							-- A member starting above the group's bound or cut is never its minimum
+							l_new [i] := l_builder.add_group_members (Current, i + 1,
+								group_survivors (i * Instruction_size, l_cut [i].min (l_range [i].hi), ix, iy, iz))
+						else
+							l_new [i] := l_builder.add_instruction (Current, i + 1, 0, 0)
+						end
+					end
+					i := i + 1
+				end
+				Result := l_builder.to_tape (l_new [l_result])
+			end
+		ensure
+			result_attached: Result /= Void
+			not_longer: Result.instruction_count <= instruction_count
+		end
+
+feature -- Instruction layout
+
+	Instruction_size: INTEGER = 5
+			-- Integers per instruction
+
+	Field_opcode: INTEGER = 0
+	Field_destination: INTEGER = 1
+	Field_source_a: INTEGER = 2
+	Field_source_b: INTEGER = 3
+	Field_constant: INTEGER = 4
+	Field_member_count: INTEGER = 2
+			-- Group opcodes read no registers; their member count uses the src_a word
+
+feature -- Opcodes
+
+	Opcode_sphere: INTEGER = 1
+	Opcode_box: INTEGER = 2
+	Opcode_capsule: INTEGER = 3
+	Opcode_cylinder: INTEGER = 4
+	Opcode_torus: INTEGER = 5
+	Opcode_plane: INTEGER = 6
+			-- Primitive opcodes (equal to SDF_SHAPE kinds)
+
+	Opcode_sphere_group: INTEGER = 8
+	Opcode_box_group: INTEGER = 9
+			-- Group opcodes: min over `member_count' spheres or boxes (SoA constants)
+
+	Opcode_union: INTEGER = 16
+	Opcode_smooth_union: INTEGER = 17
+	Opcode_subtraction: INTEGER = 18
+	Opcode_smooth_subtraction: INTEGER = 19
+	Opcode_intersection: INTEGER = 20
+	Opcode_smooth_intersection: INTEGER = 21
+			-- Combine opcodes: dst := src_a (op) src_b; subtraction cuts src_b from src_a
+
+	Opcode_transformed: INTEGER = 32
+			-- Added to a primitive opcode for a rotated or scaled shape, whose
+			-- constants start with `Transform_constant_count' transform values
+
+	Transform_constant_count: INTEGER = 13
+			-- World-to-shape matrix rows (3 x 4) and the scale
+
+	constant_count (a_opcode: INTEGER): INTEGER
+			-- Number of constants read by `a_opcode'
+		do
+			if a_opcode > Opcode_transformed then
+				Result := Transform_constant_count + constant_count (a_opcode - Opcode_transformed)
+			else
+				inspect a_opcode
+				when Opcode_sphere, Opcode_plane then
+					Result := 4
+				when Opcode_cylinder, Opcode_torus then
+					Result := 5
+				when Opcode_box then
+					Result := 6
+				when Opcode_capsule then
+					Result := 8
+				when Opcode_smooth_union, Opcode_smooth_subtraction, Opcode_smooth_intersection then
+					Result := 3
+				else
+					-- Combines read none; groups depend on `member_count'
+					Result := 0
+				end
+			end
+		end
+
+	is_primitive_opcode (a_opcode: INTEGER): BOOLEAN
+			-- Is `a_opcode' a single primitive, transformed or not?
+		do
+			Result := (a_opcode >= Opcode_sphere and a_opcode <= Opcode_plane)
+				or (a_opcode > Opcode_transformed and a_opcode - Opcode_transformed <= Opcode_plane)
+		end
+
+	is_group_opcode (a_opcode: INTEGER): BOOLEAN
+			-- Is `a_opcode' a group of primitives?
+		do
+			Result := a_opcode = Opcode_sphere_group or a_opcode = Opcode_box_group
+		end
+
+	group_opcode (a_kind: INTEGER): INTEGER
+			-- Group opcode for shapes of `a_kind' (0 if that kind is not grouped)
+		do
+			inspect a_kind
+			when Opcode_sphere then
+				Result := Opcode_sphere_group
+			when Opcode_box then
+				Result := Opcode_box_group
+			else
+				Result := 0
+			end
+		ensure
+			group_or_none: Result = 0 or is_group_opcode (Result)
+		end
+
+	member_opcode (a_group_opcode: INTEGER): INTEGER
+			-- Primitive opcode of the members of `a_group_opcode'
+		require
+			group: is_group_opcode (a_group_opcode)
+		do
+			if a_group_opcode = Opcode_sphere_group then
+				Result := Opcode_sphere
+			else
+				Result := Opcode_box
+			end
+		ensure
+			inverse: group_opcode (Result) = a_group_opcode
+		end
+
+	Max_native_registers: INTEGER = 32
+			-- Register file size of the C interpreter
+
+feature {NONE} -- Implementation
+
+	instruction_interval (pc: INTEGER; ix, iy, iz, a_left, a_right: SDF_INTERVAL): SDF_INTERVAL
+			-- Range of the instruction at `pc' over the box ix * iy * iz, given
+			-- operand ranges `a_left' and `a_right' (ignored by primitives).
+			-- A transformed primitive runs on the box enclosing the mapped box.
+		local
+			c: INTEGER
+			l_k: like constants
+		do
+			c := code [pc + 4]
+			if code [pc] > Opcode_transformed then
+				l_k := constants
+				Result := opcode_interval (code [pc] - Opcode_transformed, c + Transform_constant_count, 0,
+					(ix.scaled (l_k [c]) + iy.scaled (l_k [c + 1]) + iz.scaled (l_k [c + 2])).plus_value (l_k [c + 3]),
+					(ix.scaled (l_k [c + 4]) + iy.scaled (l_k [c + 5]) + iz.scaled (l_k [c + 6])).plus_value (l_k [c + 7]),
+					(ix.scaled (l_k [c + 8]) + iy.scaled (l_k [c + 9]) + iz.scaled (l_k [c + 10])).plus_value (l_k [c + 11]),
+					a_left, a_right).scaled (l_k [c + 12])
+			else
+				Result := opcode_interval (code [pc], c, code [pc + Field_member_count], ix, iy, iz, a_left, a_right)
+			end
+		end
+
+	opcode_interval (a_opcode, c, a_count: INTEGER; ix, iy, iz, a_left, a_right: SDF_INTERVAL): SDF_INTERVAL
+			-- Range of `a_opcode' with constants at `c' (`a_count' members
+			-- for a group) over the box ix * iy * iz, given operand ranges
+			-- `a_left' and `a_right' (ignored by primitives)
+		local
+			j: INTEGER
+			dx, dy, dz, t, h: SDF_INTERVAL
+			l_k: like constants
+		do
+			l_k := constants
+			inspect a_opcode
+			when Opcode_sphere, Opcode_box then
+				Result := member_interval (a_opcode, c, 1, ix, iy, iz)
+			when Opcode_sphere_group, Opcode_box_group then
+				Result := member_interval (a_opcode, c, a_count, ix, iy, iz)
+				from j := 1 until j >= a_count loop
+					Result := ops.interval_union (Result, member_interval (a_opcode, c + j, a_count, ix, iy, iz))
+					j := j + 1
+				end
+			when Opcode_capsule then
+				dx := ix.plus_value (- l_k [c])
+				dy := iy.plus_value (- l_k [c + 1])
+				dz := iz.plus_value (- l_k [c + 2])
+				h := (dx.scaled (l_k [c + 3]) + dy.scaled (l_k [c + 4]) + dz.scaled (l_k [c + 5])).scaled (l_k [c + 6]).clamped (0.0, 1.0)
+				dx := dx - h.scaled (l_k [c + 3])
+				dy := dy - h.scaled (l_k [c + 4])
+				dz := dz - h.scaled (l_k [c + 5])
+				Result := (dx.squared + dy.squared + dz.squared).square_root.plus_value (- l_k [c + 7])
+			when Opcode_cylinder then
+				dx := ix.plus_value (- l_k [c])
+				dz := iz.plus_value (- l_k [c + 2])
+				t := (dx.squared + dz.squared).square_root.plus_value (- l_k [c + 3])
+				h := iy.plus_value (- l_k [c + 1]).absolute.plus_value (- l_k [c + 4])
+				Result := (t.max_value (0.0).squared + h.max_value (0.0).squared).square_root
+					+ t.max (h).min_value (0.0)
+			when Opcode_torus then
+				dx := ix.plus_value (- l_k [c])
+				dy := iy.plus_value (- l_k [c + 1])
+				dz := iz.plus_value (- l_k [c + 2])
+				t := (dx.squared + dz.squared).square_root.plus_value (- l_k [c + 3])
+				Result := (t.squared + dy.squared).square_root.plus_value (- l_k [c + 4])
+			when Opcode_plane then
+				Result := (ix.scaled (l_k [c]) + iy.scaled (l_k [c + 1]) + iz.scaled (l_k [c + 2])).plus_value (l_k [c + 3])
+			when Opcode_union then
+				Result := ops.interval_union (a_left, a_right)
+			when Opcode_smooth_union then
+				Result := ops.interval_smooth_union (a_left, a_right, l_k [c])
+			when Opcode_subtraction then
+				Result := ops.interval_subtraction (a_right, a_left)
+			when Opcode_smooth_subtraction then
+				Result := ops.interval_smooth_subtraction (a_right, a_left, l_k [c])
+			when Opcode_intersection then
+				Result := ops.interval_intersection (a_left, a_right)
+			when Opcode_smooth_intersection then
+				Result := ops.interval_smooth_intersection (a_left, a_right, l_k [c])
+			else
+				Result.set (- {REAL_64}.max_value, {REAL_64}.max_value)
+			end
+		end
+
+	instruction_dual (pc: INTEGER; lx, ly, lz, a_left, a_right: SDF_DUAL): SDF_DUAL
+			-- Distance and gradient of the instruction at `pc' at the point
+			-- lx, ly, lz, given operands `a_left' and `a_right' (ignored by
+			-- primitives). A transformed primitive runs on the mapped point,
+			-- whose derivatives carry the gradient back to world space.
+		local
+			c: INTEGER
+			l_k: like constants
+		do
+			c := code [pc + 4]
+			if code [pc] > Opcode_transformed then
+				l_k := constants
+				Result := opcode_dual (code [pc] - Opcode_transformed, c + Transform_constant_count, 0,
+					(lx.scaled (l_k [c]) + ly.scaled (l_k [c + 1]) + lz.scaled (l_k [c + 2])).plus_value (l_k [c + 3]),
+					(lx.scaled (l_k [c + 4]) + ly.scaled (l_k [c + 5]) + lz.scaled (l_k [c + 6])).plus_value (l_k [c + 7]),
+					(lx.scaled (l_k [c + 8]) + ly.scaled (l_k [c + 9]) + lz.scaled (l_k [c + 10])).plus_value (l_k [c + 11]),
+					a_left, a_right).scaled (l_k [c + 12])
+			else
+				Result := opcode_dual (code [pc], c, code [pc + Field_member_count], lx, ly, lz, a_left, a_right)
+			end
+		end
+
+	opcode_dual (a_opcode, c, a_count: INTEGER; lx, ly, lz, a_left, a_right: SDF_DUAL): SDF_DUAL
+			-- Distance and gradient of `a_opcode' with constants at `c'
+			-- (`a_count' members for a group) at the point lx, ly, lz, given
+			-- operands `a_left' and `a_right' (ignored by primitives)
+		local
+			j: INTEGER
+			dx, dy, dz, t, h: SDF_DUAL
+			l_k: like constants
+		do
+			l_k := constants
+			inspect a_opcode
+			when Opcode_sphere, Opcode_box then
+				Result := member_dual (a_opcode, c, 1, lx, ly, lz)
+			when Opcode_sphere_group, Opcode_box_group then
+				Result := member_dual (a_opcode, c, a_count, lx, ly, lz)
+				from j := 1 until j >= a_count loop
+					Result := ops.dual_union (Result, member_dual (a_opcode, c + j, a_count, lx, ly, lz))
+					j := j + 1
+				end
+			when Opcode_capsule then
+				dx := lx.plus_value (- l_k [c])
+				dy := ly.plus_value (- l_k [c + 1])
+				dz := lz.plus_value (- l_k [c + 2])
+				h := (dx.scaled (l_k [c + 3]) + dy.scaled (l_k [c + 4]) + dz.scaled (l_k [c + 5])).scaled (l_k [c + 6]).clamped (0.0, 1.0)
+				dx := dx - h.scaled (l_k [c + 3])
+				dy := dy - h.scaled (l_k [c + 4])
+				dz := dz - h.scaled (l_k [c + 5])
+				Result := (dx.squared + dy.squared + dz.squared).square_root.plus_value (- l_k [c + 7])
+			when Opcode_cylinder then
+				dx := lx.plus_value (- l_k [c])
+				dz := lz.plus_value (- l_k [c + 2])
+				t := (dx.squared + dz.squared).square_root.plus_value (- l_k [c + 3])
+				h := ly.plus_value (- l_k [c + 1]).absolute.plus_value (- l_k [c + 4])
+				Result := (t.max_value (0.0).squared + h.max_value (0.0).squared).square_root
+					+ t.max (h).min_value (0.0)
+			when Opcode_torus then
+				dx := lx.plus_value (- l_k [c])
+				dy := ly.plus_value (- l_k [c + 1])
+				dz := lz.plus_value (- l_k [c + 2])
+				t := (dx.squared + dz.squared).square_root.plus_value (- l_k [c + 3])
+				Result := (t.squared + dy.squared).square_root.plus_value (- l_k [c + 4])
+			when Opcode_plane then
+				Result := (lx.scaled (l_k [c]) + ly.scaled (l_k [c + 1]) + lz.scaled (l_k [c + 2])).plus_value (l_k [c + 3])
+			when Opcode_union then
+				Result := ops.dual_union (a_left, a_right)
+			when Opcode_smooth_union then
+				Result := ops.dual_smooth_union (a_left, a_right, l_k [c])
+			when Opcode_subtraction then
+				Result := ops.dual_subtraction (a_right, a_left)
+			when Opcode_smooth_subtraction then
+				Result := ops.dual_smooth_subtraction (a_right, a_left, l_k [c])
+			when Opcode_intersection then
+				Result := ops.dual_intersection (a_left, a_right)
+			when Opcode_smooth_intersection then
+				Result := ops.dual_smooth_intersection (a_left, a_right, l_k [c])
+			else
+				Result := a_left
+			end
+		end
+
+	member_interval (a_opcode, a_offset, a_stride: INTEGER; ix, iy, iz: SDF_INTERVAL): SDF_INTERVAL
+			-- Range over the box ix * iy * iz of the sphere or box (or group
+			-- member) of `a_opcode' whose constants start at `a_offset', one
+			-- every `a_stride' (1 for a single shape, the member count in a group)
+		require
+			sphere_or_box: a_opcode = Opcode_sphere or a_opcode = Opcode_box
+				or a_opcode = Opcode_sphere_group or a_opcode = Opcode_box_group
+			positive_stride: a_stride >= 1
+		local
+			dx, dy, dz: SDF_INTERVAL
+			l_k: like constants
+		do
+			l_k := constants
+			if a_opcode = Opcode_sphere or a_opcode = Opcode_sphere_group then
+				dx := ix.plus_value (- l_k [a_offset])
+				dy := iy.plus_value (- l_k [a_offset + a_stride])
+				dz := iz.plus_value (- l_k [a_offset + 2 * a_stride])
+				Result := (dx.squared + dy.squared + dz.squared).square_root.plus_value (- l_k [a_offset + 3 * a_stride])
+			else
+				dx := ix.plus_value (- l_k [a_offset]).absolute.plus_value (- l_k [a_offset + 3 * a_stride])
+				dy := iy.plus_value (- l_k [a_offset + a_stride]).absolute.plus_value (- l_k [a_offset + 4 * a_stride])
+				dz := iz.plus_value (- l_k [a_offset + 2 * a_stride]).absolute.plus_value (- l_k [a_offset + 5 * a_stride])
+				Result := (dx.max_value (0.0).squared + dy.max_value (0.0).squared + dz.max_value (0.0).squared).square_root
+					+ dx.max (dy).max (dz).min_value (0.0)
+			end
+		end
+
+	member_dual (a_opcode, a_offset, a_stride: INTEGER; lx, ly, lz: SDF_DUAL): SDF_DUAL
+			-- Distance and gradient at lx, ly, lz of the sphere or box laid
+			-- out as in `member_interval'
+		require
+			sphere_or_box: a_opcode = Opcode_sphere or a_opcode = Opcode_box
+				or a_opcode = Opcode_sphere_group or a_opcode = Opcode_box_group
+			positive_stride: a_stride >= 1
+		local
+			dx, dy, dz: SDF_DUAL
+			l_k: like constants
+		do
+			l_k := constants
+			if a_opcode = Opcode_sphere or a_opcode = Opcode_sphere_group then
+				dx := lx.plus_value (- l_k [a_offset])
+				dy := ly.plus_value (- l_k [a_offset + a_stride])
+				dz := lz.plus_value (- l_k [a_offset + 2 * a_stride])
+				Result := (dx.squared + dy.squared + dz.squared).square_root.plus_value (- l_k [a_offset + 3 * a_stride])
+			else
+				dx := lx.plus_value (- l_k [a_offset]).absolute.plus_value (- l_k [a_offset + 3 * a_stride])
+				dy := ly.plus_value (- l_k [a_offset + a_stride]).absolute.plus_value (- l_k [a_offset + 4 * a_stride])
+				dz := lz.plus_value (- l_k [a_offset + 2 * a_stride]).absolute.plus_value (- l_k [a_offset + 5 * a_stride])
+				Result := (dx.max_value (0.0).squared + dy.max_value (0.0).squared + dz.max_value (0.0).squared).square_root
+					+ dx.max (dy).max (dz).min_value (0.0)
+			end
+		end
+
+	decided_operand (pc: INTEGER; a_left, a_right: SDF_INTERVAL): INTEGER
+			-- Operand the combine at `pc' always returns for values in
+			-- `a_left' and `a_right' (`Operand_a', `Operand_b' or 0 if undecided).
+			-- Smooth variants need the operands at least the blend radius apart.
+		local
+			k: REAL_64
+		do
+			if code [pc] = Opcode_smooth_union or code [pc] = Opcode_smooth_subtraction or code [pc] = Opcode_smooth_intersection then
+				k := constants [code [pc + 4]]
+			end
+			inspect code [pc]
+			when Opcode_union, Opcode_smooth_union then
+				if a_left.lo - a_right.hi > k then
+					Result := Operand_b
+				elseif a_right.lo - a_left.hi > k then
+					Result := Operand_a
+				end
+			when Opcode_subtraction, Opcode_smooth_subtraction then
+				-- max (-b, a) keeps a when a is always above -b
+				if a_left.lo + a_right.lo > k then
+					Result := Operand_a
+				end
+			when Opcode_intersection, Opcode_smooth_intersection then
+				if a_left.lo - a_right.hi > k then
+					Result := Operand_a
+				elseif a_right.lo - a_left.hi > k then
+					Result := Operand_b
+				end
+			else
+				-- Unknown opcode: never decided
+			end
+		end
+
+	group_survivors (pc: INTEGER; a_bound: REAL_64; ix, iy, iz: SDF_INTERVAL): SPECIAL [BOOLEAN]
+			-- Members of the group at `pc' whose range over ix * iy * iz
+			-- starts at or below `a_bound' (all of them if none does)
+		require
+			group: is_group_opcode (code [pc])
+		local
+			j, n, l_kept: INTEGER
+		do
+			n := code [pc + Field_member_count]
+			create Result.make_filled (False, n)
+			from j := 0 until j >= n loop
+				if member_interval (code [pc], code [pc + 4] + j, n, ix, iy, iz).lo <= a_bound then
+					Result [j] := True
+					l_kept := l_kept + 1
+				end
+				j := j + 1
+			end
+			if l_kept = 0 then
+				Result.fill_with (True, 0, n - 1)
+			end
+		ensure
+			one_per_member: Result.count = code [pc + Field_member_count]
+		end
+
+	keep (a_value: INTEGER; a_cut: REAL_64; a_live: SPECIAL [BOOLEAN]; a_cut_of: SPECIAL [REAL_64])
+			-- Mark `a_value' as read by an instruction that needs it below `a_cut'.
+		do
+			if not a_live [a_value] then
+				a_live [a_value] := True
+				a_cut_of [a_value] := a_cut
+			else
+				a_cut_of [a_value] := a_cut_of [a_value].max (a_cut)
+			end
+		end
+
+	resolved (a_value: INTEGER; a_aliases: SPECIAL [INTEGER]): INTEGER
+			-- Value `a_value' stands for after collapsed combines
+		do
+			from Result := a_value until a_aliases [Result] = Result loop
+				Result := a_aliases [Result]
+			end
+		end
+
+	Operand_a: INTEGER = 1
+	Operand_b: INTEGER = 2
+			-- Results of `decided_operand'
+
+	registers: SPECIAL [REAL_64]
+			-- Register file reused by `distance_at'
+
+	interval_registers: SPECIAL [SDF_INTERVAL]
+			-- Register file reused by `interval_at'
+
+	dual_registers: SPECIAL [SDF_DUAL]
+			-- Register file reused by `dual_at'
+
+	registers_32: SPECIAL [REAL_32]
+			-- Register file reused by `distance_at_32'
+
+	square_root_32 (a_value: REAL_32): REAL_32
+			-- Correctly rounded single-precision square root
+		do
+			Result := {DOUBLE_MATH}.sqrt (a_value).truncated_to_real
+		end
+
+	ops: SDF_OPS
+			-- Interval and dual forms of the combine opcodes
+		once
+			create Result
+		end
+
+	Integer_32_bytes: INTEGER = 4
+	Real_32_bytes: INTEGER = 4
+
+invariant
+	code_attached: code /= Void
+	constants_attached: constants /= Void
+	whole_instructions: code.count = instruction_count * Instruction_size
+	registers_sized: registers.count >= register_count
+	interval_registers_sized: interval_registers.count >= register_count
+	dual_registers_sized: dual_registers.count >= register_count
+	registers_32_sized: registers_32.count >= register_count
+	constants_32_sized: constants_32.count = constants.count
+
+end
@@ -0,0 +1,452 @@
+note
+	description: "[
+		Builds an SDF_TAPE from shapes and combine operations.
+
+		Instructions are first recorded in SSA form: every `add_shape' and
+		`add_combine' defines a new value, identified by the returned
+		integer. `to_tape' then assigns registers with a linear scan over
+		the value lifetimes, reusing a register as soon as its value has
+		been read for the last time. A left-folded scene therefore needs
+		only two registers however many shapes it has.
+
+		`add_scene' records each run of entries joined by sharp unions
+		(order does not matter to min) with its untransformed spheres and
+		untransformed boxes in one group instruction each, see `add_group'. `add_scene_group'
+		records a tree of SDF_SCENE_GROUP folds.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_TAPE_BUILDER
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make
+			-- Create empty builder.
+		do
+			create opcodes.make (16)
+			create sources_a.make (16)
+			create sources_b.make (16)
+			create constant_offsets.make (16)
+			create member_counts.make (16)
+			create constants.make (64)
+		ensure
+			empty: value_count = 0
+		end
+
+feature -- Access
+
+	value_count: INTEGER
+			-- Number of values (instructions) recorded so far
+		do
+			Result := opcodes.count
+		end
+
+feature -- Element change
+
+	add_shape (a_shape: SDF_SHAPE): INTEGER
+			-- Record evaluation of `a_shape'; return its value id.
+		require
+			shape_attached: a_shape /= Void
+		local
+			l_params: ARRAY [REAL_64]
+			i, l_offset, l_opcode: INTEGER
+			bx, by, bz, l_dot: REAL_64
+		do
+			l_offset := constants.count
+			l_opcode := a_shape.kind
+			if a_shape.is_transformed then
+				-- Transform prefix, see {SDF_TAPE}.Opcode_transformed
+				l_params := a_shape.transform_parameters
+				from i := l_params.lower until i > l_params.upper loop
+					constants.extend (l_params [i])
+					i := i + 1
+				end
+				l_opcode := l_opcode + {SDF_TAPE}.Opcode_transformed
+			end
+			l_params := a_shape.parameters
+			if a_shape.kind = a_shape.Kind_capsule then
+				-- Precompute axis and its inverse squared length
+				bx := l_params [l_params.lower + 3] - l_params [l_params.lower]
+				by := l_params [l_params.lower + 4] - l_params [l_params.lower + 1]
+				bz := l_params [l_params.lower + 5] - l_params [l_params.lower + 2]
+				l_dot := bx * bx + by * by + bz * bz
+				constants.extend (l_params [l_params.lower])
+				constants.extend (l_params [l_params.lower + 1])
+				constants.extend (l_params [l_params.lower + 2])
+				constants.extend (bx)
+				constants.extend (by)
+				constants.extend (bz)
+				if l_dot > 0.0 then
+					constants.extend (1.0 / l_dot)
+				else
+					constants.extend (0.0)
+				end
+				constants.extend (l_params [l_params.lower + 6])
+			else
+				from i := l_params.lower until i > l_params.upper loop
+					constants.extend (l_params [i])
+					i := i + 1
+				end
+			end
+			Result := record (l_opcode, No_value, No_value, l_offset)
+		ensure
+			one_more: value_count = old value_count + 1
+			result_is_last: Result = value_count
+		end
+
+	add_combine (a_operation: INTEGER; a_blend: REAL_64; a_left, a_right: INTEGER): INTEGER
+			-- Record `a_left' combined with `a_right' by `a_operation'
+			-- (see SDF_SCENE operation constants); return its value id.
+			-- Subtraction cuts `a_right' from `a_left'.
+		require
+			valid_operation: a_operation >= {SDF_SCENE}.Op_union and a_operation <= {SDF_SCENE}.Op_intersection
+			non_negative_blend: a_blend >= 0.0
+			valid_left: a_left >= 1 and a_left <= value_count
+			valid_right: a_right >= 1 and a_right <= value_count
+		local
+			l_opcode, l_offset: INTEGER
+		do
+			inspect a_operation
+			when {SDF_SCENE}.Op_subtraction then
+				l_opcode := {SDF_TAPE}.Opcode_subtraction
+			when {SDF_SCENE}.Op_intersection then
+				l_opcode := {SDF_TAPE}.Opcode_intersection
+			else
+				l_opcode := {SDF_TAPE}.Opcode_union
+			end
+			if a_blend > 0.0 then
+				-- Smooth variant is the next opcode
+				l_opcode := l_opcode + 1
+				l_offset := constants.count
+				constants.extend (a_blend)
+				constants.extend (1.0 / a_blend)
+				constants.extend (a_blend * 0.25)
+			end
+			Result := record (l_opcode, a_left, a_right, l_offset)
+		ensure
+			one_more: value_count = old value_count + 1
+			result_is_last: Result = value_count
+		end
+
+	add_group (a_shapes: ARRAYED_LIST [SDF_SHAPE]): INTEGER
+			-- Record the sharp union of `a_shapes' (all spheres or all boxes)
+			-- as one group instruction with structure-of-arrays constants;
+			-- return its value id. A single shape is recorded as itself.
+		require
+			shapes_attached: a_shapes /= Void
+			not_empty: not a_shapes.is_empty
+			groupable: {SDF_TAPE}.group_opcode (a_shapes.first.kind) /= 0
+			one_kind: across a_shapes as s all s.item.kind = a_shapes.first.kind end
+			untransformed: across a_shapes as s all not s.item.is_transformed end
+		local
+			l_params: ARRAY [REAL_64]
+			i, j, n, l_stride, l_offset: INTEGER
+		do
+			n := a_shapes.count
+			l_stride := {SDF_TAPE}.constant_count (a_shapes.first.kind)
+			l_offset := constants.count
+			from i := 1 until i > l_stride * n loop
+				constants.extend (0.0)
+				i := i + 1
+			end
+			-- Field i of member j goes to l_offset + i * n + (j - 1)
+			from j := 1 until j > n loop
+				l_params := a_shapes [j].parameters
+				from i := 0 until i >= l_stride loop
+					constants.put_i_th (l_params [l_params.lower + i], l_offset + i * n + j)
+					i := i + 1
+				end
+				j := j + 1
+			end
+			Result := record_group (a_shapes.first.kind, n, l_offset)
+		ensure
+			one_more: value_count = old value_count + 1
+			result_is_last: Result = value_count
+		end
+
+	add_group_members (a_tape: SDF_TAPE; a_instruction: INTEGER; a_keep: SPECIAL [BOOLEAN]): INTEGER
+			-- Record the members of group instruction `a_instruction' of
+			-- `a_tape' flagged in `a_keep' as a new group; return its value id.
+		require
+			tape_attached: a_tape /= Void
+			valid_instruction: a_instruction >= 1 and a_instruction <= a_tape.instruction_count
+			group: a_tape.is_group_opcode (a_tape.opcode (a_instruction))
+			one_flag_per_member: a_keep /= Void and then a_keep.count = a_tape.member_count (a_instruction)
+			not_empty: a_keep.has (True)
+		local
+			i, j, n, l_from, l_offset, l_kept: INTEGER
+		do
+			n := a_tape.member_count (a_instruction)
+			l_from := a_tape.constant_offset (a_instruction)
+			l_offset := constants.count
+			from i := 0 until i >= a_tape.constant_count (a_tape.member_opcode (a_tape.opcode (a_instruction))) loop
+				from j := 0 until j >= n loop
+					if a_keep [j] then
+						constants.extend (a_tape.constants [l_from + i * n + j])
+					end
+					j := j + 1
+				end
+				i := i + 1
+			end
+			from j := 0 until j >= n loop
+				if a_keep [j] then
+					l_kept := l_kept + 1
+				end
+				j := j + 1
+			end
+			Result := record_group (a_tape.member_opcode (a_tape.opcode (a_instruction)), l_kept, l_offset)
+		ensure
+			one_more: value_count = old value_count + 1
+			result_is_last: Result = value_count
+		end
+
+	add_instruction (a_tape: SDF_TAPE; a_instruction, a_left, a_right: INTEGER): INTEGER
+			-- Record a copy of instruction `a_instruction' of `a_tape' reading
+			-- values `a_left' and `a_right' (both 0 for primitives); return its value id.
+		require
+			tape_attached: a_tape /= Void
+			valid_instruction: a_instruction >= 1 and a_instruction <= a_tape.instruction_count
+			valid_left: a_left >= 0 and a_left <= value_count
+			valid_right: a_right >= 0 and a_right <= value_count
+		local
+			i, l_from, l_offset: INTEGER
+		do
+			l_from := a_tape.constant_offset (a_instruction)
+			if a_tape.instruction_constant_count (a_instruction) > 0 then
+				l_offset := constants.count
+			end
+			from i := 0 until i >= a_tape.instruction_constant_count (a_instruction) loop
+				constants.extend (a_tape.constants [l_from + i])
+				i := i + 1
+			end
+			Result := record (a_tape.opcode (a_instruction), a_left, a_right, l_offset)
+			member_counts.put_i_th (a_tape.member_count (a_instruction), Result)
+		ensure
+			one_more: value_count = old value_count + 1
+			result_is_last: Result = value_count
+		end
+
+	add_scene (a_scene: SDF_SCENE): INTEGER
+			-- Record `a_scene' as a left fold; return its value id (0 if empty).
+			-- Spheres and boxes of a run of sharp unions go into groups.
+		require
+			scene_attached: a_scene /= Void
+		local
+			i: INTEGER
+			l_entry: SDF_SCENE_ENTRY
+			l_spheres, l_boxes: ARRAYED_LIST [SDF_SHAPE]
+		do
+			create l_spheres.make (8)
+			create l_boxes.make (8)
+			from i := 1 until i > a_scene.count loop
+				l_entry := a_scene.shapes [i]
+				if i > 1 and (l_entry.operation /= {SDF_SCENE}.Op_union or l_entry.blend > 0.0) then
+					Result := add_combine (l_entry.operation, l_entry.blend, Result, add_shape (l_entry.shape))
+				elseif l_entry.shape.is_transformed then
+					Result := added_union (Result, add_shape (l_entry.shape))
+				elseif l_entry.shape.kind = l_entry.shape.Kind_sphere then
+					l_spheres.extend (l_entry.shape)
+				elseif l_entry.shape.kind = l_entry.shape.Kind_box then
+					l_boxes.extend (l_entry.shape)
+				else
+					Result := added_union (Result, add_shape (l_entry.shape))
+				end
+				i := i + 1
+				if i > a_scene.count or else (a_scene.shapes [i].operation /= {SDF_SCENE}.Op_union or a_scene.shapes [i].blend > 0.0) then
+					-- End of the run: flush its groups
+					if not l_spheres.is_empty then
+						Result := added_union (Result, add_group (l_spheres))
+						l_spheres.wipe_out
+					end
+					if not l_boxes.is_empty then
+						Result := added_union (Result, add_group (l_boxes))
+						l_boxes.wipe_out
+					end
+				end
+			end
+		ensure
+			empty_scene: a_scene.is_empty implies Result = 0
+		end
+
+	add_scene_group (a_group: SDF_SCENE_GROUP): INTEGER
+			-- Record `a_group' as a fold of its children, nested groups
+			-- recorded first as their own folds; return its value id (0 if
+			-- it has no shapes). Empty nested groups are left out, which is
+			-- exact for the unions and subtractions they can take part in.
+		require
+			group_attached: a_group /= Void
+		local
+			i, l_value: INTEGER
+		do
+			from i := 1 until i > a_group.count loop
+				l_value := 0
+				if attached {SDF_SCENE_GROUP} a_group.child (i) as l_group then
+					l_value := add_scene_group (l_group)
+				elseif attached {SDF_SHAPE} a_group.child (i) as l_shape then
+					l_value := add_shape (l_shape)
+				end
+				if l_value = 0 then
+					-- Nothing to combine
+				elseif Result = 0 then
+					Result := l_value
+				else
+					Result := add_combine (a_group.operation (i), a_group.blend (i), Result, l_value)
+				end
+				i := i + 1
+			end
+		ensure
+			empty_group: a_group.is_empty implies Result = 0
+		end
+
+feature -- Conversion
+
+	to_tape (a_result: INTEGER): SDF_TAPE
+			-- Register-allocated tape computing value `a_result'.
+			-- Values not needed for `a_result' are still evaluated.
+		require
+			valid_result: (value_count = 0 and a_result = 0) or (a_result >= 1 and a_result <= value_count)
+		local
+			l_last_use, l_register: SPECIAL [INTEGER]
+			l_free: ARRAYED_STACK [INTEGER]
+			l_code: SPECIAL [INTEGER]
+			l_constants: SPECIAL [REAL_64]
+			i, l_registers, pc: INTEGER
+		do
+			-- Last instruction reading each value (the result lives to the end)
+			create l_last_use.make_filled (0, value_count + 1)
+			from i := 1 until i > value_count loop
+				if sources_a [i] /= No_value then
+					l_last_use [sources_a [i]] := i
+					l_last_use [sources_b [i]] := i
+				end
+				i := i + 1
+			end
+			if a_result > 0 then
+				l_last_use [a_result] := value_count + 1
+			end
+
+			-- Linear scan: free operand registers before allocating the destination
+			create l_register.make_filled (0, value_count + 1)
+			create l_free.make (4)
+			create l_code.make_filled (0, value_count * {SDF_TAPE}.Instruction_size)
+			from i := 1 until i > value_count loop
+				pc := (i - 1) * {SDF_TAPE}.Instruction_size
+				l_code [pc + {SDF_TAPE}.Field_opcode] := opcodes [i]
+				l_code [pc + {SDF_TAPE}.Field_constant] := constant_offsets [i]
+				if member_counts [i] > 0 then
+					l_code [pc + {SDF_TAPE}.Field_member_count] := member_counts [i]
+				end
+				if sources_a [i] /= No_value then
+					l_code [pc + {SDF_TAPE}.Field_source_a] := l_register [sources_a [i]]
+					l_code [pc + {SDF_TAPE}.Field_source_b] := l_register [sources_b [i]]
+					release (sources_a [i], i, l_last_use, l_register, l_free)
+					if sources_b [i] /= sources_a [i] then
+						release (sources_b [i], i, l_last_use, l_register, l_free)
+					end
+				end
+				if l_free.is_empty then
+					l_register [i] := l_registers
+					l_registers := l_registers + 1
+				else
+					l_register [i] := l_free.item
+					l_free.remove
+				end
+				l_code [pc + {SDF_TAPE}.Field_destination] := l_register [i]
+				if l_last_use [i] = 0 then
+					-- Dead value: its register is free right away
+					l_free.put (l_register [i])
+				end
+				i := i + 1
+			end
+
+			create l_constants.make_filled (0.0, constants.count)
+			from i := 1 until i > constants.count loop
+				l_constants [i - 1] := constants [i]
+				i := i + 1
+			end
+
+			if a_result > 0 then
+				create Result.make (l_code, l_constants, l_registers, l_register [a_result])
+			else
+				create Result.make (l_code, l_constants, 0, 0)
+			end
+		ensure
+			result_attached: Result /= Void
+			all_instructions: Result.instruction_count = value_count
+		end
+
+feature {NONE} -- Implementation
+
+	opcodes: ARRAYED_LIST [INTEGER]
+			-- Opcode per value
+
+	sources_a, sources_b: ARRAYED_LIST [INTEGER]
+			-- Operand value ids per value (`No_value' for primitives)
+
+	constant_offsets: ARRAYED_LIST [INTEGER]
+			-- Constant pool offset per value
+
+	member_counts: ARRAYED_LIST [INTEGER]
+			-- Member count per value (0 except for groups)
+
+	constants: ARRAYED_LIST [REAL_64]
+			-- Constant pool
+
+	record (a_opcode, a_left, a_right, a_offset: INTEGER): INTEGER
+			-- Append instruction; return its value id.
+		do
+			opcodes.extend (a_opcode)
+			sources_a.extend (a_left)
+			sources_b.extend (a_right)
+			constant_offsets.extend (a_offset)
+			member_counts.extend (0)
+			Result := opcodes.count
+		end
+
+	record_group (a_kind, a_count, a_offset: INTEGER): INTEGER
+			-- Append a group of `a_count' shapes of `a_kind' whose constants
+			-- start at `a_offset'; a single member is a plain primitive
+			-- (its one-column layout is the primitive's).
+		require
+			positive_count: a_count >= 1
+		do
+			if a_count = 1 then
+				Result := record (a_kind, No_value, No_value, a_offset)
+			else
+				Result := record ({SDF_TAPE}.group_opcode (a_kind), No_value, No_value, a_offset)
+				member_counts.put_i_th (a_count, Result)
+			end
+		end
+
+	added_union (a_left, a_right: INTEGER): INTEGER
+			-- `a_right' joined to the fold `a_left' (0 if nothing yet) by sharp union
+		do
+			if a_left = 0 then
+				Result := a_right
+			else
+				Result := add_combine ({SDF_SCENE}.Op_union, 0.0, a_left, a_right)
+			end
+		end
+
+	release (a_value, a_instruction: INTEGER; a_last_use, a_register: SPECIAL [INTEGER]; a_free: ARRAYED_STACK [INTEGER])
+			-- Free the register of `a_value' if `a_instruction' is its last reader.
+		do
+			if a_last_use [a_value] = a_instruction then
+				a_free.put (a_register [a_value])
+			end
+		end
+
+	No_value: INTEGER = 0
+			-- Operand marker for primitives
+
+invariant
+	parallel_lists: sources_a.count = opcodes.count and sources_b.count = opcodes.count and constant_offsets.count = opcodes.count
+		and member_counts.count = opcodes.count
+
+end
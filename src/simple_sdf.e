@@ -247,6 +247,26 @@ feature -- Scene Factory
 			is_empty: Result.is_empty
 		end
 
+	scene_group: SDF_SCENE_GROUP
+			-- Create empty group node for a hierarchical scene
+		do
+			create Result.make
+		ensure
+			result_attached: Result /= Void
+			is_empty: Result.is_empty
+		end
+
+	instance_grid (a_cell_size: REAL_64): SDF_INSTANCE_GRID
+			-- Create empty grid of instances hashed in cells of side `a_cell_size'
+		require
+			positive_cell_size: a_cell_size > 0.0
+		do
+			create Result.make (a_cell_size)
+		ensure
+			result_attached: Result /= Void
+			is_empty: Result.is_empty
+		end
+
 feature -- Ray Marcher Factory
 
 	ray_marcher: SDF_RAY_MARCHER
@@ -269,6 +289,38 @@ feature -- Ray Marcher Factory
 			result_attached: Result /= Void
 		end
 
+	ray_batch (a_capacity: INTEGER): SDF_RAY_BATCH
+			-- Create empty ray batch for `march_batch'
+		require
+			positive_capacity: a_capacity > 0
+		do
+			create Result.make (a_capacity)
+		ensure
+			result_attached: Result /= Void
+		end
+
+	hit_buffer (a_capacity: INTEGER): SDF_HIT_BUFFER
+			-- Create hit buffer for `march_batch'
+		require
+			positive_capacity: a_capacity > 0
+		do
+			create Result.make (a_capacity)
+		ensure
+			result_attached: Result /= Void
+		end
+
+	occupancy_grid (a_field: SDF_FIELD; a_cell_size: REAL_64): SDF_OCCUPANCY_GRID
+			-- Create empty-space grid of `a_field' over its bounds for `SDF_RAY_MARCHER.set_occupancy'
+		require
+			field_attached: a_field /= Void
+			finite_bounds: not a_field.bounds.is_empty and not a_field.bounds.is_infinite
+			positive_cell_size: a_cell_size > 0.0
+		do
+			create Result.make (a_field, a_field.bounds, a_cell_size)
+		ensure
+			result_attached: Result /= Void
+		end
+
 feature -- Convenience: Distance evaluation
 
 	distance (a_shape: SDF_SHAPE; a_point: SDF_VEC3): REAL_64
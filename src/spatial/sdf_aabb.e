@@ -0,0 +1,291 @@
+note
+	description: "[
+		Axis-aligned bounding box.
+
+		Bounds are stored as six scalars so that queries in distance and
+		march loops (`distance_at', `contains_xyz') never allocate.
+		Unbounded shapes (planes) use `make_infinite', whose extents are
+		+/- {REAL_64}.max_value; every query stays finite for such boxes.
+
+		`ray_entry' and `ray_exit' clip a ray to the box (slab test), so
+		a marcher can start at the box and stop where the ray leaves it.
+
+		Design by Contract:
+		- Non-empty boxes have min <= max on every axis
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_AABB
+
+inherit
+	ANY
+		redefine
+			out
+		end
+
+create
+	make,
+	make_empty,
+	make_infinite,
+	make_around
+
+feature {NONE} -- Initialization
+
+	make (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64)
+			-- Create box from corner (min) to corner (max).
+		require
+			ordered_x: a_min_x <= a_max_x
+			ordered_y: a_min_y <= a_max_y
+			ordered_z: a_min_z <= a_max_z
+		do
+			set (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+		ensure
+			not_empty: not is_empty
+		end
+
+	make_empty
+			-- Create empty box (identity for `merge').
+		do
+			set_empty
+		ensure
+			empty: is_empty
+		end
+
+	make_infinite
+			-- Create box covering all of space.
+		do
+			set (- Infinite_extent, - Infinite_extent, - Infinite_extent, Infinite_extent, Infinite_extent, Infinite_extent)
+		ensure
+			infinite: is_infinite
+		end
+
+	make_around (a_x, a_y, a_z, a_half_x, a_half_y, a_half_z: REAL_64)
+			-- Create box centered at (x, y, z) with half-extents (hx, hy, hz).
+		require
+			non_negative_x: a_half_x >= 0.0
+			non_negative_y: a_half_y >= 0.0
+			non_negative_z: a_half_z >= 0.0
+		do
+			set (a_x - a_half_x, a_y - a_half_y, a_z - a_half_z, a_x + a_half_x, a_y + a_half_y, a_z + a_half_z)
+		ensure
+			not_empty: not is_empty
+		end
+
+feature -- Access
+
+	min_x, min_y, min_z: REAL_64
+			-- Minimum corner
+
+	max_x, max_y, max_z: REAL_64
+			-- Maximum corner
+
+	center_x: REAL_64
+			-- Center along X (0 for unbounded axes)
+		do
+			Result := min_x * 0.5 + max_x * 0.5
+		end
+
+	center_y: REAL_64
+			-- Center along Y (0 for unbounded axes)
+		do
+			Result := min_y * 0.5 + max_y * 0.5
+		end
+
+	center_z: REAL_64
+			-- Center along Z (0 for unbounded axes)
+		do
+			Result := min_z * 0.5 + max_z * 0.5
+		end
+
+feature -- Status report
+
+	is_empty: BOOLEAN
+			-- Does the box contain no points?
+		do
+			Result := min_x > max_x or min_y > max_y or min_z > max_z
+		end
+
+	is_infinite: BOOLEAN
+			-- Is the box unbounded on some axis?
+		do
+			Result := min_x <= - Infinite_extent or min_y <= - Infinite_extent or min_z <= - Infinite_extent
+				or max_x >= Infinite_extent or max_y >= Infinite_extent or max_z >= Infinite_extent
+		end
+
+	contains_xyz (a_x, a_y, a_z: REAL_64): BOOLEAN
+			-- Is point (x, y, z) inside or on the box?
+		do
+			Result := a_x >= min_x and a_x <= max_x and a_y >= min_y and a_y <= max_y
+				and a_z >= min_z and a_z <= max_z
+		end
+
+	intersects (other: SDF_AABB): BOOLEAN
+			-- Do Current and `other' overlap?
+		require
+			other_attached: other /= Void
+		do
+			Result := min_x <= other.max_x and max_x >= other.min_x
+				and min_y <= other.max_y and max_y >= other.min_y
+				and min_z <= other.max_z and max_z >= other.min_z
+		end
+
+feature -- Measurement
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Euclidean distance from (x, y, z) to the box (0 inside).
+			-- Lower bound for the distance to anything the box encloses.
+		require
+			not_empty: not is_empty
+		local
+			dx, dy, dz: REAL_64
+		do
+			dx := (min_x - a_x).max (a_x - max_x).max (0.0)
+			dy := (min_y - a_y).max (a_y - max_y).max (0.0)
+			dz := (min_z - a_z).max (a_z - max_z).max (0.0)
+			Result := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz)
+		ensure
+			non_negative: Result >= 0.0
+		end
+
+	distance_to (other: SDF_AABB): REAL_64
+			-- Euclidean gap between Current and `other' (0 if they overlap).
+		require
+			other_attached: other /= Void
+			not_empty: not is_empty
+			other_not_empty: not other.is_empty
+		local
+			dx, dy, dz: REAL_64
+		do
+			dx := (min_x - other.max_x).max (other.min_x - max_x).max (0.0)
+			dy := (min_y - other.max_y).max (other.min_y - max_y).max (0.0)
+			dz := (min_z - other.max_z).max (other.min_z - max_z).max (0.0)
+			Result := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz)
+		ensure
+			non_negative: Result >= 0.0
+		end
+
+	ray_entry (a_ox, a_oy, a_oz, a_dx, a_dy, a_dz: REAL_64): REAL_64
+			-- Smallest t at which the line o + t d is inside the box
+			-- (greater than `ray_exit' if the line misses it)
+		require
+			not_empty: not is_empty
+		do
+			Result := slab_entry (a_ox, a_dx, min_x, max_x).max (slab_entry (a_oy, a_dy, min_y, max_y)).max (
+				slab_entry (a_oz, a_dz, min_z, max_z))
+		end
+
+	ray_exit (a_ox, a_oy, a_oz, a_dx, a_dy, a_dz: REAL_64): REAL_64
+			-- Largest t at which the line o + t d is inside the box
+			-- (less than `ray_entry' if the line misses it)
+		require
+			not_empty: not is_empty
+		do
+			Result := slab_exit (a_ox, a_dx, min_x, max_x).min (slab_exit (a_oy, a_dy, min_y, max_y)).min (
+				slab_exit (a_oz, a_dz, min_z, max_z))
+		end
+
+feature -- Element change
+
+	set (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64)
+			-- Set both corners.
+		do
+			min_x := a_min_x
+			min_y := a_min_y
+			min_z := a_min_z
+			max_x := a_max_x
+			max_y := a_max_y
+			max_z := a_max_z
+		end
+
+	set_empty
+			-- Make the box empty.
+		do
+			set (Infinite_extent, Infinite_extent, Infinite_extent, - Infinite_extent, - Infinite_extent, - Infinite_extent)
+		ensure
+			empty: is_empty
+		end
+
+	merge (other: SDF_AABB)
+			-- Grow to enclose `other'.
+		require
+			other_attached: other /= Void
+		do
+			set (min_x.min (other.min_x), min_y.min (other.min_y), min_z.min (other.min_z),
+				max_x.max (other.max_x), max_y.max (other.max_y), max_z.max (other.max_z))
+		end
+
+	intersect (other: SDF_AABB)
+			-- Shrink to the overlap with `other' (empty if they are disjoint).
+		require
+			other_attached: other /= Void
+		do
+			if is_empty or other.is_empty or not intersects (other) then
+				set_empty
+			else
+				set (min_x.max (other.min_x), min_y.max (other.min_y), min_z.max (other.min_z),
+					max_x.min (other.max_x), max_y.min (other.max_y), max_z.min (other.max_z))
+			end
+		end
+
+	expand (a_margin: REAL_64)
+			-- Grow by `a_margin' on every side (unbounded sides stay unbounded).
+		require
+			non_negative_margin: a_margin >= 0.0
+			not_empty: not is_empty
+		do
+			set ((min_x - a_margin).max (- Infinite_extent), (min_y - a_margin).max (- Infinite_extent),
+				(min_z - a_margin).max (- Infinite_extent), (max_x + a_margin).min (Infinite_extent),
+				(max_y + a_margin).min (Infinite_extent), (max_z + a_margin).min (Infinite_extent))
+		end
+
+feature -- Output
+
+	out: STRING
+			-- String representation
+		do
+			Result := "AABB(" + min_x.out + ", " + min_y.out + ", " + min_z.out + " .. "
+				+ max_x.out + ", " + max_y.out + ", " + max_z.out + ")"
+		end
+
+feature {NONE} -- Implementation
+
+	slab_entry (a_origin, a_direction, a_min, a_max: REAL_64): REAL_64
+			-- Parameter where a line along one axis enters [min, max]
+		do
+			if a_direction > 0.0 then
+				Result := (a_min - a_origin) / a_direction
+			elseif a_direction < 0.0 then
+				Result := (a_max - a_origin) / a_direction
+			elseif a_origin >= a_min and a_origin <= a_max then
+				Result := - Infinite_extent
+			else
+				Result := Infinite_extent
+			end
+		end
+
+	slab_exit (a_origin, a_direction, a_min, a_max: REAL_64): REAL_64
+			-- Parameter where a line along one axis leaves [min, max]
+		do
+			if a_direction > 0.0 then
+				Result := (a_max - a_origin) / a_direction
+			elseif a_direction < 0.0 then
+				Result := (a_min - a_origin) / a_direction
+			elseif a_origin >= a_min and a_origin <= a_max then
+				Result := Infinite_extent
+			else
+				Result := - Infinite_extent
+			end
+		end
+
+feature -- Constants
+
+	Infinite_extent: REAL_64
+			-- Coordinate used for unbounded sides
+		once
+			Result := {REAL_64}.max_value
+		end
+
+end
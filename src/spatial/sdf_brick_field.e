@@ -0,0 +1,486 @@
+note
+	description: "[
+		Sparse narrow-band brick cache of a distance field.
+
+		The field is baked over a box into a coarse grid of cells of
+		`Brick_cells' voxels per axis. Only cells the surface band passes
+		through get a brick: `Brick_size'^3 distance samples on the voxel
+		corners (neighbouring bricks repeat their shared face, so a brick
+		interpolates on its own), quantized to NATURAL_8 over
+		[-band, band]. Whether a cell needs a brick is decided with
+		`interval_at' over the cell, which also gives cells without brick
+		a bound: at least the band away from the surface, and never
+		farther than the surface.
+
+		`distance_at' then costs a grid lookup and a trilinear blend of
+		eight bytes:
+		- in a brick: the blend (corners clamped to +band only make it an
+		  underestimate, a safe step);
+		- in a brick with a corner clamped to -band: the source field;
+		- in a cell without brick: the cell's bound;
+		- outside the baked box: the source field.
+
+		A scene is baked from its tape pruned to each brick, so a brick
+		costs the few shapes near it. `update' follows later edits of the
+		scene through its dirty regions: a cell is baked again only if its
+		stored distance reaches into one, and dropped bricks leave slots
+		for new ones. `dual_at', `interval_at' and
+		`lipschitz_bound' are the source's: one exact evaluation per hit.
+		`native_grid', `native_cells', `native_coarse' and
+		`native_samples' hold the same data for the C renderer
+		(RAYLIB_BUFFER.render_bricks).
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_BRICK_FIELD
+
+inherit
+	SDF_FIELD
+
+create
+	make,
+	make_from_scene
+
+feature {NONE} -- Initialization
+
+	make (a_field: SDF_FIELD; a_bounds: SDF_AABB; a_voxel_size: REAL_64)
+			-- Bake `a_field' over `a_bounds' with voxels of `a_voxel_size'.
+		require
+			field_attached: a_field /= Void
+			bounds_attached: a_bounds /= Void
+			finite_bounds: not a_bounds.is_empty and not a_bounds.is_infinite
+			positive_voxel: a_voxel_size > 0.0
+		do
+			source := a_field
+			bake (a_field, a_bounds, a_voxel_size)
+		ensure
+			source_set: source = a_field
+			voxel_set: voxel_size = a_voxel_size
+		end
+
+	make_from_scene (a_scene: SDF_SCENE; a_bounds: SDF_AABB; a_voxel_size: REAL_64)
+			-- Bake `a_scene' over `a_bounds' through its tape, pruned per brick.
+		require
+			scene_attached: a_scene /= Void
+			not_empty: not a_scene.is_empty
+			bounds_attached: a_bounds /= Void
+			finite_bounds: not a_bounds.is_empty and not a_bounds.is_infinite
+			positive_voxel: a_voxel_size > 0.0
+		local
+			l_tape: SDF_TAPE
+		do
+			scene := a_scene
+			a_scene.sync_dirty_regions
+			seen_serial := a_scene.dirty_serial
+			l_tape := a_scene.tape
+			source := l_tape
+			bake (l_tape, a_bounds, a_voxel_size)
+		ensure
+			scene_set: scene = a_scene
+			voxel_set: voxel_size = a_voxel_size
+		end
+
+feature -- Access
+
+	source: SDF_FIELD
+			-- Field the cache was baked from (the exact fallback)
+
+	scene: detachable SDF_SCENE
+			-- Scene the cache follows (`make_from_scene' only)
+
+	origin_x, origin_y, origin_z: REAL_64
+			-- Minimum corner of the baked box
+
+	voxel_size: REAL_64
+			-- Distance between samples
+
+	band: REAL_64
+			-- Half-width of the stored band (`Band_voxels' voxels)
+
+	cells_x, cells_y, cells_z: INTEGER
+			-- Grid size in cells
+
+	brick_count: INTEGER
+			-- Number of bricks stored
+
+	rebaked_cell_count: INTEGER
+			-- Cells baked again by the last `update'
+
+	cell_count: INTEGER
+			-- Number of grid cells
+		do
+			Result := cells_x * cells_y * cells_z
+		end
+
+	brick_index (i, j, k: INTEGER): INTEGER
+			-- Brick of cell (i, j, k) (0-based), -1 if none
+		require
+			valid_i: i >= 0 and i < cells_x
+			valid_j: j >= 0 and j < cells_y
+			valid_k: k >= 0 and k < cells_z
+		do
+			Result := cells [(k * cells_y + j) * cells_x + i]
+		ensure
+			valid: Result >= -1 and Result < slot_count
+		end
+
+	native_grid: MANAGED_POINTER
+			-- Origin xyz, voxel size and band as REAL_32 for the C renderer
+
+	native_cells: MANAGED_POINTER
+			-- Brick index per cell as int32
+
+	native_coarse: MANAGED_POINTER
+			-- Bound per cell as REAL_32
+
+	native_samples: MANAGED_POINTER
+			-- Brick samples as bytes
+
+feature -- Element change
+
+	update
+			-- Follow the edits made to `scene' since the last bake: bake
+			-- again only the cells a dirty region can reach, or every
+			-- cell if the scene's log no longer goes back that far.
+		require
+			from_scene: scene /= Void
+		local
+			l_serial: INTEGER
+			l_tape: SDF_TAPE
+		do
+			rebaked_cell_count := 0
+			if attached scene as l_scene then
+				l_scene.sync_dirty_regions
+				l_serial := l_scene.dirty_serial
+				if l_serial /= seen_serial then
+					l_tape := l_scene.tape
+					source := l_tape
+					if l_scene.has_dirty_regions_since (seen_serial) then
+						rebake (l_scene.dirty_regions_since (seen_serial))
+					else
+						bake (l_tape, baked_bounds, voxel_size)
+						rebaked_cell_count := cell_count
+					end
+					seen_serial := l_serial
+				end
+			end
+		end
+
+feature -- Distance evaluation
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Distance from the cache, or from `source' where it has none.
+		local
+			fx, fy, fz, tx, ty, tz, x00, x10, x01, x11, y0, y1: REAL_64
+			i, j, k, ax, ay, az, l_cell, s: INTEGER
+			c000, c100, c010, c110, c001, c101, c011, c111: INTEGER
+			l_samples: like samples
+		do
+			fx := (a_x - origin_x) / voxel_size
+			fy := (a_y - origin_y) / voxel_size
+			fz := (a_z - origin_z) / voxel_size
+			if fx >= 0.0 and fy >= 0.0 and fz >= 0.0 and fx < cells_x * Brick_cells
+				and fy < cells_y * Brick_cells and fz < cells_z * Brick_cells
+			then
+				i := fx.floor // Brick_cells
+				j := fy.floor // Brick_cells
+				k := fz.floor // Brick_cells
+				l_cell := (k * cells_y + j) * cells_x + i
+				if cells [l_cell] < 0 then
+					Result := coarse [l_cell]
+				else
+					-- Voxel within the brick and the position inside it
+					fx := fx - i * Brick_cells
+					fy := fy - j * Brick_cells
+					fz := fz - k * Brick_cells
+					ax := fx.floor.min (Brick_cells - 1)
+					ay := fy.floor.min (Brick_cells - 1)
+					az := fz.floor.min (Brick_cells - 1)
+					tx := fx - ax
+					ty := fy - ay
+					tz := fz - az
+					l_samples := samples
+					s := cells [l_cell] * Brick_volume + (az * Brick_size + ay) * Brick_size + ax
+					c000 := l_samples [s].to_integer_32
+					c100 := l_samples [s + 1].to_integer_32
+					c010 := l_samples [s + Brick_size].to_integer_32
+					c110 := l_samples [s + Brick_size + 1].to_integer_32
+					c001 := l_samples [s + Brick_area].to_integer_32
+					c101 := l_samples [s + Brick_area + 1].to_integer_32
+					c011 := l_samples [s + Brick_area + Brick_size].to_integer_32
+					c111 := l_samples [s + Brick_area + Brick_size + 1].to_integer_32
+					if c000.min (c100).min (c010).min (c110).min (c001).min (c101).min (c011).min (c111) = 0 then
+						-- Clamped to -band: the surface may be anywhere in between
+						Result := source.distance_at (a_x, a_y, a_z)
+					else
+						x00 := c000 + (c100 - c000) * tx
+						x10 := c010 + (c110 - c010) * tx
+						x01 := c001 + (c101 - c001) * tx
+						x11 := c011 + (c111 - c011) * tx
+						y0 := x00 + (x10 - x00) * ty
+						y1 := x01 + (x11 - x01) * ty
+						Result := (y0 + (y1 - y0) * tz) * band / Quantization_half - band
+					end
+				end
+			else
+				Result := source.distance_at (a_x, a_y, a_z)
+			end
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Range of `source' over the box
+		do
+			Result := source.interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Exact distance and gradient from `source'
+		do
+			Result := source.dual_at (a_x, a_y, a_z)
+		end
+
+	lipschitz_bound: REAL_64
+			-- Lipschitz bound of `source'
+		do
+			Result := source.lipschitz_bound
+		end
+
+feature -- Constants
+
+	Brick_cells: INTEGER = 7
+			-- Voxels per cell edge
+
+	Brick_size: INTEGER = 8
+			-- Samples per brick edge (`Brick_cells' + 1)
+
+	Brick_area: INTEGER = 64
+			-- Samples per brick layer
+
+	Brick_volume: INTEGER = 512
+			-- Samples per brick
+
+	Band_voxels: INTEGER = 4
+			-- Band half-width in voxels
+
+feature {NONE} -- Implementation
+
+	cells: SPECIAL [INTEGER]
+			-- Brick index per cell (x fastest), -1 if none
+
+	coarse: SPECIAL [REAL_64]
+			-- Bound of cells without brick
+
+	samples: SPECIAL [NATURAL_8]
+			-- `Brick_volume' quantized samples per brick (x fastest)
+
+	bake (a_field: SDF_FIELD; a_bounds: SDF_AABB; a_voxel_size: REAL_64)
+			-- Classify and sample every cell of `a_bounds'.
+		local
+			l_cell: INTEGER
+			l_size: REAL_64
+		do
+			baked_bounds := a_bounds
+			origin_x := a_bounds.min_x
+			origin_y := a_bounds.min_y
+			origin_z := a_bounds.min_z
+			voxel_size := a_voxel_size
+			band := Band_voxels * a_voxel_size
+			l_size := Brick_cells * a_voxel_size
+			cells_x := ((a_bounds.max_x - a_bounds.min_x) / l_size).ceiling.max (1)
+			cells_y := ((a_bounds.max_y - a_bounds.min_y) / l_size).ceiling.max (1)
+			cells_z := ((a_bounds.max_z - a_bounds.min_z) / l_size).ceiling.max (1)
+			create cells.make_filled (-1, cell_count)
+			create coarse.make_filled (0.0, cell_count)
+			create samples.make_filled ({NATURAL_8} 0, Brick_volume)
+			create free_slots.make (0)
+			brick_count := 0
+			slot_count := 0
+			from l_cell := 0 until l_cell >= cell_count loop
+				bake_cell (a_field, l_cell)
+				l_cell := l_cell + 1
+			end
+			build_native
+		ensure
+			voxel_set: voxel_size = a_voxel_size
+		end
+
+	rebake (a_regions: LIST [SDF_AABB])
+			-- Bake again the cells whose stored distance reaches into one of `a_regions'.
+		local
+			l_cell: INTEGER
+			l_size, l_reach: REAL_64
+			l_box: SDF_AABB
+			l_stale: BOOLEAN
+		do
+			l_size := Brick_cells * voxel_size
+			create l_box.make_empty
+			rebaked_cell_count := 0
+			from l_cell := 0 until l_cell >= cell_count loop
+				cell_corner (l_cell)
+				l_box.set (last_x, last_y, last_z, last_x + l_size, last_y + l_size, last_z + l_size)
+				if cells [l_cell] >= 0 then
+					l_reach := band
+				else
+					l_reach := coarse [l_cell].abs
+				end
+				l_stale := False
+				from a_regions.start until l_stale or a_regions.after loop
+					l_stale := a_regions.item.distance_to (l_box) <= l_reach
+					a_regions.forth
+				end
+				if l_stale then
+					bake_cell (source, l_cell)
+					rebaked_cell_count := rebaked_cell_count + 1
+				end
+				l_cell := l_cell + 1
+			end
+			build_native
+		end
+
+	bake_cell (a_field: SDF_FIELD; a_cell: INTEGER)
+			-- Classify `a_cell' with `a_field' and sample its brick if the band
+			-- passes through it: cells the band can reach get a brick, the
+			-- others keep a bound.
+		local
+			l_range: SDF_INTERVAL
+			l_local: SDF_FIELD
+			l_size, x0, y0, z0: REAL_64
+			ax, ay, az, s: INTEGER
+		do
+			l_size := Brick_cells * voxel_size
+			cell_corner (a_cell)
+			x0 := last_x
+			y0 := last_y
+			z0 := last_z
+			l_range := a_field.interval_at (x0, y0, z0, x0 + l_size, y0 + l_size, z0 + l_size)
+			if l_range.lo > band or l_range.hi < - band then
+				if cells [a_cell] >= 0 then
+					free_slots.extend (cells [a_cell])
+					cells [a_cell] := -1
+					brick_count := brick_count - 1
+				end
+				if l_range.lo > band then
+					coarse [a_cell] := l_range.lo
+				else
+					coarse [a_cell] := l_range.hi
+				end
+			else
+				if cells [a_cell] < 0 then
+					cells [a_cell] := new_slot
+					brick_count := brick_count + 1
+				end
+				if attached {SDF_TAPE} a_field as l_tape then
+					l_local := l_tape.pruned (create {SDF_AABB}.make (x0, y0, z0, x0 + l_size, y0 + l_size, z0 + l_size))
+				else
+					l_local := a_field
+				end
+				s := cells [a_cell] * Brick_volume
+				from az := 0 until az >= Brick_size loop
+					from ay := 0 until ay >= Brick_size loop
+						from ax := 0 until ax >= Brick_size loop
+							samples [s] := quantized (l_local.distance_at (x0 + ax * voxel_size, y0 + ay * voxel_size, z0 + az * voxel_size))
+							s := s + 1
+							ax := ax + 1
+						end
+						ay := ay + 1
+					end
+					az := az + 1
+				end
+			end
+		end
+
+	new_slot: INTEGER
+			-- Brick slot for a new brick: a freed one, or one more at the end
+		do
+			if free_slots.is_empty then
+				Result := slot_count
+				slot_count := slot_count + 1
+				if slot_count * Brick_volume > samples.count then
+					samples := samples.aliased_resized_area_with_default ({NATURAL_8} 0, (2 * samples.count).max (slot_count * Brick_volume))
+				end
+			else
+				Result := free_slots.last
+				free_slots.finish
+				free_slots.remove
+			end
+		ensure
+			fits: (Result + 1) * Brick_volume <= samples.count
+		end
+
+	baked_bounds: SDF_AABB
+			-- Box given at creation
+
+	free_slots: ARRAYED_LIST [INTEGER]
+			-- Slots of bricks dropped by `rebake'
+
+	slot_count: INTEGER
+			-- Brick slots in use or free
+
+	seen_serial: INTEGER
+			-- `scene.dirty_serial' the cache is baked at
+
+	last_x, last_y, last_z: REAL_64
+			-- Corner computed by the last `cell_corner'
+
+	cell_corner (a_cell: INTEGER)
+			-- Set `last_x', `last_y', `last_z' to the minimum corner of `a_cell'.
+		local
+			l_size: REAL_64
+		do
+			l_size := Brick_cells * voxel_size
+			last_x := origin_x + (a_cell \\ cells_x) * l_size
+			last_y := origin_y + ((a_cell // cells_x) \\ cells_y) * l_size
+			last_z := origin_z + (a_cell // (cells_x * cells_y)) * l_size
+		end
+
+	quantized (a_distance: REAL_64): NATURAL_8
+			-- `a_distance' clamped to [-band, band] as a byte
+		do
+			Result := ((a_distance.max (- band).min (band) / band + 1.0) * Quantization_half).rounded.to_natural_8
+		end
+
+	build_native
+			-- Copy the cache to the native buffers.
+		local
+			i: INTEGER
+		do
+			create native_grid.make (Grid_size * Real_32_bytes)
+			native_grid.put_real_32 (origin_x.truncated_to_real, 0)
+			native_grid.put_real_32 (origin_y.truncated_to_real, Real_32_bytes)
+			native_grid.put_real_32 (origin_z.truncated_to_real, 2 * Real_32_bytes)
+			native_grid.put_real_32 (voxel_size.truncated_to_real, 3 * Real_32_bytes)
+			native_grid.put_real_32 (band.truncated_to_real, 4 * Real_32_bytes)
+			create native_cells.make (cell_count * Integer_32_bytes)
+			create native_coarse.make (cell_count * Real_32_bytes)
+			from i := 0 until i >= cell_count loop
+				native_cells.put_integer_32 (cells [i], i * Integer_32_bytes)
+				native_coarse.put_real_32 (coarse [i].truncated_to_real, i * Real_32_bytes)
+				i := i + 1
+			end
+			create native_samples.make ((slot_count * Brick_volume).max (1))
+			from i := 0 until i >= slot_count * Brick_volume loop
+				native_samples.put_natural_8 (samples [i], i)
+				i := i + 1
+			end
+		end
+
+	Quantization_half: REAL_64 = 127.5
+			-- Byte value of distance 0
+
+	Grid_size: INTEGER = 5
+			-- Values in `native_grid'
+
+	Integer_32_bytes: INTEGER = 4
+	Real_32_bytes: INTEGER = 4
+
+invariant
+	source_attached: source /= Void
+	positive_voxel: voxel_size > 0.0
+	one_entry_per_cell: cells.count = cell_count and coarse.count = cell_count
+	samples_per_slot: samples.count >= slot_count * Brick_volume
+	bricks_in_slots: brick_count + free_slots.count = slot_count
+
+end
@@ -0,0 +1,298 @@
+note
+	description: "[
+		Bounding volume hierarchy over a list of item boxes.
+
+		Binary tree with one item per leaf, built by median split along
+		the longest axis of the item centers. Nodes live in flat arrays
+		(six bounds per node) and children always come after their parent,
+		so `refit' is a single reverse sweep.
+
+		The hierarchy only knows item indices (1-based, as given to `make');
+		callers decide what an item is and how to evaluate it.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_BVH
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_boxes: ARRAY [SDF_AABB])
+			-- Build hierarchy over `a_boxes'.
+		require
+			boxes_attached: a_boxes /= Void
+			has_boxes: a_boxes.count > 0
+			no_empty_boxes: across a_boxes as b all not b.item.is_empty end
+		local
+			l_items: SPECIAL [INTEGER]
+			i: INTEGER
+		do
+			item_count := a_boxes.count
+			create item_bounds.make_filled (0.0, item_count * 6)
+			create node_bounds.make_filled (0.0, (2 * item_count - 1) * 6)
+			create node_left.make_filled (0, 2 * item_count - 1)
+			create node_right.make_filled (0, 2 * item_count - 1)
+			create node_item.make_filled (0, 2 * item_count - 1)
+			create l_items.make_filled (0, item_count)
+			from i := 1 until i > item_count loop
+				set_item_bounds (i, a_boxes [a_boxes.lower + i - 1])
+				l_items [i - 1] := i
+				i := i + 1
+			end
+			node_count := 0
+			build (l_items, 0, item_count).do_nothing
+		ensure
+			item_count_set: item_count = a_boxes.count
+			full_tree: node_count = 2 * item_count - 1
+		end
+
+feature -- Access
+
+	item_count: INTEGER
+			-- Number of items
+
+	node_count: INTEGER
+			-- Number of nodes (root is node 1)
+
+	is_leaf (a_node: INTEGER): BOOLEAN
+			-- Is `a_node' a leaf?
+		require
+			valid_node: a_node >= 1 and a_node <= node_count
+		do
+			Result := node_item [a_node - 1] > 0
+		end
+
+	leaf_item (a_node: INTEGER): INTEGER
+			-- Item stored in leaf `a_node'
+		require
+			valid_node: a_node >= 1 and a_node <= node_count
+			leaf: is_leaf (a_node)
+		do
+			Result := node_item [a_node - 1]
+		end
+
+	left (a_node: INTEGER): INTEGER
+			-- First child of inner node `a_node'
+		require
+			valid_node: a_node >= 1 and a_node <= node_count
+			inner: not is_leaf (a_node)
+		do
+			Result := node_left [a_node - 1]
+		end
+
+	right (a_node: INTEGER): INTEGER
+			-- Second child of inner node `a_node'
+		require
+			valid_node: a_node >= 1 and a_node <= node_count
+			inner: not is_leaf (a_node)
+		do
+			Result := node_right [a_node - 1]
+		end
+
+feature -- Measurement
+
+	node_distance (a_node: INTEGER; a_x, a_y, a_z: REAL_64): REAL_64
+			-- Distance from (x, y, z) to the box of `a_node' (0 inside)
+		require
+			valid_node: a_node >= 1 and a_node <= node_count
+		local
+			o: INTEGER
+			dx, dy, dz: REAL_64
+		do
+			o := (a_node - 1) * 6
+			dx := (node_bounds [o] - a_x).max (a_x - node_bounds [o + 3]).max (0.0)
+			dy := (node_bounds [o + 1] - a_y).max (a_y - node_bounds [o + 4]).max (0.0)
+			dz := (node_bounds [o + 2] - a_z).max (a_z - node_bounds [o + 5]).max (0.0)
+			Result := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz)
+		ensure
+			non_negative: Result >= 0.0
+		end
+
+	node_box (a_node: INTEGER): SDF_AABB
+			-- Box of `a_node' (newly created)
+		require
+			valid_node: a_node >= 1 and a_node <= node_count
+		local
+			o: INTEGER
+		do
+			o := (a_node - 1) * 6
+			create Result.make_empty
+			Result.set (node_bounds [o], node_bounds [o + 1], node_bounds [o + 2],
+				node_bounds [o + 3], node_bounds [o + 4], node_bounds [o + 5])
+		end
+
+feature -- Element change
+
+	set_item_bounds (a_item: INTEGER; a_box: SDF_AABB)
+			-- Replace the box of `a_item' (takes effect at the next `refit').
+		require
+			valid_item: a_item >= 1 and a_item <= item_count
+			box_attached: a_box /= Void
+			not_empty: not a_box.is_empty
+		local
+			o: INTEGER
+		do
+			o := (a_item - 1) * 6
+			item_bounds [o] := a_box.min_x
+			item_bounds [o + 1] := a_box.min_y
+			item_bounds [o + 2] := a_box.min_z
+			item_bounds [o + 3] := a_box.max_x
+			item_bounds [o + 4] := a_box.max_y
+			item_bounds [o + 5] := a_box.max_z
+		end
+
+	refit
+			-- Recompute all node boxes from the item boxes, keeping the tree shape.
+		local
+			n, o, a, b, j: INTEGER
+		do
+			from n := node_count until n < 1 loop
+				o := (n - 1) * 6
+				if node_item [n - 1] > 0 then
+					a := (node_item [n - 1] - 1) * 6
+					from j := 0 until j > 5 loop
+						node_bounds [o + j] := item_bounds [a + j]
+						j := j + 1
+					end
+				else
+					a := (node_left [n - 1] - 1) * 6
+					b := (node_right [n - 1] - 1) * 6
+					from j := 0 until j > 2 loop
+						node_bounds [o + j] := node_bounds [a + j].min (node_bounds [b + j])
+						node_bounds [o + j + 3] := node_bounds [a + j + 3].max (node_bounds [b + j + 3])
+						j := j + 1
+					end
+				end
+				n := n - 1
+			end
+		end
+
+feature {NONE} -- Implementation
+
+	item_bounds: SPECIAL [REAL_64]
+			-- Six bounds per item (min xyz, max xyz)
+
+	node_bounds: SPECIAL [REAL_64]
+			-- Six bounds per node
+
+	node_left, node_right: SPECIAL [INTEGER]
+			-- Children of inner nodes
+
+	node_item: SPECIAL [INTEGER]
+			-- Item of leaf nodes (0 for inner nodes)
+
+	build (a_items: SPECIAL [INTEGER]; a_from, a_to: INTEGER): INTEGER
+			-- Build subtree over `a_items' [a_from, a_to); return its node.
+		require
+			non_empty_range: a_from < a_to
+		local
+			l_axis, l_mid: INTEGER
+			lo, hi, c: REAL_64
+			i, l_left, l_right: INTEGER
+		do
+			node_count := node_count + 1
+			Result := node_count
+			if a_to - a_from = 1 then
+				node_item [Result - 1] := a_items [a_from]
+			else
+				-- Split along the longest axis of the item centers
+				from l_axis := 0 until l_axis > 2 loop
+					lo := {REAL_64}.max_value
+					hi := - {REAL_64}.max_value
+					from i := a_from until i >= a_to loop
+						c := item_center (a_items [i], l_axis)
+						lo := lo.min (c)
+						hi := hi.max (c)
+						i := i + 1
+					end
+					extents [l_axis] := hi - lo
+					l_axis := l_axis + 1
+				end
+				if extents [0] >= extents [1] and extents [0] >= extents [2] then
+					l_axis := 0
+				elseif extents [1] >= extents [2] then
+					l_axis := 1
+				else
+					l_axis := 2
+				end
+				l_mid := (a_from + a_to) // 2
+				select_nth (a_items, a_from, a_to - 1, l_mid, l_axis)
+				l_left := build (a_items, a_from, l_mid)
+				l_right := build (a_items, l_mid, a_to)
+				node_left [Result - 1] := l_left
+				node_right [Result - 1] := l_right
+			end
+			if Result = 1 then
+				refit
+			end
+		end
+
+	item_center (a_item, a_axis: INTEGER): REAL_64
+			-- Center of `a_item' along `a_axis' (0 = x, 1 = y, 2 = z)
+		local
+			o: INTEGER
+		do
+			o := (a_item - 1) * 6 + a_axis
+			Result := item_bounds [o] * 0.5 + item_bounds [o + 3] * 0.5
+		end
+
+	select_nth (a_items: SPECIAL [INTEGER]; a_low, a_high, a_nth, a_axis: INTEGER)
+			-- Partially sort `a_items' [a_low, a_high] by center along `a_axis'
+			-- so that position `a_nth' holds its final item (quickselect).
+		local
+			lo, hi, i, j, t: INTEGER
+			l_pivot: REAL_64
+		do
+			from
+				lo := a_low
+				hi := a_high
+			until
+				lo >= hi
+			loop
+				l_pivot := item_center (a_items [(lo + hi) // 2], a_axis)
+				from
+					i := lo
+					j := hi
+				until
+					i > j
+				loop
+					from until item_center (a_items [i], a_axis) >= l_pivot loop
+						i := i + 1
+					end
+					from until item_center (a_items [j], a_axis) <= l_pivot loop
+						j := j - 1
+					end
+					if i <= j then
+						t := a_items [i]
+						a_items [i] := a_items [j]
+						a_items [j] := t
+						i := i + 1
+						j := j - 1
+					end
+				end
+				if a_nth <= j then
+					hi := j
+				elseif a_nth >= i then
+					lo := i
+				else
+					lo := hi
+				end
+			end
+		end
+
+	extents: SPECIAL [REAL_64]
+			-- Scratch center extents per axis during `build'
+		once
+			create Result.make_filled (0.0, 3)
+		end
+
+invariant
+	item_bounds_sized: item_bounds.count = item_count * 6
+	node_bounds_sized: node_bounds.count >= node_count * 6
+
+end
@@ -0,0 +1,363 @@
+note
+	description: "[
+		Camera-centred geometry clipmap of a scene's distance field.
+
+		`level_count' nested levels of `resolution'^3 distance samples,
+		all centred on the camera; level 0 has voxels of `finest_voxel'
+		and each next level doubles the voxel, so the field is sampled
+		finely near the viewer and ever more coarsely out to kilometres,
+		at a fixed memory cost.
+
+		Samples are addressed toroidally: world voxel index g of a level
+		lives at slot g mod `resolution' on each axis. When `update'
+		moves a level's window by a few voxels, only the slabs that
+		became visible are evaluated from the scene; every other sample
+		stays where it is. Edits to the scene are followed through its
+		dirty regions: a sample is evaluated again only if a region lies
+		within its stored distance.
+
+		`distance_at' blends the eight samples around the point in the
+		finest level whose window holds it. Beyond the coarsest level,
+		and before the first `update', it evaluates the scene. Sampling
+		uses the scene's tape, pruned to each refreshed slab. `dual_at',
+		`interval_at' and `lipschitz_bound' are the tape's: one exact
+		evaluation per hit.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_CLIPMAP_FIELD
+
+inherit
+	SDF_FIELD
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_scene: SDF_SCENE; a_level_count, a_resolution: INTEGER; a_finest_voxel: REAL_64)
+			-- Clipmap of `a_scene' with `a_level_count' levels of
+			-- `a_resolution'^3 samples, the finest `a_finest_voxel' apart.
+			-- Call `update' with the camera position before marching.
+		require
+			scene_attached: a_scene /= Void
+			not_empty: not a_scene.is_empty
+			has_levels: a_level_count >= 1
+			enough_samples: a_resolution >= 4
+			positive_voxel: a_finest_voxel > 0.0
+		do
+			scene := a_scene
+			source := a_scene.tape
+			a_scene.sync_dirty_regions
+			seen_serial := a_scene.dirty_serial
+			level_count := a_level_count
+			resolution := a_resolution
+			finest_voxel := a_finest_voxel
+			create samples.make_filled (0.0, a_level_count * a_resolution * a_resolution * a_resolution)
+			create window.make_filled (0, 3 * a_level_count)
+		ensure
+			scene_set: scene = a_scene
+			levels_set: level_count = a_level_count
+			resolution_set: resolution = a_resolution
+			voxel_set: finest_voxel = a_finest_voxel
+			not_centered: not is_centered
+		end
+
+feature -- Access
+
+	scene: SDF_SCENE
+			-- Scene the samples are taken from
+
+	source: SDF_TAPE
+			-- Tape of `scene' at the last refresh (the exact fallback)
+
+	level_count: INTEGER
+			-- Number of nested levels
+
+	resolution: INTEGER
+			-- Samples per axis of each level
+
+	finest_voxel: REAL_64
+			-- Distance between samples of level 0
+
+	level_voxel (a_level: INTEGER): REAL_64
+			-- Distance between samples of `a_level'
+		require
+			valid_level: a_level >= 0 and a_level < level_count
+		do
+			Result := finest_voxel * (2 ^ a_level)
+		ensure
+			positive: Result > 0.0
+		end
+
+	level_at (a_x, a_y, a_z: REAL_64): INTEGER
+			-- Finest level whose window holds (a_x, a_y, a_z), -1 if none
+		local
+			l_level: INTEGER
+		do
+			Result := -1
+			if is_centered then
+				from l_level := 0 until Result >= 0 or l_level >= level_count loop
+					if holds (l_level, a_x, a_y, a_z) then
+						Result := l_level
+					end
+					l_level := l_level + 1
+				end
+			end
+		ensure
+			valid: Result >= -1 and Result < level_count
+		end
+
+	refreshed_sample_count: INTEGER
+			-- Samples evaluated by the last `update'
+
+feature -- Status report
+
+	is_centered: BOOLEAN
+			-- Has `update' placed the windows yet?
+
+feature -- Element change
+
+	update (a_x, a_y, a_z: REAL_64)
+			-- Centre every level on the camera at (a_x, a_y, a_z),
+			-- evaluating only the samples that entered a window or that
+			-- a scene edit since the last update can reach.
+		local
+			l_level, n, ox, oy, oz, nx, ny, nz, lx0, lx1, ly0, ly1, l_serial: INTEGER
+			l_voxel: REAL_64
+			l_full, l_edited: BOOLEAN
+		do
+			refreshed_sample_count := 0
+			scene.sync_dirty_regions
+			l_serial := scene.dirty_serial
+			l_full := not is_centered or not scene.has_dirty_regions_since (seen_serial)
+			l_edited := not l_full and l_serial /= seen_serial
+			if l_full or l_edited then
+				source := scene.tape
+			end
+			n := resolution
+			from l_level := 0 until l_level >= level_count loop
+				l_voxel := level_voxel (l_level)
+				nx := (a_x / l_voxel).floor - n // 2
+				ny := (a_y / l_voxel).floor - n // 2
+				nz := (a_z / l_voxel).floor - n // 2
+				if l_full then
+					refresh (l_level, nx, nx + n, ny, ny + n, nz, nz + n)
+				else
+					ox := window [3 * l_level]
+					oy := window [3 * l_level + 1]
+					oz := window [3 * l_level + 2]
+					-- Slabs new along x span the whole window in y and z
+					refresh (l_level, nx, (nx + n).min (ox), ny, ny + n, nz, nz + n)
+					refresh (l_level, (ox + n).max (nx), nx + n, ny, ny + n, nz, nz + n)
+					-- Along y only over the old x range, along z over the old x and y ranges
+					lx0 := nx.max (ox)
+					lx1 := (nx + n).min (ox + n)
+					refresh (l_level, lx0, lx1, ny, (ny + n).min (oy), nz, nz + n)
+					refresh (l_level, lx0, lx1, (oy + n).max (ny), ny + n, nz, nz + n)
+					ly0 := ny.max (oy)
+					ly1 := (ny + n).min (oy + n)
+					refresh (l_level, lx0, lx1, ly0, ly1, nz, (nz + n).min (oz))
+					refresh (l_level, lx0, lx1, ly0, ly1, (oz + n).max (nz), nz + n)
+				end
+				window [3 * l_level] := nx
+				window [3 * l_level + 1] := ny
+				window [3 * l_level + 2] := nz
+				l_level := l_level + 1
+			end
+			if l_edited then
+				refresh_stale (scene.dirty_regions_since (seen_serial))
+			end
+			seen_serial := l_serial
+			is_centered := True
+		ensure
+			centered: is_centered
+			holds_camera: level_at (a_x, a_y, a_z) = 0
+		end
+
+feature -- Distance evaluation
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Distance blended from the finest level holding the point,
+			-- or from `source' outside every level.
+		local
+			l_level, n, gx, gy, gz, sx, sy, sz, sx1, sy1, sz1, l_base: INTEGER
+			fx, fy, fz, tx, ty, tz, x00, x10, x01, x11, y0, y1, l_voxel: REAL_64
+			c000, c100, c010, c110, c001, c101, c011, c111: REAL_64
+			l_samples: like samples
+		do
+			l_level := level_at (a_x, a_y, a_z)
+			if l_level < 0 then
+				Result := source.distance_at (a_x, a_y, a_z)
+			else
+				n := resolution
+				l_voxel := level_voxel (l_level)
+				fx := a_x / l_voxel
+				fy := a_y / l_voxel
+				fz := a_z / l_voxel
+				gx := fx.floor
+				gy := fy.floor
+				gz := fz.floor
+				tx := fx - gx
+				ty := fy - gy
+				tz := fz - gz
+				sx := wrapped (gx)
+				sy := wrapped (gy) * n
+				sz := wrapped (gz) * n * n
+				sx1 := wrapped (gx + 1)
+				sy1 := wrapped (gy + 1) * n
+				sz1 := wrapped (gz + 1) * n * n
+				l_base := l_level * n * n * n
+				l_samples := samples
+				c000 := l_samples [l_base + sz + sy + sx]
+				c100 := l_samples [l_base + sz + sy + sx1]
+				c010 := l_samples [l_base + sz + sy1 + sx]
+				c110 := l_samples [l_base + sz + sy1 + sx1]
+				c001 := l_samples [l_base + sz1 + sy + sx]
+				c101 := l_samples [l_base + sz1 + sy + sx1]
+				c011 := l_samples [l_base + sz1 + sy1 + sx]
+				c111 := l_samples [l_base + sz1 + sy1 + sx1]
+				x00 := c000 + (c100 - c000) * tx
+				x10 := c010 + (c110 - c010) * tx
+				x01 := c001 + (c101 - c001) * tx
+				x11 := c011 + (c111 - c011) * tx
+				y0 := x00 + (x10 - x00) * ty
+				y1 := x01 + (x11 - x01) * ty
+				Result := y0 + (y1 - y0) * tz
+			end
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Range of `source' over the box
+		do
+			Result := source.interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- Exact distance and gradient from `source'
+		do
+			Result := source.dual_at (a_x, a_y, a_z)
+		end
+
+	lipschitz_bound: REAL_64
+			-- Lipschitz bound of `source'
+		do
+			Result := source.lipschitz_bound
+		end
+
+feature {NONE} -- Implementation
+
+	samples: SPECIAL [REAL_32]
+			-- `resolution'^3 samples per level, toroidally addressed (x fastest)
+
+	window: SPECIAL [INTEGER]
+			-- Minimum world voxel index (x, y, z) of each level's window
+
+	seen_serial: INTEGER
+			-- `scene.dirty_serial' the samples are taken at
+
+	holds (a_level: INTEGER; a_x, a_y, a_z: REAL_64): BOOLEAN
+			-- Do the eight samples around (a_x, a_y, a_z) lie in the window of `a_level'?
+		local
+			l_voxel, fx, fy, fz: REAL_64
+			l_last: INTEGER
+		do
+			l_voxel := level_voxel (a_level)
+			l_last := resolution - 1
+			fx := a_x / l_voxel - window [3 * a_level]
+			fy := a_y / l_voxel - window [3 * a_level + 1]
+			fz := a_z / l_voxel - window [3 * a_level + 2]
+			Result := fx >= 0.0 and fy >= 0.0 and fz >= 0.0 and fx < l_last and fy < l_last and fz < l_last
+		end
+
+	wrapped (a_index: INTEGER): INTEGER
+			-- Slot of world voxel index `a_index' on one axis
+		do
+			Result := a_index \\ resolution
+			if Result < 0 then
+				Result := Result + resolution
+			end
+		ensure
+			in_range: Result >= 0 and Result < resolution
+		end
+
+	refresh (a_level, a_x0, a_x1, a_y0, a_y1, a_z0, a_z1: INTEGER)
+			-- Evaluate the samples of `a_level' with world voxel index in
+			-- [a_x0, a_x1) x [a_y0, a_y1) x [a_z0, a_z1).
+		local
+			gx, gy, gz, n, l_base, l_row: INTEGER
+			l_voxel: REAL_64
+			l_local: SDF_TAPE
+		do
+			if a_x0 < a_x1 and a_y0 < a_y1 and a_z0 < a_z1 then
+				n := resolution
+				l_voxel := level_voxel (a_level)
+				l_local := source.pruned (create {SDF_AABB}.make (a_x0 * l_voxel, a_y0 * l_voxel, a_z0 * l_voxel,
+					(a_x1 - 1) * l_voxel, (a_y1 - 1) * l_voxel, (a_z1 - 1) * l_voxel))
+				l_base := a_level * n * n * n
+				from gz := a_z0 until gz >= a_z1 loop
+					from gy := a_y0 until gy >= a_y1 loop
+						l_row := l_base + (wrapped (gz) * n + wrapped (gy)) * n
+						from gx := a_x0 until gx >= a_x1 loop
+							samples [l_row + wrapped (gx)] := l_local.distance_at (gx * l_voxel, gy * l_voxel, gz * l_voxel).truncated_to_real
+							gx := gx + 1
+						end
+						gy := gy + 1
+					end
+					gz := gz + 1
+				end
+				refreshed_sample_count := refreshed_sample_count + (a_x1 - a_x0) * (a_y1 - a_y0) * (a_z1 - a_z0)
+			end
+		end
+
+	refresh_stale (a_regions: LIST [SDF_AABB])
+			-- Evaluate again every sample whose stored distance reaches
+			-- into one of `a_regions' (plus a voxel for the blend).
+		local
+			l_level, n, gx, gy, gz, l_slot: INTEGER
+			l_voxel, l_reach, x, y, z: REAL_64
+			l_stale: BOOLEAN
+		do
+			n := resolution
+			from l_level := 0 until l_level >= level_count loop
+				l_voxel := level_voxel (l_level)
+				from gz := window [3 * l_level + 2] until gz >= window [3 * l_level + 2] + n loop
+					from gy := window [3 * l_level + 1] until gy >= window [3 * l_level + 1] + n loop
+						from gx := window [3 * l_level] until gx >= window [3 * l_level] + n loop
+							l_slot := l_level * n * n * n + (wrapped (gz) * n + wrapped (gy)) * n + wrapped (gx)
+							l_reach := l_voxel + samples [l_slot].abs
+							x := gx * l_voxel
+							y := gy * l_voxel
+							z := gz * l_voxel
+							l_stale := False
+							from a_regions.start until l_stale or a_regions.after loop
+								l_stale := a_regions.item.distance_at (x, y, z) <= l_reach
+								a_regions.forth
+							end
+							if l_stale then
+								samples [l_slot] := source.distance_at (x, y, z).truncated_to_real
+								refreshed_sample_count := refreshed_sample_count + 1
+							end
+							gx := gx + 1
+						end
+						gy := gy + 1
+					end
+					gz := gz + 1
+				end
+				l_level := l_level + 1
+			end
+		end
+
+invariant
+	scene_attached: scene /= Void
+	source_attached: source /= Void
+	has_levels: level_count >= 1
+	enough_samples: resolution >= 4
+	positive_voxel: finest_voxel > 0.0
+	one_window_per_level: window.count = 3 * level_count
+	samples_per_level: samples.count = level_count * resolution * resolution * resolution
+
+end
@@ -0,0 +1,577 @@
+note
+	description: "[
+		Union of many SDF_INSTANCEs, indexed by a spatial hash of
+		uniform cells so that a sample evaluates only nearby instances.
+
+		Every bounded instance is registered in each cell of side
+		`cell_size' its bounds overlap; cells are hashed into a table of
+		a power-of-two number of buckets stored as two flat arrays, so
+		the index stays small however sparse or wide the placement.
+		Instances with unbounded prototypes (planes) are evaluated for
+		every sample.
+
+		A sample evaluates the instances of its own cell. An instance
+		not registered there lies wholly outside the cell, so if the
+		nearest one found is closer than the cell walls the result is
+		exact. Otherwise the 26 neighbouring cells are visited too and
+		the result is capped by the distance to the walls of that 3x3x3
+		block, which never overestimates and still steps a marcher at
+		least one cell through empty space. Samples further than one
+		cell from all instances return the distance to their bounds.
+		The per-sample cost thus depends on the local density only.
+		Choose `cell_size' around the size of a typical instance.
+
+		Like SDF_SCENE_GROUP, culling relies on prototypes returning at
+		least the distance to their bounds. Added and moved instances
+		are picked up on the next evaluation through the shared change
+		stamp, which rebuilds the index.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_INSTANCE_GRID
+
+inherit
+	SDF_FIELD
+		redefine
+			bounds
+		end
+
+	SDF_SHARED_CHANGE_STAMP
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_cell_size: REAL_64)
+			-- Create empty grid with cells of side `a_cell_size'.
+		require
+			positive_cell_size: a_cell_size > 0.0
+		do
+			cell_size := a_cell_size
+			create instances.make (16)
+			create instance_bounds.make_empty (0)
+			create unbounded_items.make_empty (0)
+			create bucket_start.make_filled (0, 2)
+			create bucket_items.make_empty (0)
+			create visit_marks.make_empty (0)
+			create cached_bounds.make_empty
+			create padded_bounds.make_empty
+			cached_lipschitz := 1.0
+			is_stale := True
+		ensure
+			cell_size_set: cell_size = a_cell_size
+			empty: is_empty
+		end
+
+feature -- Access
+
+	cell_size: REAL_64
+			-- Side of a hash cell
+
+	count: INTEGER
+			-- Number of instances
+		do
+			Result := instances.count
+		end
+
+	instance (i: INTEGER): SDF_INSTANCE
+			-- Instance `i'
+		require
+			valid_index: i >= 1 and i <= count
+		do
+			Result := instances [i]
+		end
+
+	bucket_count: INTEGER
+			-- Number of hash buckets in the current index
+		do
+			refresh
+			Result := bucket_start.count - 1
+		end
+
+	registration_count: INTEGER
+			-- Number of (instance, cell) pairs in the current index
+		do
+			refresh
+			Result := bucket_items.count
+		end
+
+	bounds: SDF_AABB
+			-- Box enclosing every instance (empty for an empty grid)
+		do
+			refresh
+			if unbounded_items.count > 0 then
+				create Result.make_infinite
+			else
+				Result := cached_bounds.twin
+			end
+		ensure then
+			result_attached: Result /= Void
+		end
+
+	last_evaluated_count: INTEGER
+			-- Number of instances evaluated by the last `distance_at'
+
+feature -- Status report
+
+	is_empty: BOOLEAN
+			-- Has the grid no instances?
+		do
+			Result := instances.is_empty
+		end
+
+	has (a_instance: SDF_INSTANCE): BOOLEAN
+			-- Is `a_instance' in the grid?
+		do
+			Result := instances.has (a_instance)
+		end
+
+feature -- Element change
+
+	extend (a_instance: SDF_INSTANCE)
+			-- Add `a_instance'.
+		require
+			instance_attached: a_instance /= Void
+		do
+			instances.extend (a_instance)
+			is_stale := True
+		ensure
+			one_more: count = old count + 1
+			added: instance (count) = a_instance
+		end
+
+	wipe_out
+			-- Remove all instances.
+		do
+			instances.wipe_out
+			is_stale := True
+		ensure
+			empty: is_empty
+		end
+
+feature -- Distance evaluation
+
+	distance_at (a_x, a_y, a_z: REAL_64): REAL_64
+			-- Distance to the nearest instance, or a lower bound of it at
+			-- least one cell wide where no instance is that close.
+			-- Returns max value if the grid is empty.
+		do
+			refresh
+			search (a_x, a_y, a_z)
+			Result := last_distance
+		end
+
+	interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z: REAL_64): SDF_INTERVAL
+			-- Union of the ranges of the instances within one cell of the
+			-- box; the others are at least a cell away. [max, max] if the
+			-- grid is empty.
+		local
+			l_box: SDF_AABB
+			lo, hi, l_gap: REAL_64
+			ix0, iy0, iz0, ix1, iy1, iz1, i, j, k, b, m: INTEGER
+			l_cells: INTEGER_64
+			d: SDF_INTERVAL
+		do
+			refresh
+			lo := {REAL_64}.max_value
+			hi := {REAL_64}.max_value
+			from i := 0 until i = unbounded_items.count loop
+				d := instances [unbounded_items [i] + 1].interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+				lo := lo.min (d.lo)
+				hi := hi.min (d.hi)
+				i := i + 1
+			end
+			if not cached_bounds.is_empty then
+				create l_box.make (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+				l_gap := cached_bounds.distance_to (l_box)
+				if l_gap >= cell_size then
+					lo := lo.min (l_gap)
+				else
+					l_box.expand (cell_size)
+					l_box.set (l_box.min_x.max (padded_bounds.min_x), l_box.min_y.max (padded_bounds.min_y),
+						l_box.min_z.max (padded_bounds.min_z), l_box.max_x.min (padded_bounds.max_x),
+						l_box.max_y.min (padded_bounds.max_y), l_box.max_z.min (padded_bounds.max_z))
+					ix0 := cell_index (l_box.min_x)
+					iy0 := cell_index (l_box.min_y)
+					iz0 := cell_index (l_box.min_z)
+					ix1 := cell_index (l_box.max_x)
+					iy1 := cell_index (l_box.max_y)
+					iz1 := cell_index (l_box.max_z)
+					l_cells := (ix1 - ix0 + 1).to_integer_64 * (iy1 - iy0 + 1) * (iz1 - iz0 + 1)
+					if l_cells <= bucket_items.count then
+						query_mark := query_mark + 1
+						from i := ix0 until i > ix1 loop
+							from j := iy0 until j > iy1 loop
+								from k := iz0 until k > iz1 loop
+									b := bucket (i, j, k)
+									from m := bucket_start [b] until m = bucket_start [b + 1] loop
+										if visit_marks [bucket_items [m]] /= query_mark then
+											visit_marks [bucket_items [m]] := query_mark
+											d := instances [bucket_items [m] + 1].interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+											lo := lo.min (d.lo)
+											hi := hi.min (d.hi)
+										end
+										m := m + 1
+									end
+									k := k + 1
+								end
+								j := j + 1
+							end
+							i := i + 1
+						end
+						lo := lo.min (cell_size)
+					else
+						from i := 0 until i = instances.count loop
+							if is_bounded (i) then
+								d := instances [i + 1].interval_at (a_min_x, a_min_y, a_min_z, a_max_x, a_max_y, a_max_z)
+								lo := lo.min (d.lo)
+								hi := hi.min (d.hi)
+							end
+							i := i + 1
+						end
+					end
+				end
+			end
+			create Result.make (lo, hi)
+		end
+
+	dual_at (a_x, a_y, a_z: REAL_64): SDF_DUAL
+			-- `distance_at' with the gradient of the instance that gave it,
+			-- or of the bound that capped it.
+		local
+			gx, gy, gz, l_length: REAL_64
+			ix, iy, iz: INTEGER
+		do
+			refresh
+			search (a_x, a_y, a_z)
+			if last_nearest > 0 then
+				Result := instances [last_nearest].dual_at (a_x, a_y, a_z)
+			elseif last_distance = {REAL_64}.max_value then
+				Result.set (last_distance, 0.0, 0.0, 0.0)
+			elseif not padded_bounds.contains_xyz (a_x, a_y, a_z) then
+				gx := a_x - a_x.max (cached_bounds.min_x).min (cached_bounds.max_x)
+				gy := a_y - a_y.max (cached_bounds.min_y).min (cached_bounds.max_y)
+				gz := a_z - a_z.max (cached_bounds.min_z).min (cached_bounds.max_z)
+				l_length := {DOUBLE_MATH}.sqrt (gx * gx + gy * gy + gz * gz)
+				Result.set (last_distance, gx / l_length, gy / l_length, gz / l_length)
+			else
+					-- Capped by the nearest wall of the 3x3x3 block
+				ix := cell_index (a_x)
+				iy := cell_index (a_y)
+				iz := cell_index (a_z)
+				Result := wall_dual (a_x, ix, 1.0, 0.0, 0.0).min (wall_dual (a_y, iy, 0.0, 1.0, 0.0))
+					.min (wall_dual (a_z, iz, 0.0, 0.0, 1.0))
+				Result.set (last_distance, Result.dx, Result.dy, Result.dz)
+			end
+		end
+
+	lipschitz_bound: REAL_64
+			-- Largest Lipschitz bound of the instances (1 for an empty grid)
+		do
+			refresh
+			Result := cached_lipschitz
+		end
+
+feature {NONE} -- Implementation
+
+	instances: ARRAYED_LIST [SDF_INSTANCE]
+			-- Instances in insertion order
+
+	instance_bounds: SPECIAL [REAL_64]
+			-- Six bounds per instance (0-based) as of the last build
+
+	unbounded_items: SPECIAL [INTEGER]
+			-- Instances (0-based) with unbounded prototypes
+
+	bucket_start: SPECIAL [INTEGER]
+			-- Start of each bucket's run in `bucket_items'; one extra
+			-- entry closes the last run
+
+	bucket_items: SPECIAL [INTEGER]
+			-- Instances (0-based) registered in each bucket's cells
+
+	visit_marks: SPECIAL [INTEGER]
+			-- `query_mark' of the query that last evaluated each instance
+
+	query_mark: INTEGER
+			-- Serial of the current query, to evaluate an instance
+			-- registered in several visited cells only once
+
+	cached_bounds: SDF_AABB
+			-- Union of the bounded instances' bounds
+
+	padded_bounds: SDF_AABB
+			-- `cached_bounds' widened by one cell
+
+	cached_lipschitz: REAL_64
+			-- Cached `lipschitz_bound'
+
+	is_stale: BOOLEAN
+			-- Has the instance list changed since the last build?
+
+	seen_stamp: NATURAL_64
+			-- `change_stamp' at the last build
+
+	last_distance: REAL_64
+			-- Result of the last `search'
+
+	last_nearest: INTEGER
+			-- Instance (1-based) that gave `last_distance', 0 if a bound did
+
+	refresh
+			-- Rebuild the index if instances were added, removed or moved.
+		do
+			if is_stale or seen_stamp /= change_stamp then
+				build
+			end
+		end
+
+	build
+			-- Register every bounded instance in the buckets of the cells it overlaps.
+		local
+			l_bounds: SDF_AABB
+			l_unbounded, l_registrations, l_buckets, i, j, k, m, b: INTEGER
+			l_fill: SPECIAL [INTEGER]
+		do
+			create instance_bounds.make_filled (0.0, instances.count * 6)
+			create visit_marks.make_filled (0, instances.count)
+			query_mark := 0
+			cached_bounds.set_empty
+			cached_lipschitz := 1.0
+			from i := 0 until i = instances.count loop
+				l_bounds := instances [i + 1].bounds
+				instance_bounds [i * 6] := l_bounds.min_x
+				instance_bounds [i * 6 + 1] := l_bounds.min_y
+				instance_bounds [i * 6 + 2] := l_bounds.min_z
+				instance_bounds [i * 6 + 3] := l_bounds.max_x
+				instance_bounds [i * 6 + 4] := l_bounds.max_y
+				instance_bounds [i * 6 + 5] := l_bounds.max_z
+				if l_bounds.is_infinite then
+					l_unbounded := l_unbounded + 1
+				elseif is_bounded (i) then
+					cached_bounds.merge (l_bounds)
+					l_registrations := l_registrations + (cell_index (l_bounds.max_x) - cell_index (l_bounds.min_x) + 1)
+						* (cell_index (l_bounds.max_y) - cell_index (l_bounds.min_y) + 1)
+						* (cell_index (l_bounds.max_z) - cell_index (l_bounds.min_z) + 1)
+				end
+				cached_lipschitz := cached_lipschitz.max (instances [i + 1].lipschitz_bound)
+				i := i + 1
+			end
+			padded_bounds := cached_bounds.twin
+			if not padded_bounds.is_empty then
+				padded_bounds.expand (cell_size)
+			end
+			create unbounded_items.make_empty (l_unbounded)
+			from l_buckets := 1 until l_buckets >= l_registrations loop
+				l_buckets := l_buckets * 2
+			end
+			create bucket_start.make_filled (0, l_buckets + 1)
+			create bucket_items.make_filled (0, l_registrations)
+				-- Count per bucket, then turn counts into run starts
+			from i := 0 until i = instances.count loop
+				if is_bounded (i) then
+					from j := cell_index (instance_bounds [i * 6]) until j > cell_index (instance_bounds [i * 6 + 3]) loop
+						from k := cell_index (instance_bounds [i * 6 + 1]) until k > cell_index (instance_bounds [i * 6 + 4]) loop
+							from m := cell_index (instance_bounds [i * 6 + 2]) until m > cell_index (instance_bounds [i * 6 + 5]) loop
+								b := bucket (j, k, m)
+								bucket_start [b + 1] := bucket_start [b + 1] + 1
+								m := m + 1
+							end
+							k := k + 1
+						end
+						j := j + 1
+					end
+				elseif not is_empty_item (i) then
+					unbounded_items.extend (i)
+				end
+				i := i + 1
+			end
+			from b := 1 until b > l_buckets loop
+				bucket_start [b] := bucket_start [b] + bucket_start [b - 1]
+				b := b + 1
+			end
+			l_fill := bucket_start.twin
+			from i := 0 until i = instances.count loop
+				if is_bounded (i) then
+					from j := cell_index (instance_bounds [i * 6]) until j > cell_index (instance_bounds [i * 6 + 3]) loop
+						from k := cell_index (instance_bounds [i * 6 + 1]) until k > cell_index (instance_bounds [i * 6 + 4]) loop
+							from m := cell_index (instance_bounds [i * 6 + 2]) until m > cell_index (instance_bounds [i * 6 + 5]) loop
+								b := bucket (j, k, m)
+								bucket_items [l_fill [b]] := i
+								l_fill [b] := l_fill [b] + 1
+								m := m + 1
+							end
+							k := k + 1
+						end
+						j := j + 1
+					end
+				end
+				i := i + 1
+			end
+			is_stale := False
+			seen_stamp := change_stamp
+		ensure
+			fresh: not is_stale and seen_stamp = change_stamp
+			one_mark_per_instance: visit_marks.count = count
+		end
+
+	search (a_x, a_y, a_z: REAL_64)
+			-- Set `last_distance' and `last_nearest' for (x, y, z): the
+			-- own cell first, then its neighbours if the nearest instance
+			-- found is further than the cell walls.
+		local
+			ix, iy, iz, i, j, k: INTEGER
+			l_wall: REAL_64
+		do
+			last_evaluated_count := 0
+			last_distance := {REAL_64}.max_value
+			last_nearest := 0
+			query_mark := query_mark + 1
+			from i := 0 until i = unbounded_items.count loop
+				visit (unbounded_items [i], a_x, a_y, a_z)
+				i := i + 1
+			end
+			if not cached_bounds.is_empty then
+				if padded_bounds.contains_xyz (a_x, a_y, a_z) then
+					ix := cell_index (a_x)
+					iy := cell_index (a_y)
+					iz := cell_index (a_z)
+					visit_cell (ix, iy, iz, a_x, a_y, a_z)
+					l_wall := wall_distance (a_x, ix).min (wall_distance (a_y, iy)).min (wall_distance (a_z, iz))
+					if last_distance > l_wall then
+						from i := ix - 1 until i > ix + 1 loop
+							from j := iy - 1 until j > iy + 1 loop
+								from k := iz - 1 until k > iz + 1 loop
+									if i /= ix or j /= iy or k /= iz then
+										visit_cell (i, j, k, a_x, a_y, a_z)
+									end
+									k := k + 1
+								end
+								j := j + 1
+							end
+							i := i + 1
+						end
+						if last_distance > l_wall + cell_size then
+							last_distance := l_wall + cell_size
+							last_nearest := 0
+						end
+					end
+				else
+					l_wall := cached_bounds.distance_at (a_x, a_y, a_z)
+					if l_wall < last_distance then
+						last_distance := l_wall
+						last_nearest := 0
+					end
+				end
+			end
+		end
+
+	visit_cell (a_i, a_j, a_k: INTEGER; a_x, a_y, a_z: REAL_64)
+			-- Visit the instances in the bucket of cell (i, j, k).
+		local
+			b, m: INTEGER
+		do
+			b := bucket (a_i, a_j, a_k)
+			from m := bucket_start [b] until m = bucket_start [b + 1] loop
+				visit (bucket_items [m], a_x, a_y, a_z)
+				m := m + 1
+			end
+		end
+
+	visit (a_item: INTEGER; a_x, a_y, a_z: REAL_64)
+			-- Evaluate instance `a_item' (0-based) at (x, y, z) unless this
+			-- query already did or its bounds are further than the nearest so far.
+		local
+			d: REAL_64
+		do
+			if visit_marks [a_item] /= query_mark then
+				visit_marks [a_item] := query_mark
+				if not is_bounded (a_item) or else item_box_distance (a_item, a_x, a_y, a_z) < last_distance then
+					d := instances [a_item + 1].distance_at (a_x, a_y, a_z)
+					last_evaluated_count := last_evaluated_count + 1
+					if d < last_distance then
+						last_distance := d
+						last_nearest := a_item + 1
+					end
+				end
+			end
+		end
+
+	item_box_distance (a_item: INTEGER; a_x, a_y, a_z: REAL_64): REAL_64
+			-- Distance from (x, y, z) to the bounds of instance `a_item'
+		local
+			dx, dy, dz: REAL_64
+			o: INTEGER
+		do
+			o := a_item * 6
+			dx := (instance_bounds [o] - a_x).max (a_x - instance_bounds [o + 3]).max (0.0)
+			dy := (instance_bounds [o + 1] - a_y).max (a_y - instance_bounds [o + 4]).max (0.0)
+			dz := (instance_bounds [o + 2] - a_z).max (a_z - instance_bounds [o + 5]).max (0.0)
+			Result := {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz)
+		end
+
+	is_bounded (a_item: INTEGER): BOOLEAN
+			-- Does instance `a_item' (0-based) have finite, non-empty bounds
+			-- as of the last build?
+		local
+			o: INTEGER
+		do
+			o := a_item * 6
+			Result := not is_empty_item (a_item) and instance_bounds [o] > - {REAL_64}.max_value
+				and instance_bounds [o + 1] > - {REAL_64}.max_value and instance_bounds [o + 2] > - {REAL_64}.max_value
+				and instance_bounds [o + 3] < {REAL_64}.max_value and instance_bounds [o + 4] < {REAL_64}.max_value
+				and instance_bounds [o + 5] < {REAL_64}.max_value
+		end
+
+	is_empty_item (a_item: INTEGER): BOOLEAN
+			-- Are the bounds of instance `a_item' (0-based) empty (empty sub-scene)?
+		local
+			o: INTEGER
+		do
+			o := a_item * 6
+			Result := instance_bounds [o] > instance_bounds [o + 3] or instance_bounds [o + 1] > instance_bounds [o + 4]
+				or instance_bounds [o + 2] > instance_bounds [o + 5]
+		end
+
+	cell_index (a_coordinate: REAL_64): INTEGER
+			-- Cell holding `a_coordinate' along one axis
+		do
+			Result := (a_coordinate / cell_size).floor
+		end
+
+	wall_distance (a_coordinate: REAL_64; a_cell: INTEGER): REAL_64
+			-- Distance from `a_coordinate' to the nearer wall of cell `a_cell'
+		do
+			Result := (a_coordinate - a_cell * cell_size).min ((a_cell + 1) * cell_size - a_coordinate)
+		end
+
+	wall_dual (a_coordinate: REAL_64; a_cell: INTEGER; a_ax, a_ay, a_az: REAL_64): SDF_DUAL
+			-- `wall_distance' with its gradient along axis (ax, ay, az)
+		do
+			if a_coordinate - a_cell * cell_size <= (a_cell + 1) * cell_size - a_coordinate then
+				create Result.make (a_coordinate - a_cell * cell_size, a_ax, a_ay, a_az)
+			else
+				create Result.make ((a_cell + 1) * cell_size - a_coordinate, - a_ax, - a_ay, - a_az)
+			end
+		end
+
+	bucket (a_i, a_j, a_k: INTEGER): INTEGER
+			-- Hash bucket of cell (i, j, k)
+		do
+			Result := ((a_i.as_natural_32 * 73856093).bit_xor (a_j.as_natural_32 * 19349663)
+				.bit_xor (a_k.as_natural_32 * 83492791)).bit_and ((bucket_start.count - 2).as_natural_32).as_integer_32
+		ensure
+			valid_bucket: Result >= 0 and Result < bucket_start.count - 1
+		end
+
+invariant
+	instances_attached: instances /= Void
+	positive_cell_size: cell_size > 0.0
+	buckets_power_of_two: (bucket_start.count - 1).bit_and (bucket_start.count - 2) = 0
+	runs_close: bucket_start [bucket_start.count - 1] = bucket_items.count
+
+end
@@ -0,0 +1,246 @@
+note
+	description: "[
+		Coarse binary occupancy grid of a distance field.
+
+		The box is split into cubic cells of `cell_size', one bit each.
+		A cell is marked empty when it is proven to hold no surface:
+		either it lies outside the field's `bounds', or `interval_at'
+		over the cell is positive. Every other cell stays occupied, so
+		the grid is conservative: an empty cell can be crossed without
+		looking at the field.
+
+		SDF_RAY_MARCHER walks rays through runs of empty cells with a 3D
+		DDA (`skip_empty') instead of sphere tracing them, which saves
+		the many short steps a ray takes while it skims past a surface
+		in a neighbouring cell.
+
+		The grid is a snapshot: `rebuild' after the field changes.
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+class
+	SDF_OCCUPANCY_GRID
+
+create
+	make
+
+feature {NONE} -- Initialization
+
+	make (a_field: SDF_FIELD; a_bounds: SDF_AABB; a_cell_size: REAL_64)
+			-- Classify the cells of `a_field' over `a_bounds' with cells of `a_cell_size'.
+		require
+			field_attached: a_field /= Void
+			bounds_attached: a_bounds /= Void
+			finite_bounds: not a_bounds.is_empty and not a_bounds.is_infinite
+			positive_cell: a_cell_size > 0.0
+		do
+			origin_x := a_bounds.min_x
+			origin_y := a_bounds.min_y
+			origin_z := a_bounds.min_z
+			cell_size := a_cell_size
+			cells_x := ((a_bounds.max_x - a_bounds.min_x) / a_cell_size).ceiling.max (1)
+			cells_y := ((a_bounds.max_y - a_bounds.min_y) / a_cell_size).ceiling.max (1)
+			cells_z := ((a_bounds.max_z - a_bounds.min_z) / a_cell_size).ceiling.max (1)
+			create bits.make_filled ({NATURAL_64} 0, (cell_count + Word_bits - 1) // Word_bits)
+			rebuild (a_field)
+		ensure
+			cell_size_set: cell_size = a_cell_size
+		end
+
+feature -- Access
+
+	origin_x, origin_y, origin_z: REAL_64
+			-- Minimum corner of the grid
+
+	cell_size: REAL_64
+			-- Edge length of a cell
+
+	cells_x, cells_y, cells_z: INTEGER
+			-- Grid size in cells
+
+	occupied_count: INTEGER
+			-- Number of cells that may hold surface
+
+	cell_count: INTEGER
+			-- Number of grid cells
+		do
+			Result := cells_x * cells_y * cells_z
+		end
+
+	empty_count: INTEGER
+			-- Number of cells proven to hold no surface
+		do
+			Result := cell_count - occupied_count
+		end
+
+feature -- Status report
+
+	is_occupied (i, j, k: INTEGER): BOOLEAN
+			-- May cell (i, j, k) (0-based) hold surface?
+		require
+			valid_i: i >= 0 and i < cells_x
+			valid_j: j >= 0 and j < cells_y
+			valid_k: k >= 0 and k < cells_z
+		local
+			l_cell: INTEGER
+		do
+			l_cell := (k * cells_y + j) * cells_x + i
+			Result := bits [l_cell // Word_bits].bit_test (l_cell \\ Word_bits)
+		end
+
+	is_empty_at (a_x, a_y, a_z: REAL_64): BOOLEAN
+			-- Is (x, y, z) inside the grid, in a cell without surface?
+		local
+			fx, fy, fz: REAL_64
+		do
+			fx := (a_x - origin_x) / cell_size
+			fy := (a_y - origin_y) / cell_size
+			fz := (a_z - origin_z) / cell_size
+			if fx >= 0.0 and fy >= 0.0 and fz >= 0.0 and fx < cells_x and fy < cells_y and fz < cells_z then
+				Result := not is_occupied (fx.floor, fy.floor, fz.floor)
+			end
+		end
+
+feature -- Traversal
+
+	skip_empty (a_ox, a_oy, a_oz, a_dx, a_dy, a_dz, a_t, a_t_max: REAL_64): REAL_64
+			-- Walk the ray o + t d from `a_t' through empty cells (3D DDA)
+			-- and return where it enters an occupied cell or leaves the
+			-- grid, at most `a_t_max'. Never evaluates the field and
+			-- never allocates.
+		require
+			ordered: a_t <= a_t_max
+		local
+			i, j, k, si, sj, sk: INTEGER
+			fx, fy, fz, nx, ny, nz, ex, ey, ez, t: REAL_64
+			l_done: BOOLEAN
+		do
+			fx := (a_ox + a_dx * a_t - origin_x) / cell_size
+			fy := (a_oy + a_dy * a_t - origin_y) / cell_size
+			fz := (a_oz + a_dz * a_t - origin_z) / cell_size
+			i := fx.floor.max (0).min (cells_x - 1)
+			j := fy.floor.max (0).min (cells_y - 1)
+			k := fz.floor.max (0).min (cells_z - 1)
+			-- Ray parameter of the next cell face and the spacing of faces per axis
+			si := axis_step (a_dx)
+			sj := axis_step (a_dy)
+			sk := axis_step (a_dz)
+			nx := next_face (a_ox, a_dx, origin_x, i)
+			ny := next_face (a_oy, a_dy, origin_y, j)
+			nz := next_face (a_oz, a_dz, origin_z, k)
+			ex := face_spacing (a_dx)
+			ey := face_spacing (a_dy)
+			ez := face_spacing (a_dz)
+			from
+				t := a_t
+			until
+				l_done or t >= a_t_max
+			loop
+				if nx <= ny and nx <= nz then
+					t := nx
+					nx := nx + ex
+					i := i + si
+				elseif ny <= nz then
+					t := ny
+					ny := ny + ey
+					j := j + sj
+				else
+					t := nz
+					nz := nz + ez
+					k := k + sk
+				end
+				l_done := i < 0 or i >= cells_x or j < 0 or j >= cells_y or k < 0 or k >= cells_z
+					or else is_occupied (i, j, k)
+			end
+			Result := t.max (a_t).min (a_t_max)
+		ensure
+			forward: Result >= a_t
+			bounded: Result <= a_t_max
+		end
+
+feature -- Element change
+
+	rebuild (a_field: SDF_FIELD)
+			-- Classify every cell again against `a_field'.
+		require
+			field_attached: a_field /= Void
+		local
+			l_bounds: SDF_AABB
+			l_cell: INTEGER
+			x0, y0, z0: REAL_64
+			l_occupied: BOOLEAN
+		do
+			l_bounds := a_field.bounds
+			bits.fill_with ({NATURAL_64} 0, 0, bits.count - 1)
+			occupied_count := 0
+			from l_cell := 0 until l_cell >= cell_count loop
+				x0 := origin_x + (l_cell \\ cells_x) * cell_size
+				y0 := origin_y + ((l_cell // cells_x) \\ cells_y) * cell_size
+				z0 := origin_z + (l_cell // (cells_x * cells_y)) * cell_size
+				-- The bounds rule out most cells before any interval evaluation
+				l_occupied := not l_bounds.is_empty
+					and then x0 <= l_bounds.max_x and x0 + cell_size >= l_bounds.min_x
+					and then y0 <= l_bounds.max_y and y0 + cell_size >= l_bounds.min_y
+					and then z0 <= l_bounds.max_z and z0 + cell_size >= l_bounds.min_z
+					and then not a_field.interval_at (x0, y0, z0, x0 + cell_size, y0 + cell_size, z0 + cell_size).is_positive
+				if l_occupied then
+					bits [l_cell // Word_bits] := bits [l_cell // Word_bits].set_bit (True, l_cell \\ Word_bits)
+					occupied_count := occupied_count + 1
+				end
+				l_cell := l_cell + 1
+			end
+		ensure
+			counted: occupied_count <= cell_count
+		end
+
+feature {NONE} -- Implementation
+
+	bits: SPECIAL [NATURAL_64]
+			-- One bit per cell (x fastest), set when the cell is occupied
+
+	axis_step (a_direction: REAL_64): INTEGER
+			-- Cell index change when the ray crosses a face along one axis
+		do
+			if a_direction > 0.0 then
+				Result := 1
+			elseif a_direction < 0.0 then
+				Result := -1
+			end
+		end
+
+	next_face (a_origin, a_direction, a_grid_origin: REAL_64; a_index: INTEGER): REAL_64
+			-- Ray parameter where the ray leaves cell `a_index' along one axis
+		do
+			if a_direction > 0.0 then
+				Result := (a_grid_origin + (a_index + 1) * cell_size - a_origin) / a_direction
+			elseif a_direction < 0.0 then
+				Result := (a_grid_origin + a_index * cell_size - a_origin) / a_direction
+			else
+				Result := {REAL_64}.max_value
+			end
+		end
+
+	face_spacing (a_direction: REAL_64): REAL_64
+			-- Ray parameter between consecutive faces along one axis
+		do
+			if a_direction /= 0.0 then
+				Result := cell_size / a_direction.abs
+			else
+				Result := {REAL_64}.max_value
+			end
+		end
+
+feature {NONE} -- Constants
+
+	Word_bits: INTEGER = 64
+			-- Cells per word of `bits'
+
+invariant
+	bits_attached: bits /= Void
+	bits_fit: bits.count * Word_bits >= cell_count
+	positive_cell_size: cell_size > 0.0
+	valid_occupied_count: occupied_count >= 0 and occupied_count <= cell_count
+
+end
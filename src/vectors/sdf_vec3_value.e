@@ -0,0 +1,176 @@
+note
+	description: "[
+		3D vector with value semantics for allocation-free SDF loops.
+
+		Expanded counterpart of SDF_VEC3: assignment copies the components
+		and every operation returns a new value without touching the GC
+		heap. Use it for temporaries in hot paths (march steps, normal
+		gradients); convert with `to_vec3' when a reference is needed.
+
+		Design by Contract:
+		- Components are never NaN
+		- Normalized vectors have unit length (within tolerance)
+	]"
+	author: "Larry Rix"
+	date: "$Date$"
+	revision: "$Revision$"
+
+expanded class
+	SDF_VEC3_VALUE
+
+create
+	default_create,
+	make,
+	make_from_vec3
+
+feature {NONE} -- Initialization
+
+	make (a_x, a_y, a_z: REAL_64)
+			-- Set components to `a_x', `a_y', `a_z'.
+		do
+			x := a_x
+			y := a_y
+			z := a_z
+		ensure
+			x_set: x = a_x
+			y_set: y = a_y
+			z_set: z = a_z
+		end
+
+	make_from_vec3 (a_vector: SDF_VEC3)
+			-- Copy components of `a_vector'.
+		require
+			vector_attached: a_vector /= Void
+		do
+			x := a_vector.x
+			y := a_vector.y
+			z := a_vector.z
+		ensure
+			x_set: x = a_vector.x
+			y_set: y = a_vector.y
+			z_set: z = a_vector.z
+		end
+
+feature -- Access
+
+	x: REAL_64
+			-- X component
+
+	y: REAL_64
+			-- Y component
+
+	z: REAL_64
+			-- Z component
+
+feature -- Measurement
+
+	length: REAL_64
+			-- Euclidean length (magnitude)
+		do
+			Result := {DOUBLE_MATH}.sqrt (length_squared)
+		ensure
+			non_negative: Result >= 0.0
+		end
+
+	length_squared: REAL_64
+			-- Squared length (avoids sqrt for comparisons)
+		do
+			Result := x * x + y * y + z * z
+		ensure
+			non_negative: Result >= 0.0
+		end
+
+feature -- Status report
+
+	is_zero_vector: BOOLEAN
+			-- Is this the zero vector?
+		do
+			Result := x = 0.0 and y = 0.0 and z = 0.0
+		end
+
+	is_unit_vector: BOOLEAN
+			-- Is this approximately a unit vector?
+		do
+			Result := (length - 1.0).abs < Epsilon
+		end
+
+feature -- Operations (return new values)
+
+	plus alias "+" (other: SDF_VEC3_VALUE): SDF_VEC3_VALUE
+			-- Vector addition
+		do
+			Result.set (x + other.x, y + other.y, z + other.z)
+		end
+
+	minus alias "-" (other: SDF_VEC3_VALUE): SDF_VEC3_VALUE
+			-- Vector subtraction
+		do
+			Result.set (x - other.x, y - other.y, z - other.z)
+		end
+
+	scaled alias "*" (factor: REAL_64): SDF_VEC3_VALUE
+			-- Scalar multiplication
+		do
+			Result.set (x * factor, y * factor, z * factor)
+		end
+
+	plus_scaled (other: SDF_VEC3_VALUE; factor: REAL_64): SDF_VEC3_VALUE
+			-- Current + other * factor (ray point evaluation)
+		do
+			Result.set (x + other.x * factor, y + other.y * factor, z + other.z * factor)
+		end
+
+	dot (other: SDF_VEC3_VALUE): REAL_64
+			-- Dot product
+		do
+			Result := x * other.x + y * other.y + z * other.z
+		end
+
+	normalized: SDF_VEC3_VALUE
+			-- Unit vector in same direction
+		require
+			not_zero: not is_zero_vector
+		local
+			len: REAL_64
+		do
+			len := length
+			Result.set (x / len, y / len, z / len)
+		ensure
+			is_unit: Result.is_unit_vector
+		end
+
+feature -- Element change
+
+	set (a_x, a_y, a_z: REAL_64)
+			-- Set all components.
+		do
+			x := a_x
+			y := a_y
+			z := a_z
+		ensure
+			x_set: x = a_x
+			y_set: y = a_y
+			z_set: z = a_z
+		end
+
+feature -- Conversion
+
+	to_vec3: SDF_VEC3
+			-- Heap-allocated copy
+		do
+			create Result.make (x, y, z)
+		ensure
+			result_attached: Result /= Void
+		end
+
+feature {NONE} -- Constants
+
+	Epsilon: REAL_64 = 1.0e-10
+			-- Tolerance for floating point comparisons
+
+invariant
+	x_is_valid: not x.is_nan
+	y_is_valid: not y.is_nan
+	z_is_valid: not z.is_nan
+
+end
@@ -90,6 +90,44 @@ feature -- Rendering
 			c_draw_buffer_scaled (handle, a_x, a_y, a_dest_width, a_dest_height)
 		end
 
+feature -- SDF Rendering
+
+	render_scene (a_scene: SDF_COMPILED_SCENE; a_cam_x, a_cam_y, a_cam_z, a_cam_yaw, a_cam_pitch: REAL_32)
+			-- Ray march `a_scene' into the buffer with the native multithreaded renderer.
+		require
+			scene_attached: a_scene /= Void
+		do
+			c_render_sdf_compiled (handle, width, height, a_cam_x, a_cam_y, a_cam_z,
+				a_cam_yaw, a_cam_pitch, a_scene.data.item, a_scene.count)
+		end
+
+	render_tape (a_tape: SDF_TAPE; a_cam_x, a_cam_y, a_cam_z, a_cam_yaw, a_cam_pitch: REAL_32)
+			-- Ray march `a_tape' into the buffer with the native tape interpreter.
+		require
+			tape_attached: a_tape /= Void
+			fits_native_registers: a_tape.register_count <= a_tape.Max_native_registers
+		do
+			c_render_sdf_tape (handle, width, height, a_cam_x, a_cam_y, a_cam_z,
+				a_cam_yaw, a_cam_pitch, a_tape.native_code.item, a_tape.instruction_count,
+				a_tape.native_constants.item, a_tape.register_count, a_tape.result_register)
+		end
+
+	render_bricks (a_bricks: SDF_BRICK_FIELD; a_tape: SDF_TAPE; a_cam_x, a_cam_y, a_cam_z, a_cam_yaw, a_cam_pitch: REAL_32)
+			-- Ray march `a_bricks' into the buffer, running `a_tape' (the
+			-- same scene, see SDF_BRICK_FIELD.make_from_scene) where the
+			-- cache has no sample and for normals.
+		require
+			bricks_attached: a_bricks /= Void
+			tape_attached: a_tape /= Void
+			fits_native_registers: a_tape.register_count <= a_tape.Max_native_registers
+		do
+			c_render_sdf_bricks (handle, width, height, a_cam_x, a_cam_y, a_cam_z,
+				a_cam_yaw, a_cam_pitch, a_tape.native_code.item, a_tape.instruction_count,
+				a_tape.native_constants.item, a_tape.register_count, a_tape.result_register,
+				a_bricks.native_grid.item, a_bricks.cells_x, a_bricks.cells_y, a_bricks.cells_z,
+				a_bricks.native_cells.item, a_bricks.native_coarse.item, a_bricks.native_samples.item)
+		end
+
 feature -- Memory Management
 
 	dispose
@@ -154,6 +192,34 @@ feature {NONE} -- C Externals
 			"srl_draw_buffer_scaled((void*)$a_buf, (int)$a_x, (int)$a_y, (int)$a_dw, (int)$a_dh);"
 		end
 
+	c_render_sdf_compiled (a_buf: POINTER; a_w, a_h: INTEGER;
+			a_cam_x, a_cam_y, a_cam_z, a_cam_yaw, a_cam_pitch: REAL_32;
+			a_scene: POINTER; a_count: INTEGER)
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"srl_render_sdf_compiled((void*)$a_buf, (int)$a_w, (int)$a_h, (float)$a_cam_x, (float)$a_cam_y, (float)$a_cam_z, (float)$a_cam_yaw, (float)$a_cam_pitch, (const float*)$a_scene, (int)$a_count);"
+		end
+
+	c_render_sdf_tape (a_buf: POINTER; a_w, a_h: INTEGER;
+			a_cam_x, a_cam_y, a_cam_z, a_cam_yaw, a_cam_pitch: REAL_32;
+			a_code: POINTER; a_count: INTEGER; a_constants: POINTER; a_registers, a_result: INTEGER)
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"srl_render_sdf_tape((void*)$a_buf, (int)$a_w, (int)$a_h, (float)$a_cam_x, (float)$a_cam_y, (float)$a_cam_z, (float)$a_cam_yaw, (float)$a_cam_pitch, (const int*)$a_code, (int)$a_count, (const float*)$a_constants, (int)$a_registers, (int)$a_result);"
+		end
+
+	c_render_sdf_bricks (a_buf: POINTER; a_w, a_h: INTEGER;
+			a_cam_x, a_cam_y, a_cam_z, a_cam_yaw, a_cam_pitch: REAL_32;
+			a_code: POINTER; a_count: INTEGER; a_constants: POINTER; a_registers, a_result: INTEGER;
+			a_grid: POINTER; a_cells_x, a_cells_y, a_cells_z: INTEGER; a_cells, a_coarse, a_samples: POINTER)
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"srl_render_sdf_bricks((void*)$a_buf, (int)$a_w, (int)$a_h, (float)$a_cam_x, (float)$a_cam_y, (float)$a_cam_z, (float)$a_cam_yaw, (float)$a_cam_pitch, (const int*)$a_code, (int)$a_count, (const float*)$a_constants, (int)$a_registers, (int)$a_result, (const float*)$a_grid, (int)$a_cells_x, (int)$a_cells_y, (int)$a_cells_z, (const int*)$a_cells, (const float*)$a_coarse, (const unsigned char*)$a_samples);"
+		end
+
 invariant
 	positive_dimensions: width > 0 and height > 0
 
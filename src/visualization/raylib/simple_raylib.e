@@ -141,6 +141,92 @@ feature -- Drawing
 			c_draw_fps (a_x, a_y)
 		end
 
+feature -- CPU Ray Marching
+
+	set_ray_packets (a_enabled: BOOLEAN)
+			-- Enable or disable SIMD ray packets in the native CPU renderer.
+		do
+			c_set_ray_packets (a_enabled.to_integer)
+		end
+
+	ray_packet_width: INTEGER
+			-- Rays marched together by the native CPU renderer (1 = scalar).
+		do
+			Result := c_ray_packet_width
+		ensure
+			positive: Result >= 1
+		end
+
+	set_tape_pruning (a_enabled: BOOLEAN)
+			-- Enable or disable per-tile tape pruning in the native CPU renderer.
+			-- Each screen tile marches a tape specialized to its view frustum.
+		do
+			c_set_tape_pruning (a_enabled.to_integer)
+		ensure
+			set: is_tape_pruning = a_enabled
+		end
+
+	is_tape_pruning: BOOLEAN
+			-- Does the native CPU renderer prune the tape per tile?
+		do
+			Result := c_tape_pruning /= 0
+		end
+
+	set_depth_prepass (a_enabled: BOOLEAN)
+			-- Enable or disable the cone-marched depth pre-pass in the native CPU renderer.
+			-- Coarse pixel blocks march a bounding cone first, so each ray starts
+			-- at a conservative depth instead of at the camera.
+		do
+			c_set_depth_prepass (a_enabled.to_integer)
+		ensure
+			set: is_depth_prepass = a_enabled
+		end
+
+	is_depth_prepass: BOOLEAN
+			-- Does the native CPU renderer run the cone-marched depth pre-pass?
+		do
+			Result := c_depth_prepass /= 0
+		end
+
+	set_shading_rate (a_rate: INTEGER)
+			-- Set how many pixels the native CPU renderer marches per frame.
+			-- Reduced rates rebuild the other pixels from smooth neighbours
+			-- and march only at edges; the marched pattern alternates per frame.
+		require
+			valid_rate: a_rate = Shading_rate_full or a_rate = Shading_rate_checkerboard
+				or a_rate = Shading_rate_quarter
+		do
+			c_set_shading_rate (a_rate)
+		ensure
+			set: shading_rate = a_rate
+		end
+
+	shading_rate: INTEGER
+			-- Pixels marched by the native CPU renderer (see `set_shading_rate').
+		do
+			Result := c_shading_rate
+		end
+
+	set_relaxation (a_omega: REAL)
+			-- Set the enhanced sphere tracing factor of the native CPU renderer.
+			-- Rays step `a_omega' times the distance and fall back to plain
+			-- steps once consecutive unbounding spheres stop overlapping;
+			-- 1 is plain sphere tracing.
+		require
+			at_least_one: a_omega >= 1.0
+			at_most_max: a_omega <= Max_relaxation
+		do
+			c_set_relaxation (a_omega)
+		ensure
+			set: relaxation = a_omega
+		end
+
+	relaxation: REAL
+			-- Enhanced sphere tracing factor of the native CPU renderer.
+		do
+			Result := c_relaxation
+		end
+
 feature -- Buffer Factory
 
 	buffer (a_width, a_height: INTEGER): RAYLIB_BUFFER
@@ -219,6 +305,20 @@ feature -- Key Constants
 	Key_w: INTEGER = 87
 	Key_q: INTEGER = 81
 
+feature -- Renderer Constants
+
+	Shading_rate_full: INTEGER = 0
+			-- March every pixel.
+
+	Shading_rate_checkerboard: INTEGER = 1
+			-- March half the pixels in a checkerboard.
+
+	Shading_rate_quarter: INTEGER = 2
+			-- March one pixel per 2x2 block.
+
+	Max_relaxation: REAL = 1.9
+			-- Largest accepted `set_relaxation' factor.
+
 feature -- Mouse Button Constants
 
 	Mouse_left: INTEGER = 0
@@ -325,6 +425,76 @@ feature {NONE} -- C Externals
 			"srl_draw_fps((int)$a_x, (int)$a_y);"
 		end
 
+	c_set_ray_packets (a_enabled: INTEGER)
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"srl_set_ray_packets((int)$a_enabled);"
+		end
+
+	c_ray_packet_width: INTEGER
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"return srl_ray_packet_width();"
+		end
+
+	c_set_tape_pruning (a_enabled: INTEGER)
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"srl_set_tape_pruning((int)$a_enabled);"
+		end
+
+	c_tape_pruning: INTEGER
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"return srl_tape_pruning();"
+		end
+
+	c_set_depth_prepass (a_enabled: INTEGER)
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"srl_set_depth_prepass((int)$a_enabled);"
+		end
+
+	c_depth_prepass: INTEGER
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"return srl_depth_prepass();"
+		end
+
+	c_set_shading_rate (a_rate: INTEGER)
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"srl_set_shading_rate((int)$a_rate);"
+		end
+
+	c_shading_rate: INTEGER
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"return srl_shading_rate();"
+		end
+
+	c_set_relaxation (a_omega: REAL)
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"srl_set_relaxation((float)$a_omega);"
+		end
+
+	c_relaxation: REAL
+		external
+			"C inline use %"simple_raylib.h%""
+		alias
+			"return srl_relaxation();"
+		end
+
 	c_is_key_down (a_key: INTEGER): INTEGER
 		external
 			"C inline use %"simple_raylib.h%""
@@ -64,7 +64,7 @@ feature {NONE} -- Initialization
 					if l_pipeline.is_valid then
 						l_out := l_vk.create_buffer (l_ctx, (a_width * a_height * 4).to_integer_64,
 							l_vk.Buffer_storage | l_vk.Buffer_transfer)
-						l_par := l_vk.create_buffer (l_ctx, 32, l_vk.Buffer_storage)
+						l_par := l_vk.create_buffer (l_ctx, Params_size, l_vk.Buffer_storage)
 						output_buffer := l_out
 						params_buffer := l_par
 
@@ -79,7 +79,7 @@ feature {NONE} -- Initialization
 
 			-- Create pixel buffer and params
 			create pixels.make (width * height * 4)
-			create params.make (32)
+			create params.make (Params_size)
 
 			-- Create BITMAPINFO for SetDIBitsToDevice
 			create bitmap_info.make (40 + 12) -- BITMAPINFOHEADER = 40, plus 3 DWORD masks
@@ -122,6 +122,24 @@ feature -- Camera
 			camera_z := a_z
 		end
 
+feature -- Shading Rate
+
+	shading_rate: INTEGER
+			-- Pixels the shader marches per frame (a {SDF_GLSL_BUILDER} shading rate).
+
+	set_shading_rate (a_rate: INTEGER)
+			-- Match the dispatch to a shader generated with
+			-- {SDF_GLSL_BUILDER}.set_shading_rate (`a_rate').
+		require
+			valid_rate: a_rate = {SDF_GLSL_BUILDER}.Shading_rate_full
+				or a_rate = {SDF_GLSL_BUILDER}.Shading_rate_checkerboard
+				or a_rate = {SDF_GLSL_BUILDER}.Shading_rate_quarter
+		do
+			shading_rate := a_rate
+		ensure
+			set: shading_rate = a_rate
+		end
+
 feature -- Execution
 
 	run
@@ -268,6 +286,7 @@ feature {NONE} -- Rendering
 			-- Render one frame via Vulkan compute.
 		local
 			dt: REAL
+			tile_w, tile_h: INTEGER
 		do
 			dt := 0.016  -- ~60 FPS target
 
@@ -288,9 +307,21 @@ feature {NONE} -- Rendering
 				params.put_real_32 (time, 20)
 				params.put_natural_32 (width.to_natural_32, 24)
 				params.put_natural_32 (height.to_natural_32, 28)
+				params.put_natural_32 (frame_index, 56)
+				frame_index := frame_index + 1
+
+				-- Reduced-rate shaders cover 2x1 or 2x2 pixels per invocation
+				tile_w := 16
+				tile_h := 16
+				if shading_rate /= {SDF_GLSL_BUILDER}.Shading_rate_full then
+					tile_w := 32
+				end
+				if shading_rate = {SDF_GLSL_BUILDER}.Shading_rate_quarter then
+					tile_h := 32
+				end
 
-				pb.upload (params.item, 32, 0).do_nothing
-				p.dispatch (c, (width + 15) // 16, (height + 15) // 16, 1).do_nothing
+				pb.upload (params.item, Params_size, 0).do_nothing
+				p.dispatch (c, (width + tile_w - 1) // tile_w, (height + tile_h - 1) // tile_h, 1).do_nothing
 				p.wait_idle (c)
 				ob.download (pixels.item, (width * height * 4).to_integer_64, 0).do_nothing
 			end
@@ -423,8 +454,13 @@ feature {NONE} -- Implementation
 
 	running: BOOLEAN
 	frame_count: INTEGER
+	frame_index: NATURAL_32
+			-- Frames rendered, passed to the shader to alternate its shading pattern
 	fps_time: REAL
 
+	Params_size: INTEGER = 64
+			-- Bytes of the shader parameter block (layout of {SDF_GLSL_BUILDER}.emit_compute_header).
+
 	shader_directory: STRING
 		local
 			env: EXECUTION_ENVIRONMENT
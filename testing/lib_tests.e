@@ -443,6 +443,810 @@ feature -- Test: Scene
 			assert ("smooth_blends_inward", d_smooth < d_sharp)
 		end
 
+	test_scene_compilation
+			-- Test SDF_SCENE flattening into compiled entry records.
+		local
+			scene: SDF_SCENE
+			box: SDF_BOX
+			compiled: SDF_COMPILED_SCENE
+		do
+			create scene.make
+			create box.make (2.0, 4.0, 6.0)
+			box.set_position (create {SDF_VEC3}.make (1.0, 2.0, 3.0)).do_nothing
+			scene.add (create {SDF_SPHERE}.make (0.5)).do_nothing
+			scene.add_smooth_subtraction (box, 0.25).do_nothing
+
+			compiled := scene.compiled
+			assert ("two_entries", compiled.count = 2)
+			assert ("sphere_kind", compiled.kind (1) = box.Kind_sphere)
+			assert ("sphere_radius", compiled.parameter (1, 3) = {REAL_32} 0.5)
+			assert ("box_kind", compiled.kind (2) = box.Kind_box)
+			assert ("box_operation", compiled.operation (2) = 2)
+			assert ("box_blend", compiled.blend (2) = {REAL_32} 0.25)
+			assert ("box_center_z", compiled.parameter (2, 2) = {REAL_32} 3.0)
+			assert ("box_half_height", compiled.parameter (2, 4) = {REAL_32} 2.0)
+			assert ("unused_slot_zero", compiled.parameter (2, 6) = {REAL_32} 0.0)
+		end
+
+	test_scalar_distance_path
+			-- Test allocation-free `distance_at' against vector `distance'.
+		local
+			scene: SDF_SCENE
+			torus: SDF_TORUS
+			p: SDF_VEC3
+			v: SDF_VEC3_VALUE
+		do
+			create torus.make (1.0, 0.25)
+			torus.translate_xyz (0.5, 0.0, 0.0).do_nothing
+			create scene.make
+			scene.add (create {SDF_SPHERE}.make (1.0)).do_nothing
+			scene.add_smooth_union (torus, 0.3).do_nothing
+
+			create p.make (0.7, 0.4, -1.2)
+			assert ("shape_matches", (torus.distance_at (0.7, 0.4, -1.2) - torus.distance (p)).abs < Epsilon)
+			assert ("scene_matches", (scene.distance_at (0.7, 0.4, -1.2) - scene.distance (p)).abs < Epsilon)
+
+			create v.make (1.0, 2.0, 2.0)
+			assert ("value_length", (v.length - 3.0).abs < Epsilon)
+			assert ("value_plus_scaled", (v.plus_scaled (v, 2.0).x - 3.0).abs < Epsilon)
+			assert ("value_to_vec3", v.to_vec3.z = 2.0)
+			assert ("shape_value_matches", (torus.distance_value (v) - torus.distance (v.to_vec3)).abs < Epsilon)
+		end
+
+	test_scene_tape
+			-- Test tape compilation, register allocation and freezing.
+		local
+			scene: SDF_SCENE
+			capsule: SDF_CAPSULE
+			outsider: SDF_SPHERE
+			tape: SDF_TAPE
+			frozen: detachable SDF_TAPE
+			d: REAL_64
+		do
+			create scene.make
+			create capsule.make (create {SDF_VEC3}.make (-1.0, 0.0, 0.0), create {SDF_VEC3}.make (1.0, 0.5, 0.0), 0.3)
+			scene.add (create {SDF_SPHERE}.make (1.0)).do_nothing
+			scene.add_smooth_union (capsule, 0.2).do_nothing
+			scene.add_subtraction (create {SDF_BOX}.make (0.5, 0.5, 4.0)).do_nothing
+			scene.add_smooth_intersection (create {SDF_SPHERE}.make (3.0), 0.4).do_nothing
+			scene.add_smooth_subtraction (create {SDF_TORUS}.make (1.0, 0.2), 0.1).do_nothing
+
+			tape := scene.tape
+			assert ("nine_instructions", tape.instruction_count = 9)
+			assert ("two_registers", tape.register_count = 2)
+			assert ("smooth_opcode", tape.opcode (3) = tape.Opcode_smooth_union)
+			assert ("sharp_opcode", tape.opcode (5) = tape.Opcode_subtraction)
+
+			d := scene.distance_at (0.3, 0.9, -0.2)
+			assert ("tape_matches_scene", (tape.distance_at (0.3, 0.9, -0.2) - d).abs < Epsilon)
+			assert ("tape_matches_inside", (tape.distance_at (1.2, 0.1, 0.0) - scene.distance_at (1.2, 0.1, 0.0)).abs < Epsilon)
+
+			scene.freeze
+			assert ("frozen", scene.is_frozen)
+			assert ("frozen_matches", (scene.distance_at (0.3, 0.9, -0.2) - d).abs < Epsilon)
+			frozen := scene.frozen_tape
+			create outsider.make (1.0)
+			outsider.set_position (create {SDF_VEC3}.make (5.0, 0.0, 0.0)).do_nothing
+			assert ("outside_move_ignored", (scene.distance_at (0.3, 0.9, -0.2) - d).abs < Epsilon)
+			assert ("outside_move_keeps_tape", scene.frozen_tape = frozen)
+			capsule.translate_xyz (0.0, 0.5, 0.0).do_nothing
+			assert ("frozen_follows_moves", scene.is_frozen and (scene.distance_at (0.3, 0.9, -0.2) - d).abs > Epsilon)
+			assert ("frozen_relowered", (scene.distance_at (0.3, 0.9, -0.2) - scene.tape.distance_at (0.3, 0.9, -0.2)).abs < Epsilon)
+			assert ("frozen_dual_relowered", (scene.dual_at (0.3, 0.9, -0.2).value - scene.distance_at (0.3, 0.9, -0.2)).abs < Epsilon)
+			scene.add (create {SDF_SPHERE}.make (0.1)).do_nothing
+			assert ("thawed_by_add", not scene.is_frozen)
+		end
+
+	test_scene_hierarchy
+			-- Test BVH culling matches the plain fold and follows moved shapes.
+		local
+			scene: SDF_SCENE
+			sphere: SDF_SPHERE
+			moved: detachable SDF_SPHERE
+			i: INTEGER
+			d: REAL_64
+		do
+			create scene.make
+			from i := 0 until i >= 20 loop
+				create sphere.make (0.5)
+				sphere.translate_xyz (i * 2.0, 0.0, 0.0).do_nothing
+				scene.add_union (sphere).do_nothing
+				if i = 10 then
+					moved := sphere
+				end
+				i := i + 1
+			end
+			scene.add_subtraction (create {SDF_BOX}.make (1.0, 1.0, 1.0)).do_nothing
+
+			d := scene.distance_at (7.1, 0.8, 0.2)
+			scene.enable_hierarchy
+			assert ("same_distance", (scene.distance_at (7.1, 0.8, 0.2) - d).abs < Epsilon)
+			if attached scene.hierarchy as h then
+				assert ("two_segments", h.segment_count = 2)
+				assert ("one_bvh", h.hierarchy_count = 1)
+				assert ("culled", h.last_evaluated_count < scene.count)
+			else
+				assert ("hierarchy_built", False)
+			end
+
+			if attached moved as m then
+				m.set_position (create {SDF_VEC3}.make (7.0, 3.0, 0.0)).do_nothing
+				assert ("follows_move", (scene.distance_at (7.0, 3.0, 0.0) + 0.5).abs < Epsilon)
+				scene.disable_hierarchy
+				assert ("matches_fold_after_move", (scene.distance_at (7.0, 3.0, 0.0) + 0.5).abs < Epsilon)
+			end
+		end
+
+	test_interval_bounds
+			-- Test interval evaluation bounds every sample of a region.
+		local
+			scene: SDF_SCENE
+			tape: SDF_TAPE
+			region: SDF_AABB
+			bounds, tape_bounds: SDF_INTERVAL
+			i, j, k: INTEGER
+			x, y, z, d: REAL_64
+			contained: BOOLEAN
+		do
+			create scene.make
+			scene.add (create {SDF_BOX}.make (1.0, 0.5, 0.8)).do_nothing
+			scene.add_smooth_union (create {SDF_SPHERE}.make (0.7), 0.3).do_nothing
+			scene.add_subtraction (create {SDF_CYLINDER}.make (2.0, 0.3)).do_nothing
+			scene.add_union ((create {SDF_TORUS}.make (1.0, 0.2)).translate_xyz (0.0, 1.0, 0.0)).do_nothing
+			scene.add_union (create {SDF_CAPSULE}.make (create {SDF_VEC3}.make (-1.0, -1.0, 0.0), create {SDF_VEC3}.make (1.0, -1.0, 0.5), 0.2)).do_nothing
+			tape := scene.tape
+
+			create region.make (-0.4, 0.3, -0.6, 0.9, 1.2, 0.2)
+			bounds := scene.distance_interval (region)
+			tape_bounds := tape.distance_interval (region)
+			contained := True
+			from i := 0 until i > 4 loop
+				from j := 0 until j > 4 loop
+					from k := 0 until k > 4 loop
+						x := region.min_x + (region.max_x - region.min_x) * i / 4
+						y := region.min_y + (region.max_y - region.min_y) * j / 4
+						z := region.min_z + (region.max_z - region.min_z) * k / 4
+						d := scene.distance_at (x, y, z)
+						contained := contained and bounds.lo <= d + Epsilon and bounds.hi >= d - Epsilon
+							and tape_bounds.lo <= d + Epsilon and tape_bounds.hi >= d - Epsilon
+						k := k + 1
+					end
+					j := j + 1
+				end
+				i := i + 1
+			end
+			assert ("samples_inside_interval", contained)
+			assert ("tape_matches_fold", (tape_bounds.lo - bounds.lo).abs < Epsilon and (tape_bounds.hi - bounds.hi).abs < Epsilon)
+
+			bounds := scene.interval_at (5.0, 5.0, 5.0, 6.0, 6.0, 6.0)
+			assert ("far_region_empty", bounds.is_positive)
+			bounds := (create {SDF_SPHERE}.make (1.0)).interval_at (-0.1, -0.1, -0.1, 0.1, 0.1, 0.1)
+			assert ("inside_sphere", bounds.is_negative)
+		end
+
+	test_tape_pruning
+			-- Test a tape pruned to a region keeps its distances there.
+		local
+			scene: SDF_SCENE
+			tape, local_tape: SDF_TAPE
+			region: SDF_AABB
+			i: INTEGER
+			x: REAL_64
+			same: BOOLEAN
+		do
+			create scene.make
+			from i := 0 until i >= 20 loop
+				scene.add_union ((create {SDF_SPHERE}.make (0.5)).translate_xyz (i * 2.0, 0.0, 0.0)).do_nothing
+				i := i + 1
+			end
+			scene.add_smooth_union ((create {SDF_BOX}.make (1.0, 1.0, 1.0)).translate_xyz (21.0, 0.0, 0.0), 0.2).do_nothing
+			scene.add_subtraction ((create {SDF_SPHERE}.make (0.3)).translate_xyz (20.0, 0.5, 0.0)).do_nothing
+			tape := scene.tape
+
+			create region.make (9.0, -1.0, -1.0, 11.0, 1.0, 1.0)
+			local_tape := tape.pruned (region)
+			assert ("less_work", local_tape.constants.count < tape.constants.count // 4)
+			same := True
+			from x := 9.0 until x > 11.0 loop
+				same := same and (local_tape.distance_at (x, 0.7, -0.3) - tape.distance_at (x, 0.7, -0.3)).abs < Epsilon
+				x := x + 0.25
+			end
+			assert ("same_in_region", same)
+
+			create region.make (19.5, -0.5, -0.5, 20.5, 0.8, 0.5)
+			local_tape := tape.pruned (region)
+			assert ("keeps_subtraction", (local_tape.distance_at (20.0, 0.45, 0.0) - tape.distance_at (20.0, 0.45, 0.0)).abs < Epsilon)
+		end
+
+	test_lipschitz_bound
+			-- Test smooth and sharp operations keep the Lipschitz bound of their inputs.
+		local
+			scene: SDF_SCENE
+			ops: SDF_OPS
+			i, j: INTEGER
+			x, y, z, dx, dy, dz, l_bound: REAL_64
+			bounded: BOOLEAN
+		do
+			create scene.make
+			scene.add (create {SDF_BOX}.make (1.0, 0.5, 0.8)).do_nothing
+			scene.add_smooth_union (create {SDF_SPHERE}.make (0.7), 0.5).do_nothing
+			scene.add_smooth_subtraction (create {SDF_CYLINDER}.make (2.0, 0.3), 0.2).do_nothing
+			scene.add_smooth_intersection (create {SDF_SPHERE}.make (1.2), 0.4).do_nothing
+			l_bound := scene.lipschitz_bound
+			assert ("scene_bound", (l_bound - 1.0).abs < Epsilon)
+			assert ("compiled_bound", scene.compiled.lipschitz_bound = l_bound)
+			assert ("tape_bound", scene.tape.lipschitz_bound = l_bound)
+			assert ("bound_kept", scene.lipschitz_bound = l_bound)
+
+			-- |f(p) - f(q)| <= L * |p - q| for close pairs across the blends
+			bounded := True
+			from i := 0 until i > 20 loop
+				from j := 0 until j > 20 loop
+					x := -1.5 + i * 0.15
+					y := -1.0 + j * 0.1
+					z := 0.05 * i - 0.5
+					dx := 0.01
+					dy := -0.007
+					dz := 0.004
+					bounded := bounded and (scene.distance_at (x + dx, y + dy, z + dz) - scene.distance_at (x, y, z)).abs
+						<= l_bound * {DOUBLE_MATH}.sqrt (dx * dx + dy * dy + dz * dz) + Epsilon
+					j := j + 1
+				end
+				i := i + 1
+			end
+			assert ("samples_bounded", bounded)
+			scene.clear
+			assert ("cleared_bound", scene.lipschitz_bound = 1.0)
+
+			create ops
+			assert ("union_takes_max", ops.lipschitz_union (2.0, 1.0) = 2.0)
+			assert ("smooth_takes_max", ops.lipschitz_smooth (1.0, 3.0, 0.5) = 3.0)
+		end
+
+	test_dual_gradient
+			-- Test dual evaluation returns the distance and the gradient central differences see.
+		local
+			scene: SDF_SCENE
+			marcher: SDF_RAY_MARCHER
+			d, t: SDF_DUAL
+			i: INTEGER
+			x, y, z, h, gx, gy, gz: REAL_64
+			l_value, l_gradient, l_tape: BOOLEAN
+			n, m: SDF_VEC3
+		do
+			create scene.make
+			scene.add (create {SDF_BOX}.make (1.0, 0.5, 0.8)).do_nothing
+			scene.add_smooth_union ((create {SDF_SPHERE}.make (0.7)).translate_xyz (0.6, 0.3, 0.0), 0.5).do_nothing
+			scene.add_smooth_subtraction (create {SDF_CYLINDER}.make (2.0, 0.3), 0.2).do_nothing
+			scene.add_union ((create {SDF_TORUS}.make (1.0, 0.2)).translate_xyz (0.0, -0.8, 0.0)).do_nothing
+
+			l_value := True
+			l_gradient := True
+			h := 0.00001
+			from i := 0 until i > 40 loop
+				x := -1.3 + i * 0.07
+				y := 0.9 - i * 0.045
+				z := 0.35 - i * 0.02
+				d := scene.dual_at (x, y, z)
+				l_value := l_value and (d.value - scene.distance_at (x, y, z)).abs < Epsilon
+				gx := (scene.distance_at (x + h, y, z) - scene.distance_at (x - h, y, z)) / (2.0 * h)
+				gy := (scene.distance_at (x, y + h, z) - scene.distance_at (x, y - h, z)) / (2.0 * h)
+				gz := (scene.distance_at (x, y, z + h) - scene.distance_at (x, y, z - h)) / (2.0 * h)
+				l_gradient := l_gradient and (d.dx - gx).abs < 0.001 and (d.dy - gy).abs < 0.001 and (d.dz - gz).abs < 0.001
+				i := i + 1
+			end
+			assert ("values_match", l_value)
+			assert ("gradients_match", l_gradient)
+
+			-- The tape runs the same program on duals
+			l_tape := True
+			from i := 0 until i > 40 loop
+				x := -1.3 + i * 0.07
+				y := 0.9 - i * 0.045
+				z := 0.35 - i * 0.02
+				d := scene.dual_at (x, y, z)
+				t := scene.tape.dual_at (x, y, z)
+				l_tape := l_tape and (t.value - d.value).abs < Epsilon and (t.dx - d.dx).abs < Epsilon
+					and (t.dy - d.dy).abs < Epsilon and (t.dz - d.dz).abs < Epsilon
+				i := i + 1
+			end
+			assert ("tape_matches", l_tape)
+
+			-- Marcher normals come from the dual gradient
+			create marcher.make_default
+			n := marcher.normal_at (scene, 0.0, 0.5, 0.45)
+			m := marcher.difference_normal_at (scene, 0.0, 0.5, 0.45)
+			assert ("normals_agree", n.dot (m) > 0.999)
+		end
+
+	test_dual_hierarchy_after_move
+			-- Test gradients follow moved shapes when the hierarchy overrides a frozen tape.
+		local
+			scene: SDF_SCENE
+			sphere: SDF_SPHERE
+			d: SDF_DUAL
+		do
+			create scene.make
+			create sphere.make (1.0)
+			scene.add (sphere).do_nothing
+			scene.add ((create {SDF_BOX}.make (0.5, 0.5, 0.5)).translate_xyz (0.0, -4.0, 0.0)).do_nothing
+			scene.freeze
+			scene.enable_hierarchy
+			sphere.set_position (create {SDF_VEC3}.make (3.0, 0.0, 0.0)).do_nothing
+
+			d := scene.dual_at (3.0, 2.0, 0.0)
+			assert ("value_moved", (d.value - scene.distance_at (3.0, 2.0, 0.0)).abs < Epsilon)
+			assert ("value_new", (d.value - 1.0).abs < Epsilon)
+			assert ("gradient_moved", d.dx.abs < Epsilon and (d.dy - 1.0).abs < Epsilon and d.dz.abs < Epsilon)
+		end
+
+	test_primitive_groups
+			-- Test union runs of spheres and boxes compile to groups that keep the fold's distances.
+		local
+			scene: SDF_SCENE
+			tape, local_tape: SDF_TAPE
+			region: SDF_AABB
+			d, t: SDF_DUAL
+			i: INTEGER
+			x: REAL_64
+			same: BOOLEAN
+		do
+			create scene.make
+			from i := 0 until i >= 12 loop
+				if i \\ 3 = 0 then
+					scene.add_union ((create {SDF_BOX}.make (0.4, 0.4, 0.4)).translate_xyz (i * 1.5, 0.0, 0.0)).do_nothing
+				else
+					scene.add_union ((create {SDF_SPHERE}.make (0.5)).translate_xyz (i * 1.5, 0.2, 0.0)).do_nothing
+				end
+				i := i + 1
+			end
+			scene.add_smooth_union ((create {SDF_TORUS}.make (1.0, 0.2)).translate_xyz (3.0, 1.0, 0.0), 0.3).do_nothing
+			scene.add_union ((create {SDF_SPHERE}.make (0.3)).translate_xyz (6.0, 1.0, 0.0)).do_nothing
+			tape := scene.tape
+
+			-- Sphere group, box group, union; torus, smooth union; lone sphere, union
+			assert ("seven_instructions", tape.instruction_count = 7)
+			assert ("sphere_group", tape.opcode (1) = tape.Opcode_sphere_group and tape.member_count (1) = 8)
+			assert ("box_group", tape.opcode (2) = tape.Opcode_box_group and tape.member_count (2) = 4)
+			assert ("lone_sphere", tape.opcode (6) = tape.Opcode_sphere)
+
+			same := True
+			from x := -1.0 until x > 18.0 loop
+				d := scene.dual_at (x, 0.3, -0.4)
+				t := tape.dual_at (x, 0.3, -0.4)
+				same := same and (tape.distance_at (x, 0.3, -0.4) - scene.distance_at (x, 0.3, -0.4)).abs < Epsilon
+					and (tape.distance_at_32 (x.truncated_to_real, (0.3).truncated_to_real, (-0.4).truncated_to_real) - d.value).abs < 0.001
+					and (t.value - d.value).abs < Epsilon and (t.dx - d.dx).abs < Epsilon and (t.dy - d.dy).abs < Epsilon
+				x := x + 0.35
+			end
+			assert ("same_as_fold", same)
+
+			-- Pruning keeps only the members that can be nearest
+			create region.make (5.7, -0.3, -0.3, 6.3, 0.5, 0.3)
+			local_tape := tape.pruned (region)
+			assert ("group_narrowed", local_tape.opcode (1) = local_tape.Opcode_sphere)
+			same := True
+			from x := 5.7 until x > 6.3 loop
+				same := same and (local_tape.distance_at (x, 0.4, 0.1) - tape.distance_at (x, 0.4, 0.1)).abs < Epsilon
+				x := x + 0.1
+			end
+			assert ("same_in_region", same)
+		end
+
+	test_scene_group
+			-- Test group nodes scope their operations, match their tape and cull far subtrees.
+		local
+			root, cluster, row, cut: SDF_SCENE_GROUP
+			sphere: SDF_SPHERE
+			moved: detachable SDF_SPHERE
+			tape: SDF_TAPE
+			i, k: INTEGER
+			x: REAL_64
+			same: BOOLEAN
+		do
+			-- A small sphere and three rows of five spheres along x
+			create cluster.make
+			cluster.add (create {SDF_SPHERE}.make (0.3)).do_nothing
+			from k := 0 until k >= 3 loop
+				create row.make
+				from i := 0 until i >= 5 loop
+					create sphere.make (0.5)
+					sphere.translate_xyz (3.0 + (k * 5 + i) * 2.0, 0.0, 0.0).do_nothing
+					row.add_union (sphere).do_nothing
+					if k = 1 and i = 0 then
+						moved := sphere
+					end
+					i := i + 1
+				end
+				cluster.add_group (row, {SDF_SCENE}.Op_union, 0.0).do_nothing
+				k := k + 1
+			end
+			-- A cube with a hole, cutting nothing outside its own group
+			create cut.make
+			cut.add (create {SDF_BOX}.make_cube (2.0)).add_subtraction (create {SDF_SPHERE}.make (0.6)).do_nothing
+			create root.make
+			root.add_group (cluster, {SDF_SCENE}.Op_union, 0.0).add_group (cut, {SDF_SCENE}.Op_union, 0.0).do_nothing
+			assert ("shape_count", root.shape_count = 18)
+
+			assert ("scoped_cut", (root.distance_at (0.0, 0.0, 0.0) + 0.3).abs < Epsilon)
+			assert ("cut_in_group", (root.distance_at (0.5, 0.0, 0.0) - 0.1).abs < Epsilon)
+
+			tape := root.tape
+			same := True
+			from x := -2.0 until x > 32.0 loop
+				same := same and (root.distance_at (x, 0.4, 0.1) - tape.distance_at (x, 0.4, 0.1)).abs < Epsilon
+				x := x + 0.7
+			end
+			assert ("same_as_tape", same)
+			assert ("same_as_dual", (root.dual_at (6.2, 0.3, 0.0).value - root.distance_at (6.2, 0.3, 0.0)).abs < Epsilon)
+
+			x := root.distance_at (30.0, 0.8, 0.0)
+			assert ("culled", root.last_evaluated_count < root.shape_count // 2)
+
+			if attached moved as m then
+				m.set_position (create {SDF_VEC3}.make (0.0, 3.0, 0.0)).do_nothing
+				assert ("follows_move", (root.distance_at (0.0, 3.0, 0.0) + 0.5).abs < Epsilon)
+				assert ("tape_after_move", (root.tape.distance_at (0.0, 3.0, 0.0) + 0.5).abs < Epsilon)
+			end
+		end
+
+	test_brick_field
+			-- Test the brick cache is sparse, matches the scene near the surface and can be marched.
+		local
+			scene: SDF_SCENE
+			box: SDF_BOX
+			bricks: SDF_BRICK_FIELD
+			marcher: SDF_RAY_MARCHER
+			hit: SDF_RAY_HIT
+			x, y, d, e: REAL_64
+			near_ok, far_ok: BOOLEAN
+		do
+			create scene.make
+			scene.add (create {SDF_SPHERE}.make (1.0)).do_nothing
+			create box.make_cube (1.0)
+			box.set_position (create {SDF_VEC3}.make (2.5, 0.0, 0.0)).do_nothing
+			scene.add_union (box).do_nothing
+			create bricks.make_from_scene (scene, create {SDF_AABB}.make (-2.0, -2.0, -2.0, 4.0, 2.0, 2.0), 0.05)
+			assert ("sparse", bricks.brick_count > 0 and bricks.brick_count < bricks.cell_count // 2)
+
+			near_ok := True
+			far_ok := True
+			from x := -1.9 until x > 3.9 loop
+				from y := -1.9 until y > 1.9 loop
+					d := scene.distance_at (x, y, 0.1)
+					e := bricks.distance_at (x, y, 0.1)
+					if d.abs < bricks.band then
+						near_ok := near_ok and (e - d).abs < 0.01
+					elseif d > bricks.band then
+						-- Cells away from the surface give a safe, positive step
+						far_ok := far_ok and e > 0.0 and e <= d + 0.01
+					end
+					y := y + 0.13
+				end
+				x := x + 0.11
+			end
+			assert ("near_surface", near_ok)
+			assert ("safe_far", far_ok)
+			assert ("outside_is_exact", (bricks.distance_at (0.0, 0.0, 5.0) - scene.distance_at (0.0, 0.0, 5.0)).abs < Epsilon)
+
+			create marcher.make_default
+			hit := marcher.march_field (bricks, create {SDF_VEC3}.make (0.0, 0.0, 5.0), create {SDF_VEC3}.make (0.0, 0.0, -1.0))
+			assert ("ray_hit", hit.is_hit)
+			assert ("hit_distance", (hit.distance - 4.0).abs < 0.01)
+		end
+
+	test_clipmap_field
+			-- Test clipmap levels match the scene and only newly exposed slabs are re-evaluated.
+		local
+			scene: SDF_SCENE
+			sphere: SDF_SPHERE
+			clipmap: SDF_CLIPMAP_FIELD
+			marcher: SDF_RAY_MARCHER
+			hit: SDF_RAY_HIT
+		do
+			create scene.make
+			create sphere.make (1.0)
+			scene.add (sphere).do_nothing
+			scene.add_union (create {SDF_PLANE}.make_xz (-1.2)).do_nothing
+			create clipmap.make (scene, 3, 16, 0.1)
+			assert ("not_centered", clipmap.level_at (0.0, 0.0, 3.0) = -1)
+
+			clipmap.update (0.0, 0.0, 3.0)
+			assert ("full_bake", clipmap.refreshed_sample_count = 3 * 16 * 16 * 16)
+			assert ("finest_at_camera", clipmap.level_at (0.0, 0.0, 3.0) = 0)
+			assert ("coarser_away", clipmap.level_at (0.0, 0.3, 1.2) = 2)
+			assert ("near_matches", (clipmap.distance_at (0.3, 0.2, 3.05) - scene.distance_at (0.3, 0.2, 3.05)).abs < 0.01)
+			assert ("far_matches", (clipmap.distance_at (0.0, 0.3, 1.2) - scene.distance_at (0.0, 0.3, 1.2)).abs < 0.05)
+			assert ("outside_is_exact", (clipmap.distance_at (0.0, 0.0, 50.0) - scene.distance_at (0.0, 0.0, 50.0)).abs < Epsilon)
+
+			-- One voxel forward: only one slab of the finest level is new
+			clipmap.update (0.0, 0.0, 3.1)
+			assert ("slab_only", clipmap.refreshed_sample_count = 16 * 16)
+			assert ("slab_matches", (clipmap.distance_at (0.3, 0.2, 3.75) - scene.distance_at (0.3, 0.2, 3.75)).abs < 0.01)
+
+			create marcher.make_default
+			hit := marcher.march_field (clipmap, create {SDF_VEC3}.make (0.0, 0.0, 3.1), create {SDF_VEC3}.make (0.0, 0.0, -1.0))
+			assert ("ray_hit", hit.is_hit)
+			assert ("hit_distance", (hit.distance - 2.1).abs < 0.02)
+
+			-- Editing a shape refreshes the samples it can reach, not the samples near the plane only
+			sphere.set_position (create {SDF_VEC3}.make (0.0, 1.0, 0.0)).do_nothing
+			clipmap.update (0.0, 0.0, 3.1)
+			assert ("edit_refreshes", clipmap.refreshed_sample_count > 0)
+			assert ("edit_is_partial", clipmap.refreshed_sample_count < 3 * 16 * 16 * 16)
+			assert ("follows_edit", (clipmap.distance_at (0.0, 1.0, 2.8) - scene.distance_at (0.0, 1.0, 2.8)).abs < 0.01)
+		end
+
+	test_scene_dirty_regions
+			-- Test scene edits record dirty regions and a brick cache re-bakes only the cells they reach.
+		local
+			scene: SDF_SCENE
+			moved, box: SDF_SHAPE
+			bricks: SDF_BRICK_FIELD
+			regions: ARRAYED_LIST [SDF_AABB]
+			serial, i: INTEGER
+			x, y: REAL_64
+			same: BOOLEAN
+		do
+			create scene.make
+			scene.add (create {SDF_SPHERE}.make (1.0)).do_nothing
+			moved := (create {SDF_SPHERE}.make (0.5)).set_position (create {SDF_VEC3}.make (3.0, 0.0, 0.0))
+			scene.add_union (moved).do_nothing
+			create bricks.make_from_scene (scene, create {SDF_AABB}.make (-2.0, -2.0, -2.0, 5.0, 3.0, 2.0), 0.05)
+			serial := scene.dirty_serial
+			assert ("two_adds", serial = 2)
+
+			-- A move dirties the old and the new bounds
+			moved.set_position (create {SDF_VEC3}.make (3.0, 1.0, 0.0)).do_nothing
+			assert ("not_yet_synced", scene.dirty_serial = serial)
+			scene.sync_dirty_regions
+			assert ("logged", scene.has_dirty_regions_since (serial))
+			regions := scene.dirty_regions_since (serial)
+			assert ("one_region", regions.count = 1)
+			assert ("old_and_new", (regions.first.min_y + 0.5).abs < Epsilon and (regions.first.max_y - 1.5).abs < Epsilon)
+			assert ("only_the_edit", (regions.first.min_x - 2.5).abs < Epsilon)
+
+			bricks.update
+			assert ("partial_rebake", bricks.rebaked_cell_count > 0 and bricks.rebaked_cell_count < bricks.cell_count)
+			same := True
+			from x := -1.9 until x > 4.9 loop
+				from y := -1.9 until y > 2.9 loop
+					if scene.distance_at (x, y, 0.1).abs < bricks.band then
+						same := same and (bricks.distance_at (x, y, 0.1) - scene.distance_at (x, y, 0.1)).abs < 0.01
+					end
+					y := y + 0.07
+				end
+				x := x + 0.09
+			end
+			assert ("follows_move", same)
+
+			-- A burst of edits past the log capacity forces a full re-bake
+			serial := scene.dirty_serial
+			from i := 1 until i > scene.Dirty_log_capacity + 10 loop
+				moved.set_position (create {SDF_VEC3}.make (3.0, 1.0 + (i \\ 2) * 0.1, 0.0)).do_nothing
+				scene.sync_dirty_regions
+				i := i + 1
+			end
+			assert ("overflowed", scene.dirty_serial = serial + scene.Dirty_log_capacity + 10)
+			assert ("log_dropped", not scene.has_dirty_regions_since (serial))
+			bricks.update
+			assert ("full_rebake", bricks.rebaked_cell_count = bricks.cell_count)
+
+			-- A smooth add dirties its bounds widened by the blend
+			serial := scene.dirty_serial
+			box := (create {SDF_BOX}.make_cube (1.0)).set_position (create {SDF_VEC3}.make (-3.0, 0.0, 0.0))
+			scene.add_smooth_union (box, 0.25).do_nothing
+			regions := scene.dirty_regions_since (serial)
+			assert ("widened", (regions.first.min_x - (box.bounds.min_x - 0.25)).abs < Epsilon)
+
+			-- Clearing dirties everything that was there
+			serial := scene.dirty_serial
+			scene.clear
+			regions := scene.dirty_regions_since (serial)
+			assert ("clear_covers_all", regions.first.contains_xyz (0.0, 0.0, 0.0) and regions.first.contains_xyz (3.0, 1.0, 0.0))
+		end
+
+	test_instance_grid
+			-- Test instances share one prototype and the grid matches brute force near the surface.
+		local
+			rock: SDF_BOX
+			inst: SDF_INSTANCE
+			grid: SDF_INSTANCE_GRID
+			i: INTEGER
+			seed: INTEGER_64
+			x, z, d, e: REAL_64
+			near_ok, safe_ok: BOOLEAN
+		do
+			create rock.make (0.8, 0.4, 0.6)
+
+			-- Turned a quarter turn and doubled: half-extents (0.6, 0.4, 0.8)
+			create inst.make_shape (rock)
+			inst := inst.set_offset (10.0, 0.0, 0.0).set_yaw ({DOUBLE_MATH}.pi / 2.0).set_scale (2.0)
+			assert ("instance_x", (inst.distance_at (11.6, 0.0, 0.0) - 1.0).abs < Epsilon)
+			assert ("instance_z", (inst.distance_at (10.0, 0.0, 1.8) - 1.0).abs < Epsilon)
+			assert ("instance_bounds", (inst.bounds.max_x - 10.6).abs < Epsilon)
+			assert ("instance_gradient", (inst.dual_at (10.0, 0.0, 1.8).dz - 1.0).abs < Epsilon)
+
+			-- 1500 scattered rocks, all sharing `rock'
+			create grid.make (2.0)
+			seed := 7
+			from i := 1 until i > 1500 loop
+				create inst.make_shape (rock)
+				seed := (seed * 1103515245 + 12345) \\ 2147483648
+				x := seed / 2147483648.0 * 60.0
+				seed := (seed * 1103515245 + 12345) \\ 2147483648
+				z := seed / 2147483648.0 * 60.0
+				seed := (seed * 1103515245 + 12345) \\ 2147483648
+				d := seed / 2147483648.0
+				grid.extend (inst.set_offset (x, 0.0, z).set_yaw (d * 6.28).set_scale (0.5 + d))
+				i := i + 1
+			end
+			assert ("shared_prototype", grid.instance (1).prototype = rock and grid.instance (1500).prototype = rock)
+			near_ok := True
+			safe_ok := True
+			from x := -3.0 until x > 63.0 loop
+				from z := -3.0 until z > 63.0 loop
+					d := {REAL_64}.max_value
+					from i := 1 until i > grid.count loop
+						d := d.min (grid.instance (i).distance_at (x, 0.3, z))
+						i := i + 1
+					end
+					e := grid.distance_at (x, 0.3, z)
+					safe_ok := safe_ok and e <= d + Epsilon
+					if d < grid.cell_size then
+						near_ok := near_ok and (e - d).abs < Epsilon
+					end
+					z := z + 1.37
+				end
+				x := x + 1.41
+			end
+			assert ("grid_matches", near_ok)
+			assert ("grid_safe", safe_ok)
+			e := grid.distance_at (30.0, 0.3, 30.0)
+			assert ("few_evaluated", grid.last_evaluated_count < 20)
+			e := grid.distance_at (30.0, 40.0, 30.0)
+			assert ("far_above", e >= grid.cell_size and e <= 40.0)
+			assert ("far_free", grid.last_evaluated_count = 0)
+
+			-- Moving one instance reindexes it
+			inst := grid.instance (1).set_offset (100.0, 0.0, 100.0)
+			assert ("moved", grid.distance_at (100.0, 0.0, 100.0) < 0.0)
+		end
+
+	test_instance_rotation
+			-- Test instances turn about any axis exactly like a transformed shape.
+		local
+			rock, turned: SDF_BOX
+			inst: SDF_INSTANCE
+			axis: SDF_VEC3
+			x, y, z: REAL_64
+			same, same_gradient: BOOLEAN
+		do
+			create rock.make (0.8, 0.4, 0.6)
+
+			-- Tipped a quarter turn about +X: half-extents (0.4, 0.3, 0.2)
+			create inst.make_shape (rock)
+			inst := inst.set_offset (0.0, 5.0, 0.0).set_rotation (create {SDF_VEC3}.make (1.0, 0.0, 0.0), {DOUBLE_MATH}.pi / 2.0)
+			assert ("tipped_y", (inst.distance_at (0.0, 6.0, 0.0) - 0.7).abs < Epsilon)
+			assert ("tipped_bounds", (inst.bounds.max_y - 5.3).abs < Epsilon and (inst.bounds.max_z - 0.2).abs < Epsilon)
+			assert ("tipped_gradient", (inst.dual_at (0.0, 6.0, 0.0).dy - 1.0).abs < Epsilon)
+			assert ("tipped_interval", inst.interval_at (-0.1, 5.9, -0.1, 0.1, 6.1, 0.1).has (0.7))
+
+			-- A further quarter turn about +Y composes: half-extents (0.2, 0.3, 0.4)
+			inst := inst.rotate (create {SDF_VEC3}.make (0.0, 1.0, 0.0), {DOUBLE_MATH}.pi / 2.0)
+			assert ("composed_x", (inst.distance_at (1.0, 5.0, 0.0) - 0.8).abs < Epsilon)
+			assert ("composed_bounds", (inst.bounds.max_z - 0.4).abs < Epsilon)
+			assert ("yaw_cleared", inst.yaw = 0.0)
+
+			-- Oblique axis and scale match the same transform on a shape
+			create axis.make (1.0, 2.0, 0.5)
+			create turned.make (0.8, 0.4, 0.6)
+			turned := turned.set_position (create {SDF_VEC3}.make (3.0, 1.0, -2.0)).set_rotation (axis, 0.9).set_scale (1.5)
+			create inst.make_shape (rock)
+			inst := inst.set_offset (3.0, 1.0, -2.0).set_rotation (axis, 0.9).set_scale (1.5)
+			same := True
+			same_gradient := True
+			from x := 1.0 until x > 5.0 loop
+				from y := -1.0 until y > 3.0 loop
+					from z := -4.0 until z > 0.0 loop
+						same := same and (inst.distance_at (x, y, z) - turned.distance_at (x, y, z)).abs < Epsilon
+						same_gradient := same_gradient
+							and (inst.dual_at (x, y, z).dx - turned.dual_at (x, y, z).dx).abs < Epsilon
+							and (inst.dual_at (x, y, z).dz - turned.dual_at (x, y, z).dz).abs < Epsilon
+						z := z + 0.37
+					end
+					y := y + 0.41
+				end
+				x := x + 0.43
+			end
+			assert ("matches_shape", same)
+			assert ("gradient_matches_shape", same_gradient)
+			assert ("bounds_match_shape", (inst.bounds.max_x - turned.bounds.max_x).abs < Epsilon
+				and (inst.bounds.min_y - turned.bounds.min_y).abs < Epsilon)
+		end
+
+	test_repetition
+			-- Test repetition evaluates one copy per sample and matches explicit copies.
+		local
+			ops: SDF_OPS
+			rep: SDF_REPETITION
+			scene: SDF_SCENE
+			capsule: SDF_CAPSULE
+			i, j: INTEGER
+			x, z, d, e: REAL_64
+			near_ok, safe_ok: BOOLEAN
+		do
+			create ops
+			assert ("cell", ops.repeat_cell (5.2, 2.0) = 3)
+			assert ("local", (ops.repeat_local (5.2, 2.0, 3) + 0.8).abs < Epsilon)
+			assert ("mirrored_local", (ops.mirrored_repeat_local (5.2, 2.0, 3) - 0.8).abs < Epsilon)
+			assert ("limited_cell", ops.limited_repeat_cell (50.0, 2.0, 4) = 4)
+			assert ("fixed_axis", ops.repeat_cell (5.2, 0.0) = 0)
+
+			-- Limited grid of spheres against the same spheres in a scene
+			create rep.make_limited (create {SDF_SPHERE}.make (0.4), 2.0, 0.0, 2.0, 3, 0, 3)
+			create scene.make
+			from i := -3 until i > 3 loop
+				from j := -3 until j > 3 loop
+					scene.add_union ((create {SDF_SPHERE}.make (0.4)).set_position (create {SDF_VEC3}.make (2.0 * i, 0.0, 2.0 * j))).do_nothing
+					j := j + 1
+				end
+				i := i + 1
+			end
+			near_ok := True
+			safe_ok := True
+			from x := -9.0 until x > 9.0 loop
+				from z := -9.0 until z > 9.0 loop
+					d := scene.distance_at (x, 0.3, z)
+					e := rep.distance_at (x, 0.3, z)
+					safe_ok := safe_ok and e <= d + Epsilon
+					if d.abs < 0.2 then
+						near_ok := near_ok and (e - d).abs < Epsilon
+					end
+					z := z + 0.37
+				end
+				x := x + 0.41
+			end
+			assert ("limited_matches", near_ok)
+			assert ("limited_safe", safe_ok)
+			assert ("one_copy", rep.last_evaluated_count = 1)
+			assert ("limited_bounds", (rep.bounds.max_x - 6.4).abs < Epsilon)
+
+			-- A capsule longer than its cell: neighbours are checked, never overestimating
+			create capsule.make (create {SDF_VEC3}.make (0.0, 0.0, 0.0), create {SDF_VEC3}.make (1.5, 0.0, 0.0), 0.3)
+			create rep.make_infinite (capsule, 2.0, 0.0, 0.0)
+			create scene.make
+			from i := -8 until i > 8 loop
+				scene.add_union (create {SDF_CAPSULE}.make (create {SDF_VEC3}.make (2.0 * i, 0.0, 0.0), create {SDF_VEC3}.make (2.0 * i + 1.5, 0.0, 0.0), 0.3)).do_nothing
+				i := i + 1
+			end
+			near_ok := True
+			safe_ok := True
+			from x := -5.0 until x > 5.0 loop
+				from z := -1.0 until z > 1.0 loop
+					d := scene.distance_at (x, 0.1, z)
+					e := rep.distance_at (x, 0.1, z)
+					safe_ok := safe_ok and e <= d + Epsilon
+					if d.abs < 0.2 then
+						near_ok := near_ok and (e - d).abs < Epsilon
+					end
+					z := z + 0.13
+				end
+				x := x + 0.07
+			end
+			assert ("crossing_reach", rep.reach_x = 1 and rep.reach_y = 0)
+			assert ("crossing_matches", near_ok)
+			assert ("crossing_safe", safe_ok)
+			assert ("three_copies", rep.last_evaluated_count = 3)
+
+			-- Mirrored: the copy in cell 1 points back towards the origin
+			create capsule.make (create {SDF_VEC3}.make (0.0, 0.0, 0.0), create {SDF_VEC3}.make (0.6, 0.0, 0.0), 0.2)
+			create rep.make_mirrored (capsule, 2.0, 0.0, 0.0)
+			assert ("original_tip", rep.distance_at (0.8, 0.0, 0.0).abs < Epsilon)
+			assert ("mirrored_tip", rep.distance_at (1.2, 0.0, 0.0).abs < Epsilon)
+			assert ("mirrored_gradient", rep.dual_at (1.1, 0.0, 0.0).dx < 0.0)
+		end
+
 feature -- Test: Ray Marcher
 
 	test_ray_march_hit
@@ -500,6 +1304,83 @@ feature -- Test: Ray Marcher
 			assert ("ray_miss", hit.is_miss)
 		end
 
+	test_ray_march_bounds
+			-- Test scene bounds follow the operations and clip marched rays.
+		local
+			marcher: SDF_RAY_MARCHER
+			scene, lens: SDF_SCENE
+			box: SDF_AABB
+			direction: SDF_VEC3
+			clipped, unclipped: SDF_RAY_HIT
+		do
+			create scene.make
+			assert ("empty_scene_empty", scene.bounds.is_empty)
+			scene.add (create {SDF_SPHERE}.make (1.0)).do_nothing
+			scene.add ((create {SDF_SPHERE}.make (0.5)).translate_xyz (3.0, 0.0, 0.0)).do_nothing
+			box := scene.bounds
+			assert ("union_grows", (box.min_x + 1.0).abs < Epsilon and (box.max_x - 3.5).abs < Epsilon)
+			scene.add_subtraction ((create {SDF_BOX}.make (0.5, 0.5, 0.5)).translate_xyz (3.0, 0.0, 0.0)).do_nothing
+			assert ("subtraction_keeps", (scene.bounds.max_x - 3.5).abs < Epsilon)
+
+			create lens.make
+			lens.add (create {SDF_SPHERE}.make (1.0)).do_nothing
+			lens.add_intersection (create {SDF_BOX}.make (4.0, 0.5, 4.0)).do_nothing
+			box := lens.bounds
+			assert ("intersection_shrinks", (box.max_y - 0.25).abs < Epsilon and (box.max_x - 1.0).abs < Epsilon)
+			lens.add_smooth_union ((create {SDF_SPHERE}.make (0.5)).translate_xyz (0.0, 2.0, 0.0), 0.2).do_nothing
+			assert ("smooth_widens", (lens.bounds.max_y - 2.7).abs < Epsilon and (lens.bounds.max_x - 1.2).abs < Epsilon)
+
+			create marcher.make_default
+			create direction.make (0.0, 0.0, 1.0)
+			clipped := marcher.march (scene, create {SDF_VEC3}.make (0.0, 5.0, -5.0), direction)
+			assert ("miss_costs_nothing", clipped.is_miss and clipped.steps = 0)
+			clipped := marcher.march (scene, create {SDF_VEC3}.make (0.0, 0.0, -5.0), direction)
+			unclipped := marcher.march_field (scene.tape, create {SDF_VEC3}.make (0.0, 0.0, -5.0), direction)
+			assert ("same_hit", clipped.is_hit and (clipped.distance - unclipped.distance).abs < 0.01)
+			clipped := marcher.march (scene, create {SDF_VEC3}.make (2.0, 0.9, -5.0), direction)
+			unclipped := marcher.march_field (scene.tape, create {SDF_VEC3}.make (2.0, 0.9, -5.0), direction)
+			assert ("stops_at_exit", clipped.is_miss and unclipped.is_miss and clipped.steps < unclipped.steps)
+		end
+
+	test_ray_march_occupancy
+			-- Test the occupancy grid marks empty cells and lets rays skip them.
+		local
+			marcher: SDF_RAY_MARCHER
+			scene: SDF_SCENE
+			grid: SDF_OCCUPANCY_GRID
+			origin, direction: SDF_VEC3
+			plain, skipped: SDF_RAY_HIT
+			t: REAL_64
+		do
+			create scene.make
+			scene.add (create {SDF_BOX}.make (8.0, 1.0, 8.0)).do_nothing
+			scene.add ((create {SDF_SPHERE}.make (0.5)).translate_xyz (0.0, 3.0, 0.0)).do_nothing
+			create grid.make (scene, scene.bounds, 0.25)
+			assert ("has_empty_cells", grid.empty_count > 0 and grid.occupied_count > 0)
+			assert ("above_floor_empty", grid.is_empty_at (2.0, 0.8, 2.0))
+			assert ("floor_occupied", not grid.is_empty_at (2.0, 0.5, 2.0))
+			assert ("sphere_occupied", not grid.is_empty_at (0.0, 3.4, 0.0))
+			assert ("outside_not_empty", not grid.is_empty_at (0.0, 10.0, 0.0))
+			t := grid.skip_empty (0.1, 3.1, -4.0, 0.0, 0.0, 1.0, 0.5, 20.0)
+			assert ("skip_to_occupied", t > 0.5 and t < 4.0 and grid.is_empty_at (0.1, 3.1, t - 4.01)
+				and not grid.is_empty_at (0.1, 3.1, t - 3.99))
+
+			create marcher.make_default
+			-- Skimming the floor: many short steps without the grid
+			create origin.make (-5.0, 0.8, 0.1)
+			create direction.make (1.0, 0.0, 0.0)
+			plain := marcher.march (scene, origin, direction)
+			skipped := marcher.set_occupancy (grid).march (scene, origin, direction)
+			assert ("both_miss", plain.is_miss and skipped.is_miss)
+			assert ("fewer_steps", skipped.steps < plain.steps)
+
+			-- Hits land in the same place
+			create origin.make (-4.0, 3.0, 0.0)
+			skipped := marcher.march (scene, origin, direction)
+			plain := marcher.set_occupancy (Void).march (scene, origin, direction)
+			assert ("same_hit", skipped.is_hit and plain.is_hit and (skipped.distance - plain.distance).abs < 0.01)
+		end
+
 	test_ray_normal_computation
 			-- Test surface normal computation.
 		local
@@ -520,6 +1401,272 @@ feature -- Test: Ray Marcher
 			assert ("normal_z", normal.z.abs < 0.01)
 		end
 
+	test_ray_march_batch
+			-- Test batched marching into a caller-owned hit buffer.
+		local
+			marcher: SDF_RAY_MARCHER
+			scene: SDF_SCENE
+			rays: SDF_RAY_BATCH
+			hits: SDF_HIT_BUFFER
+			single: SDF_RAY_HIT
+		do
+			create scene.make
+			scene.add (create {SDF_SPHERE}.make (1.0)).do_nothing
+			create marcher.make_default
+			create rays.make (4)
+			create hits.make (4)
+			rays.extend (0.0, 0.0, -5.0, 0.0, 0.0, 1.0)
+			rays.extend (0.0, 5.0, -5.0, 0.0, 0.0, 1.0)
+			rays.extend (3.0, 0.0, 0.0, -1.0, 0.0, 0.0)
+
+			marcher.march_batch (scene, rays, hits, False)
+			assert ("three_results", hits.count = 3)
+			assert ("two_hits", hits.hit_count = 2)
+			assert ("first_hit", hits.is_hit (1))
+			assert ("second_miss", not hits.is_hit (2))
+			assert ("first_depth", (hits.depth (1) - 4.0).abs < 0.01)
+			assert ("normals_deferred", not hits.has_normals)
+
+			marcher.compute_batch_normals (scene, hits)
+			assert ("has_normals", hits.has_normals)
+			assert ("third_normal_x", (hits.normal_x [2] - 1.0).abs < 0.01)
+
+			single := marcher.march (scene, create {SDF_VEC3}.make (0.0, 0.0, -5.0), create {SDF_VEC3}.make (0.0, 0.0, 1.0))
+			assert ("same_depth", hits.depth (1) = single.distance)
+			assert ("same_steps", hits.step_count (1) = single.steps)
+			assert ("same_normal", hits.to_hit (1).normal.z = single.normal.z)
+		end
+
+	test_ray_march_relaxation
+			-- Test enhanced sphere tracing saves steps and survives oversteps.
+		local
+			marcher: SDF_RAY_MARCHER
+			plane, sphere: SDF_SCENE
+			origin, direction: SDF_VEC3
+			plain, relaxed: SDF_RAY_HIT
+		do
+			create plane.make
+			plane.add (create {SDF_PLANE}.make_xz (0.0)).do_nothing
+			create marcher.make_default
+			assert ("relaxed_by_default", marcher.relaxation > 1.0)
+
+			-- Grazing ray: every relaxed step stays inside the unbounding spheres
+			create origin.make (0.0, 1.0, 0.0)
+			direction := (create {SDF_VEC3}.make (0.0, -0.1, -1.0)).normalized
+			relaxed := marcher.march (plane, origin, direction)
+			plain := marcher.set_relaxation (1.0).march (plane, origin, direction)
+			assert ("both_hit", plain.is_hit and relaxed.is_hit)
+			assert ("same_depth", (relaxed.distance - plain.distance).abs < 0.01)
+			assert ("fewer_steps", relaxed.steps < plain.steps)
+
+			-- Head-on ray: the first relaxed step crosses the surface and falls back
+			create sphere.make
+			sphere.add (create {SDF_SPHERE}.make (1.0)).do_nothing
+			create direction.make (0.0, 0.0, -1.0)
+			relaxed := marcher.set_relaxation (1.5).march (sphere, create {SDF_VEC3}.make (0.0, 0.0, 5.0), direction)
+			assert ("overstep_hit", relaxed.is_hit)
+			assert ("overstep_depth", (relaxed.distance - 4.0).abs < 0.01)
+		end
+
+	test_ray_march_mixed_precision
+			-- Test REAL_32 marching with REAL_64 refinement lands on the double-precision hits.
+		local
+			marcher: SDF_RAY_MARCHER
+			scene: SDF_SCENE
+			origin, direction: SDF_VEC3
+			exact, mixed: SDF_RAY_HIT
+			i: INTEGER
+			l_close, l_agree, l_on_surface: BOOLEAN
+			x, y, z: REAL_64
+		do
+			create scene.make
+			scene.add (create {SDF_PLANE}.make_xz (-1.0)).do_nothing
+			scene.add_smooth_union (create {SDF_BOX}.make (1.0, 1.0, 1.0), 0.3).do_nothing
+			scene.add_smooth_union ((create {SDF_SPHERE}.make (0.6)).translate_xyz (0.0, 0.7, 0.0), 0.2).do_nothing
+			scene.freeze
+
+			-- Single-precision tape run tracks the double one
+			l_close := True
+			from i := 0 until i > 20 loop
+				x := -2.0 + i * 0.2
+				y := 1.5 - i * 0.1
+				z := 0.3 * i - 3.0
+				l_close := l_close and (scene.distance_at_32 (x.truncated_to_real, y.truncated_to_real, z.truncated_to_real)
+					- scene.distance_at (x, y, z)).abs < 0.0001
+				i := i + 1
+			end
+			assert ("single_close", l_close)
+
+			create marcher.make_default
+			assert ("double_by_default", marcher.precision = marcher.Precision_double)
+			create origin.make (0.3, 2.0, 6.0)
+			l_agree := True
+			l_on_surface := True
+			from i := 0 until i > 10 loop
+				direction := (create {SDF_VEC3}.make (-0.1 + i * 0.02, -0.3 - i * 0.03, -1.0)).normalized
+				exact := marcher.set_precision (marcher.Precision_double).march (scene, origin, direction)
+				mixed := marcher.set_precision (marcher.Precision_mixed).march (scene, origin, direction)
+				l_agree := l_agree and exact.is_hit = mixed.is_hit
+				if exact.is_hit and mixed.is_hit then
+					l_agree := l_agree and (exact.distance - mixed.distance).abs < 0.01
+					l_on_surface := l_on_surface and scene.distance (mixed.position).abs < marcher.surface_threshold
+				end
+				i := i + 1
+			end
+			assert ("same_hits", l_agree)
+			assert ("refined_on_surface", l_on_surface)
+		end
+
+feature -- Test: GLSL
+
+	test_glsl_depth_prepass
+			-- Test the generated shader starts rays at the cone pre-pass depth.
+		local
+			builder: SDF_GLSL_BUILDER
+			shader: STRING
+		do
+			create builder.make
+			assert ("prepass_by_default", builder.is_depth_prepass)
+			shader := builder.generate_basic_shader ("    return sdSphere(p, vec3(0.0), 1.0);")
+			assert ("has_cone_march", shader.has_substring ("float coneMarch("))
+			assert ("has_shared_depth", shader.has_substring ("shared float fineDepth[64];"))
+			assert ("bounds_after_barrier", shader.substring_index ("barrier();", 1) < shader.substring_index ("return;", 1))
+
+			builder.set_depth_prepass (False)
+			shader := builder.generate_basic_shader ("    return sdSphere(p, vec3(0.0), 1.0);")
+			assert ("no_cone_march", not shader.has_substring ("coneMarch"))
+			assert ("starts_at_camera", shader.has_substring ("float t = 0.0;"))
+		end
+
+	test_glsl_temporal_reprojection
+			-- Test the generated shader reprojects and records depth when enabled.
+		local
+			builder: SDF_GLSL_BUILDER
+			shader: STRING
+		do
+			create builder.make
+			assert ("off_by_default", not builder.is_temporal_reprojection)
+			shader := builder.generate_basic_shader ("    return sdSphere(p, vec3(0.0), 1.0);")
+			assert ("no_depth_buffer", not shader.has_substring ("DepthBuffer"))
+
+			builder.set_temporal_reprojection (True)
+			shader := builder.generate_basic_shader ("    return sdSphere(p, vec3(0.0), 1.0);")
+			assert ("has_buffers", shader.has_substring ("binding = 2") and shader.has_substring ("binding = 3"))
+			assert ("has_previous_camera", shader.has_substring ("prev_yaw"))
+			assert ("has_reprojection_pass", shader.has_substring ("reprojectDepth(gid);"))
+			assert ("keeps_nearest", shader.has_substring ("atomicMin("))
+			assert ("records_depth", shader.has_substring ("depth[gid.y * width + gid.x] = t;"))
+		end
+
+	test_glsl_variable_rate
+			-- Test reduced-rate shaders march one pixel per block and rebuild the rest.
+		local
+			builder: SDF_GLSL_BUILDER
+			shader: STRING
+		do
+			create builder.make
+			assert ("full_by_default", builder.shading_rate = builder.Shading_rate_full)
+			assert ("full_tile", builder.dispatch_tile_width = 16 and builder.dispatch_tile_height = 16)
+
+			builder.set_shading_rate (builder.Shading_rate_checkerboard)
+			assert ("checkerboard_tile", builder.dispatch_tile_width = 32 and builder.dispatch_tile_height = 16)
+			shader := builder.generate_basic_shader ("    return sdSphere(p, vec3(0.0), 1.0);")
+			assert ("has_reconstruction", shader.has_substring ("bool reconstructPixel("))
+			assert ("alternates_phase", shader.has_substring ("frame_index"))
+			assert ("no_prepass", not shader.has_substring ("coneMarch"))
+			assert ("barrier_before_rebuild", shader.substring_index ("barrier();", 1) < shader.substring_index ("reconstructPixel(ro", 1))
+
+			builder.set_shading_rate (builder.Shading_rate_quarter)
+			assert ("quarter_tile", builder.dispatch_tile_width = 32 and builder.dispatch_tile_height = 32)
+			shader := builder.generate_basic_shader ("    return sdSphere(p, vec3(0.0), 1.0);")
+			assert ("three_rebuilt", shader.has_substring ("for (int k = 1; k < 4; k++)"))
+		end
+
+	test_glsl_analytic_normals
+			-- Test the shader takes normals from a differentiated scene function.
+		local
+			builder: SDF_GLSL_BUILDER
+			shader: STRING
+		do
+			create builder.make
+			assert ("analytic_by_default", builder.is_analytic_normals)
+			shader := builder.generate_basic_shader ("    float d = 1e10;%N    float s = sdSphere(p, vec3(0.0), 1.0);%N    d = opSmoothUnion(d, s, 0.3);%N    return d;")
+			assert ("has_gradient_scene", shader.has_substring ("vec4 sceneSDFGrad(vec3 p) {"))
+			assert ("constant_lifted", shader.has_substring ("    vec4 d = vec4(1e10, 0.0, 0.0, 0.0);"))
+			assert ("call_rewritten", shader.has_substring ("    vec4 s = sdSphereGrad(p, vec3(0.0), 1.0);"))
+			assert ("op_rewritten", shader.has_substring ("d = opSmoothUnionGrad(d, s, 0.3);"))
+			assert ("normal_from_gradient", shader.has_substring ("sceneSDFGrad(p).yzw"))
+			assert ("scene_kept", shader.has_substring ("    float s = sdSphere(p, vec3(0.0), 1.0);"))
+
+			builder.set_analytic_normals (False)
+			shader := builder.generate_basic_shader ("    return sdSphere(p, vec3(0.0), 1.0);")
+			assert ("no_gradient_scene", not shader.has_substring ("sceneSDFGrad"))
+			assert ("central_differences", shader.has_substring ("sceneSDF(p + vec3(e, 0, 0))"))
+		end
+
+	test_glsl_repetition
+			-- Test repetition functions and their gradient twins are emitted and called.
+		local
+			builder: SDF_GLSL_BUILDER
+			shader: STRING
+		do
+			create builder.make
+			builder.add_repetition ("fencePosts", "sdBox(q, vec3(0.0), vec3(0.1, 1.0, 0.1))", builder.Repeat_limited, False)
+			builder.add_repetition ("tiles", "sdCapsule(q, vec3(0.0), vec3(1.5, 0.0, 0.0), 0.3)", builder.Repeat_mirrored, True)
+			shader := builder.generate_basic_shader ("    float d = fencePosts(p, vec3(2.0, 0.0, 0.0), vec3(10.0, 0.0, 0.0));%N    return d;")
+			assert ("limited_function", shader.has_substring ("float fencePosts(vec3 p, vec3 s, vec3 l) {"))
+			assert ("clamped_cell", shader.has_substring ("clamp(round(p / s), -l, l)"))
+			assert ("one_cell", shader.has_substring ("for (int k = 0; k < 1; k++) {"))
+			assert ("neighbours", shader.has_substring ("for (int k = 0; k < 8; k++) {"))
+			assert ("mirrored", shader.has_substring ("q *= m;") and shader.has_substring ("e.yzw *= m;"))
+			assert ("gradient_twin", shader.has_substring ("vec4 fencePostsGrad(vec3 p, vec3 s, vec3 l) {"))
+			assert ("child_gradient", shader.has_substring ("vec4 e = sdBoxGrad(q, vec3(0.0), vec3(0.1, 1.0, 0.1));"))
+			assert ("call_rewritten", shader.has_substring ("vec4 d = fencePostsGrad(p, vec3(2.0, 0.0, 0.0), vec3(10.0, 0.0, 0.0));"))
+		end
+
+	test_shape_transform
+			-- Test rotated and scaled shapes agree across direct, tape, compiled and GLSL paths.
+		local
+			scene: SDF_SCENE
+			box: SDF_BOX
+			tape: SDF_TAPE
+			box_bounds: SDF_AABB
+			builder: SDF_GLSL_BUILDER
+			d: SDF_DUAL
+		do
+			create box.make (2.0, 1.0, 1.0)
+			assert ("untransformed", not box.is_transformed and box.scale = 1.0)
+			box := box.set_rotation (create {SDF_VEC3}.make (0.0, 0.0, 1.0), {DOUBLE_MATH}.pi / 2.0).set_scale (2.0)
+			assert ("transformed", box.is_transformed and box.scale = 2.0)
+			assert ("long_axis_turned", (box.distance_at (0.0, 5.0, 0.0) - 3.0).abs < Epsilon)
+			assert ("short_axis_scaled", (box.distance_at (3.0, 0.0, 0.0) - 2.0).abs < Epsilon)
+			assert ("inside_scaled", (box.distance_at (0.0, 0.0, 0.0) + 1.0).abs < Epsilon)
+
+			box_bounds := box.bounds
+			assert ("bounds_turned", (box_bounds.max_y - 2.0).abs < Epsilon and (box_bounds.max_x - 1.0).abs < Epsilon)
+
+			d := box.dual_at (0.0, 5.0, 0.0)
+			assert ("dual_value", (d.value - 3.0).abs < Epsilon)
+			assert ("gradient_turned", d.dx.abs < Epsilon and (d.dy - 1.0).abs < Epsilon and d.dz.abs < Epsilon)
+
+			create scene.make
+			scene.add (box).do_nothing
+			scene.add ((create {SDF_SPHERE}.make (0.5)).set_position (create {SDF_VEC3}.make (6.0, 0.0, 0.0))).do_nothing
+			tape := scene.tape
+			assert ("tape_matches_shape", (tape.distance_at (0.0, 5.0, 0.0) - 3.0).abs < Epsilon)
+			assert ("tape_matches_scene", (tape.distance_at (1.5, 0.7, -0.4) - scene.distance_at (1.5, 0.7, -0.4)).abs < Epsilon)
+			assert ("tape_gradient", (tape.dual_at (0.0, 5.0, 0.0).dy - 1.0).abs < Epsilon)
+			assert ("tape_interval", tape.interval_at (-0.1, 4.9, -0.1, 0.1, 5.1, 0.1).has (3.0))
+			assert ("compiled_flag", scene.compiled.is_transformed (1) and not scene.compiled.is_transformed (2))
+
+			create builder.make
+			assert ("glsl_wrapped", builder.transformed_sdf ("sdBox", "vec3(0.0), vec3(1.0, 0.5, 0.5)", box).has_substring ("opAffine(sdBox(opTransform(p, mat4x3("))
+			assert ("glsl_gradient", builder.gradient_calls ("opAffine(").same_string ("opAffineGrad("))
+
+			box := box.reset_transform
+			assert ("reset", not box.is_transformed and (box.distance_at (0.0, 5.0, 0.0) - 4.5).abs < Epsilon)
+		end
+
 feature {NONE} -- Constants
 
 	Epsilon: REAL_64 = 0.0001
@@ -71,11 +71,41 @@ feature {NONE} -- Test Runners
 			-- Scene tests
 			run_test (agent lib_tests.test_scene_composition, "test_scene_composition")
 			run_test (agent lib_tests.test_scene_smooth_blend, "test_scene_smooth_blend")
+			run_test (agent lib_tests.test_scene_compilation, "test_scene_compilation")
+			run_test (agent lib_tests.test_scalar_distance_path, "test_scalar_distance_path")
+			run_test (agent lib_tests.test_scene_tape, "test_scene_tape")
+			run_test (agent lib_tests.test_scene_hierarchy, "test_scene_hierarchy")
+			run_test (agent lib_tests.test_interval_bounds, "test_interval_bounds")
+			run_test (agent lib_tests.test_tape_pruning, "test_tape_pruning")
+			run_test (agent lib_tests.test_lipschitz_bound, "test_lipschitz_bound")
+			run_test (agent lib_tests.test_dual_gradient, "test_dual_gradient")
+			run_test (agent lib_tests.test_dual_hierarchy_after_move, "test_dual_hierarchy_after_move")
+			run_test (agent lib_tests.test_primitive_groups, "test_primitive_groups")
+			run_test (agent lib_tests.test_scene_group, "test_scene_group")
+			run_test (agent lib_tests.test_brick_field, "test_brick_field")
+			run_test (agent lib_tests.test_clipmap_field, "test_clipmap_field")
+			run_test (agent lib_tests.test_scene_dirty_regions, "test_scene_dirty_regions")
+			run_test (agent lib_tests.test_repetition, "test_repetition")
+			run_test (agent lib_tests.test_instance_grid, "test_instance_grid")
+			run_test (agent lib_tests.test_instance_rotation, "test_instance_rotation")
+			run_test (agent lib_tests.test_shape_transform, "test_shape_transform")
 
 			-- Ray marcher tests
 			run_test (agent lib_tests.test_ray_march_hit, "test_ray_march_hit")
 			run_test (agent lib_tests.test_ray_march_miss, "test_ray_march_miss")
+			run_test (agent lib_tests.test_ray_march_bounds, "test_ray_march_bounds")
+			run_test (agent lib_tests.test_ray_march_occupancy, "test_ray_march_occupancy")
 			run_test (agent lib_tests.test_ray_normal_computation, "test_ray_normal_computation")
+			run_test (agent lib_tests.test_ray_march_batch, "test_ray_march_batch")
+			run_test (agent lib_tests.test_ray_march_relaxation, "test_ray_march_relaxation")
+			run_test (agent lib_tests.test_ray_march_mixed_precision, "test_ray_march_mixed_precision")
+
+			-- GLSL tests
+			run_test (agent lib_tests.test_glsl_depth_prepass, "test_glsl_depth_prepass")
+			run_test (agent lib_tests.test_glsl_temporal_reprojection, "test_glsl_temporal_reprojection")
+			run_test (agent lib_tests.test_glsl_variable_rate, "test_glsl_variable_rate")
+			run_test (agent lib_tests.test_glsl_analytic_normals, "test_glsl_analytic_normals")
+			run_test (agent lib_tests.test_glsl_repetition, "test_glsl_repetition")
 		end
 
 feature {NONE} -- Implementation